@@ -18,6 +18,11 @@ struct camellia_simd_ctx
   int key_length;
 };
 
+/* Kernels wider than SIMD128 are declared only for builds with matching
+ * USE_SIMD256, USE_SIMD512, USE_SVE2 or USE_RVV macro. libcamellia_simd
+ * exports SIMD128 kernels and mode functions, with wider kernels selected
+ * internally by runtime dispatch. */
+
 /* SIMD128 vector implementation of key-setup. Supported key lengths are
  * 16, 24 and 32 bytes (128-bit, 192-bit and 256-bit). KEYLEN takes length
  * in bytes. KEY is pointer to key buffer and may be unaligned. */
@@ -36,6 +41,16 @@ void camellia_encrypt_1blk_simd128(struct camellia_simd_ctx *ctx, void *out,
 void camellia_decrypt_1blk_simd128(struct camellia_simd_ctx *ctx, void *out,
 				   const void *in, size_t nblocks);
 
+/* 2-block SIMD128 variant of 1-block implementation. The two blocks are
+ * kept in separate registers and processed round by round, so that latencies
+ * of AES instructions of one block are hidden by work on the other. Used for
+ * 2- and 3-block tails where 16-block implementation would waste most of its
+ * lanes. OUT and IN may be unaligned and may point to same buffer. */
+void camellia_encrypt_2blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				    const void *in);
+void camellia_decrypt_2blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				    const void *in);
+
 /* 16-block parallel SIMD128 vector implementation of Camellia. These are
  * 128-bit vector variants (on x86, AES-NI + SSE4.1/AVX). IN is pointer to
  * 16 plaintext blocks and OUT is pointer to 16 ciphertext blocks. OUT and IN
@@ -45,6 +60,18 @@ void camellia_encrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
 void camellia_decrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
 				  const void *in);
 
+/* 32-block SIMD128 variant of 16-block implementation, with two 16-block
+ * states interleaved. have_camellia_32blks_simd128() returns non-zero where
+ * this is implemented (POWER intrinsics, with 64 VSX registers, and AArch64
+ * assembly); elsewhere these are two calls to 16-block implementation.
+ * OUT and IN may be unaligned and may point to same buffer. */
+int have_camellia_32blks_simd128(void);
+void camellia_encrypt_32blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in);
+void camellia_decrypt_32blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in);
+
+#ifdef USE_SIMD256
 /* 32-block parallel SIMD256 vector implementation of Camellia. These are
  * 256-bit vector variants (on x86, AES-NI / AVX2). IN is pointer to 32
  * plaintext blocks and OUT is pointer to 32 ciphertext blocks. OUT and IN may
@@ -54,4 +81,542 @@ void camellia_encrypt_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
 void camellia_decrypt_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
 				     const void *in);
 
+/* Partial-batch variants of 32-block SIMD256 kernels: encrypt/decrypt first
+ * NBLKS (at most 32) blocks from IN to OUT in one pass of the 32-block
+ * kernel. When built with AVX512BW/VL, blocks are moved with byte-masked
+ * loads/stores and memory past NBLKS blocks is not accessed; otherwise blocks
+ * go through stack buffer. OUT and IN may be unaligned and may point to same
+ * buffer. have_camellia_nblks_simd256_masked() returns non-zero when masked
+ * loads/stores are used. */
+int have_camellia_nblks_simd256_masked(void);
+void camellia_encrypt_nblks_simd256_masked(struct camellia_simd_ctx *ctx,
+					   void *out, const void *in,
+					   size_t nblks);
+void camellia_decrypt_nblks_simd256_masked(struct camellia_simd_ctx *ctx,
+					   void *out, const void *in,
+					   size_t nblks);
+
+/* Gather/scatter variants of 32-block SIMD256 kernels: block I is loaded
+ * from IN[I] and result is stored to OUT[I]. Used for scatter-gather input
+ * where blocks are spread over several segments. Pointers may be unaligned
+ * and OUT[I] may point to any of input blocks. Intrinsics implementation
+ * loads and stores blocks directly through pointers; other builds go
+ * through stack buffer. */
+void camellia_encrypt_32blks_simd256_ptrs(struct camellia_simd_ctx *ctx,
+					  void *const out[32],
+					  const void *const in[32]);
+void camellia_decrypt_32blks_simd256_ptrs(struct camellia_simd_ctx *ctx,
+					  void *const out[32],
+					  const void *const in[32]);
+#endif
+
+#ifdef USE_SIMD512
+/* 64-block parallel SIMD512 vector implementation of Camellia. These are
+ * 512-bit vector variants (on x86, AVX-512 with VAES or GFNI). IN is pointer
+ * to 64 plaintext blocks and OUT is pointer to 64 ciphertext blocks. OUT and
+ * IN may be unaligned. */
+void camellia_encrypt_64blks_simd512(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in);
+void camellia_decrypt_64blks_simd512(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in);
+#endif
+
+#ifdef USE_SVE2
+/* Vector-length agnostic ARMv9 SVE2 implementation of Camellia, using
+ * SVE2-AES. camellia_sve2_parallel_blks() returns number of blocks processed
+ * in parallel, 16 blocks per 128 bits of vector length (16 to 256 blocks).
+ * Encrypt/decrypt first NBLKS (at most camellia_sve2_parallel_blks()) blocks
+ * from IN to OUT; memory past NBLKS blocks is not accessed. OUT and IN may
+ * be unaligned and may point to same buffer. */
+unsigned int camellia_sve2_parallel_blks(void);
+void camellia_encrypt_nblks_sve2(struct camellia_simd_ctx *ctx, void *out,
+				 const void *in, size_t nblks);
+void camellia_decrypt_nblks_sve2(struct camellia_simd_ctx *ctx, void *out,
+				 const void *in, size_t nblks);
+#endif
+
+#ifdef USE_RVV
+/* VLEN agnostic RISC-V vector implementation of Camellia, using Zvkned.
+ * camellia_rvv_parallel_blks() returns number of blocks processed in
+ * parallel, 16 blocks per 128 bits of VLEN (16 to 256 blocks). Otherwise
+ * same as SVE2 functions above. */
+unsigned int camellia_rvv_parallel_blks(void);
+void camellia_encrypt_nblks_rvv(struct camellia_simd_ctx *ctx, void *out,
+				const void *in, size_t nblks);
+void camellia_decrypt_nblks_rvv(struct camellia_simd_ctx *ctx, void *out,
+				const void *in, size_t nblks);
+#endif
+
+/* Multi-chunk ECB kernels: encrypt/decrypt NCHUNKS consecutive 16-block
+ * (or 32-block) chunks from IN to OUT in one call, with constants and key
+ * length set up once for all chunks. OUT and IN may be unaligned and may
+ * point to same buffer. */
+void camellia_ecb_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, size_t nchunks);
+void camellia_ecb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, size_t nchunks);
+#ifdef USE_SIMD256
+void camellia_ecb_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, size_t nchunks);
+void camellia_ecb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, size_t nchunks);
+#endif
+
+/* ECB mode encryption/decryption of NBLKS 16-byte blocks from IN to OUT.
+ * Any block count is handled: with USE_SVE2 or USE_RVV, input goes to
+ * vector-length agnostic SVE2 or RVV kernel. 64-block (with USE_SIMD512),
+ * 32-block (with USE_SIMD256) and 16-block chunks go to multi-chunk kernels.
+ * Remaining tail goes to masked 32-block kernel (with USE_SIMD256), to
+ * 16-block kernel with bounce buffer or to 2-block and 1-block kernels. OUT
+ * and IN may be unaligned and may point to same buffer. */
+void camellia_ecb_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nblks);
+void camellia_ecb_decrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nblks);
+
+/* 16-block and 32-block parallel CTR mode kernels. CTR is pointer to 128-bit
+ * big-endian counter block; 16 (or 32) consecutive counter values starting
+ * from CTR are encrypted and XORed with blocks from IN, result is written to
+ * OUT and CTR is incremented by 16 (or 32). OUT and IN may be unaligned and
+ * may point to same buffer. */
+void camellia_ctr_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *ctr);
+#ifdef USE_SIMD256
+void camellia_ctr_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *ctr);
+#endif
+
+/* CTR mode encryption/decryption of NBYTES from IN to OUT, using widest
+ * available parallel kernel. CTR is pointer to 128-bit big-endian counter
+ * block and is incremented by number of processed blocks. If NBYTES is not
+ * multiple of 16, keystream of last partial block is discarded (its counter
+ * value is still consumed). OUT and IN may be unaligned and may point to
+ * same buffer. */
+void camellia_ctr_crypt(struct camellia_simd_ctx *ctx, void *out,
+			const void *in, size_t nbytes, void *ctr);
+
+/* 16-block and 32-block parallel CBC mode decryption kernels. IV is pointer
+ * to 128-bit IV / previous ciphertext block and is updated with last
+ * ciphertext block of IN. OUT and IN may be unaligned and may point to same
+ * buffer. */
+void camellia_cbc_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *iv);
+#ifdef USE_SIMD256
+void camellia_cbc_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *iv);
+#endif
+
+/* CBC mode decryption of NBLKS 16-byte blocks from IN to OUT, using widest
+ * available parallel kernel. IV is pointer to 128-bit IV and is updated with
+ * last ciphertext block, so that consecutive calls continue the chain. OUT
+ * and IN may be unaligned and may point to same buffer. */
+void camellia_cbc_decrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nblks, void *iv);
+
+/* CBC mode encryption of NBLKS 16-byte blocks from IN to OUT. Chain is
+ * serial, so this runs with 1-block kernel; use camellia_cbc_encrypt_multi
+ * for multiple independent streams. IV is updated with last ciphertext
+ * block. OUT and IN may be unaligned and may point to same buffer. */
+void camellia_cbc_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nblks, void *iv);
+
+/* Job descriptor for multi-stream CBC encryption. IV is updated with last
+ * ciphertext block of the stream. */
+struct camellia_cbc_job
+{
+  const void *in;
+  void *out;
+  size_t nblks;
+  void *iv;
+};
+
+/* CBC mode encryption of NJOBS independent streams, each with its own IV
+ * and length. Chains of up to 32 (16 without SIMD256) streams run in lanes
+ * of the parallel kernel, one block of each stream per kernel call, and
+ * lane of finished stream is refilled with next pending job. Only the last
+ * few streams are finished with 1-block kernel. */
+void camellia_cbc_encrypt_multi(struct camellia_simd_ctx *ctx,
+				const struct camellia_cbc_job *jobs,
+				size_t njobs);
+
+/* 16-block and 32-block parallel CFB mode decryption kernels. IV is pointer
+ * to 128-bit IV / previous ciphertext block and is updated with last
+ * ciphertext block of IN. OUT and IN may be unaligned and may point to same
+ * buffer. */
+void camellia_cfb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *iv);
+#ifdef USE_SIMD256
+void camellia_cfb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *iv);
+#endif
+
+/* CFB (CFB128) mode encryption/decryption of NBYTES from IN to OUT. IV is
+ * pointer to 128-bit IV and is updated with last ciphertext block, so that
+ * consecutive calls continue the chain. If NBYTES is not multiple of 16, last
+ * partial block ends the chain and IV content is unspecified. Decryption
+ * uses widest available parallel kernel, encryption is serial and uses
+ * 1-block kernel. OUT and IN may be unaligned and may point to same
+ * buffer. */
+void camellia_cfb_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nbytes, void *iv);
+void camellia_cfb_decrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nbytes, void *iv);
+
+/* 16-block and 32-block parallel XTS mode kernels. TWEAK is pointer to
+ * 128-bit little-endian tweak T; blocks are processed with tweaks T, T*x,
+ * T*x^2, ... and TWEAK is updated with tweak of next block. OUT and IN may
+ * be unaligned and may point to same buffer. */
+void camellia_xts_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *tweak);
+void camellia_xts_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *tweak);
+#ifdef USE_SIMD256
+void camellia_xts_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *tweak);
+void camellia_xts_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *tweak);
+#endif
+
+/* XTS mode encryption/decryption of NBYTES from IN to OUT, using widest
+ * available parallel kernel. TWEAK is pointer to initial 128-bit tweak,
+ * already encrypted with the tweak key (T = E(K2, sector number)). If NBYTES
+ * is multiple of 16, TWEAK is updated with tweak of next block so that
+ * consecutive calls continue the data unit. Otherwise, ciphertext stealing
+ * is used for the partial last block, which ends the data unit. NBYTES must
+ * be at least 16; returns 0 on success and -1 otherwise. OUT and IN may be
+ * unaligned and may point to same buffer. */
+int camellia_xts_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			 const void *in, size_t nbytes, void *tweak);
+int camellia_xts_decrypt(struct camellia_simd_ctx *ctx, void *out,
+			 const void *in, size_t nbytes, void *tweak);
+
+/* 16-block and 32-block parallel OCB mode kernels. OFFSET is pointer to
+ * current 128-bit offset and is updated with offset of last block. LS is
+ * array of pointers to L_{ntz(i)} values for each block. CHECKSUM (or SUM
+ * for associated data) is XORed with plaintext blocks (or encrypted
+ * associated data blocks). OUT and IN may be unaligned and may point to same
+ * buffer. */
+void camellia_ocb_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *offset,
+				     void *checksum, const void *Ls[16]);
+void camellia_ocb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *offset,
+				     void *checksum, const void *Ls[16]);
+void camellia_ocb_auth_16blks_simd128(struct camellia_simd_ctx *ctx,
+				      const void *abuf, void *offset,
+				      void *sum, const void *Ls[16]);
+#ifdef USE_SIMD256
+void camellia_ocb_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *offset,
+				     void *checksum, const void *Ls[32]);
+void camellia_ocb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *offset,
+				     void *checksum, const void *Ls[32]);
+void camellia_ocb_auth_32blks_simd256(struct camellia_simd_ctx *ctx,
+				      const void *abuf, void *offset,
+				      void *sum, const void *Ls[32]);
+#endif
+
+/* OCB3 (RFC 7253) authenticated encryption state. */
+struct camellia_ocb_ctx
+{
+  struct camellia_simd_ctx *key;
+  uint8_t L_star[16];
+  uint8_t L_dollar[16];
+  uint8_t L[64][16];
+  uint8_t offset[16];
+  uint8_t checksum[16];
+  uint8_t aad_offset[16];
+  uint8_t aad_sum[16];
+  uint8_t aad_partial[16];
+  uint64_t blkn;
+  uint64_t aad_blkn;
+  unsigned int aad_partial_len;
+  unsigned int taglen;
+};
+
+/* Precompute L table for key CTX. CTX must stay valid while OCB context is
+ * used. */
+void camellia_ocb_setkey(struct camellia_ocb_ctx *ocb,
+			 struct camellia_simd_ctx *ctx);
+
+/* Start new message with NONCE of NONCELEN bytes (1 to 15) and tag length
+ * TAGLEN bytes (1 to 16). Returns 0 on success and -1 on invalid
+ * parameters. */
+int camellia_ocb_set_nonce(struct camellia_ocb_ctx *ocb, const void *nonce,
+			   size_t noncelen, size_t taglen);
+
+/* Process NBYTES of associated data. May be called multiple times and in
+ * any length chunks, before or between encryption/decryption calls. */
+void camellia_ocb_authenticate(struct camellia_ocb_ctx *ocb, const void *aad,
+			       size_t nbytes);
+
+/* Encrypt/decrypt NBYTES from IN to OUT. May be called multiple times;
+ * NBYTES must be multiple of 16 in all but the last call. OUT and IN may be
+ * unaligned and may point to same buffer. */
+void camellia_ocb_encrypt(struct camellia_ocb_ctx *ocb, void *out,
+			  const void *in, size_t nbytes);
+void camellia_ocb_decrypt(struct camellia_ocb_ctx *ocb, void *out,
+			  const void *in, size_t nbytes);
+
+/* Compute authentication tag of TAGLEN bytes to TAG. */
+void camellia_ocb_get_tag(struct camellia_ocb_ctx *ocb, void *tag);
+
+/* Compare authentication tag against TAG in constant time. Returns 0 if tag
+ * matches and -1 otherwise. */
+int camellia_ocb_check_tag(struct camellia_ocb_ctx *ocb, const void *tag);
+
+#ifdef USE_SIMD256
+/* GCM mode GHASH and stitched CTR+GHASH kernels. HTABLE is 256-byte GHASH
+ * key table computed from hash subkey H by camellia_gcm_ghash_init_simd256,
+ * and HASH is 128-bit GHASH state. camellia_gcm_ctr_ghash_32blks_simd256
+ * encrypts 32 counter blocks from CTR (incrementing low 32 bits of CTR) and
+ * XORs them with IN to OUT, while hashing 32 blocks from GHASH_IN (if not
+ * NULL). OUT, IN and GHASH_IN may be unaligned and may point to same
+ * buffer. */
+void camellia_gcm_ghash_init_simd256(void *htable, const void *H);
+void camellia_gcm_ghash_simd256(void *hash, const void *htable,
+				const void *in, size_t nblks);
+void camellia_gcm_ctr_ghash_32blks_simd256(struct camellia_simd_ctx *ctx,
+					   void *out, const void *in,
+					   void *ctr, const void *ghash_in,
+					   void *hash, const void *htable);
+#endif
+
+/* GCM (NIST SP 800-38D, RFC 6367) authenticated encryption state. */
+struct camellia_gcm_ctx
+{
+  struct camellia_simd_ctx *key;
+  uint64_t htable[16][2];
+  uint8_t J0[16];
+  uint8_t ctr[16];
+  uint8_t hash[16];
+  uint8_t aad_partial[16];
+  uint64_t aadlen;
+  uint64_t datalen;
+  unsigned int aad_partial_len;
+};
+
+/* Compute hash subkey and GHASH key table for key CTX. CTX must stay valid
+ * while GCM context is used. */
+void camellia_gcm_setkey(struct camellia_gcm_ctx *gcm,
+			 struct camellia_simd_ctx *ctx);
+
+/* Start new message with IV of IVLEN bytes (96-bit IV recommended). Returns
+ * 0 on success and -1 on invalid parameters. */
+int camellia_gcm_set_iv(struct camellia_gcm_ctx *gcm, const void *iv,
+			size_t ivlen);
+
+/* Process NBYTES of associated data. May be called multiple times and in
+ * any length chunks, but only before encryption/decryption calls. */
+void camellia_gcm_authenticate(struct camellia_gcm_ctx *gcm, const void *aad,
+			       size_t nbytes);
+
+/* Encrypt/decrypt NBYTES from IN to OUT. May be called multiple times;
+ * NBYTES must be multiple of 16 in all but the last call. OUT and IN may be
+ * unaligned and may point to same buffer. */
+void camellia_gcm_encrypt(struct camellia_gcm_ctx *gcm, void *out,
+			  const void *in, size_t nbytes);
+void camellia_gcm_decrypt(struct camellia_gcm_ctx *gcm, void *out,
+			  const void *in, size_t nbytes);
+
+/* Compute authentication tag of TAGLEN bytes (1 to 16) to TAG. */
+void camellia_gcm_get_tag(struct camellia_gcm_ctx *gcm, void *tag,
+			  size_t taglen);
+
+/* Compare authentication tag of TAGLEN bytes against TAG in constant time.
+ * Returns 0 if tag matches and -1 otherwise. */
+int camellia_gcm_check_tag(struct camellia_gcm_ctx *gcm, const void *tag,
+			   size_t taglen);
+
+/* CCM (RFC 3610, RFC 5528) authenticated encryption of NBYTES from IN to
+ * OUT with NONCE of NONCELEN bytes (7 to 13) and associated data AAD of
+ * AADLEN bytes. Encryption writes tag of TAGLEN bytes (4, 6, ..., 16) to
+ * TAG. Decryption checks tag against TAG and returns -1 and zeroes OUT if
+ * tag does not match. Both return -1 on invalid parameters and 0 on
+ * success. OUT and IN may be unaligned and may point to same buffer. */
+int camellia_ccm_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			 const void *in, size_t nbytes, const void *nonce,
+			 size_t noncelen, const void *aad, size_t aadlen,
+			 void *tag, size_t taglen);
+int camellia_ccm_decrypt(struct camellia_simd_ctx *ctx, void *out,
+			 const void *in, size_t nbytes, const void *nonce,
+			 size_t noncelen, const void *aad, size_t aadlen,
+			 const void *tag, size_t taglen);
+
+/* Message descriptor for multi-message CCM. TAG is output for encryption
+ * and input for decryption. STATUS is set to -1 if payload is too long for
+ * nonce length (message is then skipped) or, by decryption, if tag did not
+ * match, and to 0 otherwise. */
+struct camellia_ccm_msg
+{
+  const void *nonce;
+  const void *aad;
+  size_t aadlen;
+  const void *in;
+  void *out;
+  size_t nbytes;
+  void *tag;
+  int status;
+};
+
+/* CCM encryption/decryption of NMSGS independent messages with same key,
+ * nonce length and tag length. CBC-MAC chains of up to 32 messages are
+ * processed in parallel, one block of each message per parallel kernel
+ * call, and CTR keystream blocks of all messages are packed to parallel
+ * kernel calls. Returns -1 if nonce or tag length is invalid (no message
+ * is processed) or if STATUS of any message is -1, and 0 otherwise. */
+int camellia_ccm_encrypt_multi(struct camellia_simd_ctx *ctx,
+			       struct camellia_ccm_msg *msgs, size_t nmsgs,
+			       size_t noncelen, size_t taglen);
+int camellia_ccm_decrypt_multi(struct camellia_simd_ctx *ctx,
+			       struct camellia_ccm_msg *msgs, size_t nmsgs,
+			       size_t noncelen, size_t taglen);
+
+struct camellia_cmac_ctx
+{
+  struct camellia_simd_ctx *key;
+  uint8_t K1[16];
+  uint8_t K2[16];
+};
+
+/* Message descriptor for multi-message CMAC. MAC receives 16-byte MAC. */
+struct camellia_cmac_msg
+{
+  const void *in;
+  size_t nbytes;
+  void *mac;
+};
+
+/* Set up CMAC (NIST SP 800-38B, RFC 4493 with Camellia) subkeys for
+ * key CTX. */
+void camellia_cmac_setkey(struct camellia_cmac_ctx *cmac,
+			  struct camellia_simd_ctx *ctx);
+
+/* Compute 16-byte CMAC of NBYTES from IN to MAC. */
+void camellia_cmac(const struct camellia_cmac_ctx *cmac, void *mac,
+		   const void *in, size_t nbytes);
+
+/* Compute CMAC of NMSGS independent messages. Each message chain runs in
+ * its own lane of the 32-block (or 16-block) kernel, one block per kernel
+ * call, and lane of finished message is refilled with next pending
+ * message. Last few chains are finished with 1-block kernel. */
+void camellia_cmac_multi(const struct camellia_cmac_ctx *cmac,
+			 const struct camellia_cmac_msg *msgs, size_t nmsgs);
+
+/* Streaming context for data arriving in arbitrary size fragments. Input
+ * is buffered until full 32-block batch is available, so that the
+ * parallel kernels always get full batches regardless of fragment sizes;
+ * remainder is processed on final. */
+enum camellia_stream_mode
+{
+  CAMELLIA_STREAM_ECB_ENC,
+  CAMELLIA_STREAM_ECB_DEC,
+  CAMELLIA_STREAM_CTR,
+  CAMELLIA_STREAM_CBC_DEC
+};
+
+#define CAMELLIA_STREAM_BATCH_BYTES (32 * 16)
+
+struct camellia_stream_ctx
+{
+  struct camellia_simd_ctx *key;
+  int mode;
+  uint8_t iv[16];
+  size_t buflen;
+  uint8_t buf[CAMELLIA_STREAM_BATCH_BYTES];
+};
+
+/* Start stream with KEY in MODE. IV is 128-bit big-endian initial counter
+ * for CTR and IV for CBC decryption, and is ignored (may be NULL) for ECB.
+ * Returns 0 on success and -1 on invalid MODE. */
+int camellia_stream_init(struct camellia_stream_ctx *st,
+			 struct camellia_simd_ctx *key, int mode,
+			 const void *iv);
+
+/* Process NBYTES from IN. Output is written to OUT in whole batches of
+ * CAMELLIA_STREAM_BATCH_BYTES, so it lags input by up to one batch; OUT
+ * must have room for NBYTES + CAMELLIA_STREAM_BATCH_BYTES - 1 bytes. Returns
+ * number of bytes written to OUT. OUT and IN may be unaligned but must not
+ * overlap. */
+size_t camellia_stream_update(struct camellia_stream_ctx *st, void *out,
+			      const void *in, size_t nbytes);
+
+/* Process buffered remainder to OUT, which must have room for
+ * CAMELLIA_STREAM_BATCH_BYTES - 1 bytes, and store number of bytes written
+ * to OUTLEN. CTR accepts partial last block; ECB and CBC return -1 if total
+ * input is not multiple of 16 bytes, and 0 otherwise. Context must be
+ * initialized again before next stream. */
+int camellia_stream_final(struct camellia_stream_ctx *st, void *out,
+			  size_t *outlen);
+
+/* Scatter-gather variants of ECB, CTR and CBC decryption, processing all
+ * data of SRCCNT segments of SRC to DST segments. Segment boundaries may
+ * split blocks. Where source and destination segments are contiguous for
+ * at least 32 blocks, data is processed in place in the segments; other
+ * blocks, including ones straddling segment boundaries, are gathered to
+ * 32-block batches for the parallel kernels and results scattered back.
+ * With USE_SIMD256, ECB and CBC batches are passed to the kernels as block
+ * pointers into segments, and only blocks straddling segment boundaries
+ * are copied.
+ * CTR and IV are updated as in camellia_ctr_crypt and
+ * camellia_cbc_decrypt. DST may be same array as SRC, otherwise they must
+ * not overlap. Returns -1 if DST is shorter than SRC or, for ECB and CBC,
+ * if SRC length is not multiple of 16, and 0 otherwise. */
+struct iovec;
+int camellia_ecb_encrypt_iov(struct camellia_simd_ctx *ctx,
+			     const struct iovec *dst, size_t dstcnt,
+			     const struct iovec *src, size_t srccnt);
+int camellia_ecb_decrypt_iov(struct camellia_simd_ctx *ctx,
+			     const struct iovec *dst, size_t dstcnt,
+			     const struct iovec *src, size_t srccnt);
+int camellia_ctr_crypt_iov(struct camellia_simd_ctx *ctx,
+			   const struct iovec *dst, size_t dstcnt,
+			   const struct iovec *src, size_t srccnt, void *ctr);
+int camellia_cbc_decrypt_iov(struct camellia_simd_ctx *ctx,
+			     const struct iovec *dst, size_t dstcnt,
+			     const struct iovec *src, size_t srccnt, void *iv);
+
+/* Runtime kernel selection, when all kernel variants of the architecture
+ * are linked together with camellia_simd_dispatch.c. SIMD128 kernels and
+ * mode functions above then call implementation selected on first use by
+ * CPU features (CPUID on x86-64, HWCAP on AArch64) or by environment
+ * variable CAMELLIA_SIMD_IMPL. SIMD256, SIMD512 and SVE2 kernels are used
+ * internally by the modes and are not exported.
+ *
+ * camellia_simd_impl_name() returns name of selected implementation.
+ * camellia_simd_impl_available() returns name of IDX:th implementation
+ * supported by this CPU, in order of preference, or NULL if IDX is past the
+ * last one. camellia_simd_set_impl() selects implementation by NAME and
+ * returns 0, or -1 if NAME is unknown or not supported by this CPU. Key
+ * and mode contexts must be used with the implementation they were set up
+ * with. */
+const char *camellia_simd_impl_name(void);
+const char *camellia_simd_impl_available(unsigned int idx);
+int camellia_simd_set_impl(const char *name);
+
+/* Autotune implementation selection. Each supported implementation is timed
+ * for a few milliseconds per operation (ECB, CTR, CBC, CFB, XTS, OCB, GCM,
+ * CCM, CMAC) and, for bulk modes, per size class (under 16, under 128 and
+ * 128 or more blocks), and the fastest one is used for that operation from
+ * then on. Functions of a mode with its own context always use a single
+ * implementation, as context layout may differ between them. For each
+ * implementation, also measures from which length tails of under 16 blocks
+ * are processed with parallel kernel instead of 1-block kernel.
+ *
+ * If CACHE_PATH is not NULL, results are loaded from that file when it was
+ * written on the same CPU model with the same set of implementations, and
+ * otherwise measured and written there. Returns 0 on success and -1 if
+ * measuring or writing the cache failed. Does nothing if CAMELLIA_SIMD_IMPL
+ * is set; camellia_simd_set_impl() discards autotuned selection. Must be
+ * called before contexts are set up, or contexts must be set up again
+ * afterwards. Library never autotunes or writes the cache on its own.
+ *
+ * camellia_simd_tuned_impl_name() returns name of implementation used for
+ * operation OP ("ecb_enc", "ecb_dec", "ctr", "cbc_enc", "cbc_dec",
+ * "cbc_enc_multi", "cfb_enc", "cfb_dec", "xts", "ocb", "gcm", "ccm" or
+ * "cmac") with NBLKS blocks, or NULL if OP is unknown. */
+int camellia_simd_autotune(const char *cache_path);
+const char *camellia_simd_tuned_impl_name(const char *op, size_t nblks);
+
 #endif /* _CAMELLIA_SIMD_H_ */
@@ -10,6 +10,10 @@
  * them in parallel. Vectorized key setup is also available at the end of
  * file.
  *
+ * On x86, GFNI can be used for sbox instead (USE_GFNI). For CPUs without
+ * AES instructions, sbox can be computed with constant-time bitsliced
+ * circuit (USE_BITSLICED_SBOX).
+ *
  * This work was originally presented in Master's Thesis,
  *   "Block Ciphers: Fast Implementations on x86-64 Architecture" (pages 42-50)
  *   http://urn.fi/URN:NBN:fi:oulu-201305311409
@@ -20,7 +24,7 @@
 
 #if defined(__riscv) && (__riscv_v_min_vlen >= 128) && \
     (__riscv_v_intrinsic >= 11000) && (__riscv_zvkb >= 1000000) && \
-    (__riscv_zvkned >= 1000000)
+    ((__riscv_zvkned >= 1000000) || defined(USE_BITSLICED_SBOX))
 
 /**********************************************************************
   AT&T x86 asm to intrinsics conversion macros (RISCV RVA23+Zvkb+Zvkned)
@@ -243,6 +247,7 @@ typedef __m128i __m128i_mem;
 				   vpxor128(tmp, o, o); })
 
 #define vpaddb128(a, b, o)      (o = (__m128i)vec_add((uint8x16_t)b, (uint8x16_t)a))
+#define vpbroadcastb128(a, o)   (o = (__m128i)vec_splats((uint8_t)(a)))
 
 #define vpcmpgtb128(a, b, o)    (o = (__m128i)vec_cmpgt((int8x16_t)b, (int8x16_t)a))
 #define vpabsb128(a, o)         (o = (__m128i)vec_abs((int8x16_t)a))
@@ -448,8 +453,15 @@ typedef __m128i __m128i_mem;
 #define vpsrl_byte_128(s, a, o) vpsrld128(s, a, o)
 #define vpsll_byte_128(s, a, o) vpslld128(s, a, o)
 
+#ifdef USE_GFNI
+/* GFNI post-filters include sbox2/sbox3 output rotations, so byte layout
+ * after sbox matches the VPROLB variant. */
+#define if_vprolb128(...)       __VA_ARGS__
+#define if_not_vprolb128(...)   /*_*/
+#else
 #define if_vprolb128(...)       /*_*/
 #define if_not_vprolb128(...)   __VA_ARGS__
+#endif
 
 #define vpaddb128(a, b, o)      (o = _mm_add_epi8(b, a))
 
@@ -498,6 +510,18 @@ typedef __m128i __m128i_mem;
 #define vmovdqu128_memst(a, o)  _mm_storeu_si128((__m128i *)(o), a)
 #define vmovq128_memst(a, o)    _mm_storel_epi64((__m128i *)(o), a)
 
+#ifdef USE_GFNI
+/* GFNI macros (SSE encoding, no AVX required) */
+#define vgf2p8affineqb128(b, A, x, o) \
+	(o = _mm_gf2p8affine_epi64_epi8(x, A, b))
+#define vgf2p8affineinvqb128(b, A, x, o) \
+	(o = _mm_gf2p8affineinv_epi64_epi8(x, A, b))
+#define vpbroadcastq128(a, o)   (o = _mm_set1_epi64x(a))
+
+/* GF2P8AFFINEINVQB does SubBytes without ShiftRows. */
+#define if_aes_subbytes(...) __VA_ARGS__
+#define if_not_aes_subbytes(...) /*_*/
+#else
 /* Macros for exposing SubBytes from AES-NI instruction set. */
 #define aes_subbytes_and_shuf_and_xor(zero, a, o) \
 	vaesenclast128(zero, a, o)
@@ -507,11 +531,305 @@ typedef __m128i __m128i_mem;
 	vpshufb128(shufmask_reg, a, o)
 #define if_aes_subbytes(...) /*_*/
 #define if_not_aes_subbytes(...) __VA_ARGS__
+#endif /* USE_GFNI */
 
 #define memory_barrier_with_vec(a) __asm__("" : "+x"(a) :: "memory")
 
 #endif /* defined(__x86_64__) || defined(__i386__) */
 
+#ifdef USE_BITSLICED_SBOX
+/* Bitsliced sbox circuit outputs sboxes without ShiftRows and with
+ * sbox2/sbox3 output rotations applied. */
+#undef if_aes_subbytes
+#undef if_not_aes_subbytes
+#undef if_vprolb128
+#undef if_not_vprolb128
+#define if_aes_subbytes(...)    __VA_ARGS__
+#define if_not_aes_subbytes(...) /*_*/
+#define if_vprolb128(...)       __VA_ARGS__
+#define if_not_vprolb128(...)   /*_*/
+#endif /* USE_BITSLICED_SBOX */
+
+/**********************************************************************
+  GFNI helper macros and constants
+ **********************************************************************/
+
+#ifdef USE_GFNI
+
+#define BV8(a0,a1,a2,a3,a4,a5,a6,a7) \
+	( (((a0) & 1) << 0) | \
+	  (((a1) & 1) << 1) | \
+	  (((a2) & 1) << 2) | \
+	  (((a3) & 1) << 3) | \
+	  (((a4) & 1) << 4) | \
+	  (((a5) & 1) << 5) | \
+	  (((a6) & 1) << 6) | \
+	  (((a7) & 1) << 7) )
+
+#define BM8X8(l0,l1,l2,l3,l4,l5,l6,l7) \
+	( ((uint64_t)(l7) << (0 * 8)) | \
+	  ((uint64_t)(l6) << (1 * 8)) | \
+	  ((uint64_t)(l5) << (2 * 8)) | \
+	  ((uint64_t)(l4) << (3 * 8)) | \
+	  ((uint64_t)(l3) << (4 * 8)) | \
+	  ((uint64_t)(l2) << (5 * 8)) | \
+	  ((uint64_t)(l1) << (6 * 8)) | \
+	  ((uint64_t)(l0) << (7 * 8)) )
+
+/* Pre-filters and post-filters constants for Camellia sboxes s1, s2, s3 and s4.
+ *   See http://urn.fi/URN:NBN:fi:oulu-201305311409, pages 43-48.
+ *
+ * Pre-filters are directly from above source, "θ₁"/"θ₄". Post-filters are
+ * combination of function "A" (AES SubBytes affine transformation) and
+ * "ψ₁"/"ψ₂"/"ψ₃".
+ */
+
+/* Constant from "θ₁(x)" and "θ₄(x)" functions. */
+#define pre_filter_constant_s1234 BV8(1, 0, 1, 0, 0, 0, 1, 0)
+
+/* Constant from "ψ₁(A(x))" function: */
+#define post_filter_constant_s14  BV8(0, 1, 1, 1, 0, 1, 1, 0)
+
+/* Constant from "ψ₂(A(x))" function: */
+#define post_filter_constant_s2   BV8(0, 0, 1, 1, 1, 0, 1, 1)
+
+/* Constant from "ψ₃(A(x))" function: */
+#define post_filter_constant_s3   BV8(1, 1, 1, 0, 1, 1, 0, 0)
+
+#endif /* USE_GFNI */
+
+/**********************************************************************
+  bitsliced sbox helper macros
+ **********************************************************************/
+
+#ifdef USE_BITSLICED_SBOX
+
+/* Constant-time sbox for CPUs without AES or GFNI instructions.
+ *
+ * Bytes are transposed to bit-planes and Camellia s1 is evaluated with
+ * Boolean circuit: GF(2⁸) inversion from Boyar-Peralta AES S-box circuit
+ * (see https://eprint.iacr.org/2011/332), with Camellia pre-filter merged
+ * to top linear layer and post-filter ("ψ₁(A⁻¹(x))") merged to bottom linear
+ * layer. s2, s3 and s4 are derived with byte rotations:
+ *   s2(x) = s1(x) <<< 1, s3(x) = s1(x) >>> 1, s4(x) = s1(x <<< 1)
+ */
+
+/* Swap bits of B selected by MASK with bits of A selected by (MASK << N). */
+#define swapmove_bits(a, b, n, mask, t) \
+	vpsrlq128(n, a, t); \
+	vpxor128(b, t, t); \
+	vpand128_amemld(&(mask), t, t); \
+	vpxor128(t, b, b); \
+	vpsllq128(n, t, t); \
+	vpxor128(t, a, a);
+
+/* Transpose bytes x0..x7 to bit-planes x0..x7 (bit N of each byte to xN),
+ * and back. */
+#define bitslice_transpose_8x8(x0, x1, x2, x3, x4, x5, x6, x7, t) \
+	swapmove_bits(x0, x1, 1, bitslice_mask_55, t); \
+	swapmove_bits(x2, x3, 1, bitslice_mask_55, t); \
+	swapmove_bits(x4, x5, 1, bitslice_mask_55, t); \
+	swapmove_bits(x6, x7, 1, bitslice_mask_55, t); \
+	swapmove_bits(x0, x2, 2, bitslice_mask_33, t); \
+	swapmove_bits(x1, x3, 2, bitslice_mask_33, t); \
+	swapmove_bits(x4, x6, 2, bitslice_mask_33, t); \
+	swapmove_bits(x5, x7, 2, bitslice_mask_33, t); \
+	swapmove_bits(x0, x4, 4, bitslice_mask_0f, t); \
+	swapmove_bits(x1, x5, 4, bitslice_mask_0f, t); \
+	swapmove_bits(x2, x6, 4, bitslice_mask_0f, t); \
+	swapmove_bits(x3, x7, 4, bitslice_mask_0f, t);
+
+/* Same within each 64-bit lane of X: bit N of each byte to byte N. */
+#define bitslice_transpose_8x8_qword(x, t) \
+	swapmove_bits(x, x, 7, bitslice_qmask_aa, t); \
+	swapmove_bits(x, x, 14, bitslice_qmask_cc, t); \
+	swapmove_bits(x, x, 28, bitslice_qmask_f0, t);
+
+#define bitslice_rol1_byte(a, o, t, mask_01) \
+	vpsrlq128(7, a, t); \
+	vpand128(mask_01, t, t); \
+	vpaddb128(a, a, o); \
+	vpor128(t, o, o);
+
+#define bitslice_ror1_byte(a, o, t, mask_01, mask_7f) \
+	vpand128(mask_01, a, t); \
+	vpsllq128(7, t, t); \
+	vpsrlq128(1, a, o); \
+	vpand128(mask_7f, o, o); \
+	vpor128(t, o, o);
+
+/* Camellia s1 on bit-planes x0..x7 (in-place), ONES: all bits set. */
+#define bitslice_sbox1(x0, x1, x2, x3, x4, x5, x6, x7, ones) ({ \
+	__m128i a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, T1, T2, \
+		T3, T4, T6, T8, T9, T10, T13, T14, T15, T16, T17, T19, T20, T22, \
+		T23, T24, T25, T26, T27, U7; \
+	__m128i M1, M2, M3, M4, M5, M6, M7, M8, M9, M10, M11, M12, M13, M14, \
+		M15, M16, M17, M18, M19, M20, M21, M22, M23, M24, M25, M26, M27, \
+		M28, M29, M30, M31, M32, M33, M34, M35, M36, M37, M38, M39, M40, \
+		M41, M42, M43, M44, M45, M46, M47, M48, M49, M50, M51, M52, M53, \
+		M54, M55, M56, M57, M58, M59, M60, M61, M62, M63; \
+	__m128i b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11, b12, b13, \
+		b14, b15, b16, b17, b18, b19, b20, b21, b22, b23, b24, b25, b26, \
+		b27, b28, b29, b30, b31, b32, b33, b34, b35; \
+	\
+	/* input affine transform, constant part (⊕ 0xc5) */ \
+	vpxor128(ones, x0, x0); \
+	vpxor128(ones, x2, x2); \
+	vpxor128(ones, x6, x6); \
+	vpxor128(ones, x7, x7); \
+	\
+	/* input affine transform + AES S-box top linear layer */ \
+	vpxor128(x1, x2, a0); \
+	vpxor128(x3, x5, a1); \
+	vpxor128(x7, a0, a2); \
+	vpxor128(x0, x6, a3); \
+	vpxor128(x0, a1, a4); \
+	vpxor128(x1, x7, T26); \
+	vpxor128(x4, a2, T19); \
+	vpxor128(x4, a0, T13); \
+	vpxor128(x6, a1, a5); \
+	vpxor128(a1, a3, a6); \
+	vpxor128(x0, x3, T17); \
+	vpxor128(x0, x5, a7); \
+	vpxor128(x1, x4, a8); \
+	vpxor128(x1, a5, T2); \
+	vpxor128(x2, a4, T3); \
+	vpxor128(x3, x6, a9); \
+	vpxor128(x4, x6, a10); \
+	vpxor128(x4, a3, T1); \
+	vpxor128(x5, a0, a11); \
+	vpxor128(x5, a2, T9); \
+	vpxor128(x7, a3, T10); \
+	vpxor128(x7, a10, T6); \
+	vpxor128(a1, T19, T15); \
+	vpxor128(a2, a3, T20); \
+	vpxor128(a2, a4, T16); \
+	vpxor128(a2, a6, T14); \
+	vpxor128(a2, a9, T25); \
+	vpxor128(a3, a11, T8); \
+	vpxor128(a4, T26, T24); \
+	vpxor128(a4, a8, T4); \
+	vpxor128(T26, a5, T22); \
+	vpxor128(T19, a7, U7); \
+	vpxor128(T13, a6, T27); \
+	vmovdqa128(x7, T23); \
+	\
+	/* GF(2⁸) inversion, non-linear middle layer */ \
+	vpand128(T13, T6, M1); \
+	vpand128(T23, T8, M2); \
+	vpxor128(T14, M1, M3); \
+	vpand128(T19, U7, M4); \
+	vpxor128(M4, M1, M5); \
+	vpand128(T3, T16, M6); \
+	vpand128(T22, T9, M7); \
+	vpxor128(T26, M6, M8); \
+	vpand128(T20, T17, M9); \
+	vpxor128(M9, M6, M10); \
+	vpand128(T1, T15, M11); \
+	vpand128(T4, T27, M12); \
+	vpxor128(M12, M11, M13); \
+	vpand128(T2, T10, M14); \
+	vpxor128(M14, M11, M15); \
+	vpxor128(M3, M2, M16); \
+	vpxor128(M5, T24, M17); \
+	vpxor128(M8, M7, M18); \
+	vpxor128(M10, M15, M19); \
+	vpxor128(M16, M13, M20); \
+	vpxor128(M17, M15, M21); \
+	vpxor128(M18, M13, M22); \
+	vpxor128(M19, T25, M23); \
+	vpxor128(M22, M23, M24); \
+	vpand128(M22, M20, M25); \
+	vpxor128(M21, M25, M26); \
+	vpxor128(M20, M21, M27); \
+	vpxor128(M23, M25, M28); \
+	vpand128(M28, M27, M29); \
+	vpand128(M26, M24, M30); \
+	vpand128(M20, M23, M31); \
+	vpand128(M27, M31, M32); \
+	vpxor128(M27, M25, M33); \
+	vpand128(M21, M22, M34); \
+	vpand128(M24, M34, M35); \
+	vpxor128(M24, M25, M36); \
+	vpxor128(M21, M29, M37); \
+	vpxor128(M32, M33, M38); \
+	vpxor128(M23, M30, M39); \
+	vpxor128(M35, M36, M40); \
+	vpxor128(M38, M40, M41); \
+	vpxor128(M37, M39, M42); \
+	vpxor128(M37, M38, M43); \
+	vpxor128(M39, M40, M44); \
+	vpxor128(M42, M41, M45); \
+	vpand128(M44, T6, M46); \
+	vpand128(M40, T8, M47); \
+	vpand128(M39, U7, M48); \
+	vpand128(M43, T16, M49); \
+	vpand128(M38, T9, M50); \
+	vpand128(M37, T17, M51); \
+	vpand128(M42, T15, M52); \
+	vpand128(M45, T27, M53); \
+	vpand128(M41, T10, M54); \
+	vpand128(M44, T13, M55); \
+	vpand128(M40, T23, M56); \
+	vpand128(M39, T19, M57); \
+	vpand128(M43, T3, M58); \
+	vpand128(M38, T22, M59); \
+	vpand128(M37, T20, M60); \
+	vpand128(M42, T1, M61); \
+	vpand128(M45, T4, M62); \
+	vpand128(M41, T2, M63); \
+	\
+	/* bottom linear layer + output affine transform */ \
+	vpxor128(M47, M53, b0); \
+	vpxor128(M49, M51, b1); \
+	vpxor128(M52, M54, b2); \
+	vpxor128(M46, M62, b3); \
+	vpxor128(M57, b0, b4); \
+	vpxor128(M58, b1, b5); \
+	vpxor128(M61, b2, b6); \
+	vpxor128(M48, M60, b7); \
+	vpxor128(M52, M63, b8); \
+	vpxor128(M54, M55, b9); \
+	vpxor128(M55, M56, b10); \
+	vpxor128(M59, b5, b11); \
+	vpxor128(M62, b6, b12); \
+	vpxor128(b3, b4, b13); \
+	vpxor128(M46, M48, b14); \
+	vpxor128(M47, M50, b15); \
+	vpxor128(M51, b3, b16); \
+	vpxor128(M56, b8, b17); \
+	vpxor128(M58, b4, b18); \
+	vpxor128(M61, b0, b19); \
+	vpxor128(M63, b9, b20); \
+	vpxor128(b1, b10, b21); \
+	vpxor128(b2, b14, b22); \
+	vpxor128(b5, b7, b23); \
+	vpxor128(b6, b10, b24); \
+	vpxor128(b7, b9, b25); \
+	vpxor128(b8, b19, b26); \
+	vpxor128(b11, b12, b27); \
+	vpxor128(b11, b13, b28); \
+	vpxor128(b12, b21, b29); \
+	vpxor128(b13, b17, b30); \
+	vpxor128(b15, b16, b31); \
+	vpxor128(b18, b25, b32); \
+	vpxor128(b20, b28, b33); \
+	vpxor128(b23, b26, b34); \
+	vpxor128(b24, b31, b35); \
+	\
+	/* output affine transform, constant part (⊕ 0x6e) */ \
+	vmovdqa128(b27, x0); \
+	vpxor128(ones, b33, x1); \
+	vpxor128(ones, b30, x2); \
+	vpxor128(ones, b32, x3); \
+	vmovdqa128(b22, x4); \
+	vpxor128(ones, b29, x5); \
+	vpxor128(ones, b35, x6); \
+	vmovdqa128(b34, x7); \
+	})
+
+#endif /* USE_BITSLICED_SBOX */
+
 /**********************************************************************
   helper macros
  **********************************************************************/
@@ -553,6 +871,18 @@ typedef __m128i __m128i_mem;
 	memory_barrier_with_vec(__tmp); \
 	vmovdqa128_memst(__tmp, &constant ## _stack); })
 
+#if defined(USE_GFNI) || defined(USE_BITSLICED_SBOX)
+
+#define prepare_frequent_constants() \
+	prepare_frequent_const(pack_bswap); \
+	prepare_frequent_const(shufb_16x16b)
+
+#define frequent_constants_declare \
+	__m128i_mem pack_bswap_stack; \
+	__m128i_mem shufb_16x16b_stack
+
+#else /* USE_GFNI || USE_BITSLICED_SBOX */
+
 #define prepare_frequent_constants() \
 	prepare_frequent_const(inv_shift_row); \
 	prepare_frequent_const(pack_bswap); \
@@ -585,10 +915,218 @@ typedef __m128i __m128i_mem;
 	__m128i_mem post_tf_lo_s2_stack; \
 	__m128i_mem post_tf_hi_s2_stack
 
+#endif /* USE_GFNI || USE_BITSLICED_SBOX */
+
 /**********************************************************************
   16-way camellia macros
  **********************************************************************/
 
+#ifdef USE_GFNI
+
+/*
+ * GFNI version of round function.
+ *
+ * IN:
+ *   x0..x7: byte-sliced AB state
+ *   mem_cd: register pointer storing CD state
+ *   key: index for key material
+ * OUT:
+ *   x0..x7: new byte-sliced CD state
+ */
+#define roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, t0, t1, t2, t3, t4, t5, t6, \
+		  t7, mem_cd, key) \
+	/* \
+	 * S-function with GFNI \
+	 */ \
+	vpbroadcastq128(pre_filter_bitmatrix_s123, t5); \
+	vpbroadcastq128(pre_filter_bitmatrix_s4, t2); \
+	vpbroadcastq128(post_filter_bitmatrix_s14, t4); \
+	vpbroadcastq128(post_filter_bitmatrix_s2, t3); \
+	vpbroadcastq128(post_filter_bitmatrix_s3, t7); \
+	vmovq128_amemld(&(key), t0); \
+	\
+	/* prefilter sboxes */ \
+	vgf2p8affineqb128(pre_filter_constant_s1234, t5, x0, x0); \
+	vgf2p8affineqb128(pre_filter_constant_s1234, t5, x7, x7); \
+	vgf2p8affineqb128(pre_filter_constant_s1234, t2, x3, x3); \
+	vgf2p8affineqb128(pre_filter_constant_s1234, t2, x6, x6); \
+	vgf2p8affineqb128(pre_filter_constant_s1234, t5, x2, x2); \
+	vgf2p8affineqb128(pre_filter_constant_s1234, t5, x5, x5); \
+	vgf2p8affineqb128(pre_filter_constant_s1234, t5, x1, x1); \
+	vgf2p8affineqb128(pre_filter_constant_s1234, t5, x4, x4); \
+	\
+	/* sbox GF8 inverse + postfilter sboxes 1 and 4 */ \
+	vgf2p8affineinvqb128(post_filter_constant_s14, t4, x0, x0); \
+	vgf2p8affineinvqb128(post_filter_constant_s14, t4, x7, x7); \
+	vgf2p8affineinvqb128(post_filter_constant_s14, t4, x3, x3); \
+	vgf2p8affineinvqb128(post_filter_constant_s14, t4, x6, x6); \
+	\
+	/* sbox GF8 inverse + postfilter sbox 3 */ \
+	vgf2p8affineinvqb128(post_filter_constant_s3, t7, x2, x2); \
+	vgf2p8affineinvqb128(post_filter_constant_s3, t7, x5, x5); \
+	\
+	/* sbox GF8 inverse + postfilter sbox 2 */ \
+	vgf2p8affineinvqb128(post_filter_constant_s2, t3, x1, x1); \
+	vgf2p8affineinvqb128(post_filter_constant_s2, t3, x4, x4); \
+	\
+	/* P-function */ \
+	vpxor128(x5, x0, x0); \
+	vpxor128(x6, x1, x1); \
+	vpxor128(x7, x2, x2); \
+	vpxor128(x4, x3, x3); \
+	\
+	vpxor128(x2, x4, x4); \
+	vpxor128(x3, x5, x5); \
+	vpxor128(x0, x6, x6); \
+	vpxor128(x1, x7, x7); \
+	\
+	vpxor128(x7, x0, x0); \
+	vpxor128(x4, x1, x1); \
+	vpxor128(x5, x2, x2); \
+	vpxor128(x6, x3, x3); \
+	\
+	vpxor128(x3, x4, x4); \
+	vpxor128(x0, x5, x5); \
+	vpxor128(x1, x6, x6); \
+	vpxor128(x2, x7, x7); /* note: high and low parts swapped */ \
+	\
+	/* Add key material and result to CD (x becomes new CD) */ \
+	\
+	vpshufb128_amemld(&bcast[7], t0, t7); \
+	vpshufb128_amemld(&bcast[6], t0, t6); \
+	vpshufb128_amemld(&bcast[5], t0, t5); \
+	vpshufb128_amemld(&bcast[4], t0, t4); \
+	vpshufb128_amemld(&bcast[3], t0, t3); \
+	vpshufb128_amemld(&bcast[2], t0, t2); \
+	vpshufb128_amemld(&bcast[1], t0, t1); \
+	\
+	vpxor128(t3, x4, x4); \
+	vpxor128_amemld(&mem_cd[0], x4, x4); \
+	\
+	load_zero(t3); \
+	vpshufb128(t3, t0, t0); \
+	\
+	vpxor128(t2, x5, x5); \
+	vpxor128_amemld(&mem_cd[1], x5, x5); \
+	\
+	vpxor128(t1, x6, x6); \
+	vpxor128_amemld(&mem_cd[2], x6, x6); \
+	\
+	vpxor128(t0, x7, x7); \
+	vpxor128_amemld(&mem_cd[3], x7, x7); \
+	\
+	vpxor128(t7, x0, x0); \
+	vpxor128_amemld(&mem_cd[4], x0, x0); \
+	\
+	vpxor128(t6, x1, x1); \
+	vpxor128_amemld(&mem_cd[5], x1, x1); \
+	\
+	vpxor128(t5, x2, x2); \
+	vpxor128_amemld(&mem_cd[6], x2, x2); \
+	\
+	vpxor128(t4, x3, x3); \
+	vpxor128_amemld(&mem_cd[7], x3, x3);
+
+#elif defined(USE_BITSLICED_SBOX)
+
+/*
+ * Bitsliced version of round function.
+ *
+ * IN:
+ *   x0..x7: byte-sliced AB state
+ *   mem_cd: register pointer storing CD state
+ *   key: index for key material
+ * OUT:
+ *   x0..x7: new byte-sliced CD state
+ */
+#define roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, t0, t1, t2, t3, t4, t5, t6, \
+		  t7, mem_cd, key) \
+	/* \
+	 * S-function with bitsliced sbox circuit \
+	 */ \
+	vmovdqa128_memld(&bitslice_mask_01, t1); \
+	vmovdqa128_memld(&bitslice_mask_7f, t2); \
+	\
+	/* input rotation for sbox4 (<<< 1) */ \
+	bitslice_rol1_byte(x3, x3, t0, t1); \
+	bitslice_rol1_byte(x6, x6, t0, t1); \
+	\
+	/* sbox1 for all bytes, in bit-sliced form */ \
+	bitslice_transpose_8x8(x0, x1, x2, x3, x4, x5, x6, x7, t0); \
+	vmovdqa128_memld(&bitslice_ones, t3); \
+	bitslice_sbox1(x0, x1, x2, x3, x4, x5, x6, x7, t3); \
+	bitslice_transpose_8x8(x0, x1, x2, x3, x4, x5, x6, x7, t0); \
+	\
+	/* output rotation for sbox2 (<<< 1) */ \
+	bitslice_rol1_byte(x1, x1, t0, t1); \
+	bitslice_rol1_byte(x4, x4, t0, t1); \
+	\
+	/* output rotation for sbox3 (>>> 1) */ \
+	bitslice_ror1_byte(x2, x2, t0, t1, t2); \
+	bitslice_ror1_byte(x5, x5, t0, t1, t2); \
+	\
+	vmovq128_amemld(&(key), t0); \
+	\
+	/* P-function */ \
+	vpxor128(x5, x0, x0); \
+	vpxor128(x6, x1, x1); \
+	vpxor128(x7, x2, x2); \
+	vpxor128(x4, x3, x3); \
+	\
+	vpxor128(x2, x4, x4); \
+	vpxor128(x3, x5, x5); \
+	vpxor128(x0, x6, x6); \
+	vpxor128(x1, x7, x7); \
+	\
+	vpxor128(x7, x0, x0); \
+	vpxor128(x4, x1, x1); \
+	vpxor128(x5, x2, x2); \
+	vpxor128(x6, x3, x3); \
+	\
+	vpxor128(x3, x4, x4); \
+	vpxor128(x0, x5, x5); \
+	vpxor128(x1, x6, x6); \
+	vpxor128(x2, x7, x7); /* note: high and low parts swapped */ \
+	\
+	/* Add key material and result to CD (x becomes new CD) */ \
+	\
+	vpshufb128_amemld(&bcast[7], t0, t7); \
+	vpshufb128_amemld(&bcast[6], t0, t6); \
+	vpshufb128_amemld(&bcast[5], t0, t5); \
+	vpshufb128_amemld(&bcast[4], t0, t4); \
+	vpshufb128_amemld(&bcast[3], t0, t3); \
+	vpshufb128_amemld(&bcast[2], t0, t2); \
+	vpshufb128_amemld(&bcast[1], t0, t1); \
+	\
+	vpxor128(t3, x4, x4); \
+	vpxor128_amemld(&mem_cd[0], x4, x4); \
+	\
+	load_zero(t3); \
+	vpshufb128(t3, t0, t0); \
+	\
+	vpxor128(t2, x5, x5); \
+	vpxor128_amemld(&mem_cd[1], x5, x5); \
+	\
+	vpxor128(t1, x6, x6); \
+	vpxor128_amemld(&mem_cd[2], x6, x6); \
+	\
+	vpxor128(t0, x7, x7); \
+	vpxor128_amemld(&mem_cd[3], x7, x7); \
+	\
+	vpxor128(t7, x0, x0); \
+	vpxor128_amemld(&mem_cd[4], x0, x0); \
+	\
+	vpxor128(t6, x1, x1); \
+	vpxor128_amemld(&mem_cd[5], x1, x1); \
+	\
+	vpxor128(t5, x2, x2); \
+	vpxor128_amemld(&mem_cd[6], x2, x2); \
+	\
+	vpxor128(t4, x3, x3); \
+	vpxor128_amemld(&mem_cd[7], x3, x3);
+
+#else /* USE_GFNI */
+
 /*
  * IN:
  *   x0..x7: byte-sliced AB state
@@ -736,6 +1274,8 @@ typedef __m128i __m128i_mem;
 	vpxor128(t4, x3, x3); \
 	vpxor128_amemld(&mem_cd[7], x3, x3);
 
+#endif /* USE_GFNI */
+
 /*
  * IN/OUT:
  *  x0..x7: byte-sliced AB state preloaded
@@ -1013,6 +1553,30 @@ typedef __m128i __m128i_mem;
 	vpxor128_memld((rio) + 14 * 16, x0, x1); \
 	vpxor128_memld((rio) + 15 * 16, x0, x0);
 
+/* load blocks from IV and from RIO shifted by one block (IV, RIO[0], ...,
+ * RIO[14]) and apply pre-whitening, for CFB decryption */
+#define inpack16_pre_shifted(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			     y4, y5, y6, y7, iv, rio, key) \
+	vmovq128_amemld(&(key), x0); \
+	vpshufb128_amemld(&pack_bswap_stack, x0, x0); \
+	\
+	vpxor128_memld(iv, x0, y7); \
+	vpxor128_memld((rio) + 0 * 16, x0, y6); \
+	vpxor128_memld((rio) + 1 * 16, x0, y5); \
+	vpxor128_memld((rio) + 2 * 16, x0, y4); \
+	vpxor128_memld((rio) + 3 * 16, x0, y3); \
+	vpxor128_memld((rio) + 4 * 16, x0, y2); \
+	vpxor128_memld((rio) + 5 * 16, x0, y1); \
+	vpxor128_memld((rio) + 6 * 16, x0, y0); \
+	vpxor128_memld((rio) + 7 * 16, x0, x7); \
+	vpxor128_memld((rio) + 8 * 16, x0, x6); \
+	vpxor128_memld((rio) + 9 * 16, x0, x5); \
+	vpxor128_memld((rio) + 10 * 16, x0, x4); \
+	vpxor128_memld((rio) + 11 * 16, x0, x3); \
+	vpxor128_memld((rio) + 12 * 16, x0, x2); \
+	vpxor128_memld((rio) + 13 * 16, x0, x1); \
+	vpxor128_memld((rio) + 14 * 16, x0, x0);
+
 /* byteslice pre-whitened blocks and store to temporary memory */
 #define inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
 		      y6, y7, mem_ab, mem_cd) \
@@ -1083,34 +1647,365 @@ typedef __m128i __m128i_mem;
 	vmovdqu128_memst(y6, (rio) + 14 * 16); \
 	vmovdqu128_memst(y7, (rio) + 15 * 16);
 
-/**********************************************************************
-  macros for defining constant vectors
- **********************************************************************/
-#define SWAP_LE64(x) (x)
+/* xor blocks with blocks from memory and store result */
+#define write_output_xor(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, rio, xio) \
+	vpxor128_memld((xio) + 0 * 16, x0, x0); \
+	vmovdqu128_memst(x0, (rio) + 0 * 16); \
+	vpxor128_memld((xio) + 1 * 16, x1, x1); \
+	vmovdqu128_memst(x1, (rio) + 1 * 16); \
+	vpxor128_memld((xio) + 2 * 16, x2, x2); \
+	vmovdqu128_memst(x2, (rio) + 2 * 16); \
+	vpxor128_memld((xio) + 3 * 16, x3, x3); \
+	vmovdqu128_memst(x3, (rio) + 3 * 16); \
+	vpxor128_memld((xio) + 4 * 16, x4, x4); \
+	vmovdqu128_memst(x4, (rio) + 4 * 16); \
+	vpxor128_memld((xio) + 5 * 16, x5, x5); \
+	vmovdqu128_memst(x5, (rio) + 5 * 16); \
+	vpxor128_memld((xio) + 6 * 16, x6, x6); \
+	vmovdqu128_memst(x6, (rio) + 6 * 16); \
+	vpxor128_memld((xio) + 7 * 16, x7, x7); \
+	vmovdqu128_memst(x7, (rio) + 7 * 16); \
+	vpxor128_memld((xio) + 8 * 16, y0, y0); \
+	vmovdqu128_memst(y0, (rio) + 8 * 16); \
+	vpxor128_memld((xio) + 9 * 16, y1, y1); \
+	vmovdqu128_memst(y1, (rio) + 9 * 16); \
+	vpxor128_memld((xio) + 10 * 16, y2, y2); \
+	vmovdqu128_memst(y2, (rio) + 10 * 16); \
+	vpxor128_memld((xio) + 11 * 16, y3, y3); \
+	vmovdqu128_memst(y3, (rio) + 11 * 16); \
+	vpxor128_memld((xio) + 12 * 16, y4, y4); \
+	vmovdqu128_memst(y4, (rio) + 12 * 16); \
+	vpxor128_memld((xio) + 13 * 16, y5, y5); \
+	vmovdqu128_memst(y5, (rio) + 13 * 16); \
+	vpxor128_memld((xio) + 14 * 16, y6, y6); \
+	vmovdqu128_memst(y6, (rio) + 14 * 16); \
+	vpxor128_memld((xio) + 15 * 16, y7, y7); \
+	vmovdqu128_memst(y7, (rio) + 15 * 16);
 
-#define M128I_BYTE(a0, a1, a2, a3, a4, a5, a6, a7, b0, b1, b2, b3, b4, b5, b6, b7) \
-	{ \
-	  SWAP_LE64((((a0) & 0xffULL) << 0) | \
-		    (((a1) & 0xffULL) << 8) | \
-		    (((a2) & 0xffULL) << 16) | \
-		    (((a3) & 0xffULL) << 24) | \
-		    (((a4) & 0xffULL) << 32) | \
-		    (((a5) & 0xffULL) << 40) | \
-		    (((a6) & 0xffULL) << 48) | \
-		    (((a7) & 0xffULL) << 56)), \
-	  SWAP_LE64((((b0) & 0xffULL) << 0) | \
-		    (((b1) & 0xffULL) << 8) | \
-		    (((b2) & 0xffULL) << 16) | \
-		    (((b3) & 0xffULL) << 24) | \
-		    (((b4) & 0xffULL) << 32) | \
-		    (((b5) & 0xffULL) << 40) | \
-		    (((b6) & 0xffULL) << 48) | \
-		    (((b7) & 0xffULL) << 56)) \
-	}
+/* load blocks from RIO, apply pre-whitening and xor with blocks from XIO */
+#define inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, rio, xio, key) \
+	vmovq128_amemld(&(key), x0); \
+	vpshufb128_amemld(&pack_bswap_stack, x0, x0); \
+	\
+	vpxor128_memld((xio) + 0 * 16, x0, y7); \
+	vpxor128_memld((rio) + 0 * 16, y7, y7); \
+	vpxor128_memld((xio) + 1 * 16, x0, y6); \
+	vpxor128_memld((rio) + 1 * 16, y6, y6); \
+	vpxor128_memld((xio) + 2 * 16, x0, y5); \
+	vpxor128_memld((rio) + 2 * 16, y5, y5); \
+	vpxor128_memld((xio) + 3 * 16, x0, y4); \
+	vpxor128_memld((rio) + 3 * 16, y4, y4); \
+	vpxor128_memld((xio) + 4 * 16, x0, y3); \
+	vpxor128_memld((rio) + 4 * 16, y3, y3); \
+	vpxor128_memld((xio) + 5 * 16, x0, y2); \
+	vpxor128_memld((rio) + 5 * 16, y2, y2); \
+	vpxor128_memld((xio) + 6 * 16, x0, y1); \
+	vpxor128_memld((rio) + 6 * 16, y1, y1); \
+	vpxor128_memld((xio) + 7 * 16, x0, y0); \
+	vpxor128_memld((rio) + 7 * 16, y0, y0); \
+	vpxor128_memld((xio) + 8 * 16, x0, x7); \
+	vpxor128_memld((rio) + 8 * 16, x7, x7); \
+	vpxor128_memld((xio) + 9 * 16, x0, x6); \
+	vpxor128_memld((rio) + 9 * 16, x6, x6); \
+	vpxor128_memld((xio) + 10 * 16, x0, x5); \
+	vpxor128_memld((rio) + 10 * 16, x5, x5); \
+	vpxor128_memld((xio) + 11 * 16, x0, x4); \
+	vpxor128_memld((rio) + 11 * 16, x4, x4); \
+	vpxor128_memld((xio) + 12 * 16, x0, x3); \
+	vpxor128_memld((rio) + 12 * 16, x3, x3); \
+	vpxor128_memld((xio) + 13 * 16, x0, x2); \
+	vpxor128_memld((rio) + 13 * 16, x2, x2); \
+	vpxor128_memld((xio) + 14 * 16, x0, x1); \
+	vpxor128_memld((rio) + 14 * 16, x1, x1); \
+	vpxor128_memld((xio) + 15 * 16, x0, x0); \
+	vpxor128_memld((rio) + 15 * 16, x0, x0);
 
-#define PSHUFD_MASK_TO_PSHUFB_MASK(m32) \
-	M128I_BYTE(((((m32) >> 0) & 0x03) * 4) + 0, \
-		   ((((m32) >> 0) & 0x03) * 4) + 1, \
+/* Multiply XTS tweak A by x in GF(2^128) (little-endian, reduction
+ * polynomial x^128 + x^7 + x^2 + x + 1), result to O. */
+#define xts_gfmul_x(a, o, t0, t1) \
+	vpsrlq128(63, a, t0); \
+	vpshufd128_0x4e(t0, t0); \
+	vmovdqa128_memld(&xts_carry_to_mask, t1); \
+	vpshufb128(t0, t1, t0); \
+	vpand128_amemld(&xts_gfmul_poly, t0, t0); \
+	vpsllq128(1, a, o); \
+	vpxor128(t0, o, o);
+
+/* Generate XTS tweaks T, T*x, ..., T*x^15 from TWEAK to memory TWEAKS, and
+ * store next tweak T*x^16 back to TWEAK. */
+#define xts_gen_tweaks16(tweaks, tweak, t0, t1, t2) \
+	({ \
+	  unsigned int __i; \
+	  \
+	  vmovdqu128_memld(tweak, t0); \
+	  vmovdqa128_memst(t0, &(tweaks)[0]); \
+	  for (__i = 1; __i < 16; __i++) { \
+	    xts_gfmul_x(t0, t0, t1, t2); \
+	    vmovdqa128_memst(t0, &(tweaks)[__i]); \
+	  } \
+	  xts_gfmul_x(t0, t0, t1, t2); \
+	  vmovdqu128_memst(t0, tweak); \
+	})
+
+/* xor-fold 16 registers and xor result into SUM in memory */
+#define xor_fold16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		   y6, y7, sum) \
+	vpxor128(x1, x0, x0); \
+	vpxor128(x3, x2, x2); \
+	vpxor128(x5, x4, x4); \
+	vpxor128(x7, x6, x6); \
+	vpxor128(y1, y0, y0); \
+	vpxor128(y3, y2, y2); \
+	vpxor128(y5, y4, y4); \
+	vpxor128(y7, y6, y6); \
+	vpxor128(x2, x0, x0); \
+	vpxor128(x6, x4, x4); \
+	vpxor128(y2, y0, y0); \
+	vpxor128(y6, y4, y4); \
+	vpxor128(x4, x0, x0); \
+	vpxor128(y4, y0, y0); \
+	vpxor128(y0, x0, x0); \
+	vpxor128_memld(sum, x0, x0); \
+	vmovdqu128_memst(x0, sum);
+
+/* Generate OCB offsets O_i = O_{i-1} ^ L_{ntz(i)} for 16 blocks to memory
+ * OFFSETS, starting from OFFSET and using L pointers from LS. Last offset is
+ * stored back to OFFSET. */
+#define ocb_gen_offsets16(offsets, offset, Ls, t0) \
+	({ \
+	  unsigned int __i; \
+	  \
+	  vmovdqu128_memld(offset, t0); \
+	  for (__i = 0; __i < 16; __i++) { \
+	    vpxor128_memld((Ls)[__i], t0, t0); \
+	    vmovdqa128_memst(t0, &(offsets)[__i]); \
+	  } \
+	  vmovdqu128_memst(t0, offset); \
+	})
+
+/* xor 16 blocks from RIO into CHECKSUM in memory */
+#define ocb_checksum16(rio, checksum, t0) \
+	({ \
+	  unsigned int __i; \
+	  \
+	  vmovdqu128_memld(checksum, t0); \
+	  for (__i = 0; __i < 16; __i++) \
+	    vpxor128_memld((rio) + __i * 16, t0, t0); \
+	  vmovdqu128_memst(t0, checksum); \
+	})
+
+/* CBC decryption: xor blocks with previous ciphertext blocks from IIO (and
+ * first block with IV) and store result. Blocks are stored in reverse order,
+ * so that ciphertext is still available when RIO and IIO are same buffer. */
+#define write_output_cbc_dec(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			     y4, y5, y6, y7, rio, iio, iv) \
+	vpxor128_memld((iio) + 14 * 16, y7, y7); \
+	vmovdqu128_memst(y7, (rio) + 15 * 16); \
+	vpxor128_memld((iio) + 13 * 16, y6, y6); \
+	vmovdqu128_memst(y6, (rio) + 14 * 16); \
+	vpxor128_memld((iio) + 12 * 16, y5, y5); \
+	vmovdqu128_memst(y5, (rio) + 13 * 16); \
+	vpxor128_memld((iio) + 11 * 16, y4, y4); \
+	vmovdqu128_memst(y4, (rio) + 12 * 16); \
+	vpxor128_memld((iio) + 10 * 16, y3, y3); \
+	vmovdqu128_memst(y3, (rio) + 11 * 16); \
+	vpxor128_memld((iio) + 9 * 16, y2, y2); \
+	vmovdqu128_memst(y2, (rio) + 10 * 16); \
+	vpxor128_memld((iio) + 8 * 16, y1, y1); \
+	vmovdqu128_memst(y1, (rio) + 9 * 16); \
+	vpxor128_memld((iio) + 7 * 16, y0, y0); \
+	vmovdqu128_memst(y0, (rio) + 8 * 16); \
+	vpxor128_memld((iio) + 6 * 16, x7, x7); \
+	vmovdqu128_memst(x7, (rio) + 7 * 16); \
+	vpxor128_memld((iio) + 5 * 16, x6, x6); \
+	vmovdqu128_memst(x6, (rio) + 6 * 16); \
+	vpxor128_memld((iio) + 4 * 16, x5, x5); \
+	vmovdqu128_memst(x5, (rio) + 5 * 16); \
+	vpxor128_memld((iio) + 3 * 16, x4, x4); \
+	vmovdqu128_memst(x4, (rio) + 4 * 16); \
+	vpxor128_memld((iio) + 2 * 16, x3, x3); \
+	vmovdqu128_memst(x3, (rio) + 3 * 16); \
+	vpxor128_memld((iio) + 1 * 16, x2, x2); \
+	vmovdqu128_memst(x2, (rio) + 2 * 16); \
+	vpxor128_memld((iio) + 0 * 16, x1, x1); \
+	vmovdqu128_memst(x1, (rio) + 1 * 16); \
+	vpxor128_memld(iv, x0, x0); \
+	vmovdqu128_memst(x0, (rio) + 0 * 16);
+
+/*
+ * Generate 16 big-endian counter blocks directly in byte-sliced form and
+ * apply pre-whitening. After byte-slicing, register xN holds byte N of all
+ * blocks. When lowest counter byte does not overflow within 16 blocks, bytes
+ * 0..14 are the same for all blocks and only byte 15 varies.
+ *
+ * IN:
+ *   ctr: pointer to big-endian counter, lowest byte must be <= 0xf0
+ * OUT:
+ *   x0..x7, y0..y7: byte-sliced AB and CD state (as from inpack16_post)
+ */
+#define inpack16_ctr_bsliced(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			     y4, y5, y6, y7, ctr, key, mem_ab, mem_cd) \
+	vmovdqu128_memld(ctr, x0); \
+	vmovq128_amemld(&(key), x1); \
+	vpshufb128_amemld(&pack_bswap_stack, x1, x1); \
+	\
+	/* byte 15: counter + block index */ \
+	vpshufb128_amemld(&bcast[15], x0, y7); \
+	vpshufb128_amemld(&bcast[15], x1, y6); \
+	vmovdqa128_memld(&ctr_bsliced_add16, y5); \
+	vpaddb128(y5, y7, y7); \
+	vpxor128(y6, y7, y7); \
+	\
+	/* bytes 0..14: broadcast of whitened counter */ \
+	vpxor128(x0, x1, y6); \
+	vpshufb128_amemld(&bcast[0], y6, x0); \
+	vpshufb128_amemld(&bcast[1], y6, x1); \
+	vpshufb128_amemld(&bcast[2], y6, x2); \
+	vpshufb128_amemld(&bcast[3], y6, x3); \
+	vpshufb128_amemld(&bcast[4], y6, x4); \
+	vpshufb128_amemld(&bcast[5], y6, x5); \
+	vpshufb128_amemld(&bcast[6], y6, x6); \
+	vpshufb128_amemld(&bcast[7], y6, x7); \
+	vpshufb128_amemld(&bcast[8], y6, y0); \
+	vpshufb128_amemld(&bcast[9], y6, y1); \
+	vpshufb128_amemld(&bcast[10], y6, y2); \
+	vpshufb128_amemld(&bcast[11], y6, y3); \
+	vpshufb128_amemld(&bcast[12], y6, y4); \
+	vpshufb128_amemld(&bcast[13], y6, y5); \
+	vpshufb128_amemld(&bcast[14], y6, y6); \
+	\
+	vmovdqa128_memst(x0, &mem_ab[0]); \
+	vmovdqa128_memst(x1, &mem_ab[1]); \
+	vmovdqa128_memst(x2, &mem_ab[2]); \
+	vmovdqa128_memst(x3, &mem_ab[3]); \
+	vmovdqa128_memst(x4, &mem_ab[4]); \
+	vmovdqa128_memst(x5, &mem_ab[5]); \
+	vmovdqa128_memst(x6, &mem_ab[6]); \
+	vmovdqa128_memst(x7, &mem_ab[7]); \
+	vmovdqa128_memst(y0, &mem_cd[0]); \
+	vmovdqa128_memst(y1, &mem_cd[1]); \
+	vmovdqa128_memst(y2, &mem_cd[2]); \
+	vmovdqa128_memst(y3, &mem_cd[3]); \
+	vmovdqa128_memst(y4, &mem_cd[4]); \
+	vmovdqa128_memst(y5, &mem_cd[5]); \
+	vmovdqa128_memst(y6, &mem_cd[6]); \
+	vmovdqa128_memst(y7, &mem_cd[7]);
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state preloaded
+ *  mem_ab: byte-sliced AB state in memory
+ *  mem_cd: byte-sliced CD state in memory
+ *  lastk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: encrypted blocks, ready for write_output
+ */
+#define enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, mem_ab, mem_cd, lastk, stack_tmp0, stack_tmp1) \
+	({ \
+	  unsigned int __k = 0; \
+	  \
+	  while (1) { \
+	    enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, mem_ab, mem_cd, __k); \
+	    \
+	    if (__k == (lastk) - 8) \
+	      break; \
+	    \
+	    fls16(mem_ab, x0, x1, x2, x3, x4, x5, x6, x7, mem_cd, y0, y1, y2, \
+		  y3, y4, y5, y6, y7, &ctx->key_table[__k + 8], \
+		  &ctx->key_table[__k + 9]); \
+	    \
+	    __k += 8; \
+	  } \
+	  \
+	  /* load CD for output */ \
+	  vmovdqa128_memld(&mem_cd[0], y0); \
+	  vmovdqa128_memld(&mem_cd[1], y1); \
+	  vmovdqa128_memld(&mem_cd[2], y2); \
+	  vmovdqa128_memld(&mem_cd[3], y3); \
+	  vmovdqa128_memld(&mem_cd[4], y4); \
+	  vmovdqa128_memld(&mem_cd[5], y5); \
+	  vmovdqa128_memld(&mem_cd[6], y6); \
+	  vmovdqa128_memld(&mem_cd[7], y7); \
+	  \
+	  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		      y5, y6, y7, ctx->key_table[(lastk)], stack_tmp0, \
+		      stack_tmp1); \
+	})
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state preloaded
+ *  mem_ab: byte-sliced AB state in memory
+ *  mem_cd: byte-sliced CD state in memory
+ *  firstk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: decrypted blocks, ready for write_output
+ */
+#define dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, mem_ab, mem_cd, firstk, stack_tmp0, stack_tmp1) \
+	({ \
+	  unsigned int __k = (firstk) - 8; \
+	  \
+	  while (1) { \
+	    dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, mem_ab, mem_cd, __k); \
+	    \
+	    if (__k == 0) \
+	      break; \
+	    \
+	    fls16(mem_ab, x0, x1, x2, x3, x4, x5, x6, x7, mem_cd, y0, y1, y2, \
+		  y3, y4, y5, y6, y7, &ctx->key_table[__k + 1], \
+		  &ctx->key_table[__k]); \
+	    \
+	    __k -= 8; \
+	  } \
+	  \
+	  /* load CD for output */ \
+	  vmovdqa128_memld(&mem_cd[0], y0); \
+	  vmovdqa128_memld(&mem_cd[1], y1); \
+	  vmovdqa128_memld(&mem_cd[2], y2); \
+	  vmovdqa128_memld(&mem_cd[3], y3); \
+	  vmovdqa128_memld(&mem_cd[4], y4); \
+	  vmovdqa128_memld(&mem_cd[5], y5); \
+	  vmovdqa128_memld(&mem_cd[6], y6); \
+	  vmovdqa128_memld(&mem_cd[7], y7); \
+	  \
+	  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		      y5, y6, y7, ctx->key_table[0], stack_tmp0, stack_tmp1); \
+	})
+
+/**********************************************************************
+  macros for defining constant vectors
+ **********************************************************************/
+#define SWAP_LE64(x) (x)
+
+#define M128I_BYTE(a0, a1, a2, a3, a4, a5, a6, a7, b0, b1, b2, b3, b4, b5, b6, b7) \
+	{ \
+	  SWAP_LE64((((a0) & 0xffULL) << 0) | \
+		    (((a1) & 0xffULL) << 8) | \
+		    (((a2) & 0xffULL) << 16) | \
+		    (((a3) & 0xffULL) << 24) | \
+		    (((a4) & 0xffULL) << 32) | \
+		    (((a5) & 0xffULL) << 40) | \
+		    (((a6) & 0xffULL) << 48) | \
+		    (((a7) & 0xffULL) << 56)), \
+	  SWAP_LE64((((b0) & 0xffULL) << 0) | \
+		    (((b1) & 0xffULL) << 8) | \
+		    (((b2) & 0xffULL) << 16) | \
+		    (((b3) & 0xffULL) << 24) | \
+		    (((b4) & 0xffULL) << 32) | \
+		    (((b5) & 0xffULL) << 40) | \
+		    (((b6) & 0xffULL) << 48) | \
+		    (((b7) & 0xffULL) << 56)) \
+	}
+
+#define PSHUFD_MASK_TO_PSHUFB_MASK(m32) \
+	M128I_BYTE(((((m32) >> 0) & 0x03) * 4) + 0, \
+		   ((((m32) >> 0) & 0x03) * 4) + 1, \
 		   ((((m32) >> 0) & 0x03) * 4) + 2, \
 		   ((((m32) >> 0) & 0x03) * 4) + 3, \
 		   ((((m32) >> 2) & 0x03) * 4) + 0, \
@@ -1148,12 +2043,114 @@ static const __m128i_mem shufb_16x16b =
 static const __m128i_mem pack_bswap =
   M128I_U32(0x00010203, 0x04050607, 0x0f0f0f0f, 0x0f0f0f0f);
 
-static const __m128i_mem bcast[8] =
+static const __m128i_mem bcast[16] =
 {
   M128I_REP16(0), M128I_REP16(1), M128I_REP16(2), M128I_REP16(3),
-  M128I_REP16(4), M128I_REP16(5), M128I_REP16(6), M128I_REP16(7)
+  M128I_REP16(4), M128I_REP16(5), M128I_REP16(6), M128I_REP16(7),
+  M128I_REP16(8), M128I_REP16(9), M128I_REP16(10), M128I_REP16(11),
+  M128I_REP16(12), M128I_REP16(13), M128I_REP16(14), M128I_REP16(15)
 };
 
+/* Block index of each byte in byte-sliced register, for counter byte 15 */
+static const __m128i_mem ctr_bsliced_add16 =
+  M128I_BYTE(15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0);
+
+/* XTS tweak multiplication: carry bit (0/1) to byte mask lookup, and
+ * reduction values for carries from low and high 64-bit halves. */
+static const __m128i_mem xts_carry_to_mask =
+  M128I_BYTE(0x00, 0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+static const __m128i_mem xts_gfmul_poly =
+  M128I_BYTE(0x87, 0, 0, 0, 0, 0, 0, 0, 0x01, 0, 0, 0, 0, 0, 0, 0);
+
+#ifdef USE_GFNI
+
+/* Pre-filters and post-filters bit-matrixes for Camellia sboxes s1, s2, s3
+ * and s4.
+ *   See http://urn.fi/URN:NBN:fi:oulu-201305311409, pages 43-48.
+ *
+ * Pre-filters are directly from above source, "θ₁"/"θ₄". Post-filters are
+ * combination of function "A" (AES SubBytes affine transformation) and
+ * "ψ₁"/"ψ₂"/"ψ₃".
+ */
+
+/* Bit-matrix from "θ₁(x)" function: */
+static const uint64_t pre_filter_bitmatrix_s123 =
+	      BM8X8(BV8(1, 1, 1, 0, 1, 1, 0, 1),
+		    BV8(0, 0, 1, 1, 0, 0, 1, 0),
+		    BV8(1, 1, 0, 1, 0, 0, 0, 0),
+		    BV8(1, 0, 1, 1, 0, 0, 1, 1),
+		    BV8(0, 0, 0, 0, 1, 1, 0, 0),
+		    BV8(1, 0, 1, 0, 0, 1, 0, 0),
+		    BV8(0, 0, 1, 0, 1, 1, 0, 0),
+		    BV8(1, 0, 0, 0, 0, 1, 1, 0));
+
+/* Bit-matrix from "θ₄(x)" function: */
+static const uint64_t pre_filter_bitmatrix_s4 =
+	      BM8X8(BV8(1, 1, 0, 1, 1, 0, 1, 1),
+		    BV8(0, 1, 1, 0, 0, 1, 0, 0),
+		    BV8(1, 0, 1, 0, 0, 0, 0, 1),
+		    BV8(0, 1, 1, 0, 0, 1, 1, 1),
+		    BV8(0, 0, 0, 1, 1, 0, 0, 0),
+		    BV8(0, 1, 0, 0, 1, 0, 0, 1),
+		    BV8(0, 1, 0, 1, 1, 0, 0, 0),
+		    BV8(0, 0, 0, 0, 1, 1, 0, 1));
+
+/* Bit-matrix from "ψ₁(A(x))" function: */
+static const uint64_t post_filter_bitmatrix_s14 =
+	      BM8X8(BV8(0, 0, 0, 0, 0, 0, 0, 1),
+		    BV8(0, 1, 1, 0, 0, 1, 1, 0),
+		    BV8(1, 0, 1, 1, 1, 1, 1, 0),
+		    BV8(0, 0, 0, 1, 1, 0, 1, 1),
+		    BV8(1, 0, 0, 0, 1, 1, 1, 0),
+		    BV8(0, 1, 0, 1, 1, 1, 1, 0),
+		    BV8(0, 1, 1, 1, 1, 1, 1, 1),
+		    BV8(0, 0, 0, 1, 1, 1, 0, 0));
+
+/* Bit-matrix from "ψ₂(A(x))" function: */
+static const uint64_t post_filter_bitmatrix_s2 =
+	      BM8X8(BV8(0, 0, 0, 1, 1, 1, 0, 0),
+		    BV8(0, 0, 0, 0, 0, 0, 0, 1),
+		    BV8(0, 1, 1, 0, 0, 1, 1, 0),
+		    BV8(1, 0, 1, 1, 1, 1, 1, 0),
+		    BV8(0, 0, 0, 1, 1, 0, 1, 1),
+		    BV8(1, 0, 0, 0, 1, 1, 1, 0),
+		    BV8(0, 1, 0, 1, 1, 1, 1, 0),
+		    BV8(0, 1, 1, 1, 1, 1, 1, 1));
+
+/* Bit-matrix from "ψ₃(A(x))" function: */
+static const uint64_t post_filter_bitmatrix_s3 =
+	      BM8X8(BV8(0, 1, 1, 0, 0, 1, 1, 0),
+		    BV8(1, 0, 1, 1, 1, 1, 1, 0),
+		    BV8(0, 0, 0, 1, 1, 0, 1, 1),
+		    BV8(1, 0, 0, 0, 1, 1, 1, 0),
+		    BV8(0, 1, 0, 1, 1, 1, 1, 0),
+		    BV8(0, 1, 1, 1, 1, 1, 1, 1),
+		    BV8(0, 0, 0, 1, 1, 1, 0, 0),
+		    BV8(0, 0, 0, 0, 0, 0, 0, 1));
+
+#elif defined(USE_BITSLICED_SBOX)
+
+/* Masks for bytes to bit-planes transposes */
+static const __m128i_mem bitslice_mask_55 = M128I_REP16(0x55);
+static const __m128i_mem bitslice_mask_33 = M128I_REP16(0x33);
+static const __m128i_mem bitslice_mask_0f = M128I_REP16(0x0f);
+static const __m128i_mem bitslice_qmask_aa =
+  M128I_U32(0x00aa00aa, 0x00aa00aa, 0x00aa00aa, 0x00aa00aa);
+static const __m128i_mem bitslice_qmask_cc =
+  M128I_U32(0x0000cccc, 0x0000cccc, 0x0000cccc, 0x0000cccc);
+static const __m128i_mem bitslice_qmask_f0 =
+  M128I_U32(0xf0f0f0f0, 0x00000000, 0xf0f0f0f0, 0x00000000);
+static const __m128i_mem bitslice_qmask_lo8 =
+  M128I_U32(0x000000ff, 0x00000000, 0x000000ff, 0x00000000);
+
+/* Masks for byte rotations */
+static const __m128i_mem bitslice_mask_01 = M128I_REP16(0x01);
+static const __m128i_mem bitslice_mask_7f = M128I_REP16(0x7f);
+
+static const __m128i_mem bitslice_ones = M128I_REP16(0xff);
+
+#else /* USE_GFNI */
+
 /*
  * pre-SubByte transform
  *
@@ -1279,18 +2276,945 @@ static const __m128i_mem inv_shift_row =
 static const __m128i_mem mask_0f =
   M128I_U32(0x0f0f0f0f, 0x0f0f0f0f, 0x0f0f0f0f, 0x0f0f0f0f);
 
+#endif /* USE_GFNI */
+
+
+/* Encrypts 16 input block from IN and writes result to OUT. IN and OUT may
+ * unaligned pointers. */
+void camellia_encrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  unsigned int lastk;
+  frequent_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	       x15, in, ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
+	       x8, out);
+}
+
+/* Decrypts 16 input block from IN and writes result to OUT. IN and OUT may
+ * unaligned pointers. */
+void camellia_decrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  unsigned int firstk;
+  frequent_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	       x15, in, ctx->key_table[firstk]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
+
+  write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
+	       x8, out);
+}
+
+/* Encrypts NCHUNKS consecutive 16-block chunks from IN and writes result to
+ * OUT. IN and OUT may unaligned pointers. */
+void camellia_ecb_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, size_t nchunks)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  unsigned int lastk;
+  frequent_constants_declare;
+
+  if (nchunks == 0)
+    return;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  while (nchunks) {
+    inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		 x14, x15, in, ctx->key_table[0]);
+
+    inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		  x14, x15, ab, cd);
+
+    enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	      x15, ab, cd, lastk, tmp0, tmp1);
+
+    write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		 x9, x8, out);
+
+    in += 16 * 16;
+    out += 16 * 16;
+    nchunks--;
+  }
+}
+
+/* Decrypts NCHUNKS consecutive 16-block chunks from IN and writes result to
+ * OUT. IN and OUT may unaligned pointers. */
+void camellia_ecb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, size_t nchunks)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  unsigned int firstk;
+  frequent_constants_declare;
+
+  if (nchunks == 0)
+    return;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  while (nchunks) {
+    inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		 x14, x15, in, ctx->key_table[firstk]);
+
+    inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		  x14, x15, ab, cd);
+
+    dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	      x15, ab, cd, firstk, tmp0, tmp1);
+
+    write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		 x9, x8, out);
+
+    in += 16 * 16;
+    out += 16 * 16;
+    nchunks--;
+  }
+}
+
+/**********************************************************************
+  32-way camellia, two interleaved 16-block states (POWER)
+ **********************************************************************/
+
+#if defined(__powerpc__) && !defined(USE_BITSLICED_SBOX)
+
+/* With 64 VSX registers, AB and CD state of two 16-block halves, S-box
+ * filter tables and round temporaries all fit in registers. Two independent
+ * halves give the vector units (and two crypto pipelines on POWER9/10)
+ * independent instructions to interleave. */
+
+/* split X to nibbles and filter to O, leaving X intact */
+#define filter_8bit_copy(x, o, lo_t, hi_t, mask4bit, tmp0) \
+	split_nibbles(tmp0, o, x, mask4bit); \
+	filter_8bit_nibbles(o, tmp0, o, lo_t, hi_t, tmp0);
+
+/* Broadcast byte N of 64-bit key K to all bytes of O. */
+#define vpbroadcastb128_key(k, n, o) \
+	vpbroadcastb128((uint8_t)((k) >> ((n) * 8)), o)
+
+#define ppc32_constants_declare \
+	__m128i zero, mask4bit, pre_s1_lo, pre_s1_hi, pre_s4_lo, pre_s4_hi, \
+		post_s1_lo, post_s1_hi, post_s2_lo, post_s2_hi, post_s3_lo, \
+		post_s3_hi
+
+#define prepare_ppc32_constants() \
+	load_zero(zero); \
+	vmovdqa128_memld(&mask_0f, mask4bit); \
+	vmovdqa128_memld(&pre_tf_lo_s1, pre_s1_lo); \
+	vmovdqa128_memld(&pre_tf_hi_s1, pre_s1_hi); \
+	vmovdqa128_memld(&pre_tf_lo_s4, pre_s4_lo); \
+	vmovdqa128_memld(&pre_tf_hi_s4, pre_s4_hi); \
+	vmovdqa128_memld(&post_tf_lo_s1, post_s1_lo); \
+	vmovdqa128_memld(&post_tf_hi_s1, post_s1_hi); \
+	vmovdqa128_memld(&post_tf_lo_s2, post_s2_lo); \
+	vmovdqa128_memld(&post_tf_hi_s2, post_s2_hi); \
+	vmovdqa128_memld(&post_tf_lo_s3, post_s3_lo); \
+	vmovdqa128_memld(&post_tf_hi_s3, post_s3_hi)
+
+/*
+ * IN:
+ *   x0..x7: byte-sliced AB state, first half
+ *   u0..u7: byte-sliced AB state, second half
+ *   y0..y7: byte-sliced CD state, first half
+ *   v0..v7: byte-sliced CD state, second half
+ *   key: key material
+ * OUT:
+ *   y0..y7, v0..v7: new byte-sliced CD state
+ */
+#define roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, u5, \
+		  u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, v3, v4, \
+		  v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, s1, s2, s3, \
+		  s4, s5, s6, s7, tt0, key) \
+	/* \
+	 * S-function with AES subbytes \
+	 */ \
+	\
+	/* prefilter sboxes 1, 2 and 3 */ \
+	filter_8bit_copy(x0, t0, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(u0, s0, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(x7, t7, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(u7, s7, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(x1, t1, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(u1, s1, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(x4, t4, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(u4, s4, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(x2, t2, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(u2, s2, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(x5, t5, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	filter_8bit_copy(u5, s5, pre_s1_lo, pre_s1_hi, mask4bit, tt0); \
+	\
+	/* prefilter sbox 4 */ \
+	filter_8bit_copy(x3, t3, pre_s4_lo, pre_s4_hi, mask4bit, tt0); \
+	filter_8bit_copy(u3, s3, pre_s4_lo, pre_s4_hi, mask4bit, tt0); \
+	filter_8bit_copy(x6, t6, pre_s4_lo, pre_s4_hi, mask4bit, tt0); \
+	filter_8bit_copy(u6, s6, pre_s4_lo, pre_s4_hi, mask4bit, tt0); \
+	\
+	/* AES subbytes */ \
+	aes_subbytes(t0, t0); \
+	aes_subbytes(s0, s0); \
+	aes_subbytes(t7, t7); \
+	aes_subbytes(s7, s7); \
+	aes_subbytes(t1, t1); \
+	aes_subbytes(s1, s1); \
+	aes_subbytes(t4, t4); \
+	aes_subbytes(s4, s4); \
+	aes_subbytes(t2, t2); \
+	aes_subbytes(s2, s2); \
+	aes_subbytes(t5, t5); \
+	aes_subbytes(s5, s5); \
+	aes_subbytes(t3, t3); \
+	aes_subbytes(s3, s3); \
+	aes_subbytes(t6, t6); \
+	aes_subbytes(s6, s6); \
+	\
+	/* postfilter sboxes 1 and 4 */ \
+	filter_8bit(t0, post_s1_lo, post_s1_hi, mask4bit, tt0); \
+	filter_8bit(s0, post_s1_lo, post_s1_hi, mask4bit, tt0); \
+	filter_8bit(t7, post_s1_lo, post_s1_hi, mask4bit, tt0); \
+	filter_8bit(s7, post_s1_lo, post_s1_hi, mask4bit, tt0); \
+	filter_8bit(t3, post_s1_lo, post_s1_hi, mask4bit, tt0); \
+	filter_8bit(s3, post_s1_lo, post_s1_hi, mask4bit, tt0); \
+	filter_8bit(t6, post_s1_lo, post_s1_hi, mask4bit, tt0); \
+	filter_8bit(s6, post_s1_lo, post_s1_hi, mask4bit, tt0); \
+	\
+	/* postfilter sbox 3 */ \
+	filter_8bit(t2, post_s3_lo, post_s3_hi, mask4bit, tt0); \
+	filter_8bit(s2, post_s3_lo, post_s3_hi, mask4bit, tt0); \
+	filter_8bit(t5, post_s3_lo, post_s3_hi, mask4bit, tt0); \
+	filter_8bit(s5, post_s3_lo, post_s3_hi, mask4bit, tt0); \
+	\
+	/* postfilter sbox 2 */ \
+	filter_8bit(t1, post_s2_lo, post_s2_hi, mask4bit, tt0); \
+	filter_8bit(s1, post_s2_lo, post_s2_hi, mask4bit, tt0); \
+	filter_8bit(t4, post_s2_lo, post_s2_hi, mask4bit, tt0); \
+	filter_8bit(s4, post_s2_lo, post_s2_hi, mask4bit, tt0); \
+	\
+	/* P-function */ \
+	vpxor128(t5, t0, t0); \
+	vpxor128(s5, s0, s0); \
+	vpxor128(t6, t1, t1); \
+	vpxor128(s6, s1, s1); \
+	vpxor128(t7, t2, t2); \
+	vpxor128(s7, s2, s2); \
+	vpxor128(t4, t3, t3); \
+	vpxor128(s4, s3, s3); \
+	\
+	vpxor128(t2, t4, t4); \
+	vpxor128(s2, s4, s4); \
+	vpxor128(t3, t5, t5); \
+	vpxor128(s3, s5, s5); \
+	vpxor128(t0, t6, t6); \
+	vpxor128(s0, s6, s6); \
+	vpxor128(t1, t7, t7); \
+	vpxor128(s1, s7, s7); \
+	\
+	vpxor128(t7, t0, t0); \
+	vpxor128(s7, s0, s0); \
+	vpxor128(t4, t1, t1); \
+	vpxor128(s4, s1, s1); \
+	vpxor128(t5, t2, t2); \
+	vpxor128(s5, s2, s2); \
+	vpxor128(t6, t3, t3); \
+	vpxor128(s6, s3, s3); \
+	\
+	vpxor128(t3, t4, t4); \
+	vpxor128(s3, s4, s4); \
+	vpxor128(t0, t5, t5); \
+	vpxor128(s0, s5, s5); \
+	vpxor128(t1, t6, t6); \
+	vpxor128(s1, s6, s6); \
+	vpxor128(t2, t7, t7); /* note: high and low parts swapped */ \
+	vpxor128(s2, s7, s7); \
+	\
+	/* Add key material and result to CD */ \
+	vpbroadcastb128_key(key, 3, tt0); \
+	vpxor128(t4, y0, y0); \
+	vpxor128(s4, v0, v0); \
+	vpxor128(tt0, y0, y0); \
+	vpxor128(tt0, v0, v0); \
+	vpbroadcastb128_key(key, 2, tt0); \
+	vpxor128(t5, y1, y1); \
+	vpxor128(s5, v1, v1); \
+	vpxor128(tt0, y1, y1); \
+	vpxor128(tt0, v1, v1); \
+	vpbroadcastb128_key(key, 1, tt0); \
+	vpxor128(t6, y2, y2); \
+	vpxor128(s6, v2, v2); \
+	vpxor128(tt0, y2, y2); \
+	vpxor128(tt0, v2, v2); \
+	vpbroadcastb128_key(key, 0, tt0); \
+	vpxor128(t7, y3, y3); \
+	vpxor128(s7, v3, v3); \
+	vpxor128(tt0, y3, y3); \
+	vpxor128(tt0, v3, v3); \
+	vpbroadcastb128_key(key, 7, tt0); \
+	vpxor128(t0, y4, y4); \
+	vpxor128(s0, v4, v4); \
+	vpxor128(tt0, y4, y4); \
+	vpxor128(tt0, v4, v4); \
+	vpbroadcastb128_key(key, 6, tt0); \
+	vpxor128(t1, y5, y5); \
+	vpxor128(s1, v5, v5); \
+	vpxor128(tt0, y5, y5); \
+	vpxor128(tt0, v5, v5); \
+	vpbroadcastb128_key(key, 5, tt0); \
+	vpxor128(t2, y6, y6); \
+	vpxor128(s2, v6, v6); \
+	vpxor128(tt0, y6, y6); \
+	vpxor128(tt0, v6, v6); \
+	vpbroadcastb128_key(key, 4, tt0); \
+	vpxor128(t3, y7, y7); \
+	vpxor128(s3, v7, v7); \
+	vpxor128(tt0, y7, y7); \
+	vpxor128(tt0, v7, v7);
+
+/*
+ * IN/OUT:
+ *  x0..x7, u0..u7: byte-sliced AB state of both halves
+ *  y0..y7, v0..v7: byte-sliced CD state of both halves
+ */
+#define two_roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		      u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		      v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		      s1, s2, s3, s4, s5, s6, s7, tt0, i, dir) \
+	roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, u5, \
+		  u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, v3, v4, \
+		  v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, s1, s2, s3, \
+		  s4, s5, s6, s7, tt0, ctx->key_table[(i)]); \
+	roundsm32(y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, v3, v4, v5, \
+		  v6, v7, x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		  u5, u6, u7, t0, t1, t2, t3, t4, t5, t6, t7, s0, s1, s2, s3, \
+		  s4, s5, s6, s7, tt0, ctx->key_table[(i) + (dir)]);
+
+#define enc_rounds32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		     u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		     v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		     s1, s2, s3, s4, s5, s6, s7, tt0, i) \
+	two_roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		      u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		      v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		      s1, s2, s3, s4, s5, s6, s7, tt0, (i) + 2, 1); \
+	two_roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		      u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		      v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		      s1, s2, s3, s4, s5, s6, s7, tt0, (i) + 4, 1); \
+	two_roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		      u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		      v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		      s1, s2, s3, s4, s5, s6, s7, tt0, (i) + 6, 1);
+
+#define dec_rounds32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		     u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		     v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		     s1, s2, s3, s4, s5, s6, s7, tt0, i) \
+	two_roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		      u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		      v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		      s1, s2, s3, s4, s5, s6, s7, tt0, (i) + 7, -1); \
+	two_roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		      u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		      v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		      s1, s2, s3, s4, s5, s6, s7, tt0, (i) + 5, -1); \
+	two_roundsm32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, \
+		      u5, u6, u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, \
+		      v3, v4, v5, v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, \
+		      s1, s2, s3, s4, s5, s6, s7, tt0, (i) + 3, -1);
+
+/*
+ * IN/OUT:
+ *   l0..l7, m0..m7: byte-sliced AB state of both halves
+ *   r0..r7, q0..q7: byte-sliced CD state of both halves
+ */
+#define fls32(l0, l1, l2, l3, l4, l5, l6, l7, m0, m1, m2, m3, m4, m5, m6, \
+	      m7, r0, r1, r2, r3, r4, r5, r6, r7, q0, q1, q2, q3, q4, q5, q6, \
+	      q7, t0, t1, t2, t3, s0, s1, s2, s3, k0, k1, k2, k3, tt0, tt1, \
+	      tt2, kl, kr) \
+	/* \
+	 * t0 = kll; \
+	 * t0 &= ll; \
+	 * lr ^= rol32(t0, 1); \
+	 */ \
+	vpbroadcastb128_key(*(kl), 0, k3); \
+	vpbroadcastb128_key(*(kl), 1, k2); \
+	vpbroadcastb128_key(*(kl), 2, k1); \
+	vpbroadcastb128_key(*(kl), 3, k0); \
+	\
+	vpand128(l0, k0, t0); \
+	vpand128(m0, k0, s0); \
+	vpand128(l1, k1, t1); \
+	vpand128(m1, k1, s1); \
+	vpand128(l2, k2, t2); \
+	vpand128(m2, k2, s2); \
+	vpand128(l3, k3, t3); \
+	vpand128(m3, k3, s3); \
+	\
+	rol32_1_16(t3, t2, t1, t0, tt0, tt1, tt2, zero); \
+	rol32_1_16(s3, s2, s1, s0, tt0, tt1, tt2, zero); \
+	\
+	vpxor128(t0, l4, l4); \
+	vpxor128(s0, m4, m4); \
+	vpxor128(t1, l5, l5); \
+	vpxor128(s1, m5, m5); \
+	vpxor128(t2, l6, l6); \
+	vpxor128(s2, m6, m6); \
+	vpxor128(t3, l7, l7); \
+	vpxor128(s3, m7, m7); \
+	\
+	/* \
+	 * t2 = krr; \
+	 * t2 |= rr; \
+	 * rl ^= t2; \
+	 */ \
+	vpbroadcastb128_key(*(kr), 4, k3); \
+	vpbroadcastb128_key(*(kr), 5, k2); \
+	vpbroadcastb128_key(*(kr), 6, k1); \
+	vpbroadcastb128_key(*(kr), 7, k0); \
+	\
+	vpor128(r4, k0, t0); \
+	vpor128(q4, k0, s0); \
+	vpor128(r5, k1, t1); \
+	vpor128(q5, k1, s1); \
+	vpor128(r6, k2, t2); \
+	vpor128(q6, k2, s2); \
+	vpor128(r7, k3, t3); \
+	vpor128(q7, k3, s3); \
+	\
+	vpxor128(t0, r0, r0); \
+	vpxor128(s0, q0, q0); \
+	vpxor128(t1, r1, r1); \
+	vpxor128(s1, q1, q1); \
+	vpxor128(t2, r2, r2); \
+	vpxor128(s2, q2, q2); \
+	vpxor128(t3, r3, r3); \
+	vpxor128(s3, q3, q3); \
+	\
+	/* \
+	 * t2 = krl; \
+	 * t2 &= rl; \
+	 * rr ^= rol32(t2, 1); \
+	 */ \
+	vpbroadcastb128_key(*(kr), 0, k3); \
+	vpbroadcastb128_key(*(kr), 1, k2); \
+	vpbroadcastb128_key(*(kr), 2, k1); \
+	vpbroadcastb128_key(*(kr), 3, k0); \
+	\
+	vpand128(r0, k0, t0); \
+	vpand128(q0, k0, s0); \
+	vpand128(r1, k1, t1); \
+	vpand128(q1, k1, s1); \
+	vpand128(r2, k2, t2); \
+	vpand128(q2, k2, s2); \
+	vpand128(r3, k3, t3); \
+	vpand128(q3, k3, s3); \
+	\
+	rol32_1_16(t3, t2, t1, t0, tt0, tt1, tt2, zero); \
+	rol32_1_16(s3, s2, s1, s0, tt0, tt1, tt2, zero); \
+	\
+	vpxor128(t0, r4, r4); \
+	vpxor128(s0, q4, q4); \
+	vpxor128(t1, r5, r5); \
+	vpxor128(s1, q5, q5); \
+	vpxor128(t2, r6, r6); \
+	vpxor128(s2, q6, q6); \
+	vpxor128(t3, r7, r7); \
+	vpxor128(s3, q7, q7); \
+	\
+	/* \
+	 * t0 = klr; \
+	 * t0 |= lr; \
+	 * ll ^= t0; \
+	 */ \
+	vpbroadcastb128_key(*(kl), 4, k3); \
+	vpbroadcastb128_key(*(kl), 5, k2); \
+	vpbroadcastb128_key(*(kl), 6, k1); \
+	vpbroadcastb128_key(*(kl), 7, k0); \
+	\
+	vpor128(l4, k0, t0); \
+	vpor128(m4, k0, s0); \
+	vpor128(l5, k1, t1); \
+	vpor128(m5, k1, s1); \
+	vpor128(l6, k2, t2); \
+	vpor128(m6, k2, s2); \
+	vpor128(l7, k3, t3); \
+	vpor128(m7, k3, s3); \
+	\
+	vpxor128(t0, l0, l0); \
+	vpxor128(s0, m0, m0); \
+	vpxor128(t1, l1, l1); \
+	vpxor128(s1, m1, m1); \
+	vpxor128(t2, l2, l2); \
+	vpxor128(s2, m2, m2); \
+	vpxor128(t3, l3, l3); \
+	vpxor128(s3, m3, m3);
+
+/* load 16 blocks from RIO, apply pre-whitening and byteslice; x0..x7 get
+ * AB state and y0..y7 CD state */
+#define inpack16_regs(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		      y5, y6, y7, rio, key, stack_tmp0, stack_tmp1) \
+	inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		     y6, y7, rio, key); \
+	byteslice_16x16b_fast(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			      y4, y5, y6, y7, stack_tmp0, stack_tmp1);
+
+/* de-byteslice AB state x0..x7 and CD state y0..y7, apply post-whitening and
+ * store 16 blocks to RIO */
+#define outunpack16_regs(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, rio, key, stack_tmp0, stack_tmp1) \
+	outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		    y6, y7, key, stack_tmp0, stack_tmp1); \
+	write_output(x7, x6, x5, x4, x3, x2, x1, x0, y7, y6, y5, y4, y3, y2, \
+		     y1, y0, rio);
+
+/* Encrypts 32 input blocks from IN and writes result to OUT. IN and OUT may
+ * unaligned pointers. */
+void camellia_encrypt_32blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, y6, y7;
+  __m128i u0, u1, u2, u3, u4, u5, u6, u7, v0, v1, v2, v3, v4, v5, v6, v7;
+  __m128i t0, t1, t2, t3, t4, t5, t6, t7, s0, s1, s2, s3, s4, s5, s6, s7;
+  __m128i tt0, tt1, tt2;
+  __m128i_mem tmp0, tmp1;
+  unsigned int lastk, k;
+  frequent_constants_declare;
+  ppc32_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  inpack16_regs(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, y6,
+		y7, in + 0 * 16, ctx->key_table[0], tmp0, tmp1);
+  inpack16_regs(u0, u1, u2, u3, u4, u5, u6, u7, v0, v1, v2, v3, v4, v5, v6,
+		v7, in + 16 * 16, ctx->key_table[0], tmp0, tmp1);
+
+  prepare_ppc32_constants();
+
+  for (k = 0; ; k += 8) {
+    enc_rounds32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, u5, u6,
+		 u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, v3, v4, v5,
+		 v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, s1, s2, s3, s4,
+		 s5, s6, s7, tt0, k);
+
+    if (k == lastk - 8)
+      break;
+
+    fls32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, u5, u6, u7,
+	  y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, v3, v4, v5, v6, v7,
+	  t0, t1, t2, t3, s0, s1, s2, s3, t4, t5, t6, t7, tt0, tt1, tt2,
+	  &ctx->key_table[k + 8], &ctx->key_table[k + 9]);
+  }
+
+  outunpack16_regs(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5,
+		   y6, y7, out + 0 * 16, ctx->key_table[lastk], tmp0, tmp1);
+  outunpack16_regs(u0, u1, u2, u3, u4, u5, u6, u7, v0, v1, v2, v3, v4, v5,
+		   v6, v7, out + 16 * 16, ctx->key_table[lastk], tmp0, tmp1);
+}
+
+/* Decrypts 32 input blocks from IN and writes result to OUT. IN and OUT may
+ * unaligned pointers. */
+void camellia_decrypt_32blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, y6, y7;
+  __m128i u0, u1, u2, u3, u4, u5, u6, u7, v0, v1, v2, v3, v4, v5, v6, v7;
+  __m128i t0, t1, t2, t3, t4, t5, t6, t7, s0, s1, s2, s3, s4, s5, s6, s7;
+  __m128i tt0, tt1, tt2;
+  __m128i_mem tmp0, tmp1;
+  unsigned int firstk, k;
+  frequent_constants_declare;
+  ppc32_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  inpack16_regs(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, y6,
+		y7, in + 0 * 16, ctx->key_table[firstk], tmp0, tmp1);
+  inpack16_regs(u0, u1, u2, u3, u4, u5, u6, u7, v0, v1, v2, v3, v4, v5, v6,
+		v7, in + 16 * 16, ctx->key_table[firstk], tmp0, tmp1);
+
+  prepare_ppc32_constants();
+
+  for (k = firstk - 8; ; k -= 8) {
+    dec_rounds32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, u5, u6,
+		 u7, y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, v3, v4, v5,
+		 v6, v7, t0, t1, t2, t3, t4, t5, t6, t7, s0, s1, s2, s3, s4,
+		 s5, s6, s7, tt0, k);
+
+    if (k == 0)
+      break;
+
+    fls32(x0, x1, x2, x3, x4, x5, x6, x7, u0, u1, u2, u3, u4, u5, u6, u7,
+	  y0, y1, y2, y3, y4, y5, y6, y7, v0, v1, v2, v3, v4, v5, v6, v7,
+	  t0, t1, t2, t3, s0, s1, s2, s3, t4, t5, t6, t7, tt0, tt1, tt2,
+	  &ctx->key_table[k + 1], &ctx->key_table[k]);
+  }
+
+  outunpack16_regs(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5,
+		   y6, y7, out + 0 * 16, ctx->key_table[0], tmp0, tmp1);
+  outunpack16_regs(u0, u1, u2, u3, u4, u5, u6, u7, v0, v1, v2, v3, v4, v5,
+		   v6, v7, out + 16 * 16, ctx->key_table[0], tmp0, tmp1);
+}
+
+int have_camellia_32blks_simd128(void)
+{
+  return 1;
+}
+
+#else /* __powerpc__ */
+
+/* Other architectures do not have enough vector registers for two 16-block
+ * states (and bitsliced sbox needs all of them for one), so 32-block
+ * functions are two calls to 16-block kernel. */
+void camellia_encrypt_32blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  camellia_encrypt_16blks_simd128(ctx, vout, vin);
+  camellia_encrypt_16blks_simd128(ctx, (char *)vout + 16 * 16,
+				  (const char *)vin + 16 * 16);
+}
+
+void camellia_decrypt_32blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  camellia_decrypt_16blks_simd128(ctx, vout, vin);
+  camellia_decrypt_16blks_simd128(ctx, (char *)vout + 16 * 16,
+				  (const char *)vin + 16 * 16);
+}
+
+int have_camellia_32blks_simd128(void)
+{
+  return 0;
+}
+
+#endif /* __powerpc__ */
+
+/**********************************************************************
+  16-way camellia modes of operation
+ **********************************************************************/
+
+/* Add ADD to 128-bit big-endian counter CTR. */
+static inline void ctr_be128_add(uint8_t *ctr, unsigned int add)
+{
+  unsigned int i = 16;
+
+  while (i-- > 0 && add) {
+    add += ctr[i];
+    ctr[i] = add & 0xff;
+    add >>= 8;
+  }
+}
+
+/* Store NBLKS consecutive counter blocks starting from CTR to DST and
+ * advance CTR by NBLKS. */
+static inline void ctr_be128_blks(uint8_t *dst, uint8_t *ctr,
+				  unsigned int nblks)
+{
+  while (nblks--) {
+    ((uint64_unaligned_t *)dst)[0] = ((const uint64_unaligned_t *)ctr)[0];
+    ((uint64_unaligned_t *)dst)[1] = ((const uint64_unaligned_t *)ctr)[1];
+    ctr_be128_add(ctr, 1);
+    dst += 16;
+  }
+}
+
+/* CTR mode: Encrypts 16 counter blocks starting from 128-bit big-endian
+ * counter CTR, XORs result with 16 input blocks from IN and writes result
+ * to OUT. CTR is incremented by 16. IN and OUT may be unaligned pointers. */
+void camellia_ctr_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *vctr)
+{
+  char *out = vout;
+  const char *in = vin;
+  uint8_t *ctr = vctr;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  unsigned int lastk;
+  frequent_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  if (ctr[15] <= 0xff - 15) {
+    /* No carry from lowest counter byte, generate byte-sliced state
+     * directly. */
+    inpack16_ctr_bsliced(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11,
+			 x12, x13, x14, x15, ctr, ctx->key_table[0], ab, cd);
+    ctr_be128_add(ctr, 16);
+  } else {
+    __m128i_mem ctrblks[16];
+
+    ctr_be128_blks((uint8_t *)ctrblks, ctr, 16);
+
+    inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		 x14, x15, (const char *)ctrblks, ctx->key_table[0]);
+
+    inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		  x14, x15, ab, cd);
+  }
+
+  enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, in);
+}
+
+/* CBC mode decryption: Decrypts 16 input blocks from IN, XORs result with
+ * previous ciphertext blocks (first block with IV) and writes result to OUT.
+ * IV is updated with last ciphertext block. IN and OUT may be unaligned
+ * pointers and may point to same buffer. */
+void camellia_cbc_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *viv)
+{
+  char *out = vout;
+  const char *in = vin;
+  uint64_unaligned_t *iv = viv;
+  uint64_t iv_next[2];
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  unsigned int firstk;
+  frequent_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  /* Save last ciphertext block before it can get overwritten. */
+  iv_next[0] = ((const uint64_unaligned_t *)(in + 15 * 16))[0];
+  iv_next[1] = ((const uint64_unaligned_t *)(in + 15 * 16))[1];
+
+  inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	       x15, in, ctx->key_table[firstk]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
+
+  write_output_cbc_dec(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11,
+		       x10, x9, x8, out, in, iv);
+
+  iv[0] = iv_next[0];
+  iv[1] = iv_next[1];
+}
+
+/* CFB mode decryption: Encrypts IV and 15 first input blocks from IN,
+ * XORs result with 16 input blocks from IN and writes result to OUT. IV is
+ * updated with last ciphertext block. IN and OUT may be unaligned pointers
+ * and may point to same buffer. */
+void camellia_cfb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *viv)
+{
+  char *out = vout;
+  const char *in = vin;
+  uint64_unaligned_t *iv = viv;
+  uint64_t iv_next[2];
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  unsigned int lastk;
+  frequent_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  /* Save last ciphertext block before it can get overwritten. */
+  iv_next[0] = ((const uint64_unaligned_t *)(in + 15 * 16))[0];
+  iv_next[1] = ((const uint64_unaligned_t *)(in + 15 * 16))[1];
+
+  inpack16_pre_shifted(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12,
+		       x13, x14, x15, iv, in, ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, in);
+
+  iv[0] = iv_next[0];
+  iv[1] = iv_next[1];
+}
+
+/* XTS mode encryption: Encrypts 16 input blocks from IN with tweaks T, T*x,
+ * ..., T*x^15 (T from TWEAK) and writes result to OUT. TWEAK is updated to
+ * T*x^16. IN and OUT may be unaligned pointers and may point to same
+ * buffer. */
+void camellia_xts_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *tweak)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  __m128i_mem tweaks[16];
+  unsigned int lastk;
+  frequent_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  xts_gen_tweaks16(tweaks, tweak, x0, x1, x2);
+
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, in, (const char *)tweaks,
+		   ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, (const char *)tweaks);
+}
+
+/* XTS mode decryption: Decrypts 16 input blocks from IN with tweaks T, T*x,
+ * ..., T*x^15 (T from TWEAK) and writes result to OUT. TWEAK is updated to
+ * T*x^16. IN and OUT may be unaligned pointers and may point to same
+ * buffer. */
+void camellia_xts_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *tweak)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  __m128i_mem tweaks[16];
+  unsigned int firstk;
+  frequent_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  xts_gen_tweaks16(tweaks, tweak, x0, x1, x2);
+
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, in, (const char *)tweaks,
+		   ctx->key_table[firstk]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
 
-/* Encrypts 16 input block from IN and writes result to OUT. IN and OUT may
- * unaligned pointers. */
-void camellia_encrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
-				     const void *vin)
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, (const char *)tweaks);
+}
+
+/* OCB mode encryption: Encrypts 16 input blocks from IN with offsets
+ * O_i = O_{i-1} ^ L_{ntz(i)}, where O_0 is read from OFFSET and pointers to
+ * L_{ntz(i)} are in LS, and writes result to OUT. Plaintext blocks are
+ * XORed to CHECKSUM and OFFSET is updated to last offset. IN and OUT may be
+ * unaligned pointers and may point to same buffer. */
+void camellia_ocb_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *offset,
+				     void *checksum, const void *Ls[16])
 {
   char *out = vout;
   const char *in = vin;
   __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
   __m128i_mem ab[8], cd[8];
   __m128i_mem tmp0, tmp1;
-  unsigned int lastk, k;
+  __m128i_mem offsets[16];
+  unsigned int lastk;
   frequent_constants_declare;
 
   prepare_frequent_constants();
@@ -1300,54 +3224,40 @@ void camellia_encrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
   else
     lastk = 24;
 
-  inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-	       x15, in, ctx->key_table[0]);
-
-  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-		x15, ab, cd);
-
-  k = 0;
-  while (1) {
-    enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-	         x15, ab, cd, k);
-
-    if (k == lastk - 8)
-      break;
+  ocb_checksum16(in, checksum, x0);
 
-    fls16(ab, x0, x1, x2, x3, x4, x5, x6, x7, cd, x8, x9, x10, x11, x12, x13, x14,
-	  x15, &ctx->key_table[k + 8], &ctx->key_table[k + 9]);
+  ocb_gen_offsets16(offsets, offset, Ls, x0);
 
-    k += 8;
-  }
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, in, (const char *)offsets,
+		   ctx->key_table[0]);
 
-  /* load CD for output */
-  vmovdqa128_memld(&cd[0], x8);
-  vmovdqa128_memld(&cd[1], x9);
-  vmovdqa128_memld(&cd[2], x10);
-  vmovdqa128_memld(&cd[3], x11);
-  vmovdqa128_memld(&cd[4], x12);
-  vmovdqa128_memld(&cd[5], x13);
-  vmovdqa128_memld(&cd[6], x14);
-  vmovdqa128_memld(&cd[7], x15);
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
 
-  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-	      x15, ctx->key_table[lastk], tmp0, tmp1);
+  enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
 
-  write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
-	       x8, out);
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, (const char *)offsets);
 }
 
-/* Decrypts 16 input block from IN and writes result to OUT. IN and OUT may
- * unaligned pointers. */
-void camellia_decrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
-				     const void *vin)
+/* OCB mode decryption: Decrypts 16 input blocks from IN with offsets
+ * O_i = O_{i-1} ^ L_{ntz(i)}, where O_0 is read from OFFSET and pointers to
+ * L_{ntz(i)} are in LS, and writes result to OUT. Plaintext blocks are
+ * XORed to CHECKSUM and OFFSET is updated to last offset. IN and OUT may be
+ * unaligned pointers and may point to same buffer. */
+void camellia_ocb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *offset,
+				     void *checksum, const void *Ls[16])
 {
   char *out = vout;
   const char *in = vin;
   __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
   __m128i_mem ab[8], cd[8];
   __m128i_mem tmp0, tmp1;
-  unsigned int firstk, k;
+  __m128i_mem offsets[16];
+  unsigned int firstk;
   frequent_constants_declare;
 
   prepare_frequent_constants();
@@ -1357,47 +3267,205 @@ void camellia_decrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
   else
     firstk = 24;
 
-  inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-	       x15, in, ctx->key_table[firstk]);
+  ocb_gen_offsets16(offsets, offset, Ls, x0);
+
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, in, (const char *)offsets,
+		   ctx->key_table[firstk]);
 
   inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
 		x15, ab, cd);
 
-  k = firstk - 8;
-  while (1) {
-    dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
-		 x14, x15, ab, cd, k);
+  dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
 
-    if (k == 0)
-      break;
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, (const char *)offsets);
 
-    fls16(ab, x0, x1, x2, x3, x4, x5, x6, x7, cd, x8, x9, x10, x11, x12, x13,
-	  x14, x15, &ctx->key_table[k + 1], &ctx->key_table[k]);
+  xor_fold16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	     x15, checksum);
+}
 
-    k -= 8;
-  }
+/* OCB mode authentication: Encrypts 16 associated data blocks from ABUF
+ * with offsets O_i = O_{i-1} ^ L_{ntz(i)}, where O_0 is read from OFFSET and
+ * pointers to L_{ntz(i)} are in LS, and XORs results to SUM. OFFSET is
+ * updated to last offset. ABUF may be unaligned pointer. */
+void camellia_ocb_auth_16blks_simd128(struct camellia_simd_ctx *ctx,
+				      const void *vabuf, void *offset,
+				      void *sum, const void *Ls[16])
+{
+  const char *abuf = vabuf;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m128i_mem ab[8], cd[8];
+  __m128i_mem tmp0, tmp1;
+  __m128i_mem offsets[16];
+  unsigned int lastk;
+  frequent_constants_declare;
+
+  prepare_frequent_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
 
-  /* load CD for output */
-  vmovdqa128_memld(&cd[0], x8);
-  vmovdqa128_memld(&cd[1], x9);
-  vmovdqa128_memld(&cd[2], x10);
-  vmovdqa128_memld(&cd[3], x11);
-  vmovdqa128_memld(&cd[4], x12);
-  vmovdqa128_memld(&cd[5], x13);
-  vmovdqa128_memld(&cd[6], x14);
-  vmovdqa128_memld(&cd[7], x15);
+  ocb_gen_offsets16(offsets, offset, Ls, x0);
 
-  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-	      x15, ctx->key_table[0], tmp0, tmp1);
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, abuf, (const char *)offsets,
+		   ctx->key_table[0]);
 
-  write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
-	       x8, out);
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  xor_fold16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	     x15, sum);
 }
 
 /**********************************************************************
   1-way camellia
  **********************************************************************/
 
+#ifdef USE_GFNI
+
+/* Camellia F-function, 1-way SIMD128 with GFNI. */
+#define camellia_f_core(ab, x, t0, t1, t2, t3, t4, post_s3_bitmatrix, \
+			pre_s4_bitmatrix, pre_s123_bitmatrix, \
+			post_s2_bitmatrix, sp1mask, sp2mask, sp3mask, sp4mask, \
+			fn_out_xor, out_xor_dst) \
+	/* \
+	 * S-function with GFNI \
+	 */ \
+	\
+	/* prefilter sboxes */ \
+	vgf2p8affineqb128(pre_filter_constant_s1234, pre_s123_bitmatrix, ab, t4); \
+	vgf2p8affineqb128(pre_filter_constant_s1234, pre_s4_bitmatrix, ab, x); \
+	\
+	vpbroadcastq128(post_filter_bitmatrix_s14, t3); \
+	\
+	/* sbox GF8 inverse + postfilter sboxes s2 and s3 */ \
+	vgf2p8affineinvqb128(post_filter_constant_s2, post_s2_bitmatrix, t4, t1); \
+	vgf2p8affineinvqb128(post_filter_constant_s3, post_s3_bitmatrix, t4, t2); \
+	\
+	/* sbox GF8 inverse + postfilter sboxes s1 and s4 */ \
+	vgf2p8affineinvqb128(post_filter_constant_s14, t3, t4, t4); \
+	vgf2p8affineinvqb128(post_filter_constant_s14, t3, x, x); \
+	\
+	/* permutation */ \
+	vpshufb128(sp2mask, t1, t0); \
+	vpshufb128(sp3mask, t2, t1); \
+	vpshufb128(sp1mask, t4, t4); \
+	vpshufb128(sp4mask, x, x); \
+	\
+	vpxor128(x, t4, t4); \
+	vpxor128(t4, t0, t0); \
+	vpxor128(t1, t0, t0); \
+	vpsrldq128(8, t0, x); \
+	fn_out_xor(t0, x, out_xor_dst);
+
+#define load_camellia_f_bitmatrices(post_s3, pre_s4, pre_s123, post_s2) \
+	vpbroadcastq128(post_filter_bitmatrix_s3, post_s3); \
+	vpbroadcastq128(pre_filter_bitmatrix_s4, pre_s4); \
+	vpbroadcastq128(pre_filter_bitmatrix_s123, pre_s123); \
+	vpbroadcastq128(post_filter_bitmatrix_s2, post_s2);
+
+#define preload_camellia_f_consts() \
+	load_camellia_f_bitmatrices(x9, x10, x11, x12); \
+	vmovdqa128_memld(&sp1mask_swap32, x13); \
+	vmovdqa128_memld(&sp2mask_swap32, x14); \
+	vmovdqa128_memld(&sp3mask_swap32, x15); \
+	vmovdqa128_memld(&sp4mask_swap32, x8);
+
+#elif defined(USE_BITSLICED_SBOX)
+
+/* Camellia F-function, 1-way SIMD128 with bitsliced sbox. */
+#define camellia_f_core(ab, x, t0, t1, t2, t3, t4, ones, mask_lo8, mask_01, \
+			mask_7f, sp1mask, sp2mask, sp3mask, sp4mask, \
+			fn_out_xor, out_xor_dst) \
+	({ \
+	  __m128i p1, p2, p3, p4, p5, p6, p7; \
+	  \
+	  /* \
+	   * S-function with bitsliced sbox circuit \
+	   */ \
+	  \
+	  /* sbox1 input to low qword, sbox4 input (<<< 1) to high qword */ \
+	  bitslice_rol1_byte(ab, t1, t0, mask_01); \
+	  vpunpcklqdq128(t1, ab, t4); \
+	  \
+	  /* bytes to bit-planes */ \
+	  bitslice_transpose_8x8_qword(t4, t3); \
+	  vpsrlq128(8, t4, p1); \
+	  vpsrlq128(16, t4, p2); \
+	  vpsrlq128(24, t4, p3); \
+	  vpsrlq128(32, t4, p4); \
+	  vpsrlq128(40, t4, p5); \
+	  vpsrlq128(48, t4, p6); \
+	  vpsrlq128(56, t4, p7); \
+	  \
+	  bitslice_sbox1(t4, p1, p2, p3, p4, p5, p6, p7, ones); \
+	  \
+	  /* bit-planes to bytes */ \
+	  vpsllq128(8, p7, p7); \
+	  vpand128(mask_lo8, p6, p6); \
+	  vpor128(p6, p7, p7); \
+	  vpsllq128(8, p7, p7); \
+	  vpand128(mask_lo8, p5, p5); \
+	  vpor128(p5, p7, p7); \
+	  vpsllq128(8, p7, p7); \
+	  vpand128(mask_lo8, p4, p4); \
+	  vpor128(p4, p7, p7); \
+	  vpsllq128(8, p7, p7); \
+	  vpand128(mask_lo8, p3, p3); \
+	  vpor128(p3, p7, p7); \
+	  vpsllq128(8, p7, p7); \
+	  vpand128(mask_lo8, p2, p2); \
+	  vpor128(p2, p7, p7); \
+	  vpsllq128(8, p7, p7); \
+	  vpand128(mask_lo8, p1, p1); \
+	  vpor128(p1, p7, p7); \
+	  vpsllq128(8, p7, p7); \
+	  vpand128(mask_lo8, t4, t4); \
+	  vpor128(p7, t4, t4); \
+	  bitslice_transpose_8x8_qword(t4, t3); \
+	  \
+	  /* output rotation for sbox2 (<<< 1) */ \
+	  /* output rotation for sbox3 (>>> 1) */ \
+	  vpsrldq128(8, t4, x); \
+	  bitslice_rol1_byte(t4, t1, t0, mask_01); \
+	  bitslice_ror1_byte(t4, t2, t0, mask_01, mask_7f); \
+	  \
+	  /* permutation */ \
+	  vpshufb128(sp2mask, t1, t0); \
+	  vpshufb128(sp3mask, t2, t1); \
+	  vpshufb128(sp1mask, t4, t4); \
+	  vpshufb128(sp4mask, x, x); \
+	  \
+	  vpxor128(x, t4, t4); \
+	  vpxor128(t4, t0, t0); \
+	  vpxor128(t1, t0, t0); \
+	  vpsrldq128(8, t0, x); \
+	  fn_out_xor(t0, x, out_xor_dst); \
+	})
+
+#define load_camellia_f_bitslice_masks(ones, mask_lo8, mask_01, mask_7f) \
+	vmovdqa128_memld(&bitslice_ones, ones); \
+	vmovdqa128_memld(&bitslice_qmask_lo8, mask_lo8); \
+	vmovdqa128_memld(&bitslice_mask_01, mask_01); \
+	vmovdqa128_memld(&bitslice_mask_7f, mask_7f);
+
+#define preload_camellia_f_consts() \
+	load_camellia_f_bitslice_masks(x9, x10, x11, x12); \
+	vmovdqa128_memld(&sp1mask_swap32, x13); \
+	vmovdqa128_memld(&sp2mask_swap32, x14); \
+	vmovdqa128_memld(&sp3mask_swap32, x15); \
+	vmovdqa128_memld(&sp4mask_swap32, x8);
+
+#else /* USE_GFNI */
+
 /* Camellia F-function, 1-way SIMD128. */
 #define camellia_f_core(ab, x, t0, t1, t2, t3, t4, inv_shift_row_n_s2n3_shuffle, \
 			_0f0f0f0fmask, pre_s1lo_mask, pre_s1hi_mask, \
@@ -1462,13 +3530,6 @@ void camellia_decrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
 	vpsrldq128(8, t0, x); \
 	fn_out_xor(t0, x, out_xor_dst);
 
-#define camellia_f_xor_x(t0, x, _) \
-	vpxor128(t0, x, x);
-
-#define camellia_f_xor_cd(t0, x, cd) \
-	vpxor128(t0, cd, cd); \
-	vpxor128(x, cd, cd);
-
 #define preload_camellia_f_consts() \
 	if_not_vprolb128(vmovdqa128_memld(&inv_shift_row_and_unpcklbw_sp2n3_swap32, x9)); \
 	vmovdqa128_memld(&mask_0f, x10); \
@@ -1479,6 +3540,15 @@ void camellia_decrypt_16blks_simd128(struct camellia_simd_ctx *ctx, void *vout,
 	vmovdqa128_memld(&sp3mask_swap32, x15); \
 	vmovdqa128_memld(&sp4mask_swap32, x8);
 
+#endif /* USE_GFNI */
+
+#define camellia_f_xor_x(t0, x, _) \
+	vpxor128(t0, x, x);
+
+#define camellia_f_xor_cd(t0, x, cd) \
+	vpxor128(t0, cd, cd); \
+	vpxor128(x, cd, cd);
+
 #define do_camellia_f(ab, cd, x, t0, t1, t2, t3, t4) \
 	camellia_f_core(ab, x, t0, t1, t2, t3, t4, \
 			x9, x10, x11, x12, \
@@ -1683,6 +3753,393 @@ void camellia_decrypt_1blk_simd128(struct camellia_simd_ctx *ctx, void *out,
   }
 }
 
+/**********************************************************************
+  2-way camellia
+ **********************************************************************/
+
+#if defined(USE_GFNI) || defined(USE_BITSLICED_SBOX)
+
+/* GFNI and bitsliced sboxes: two blocks interleaved in separate registers.
+ * The bitsliced circuit already uses both 64-bit halves for one block.
+ *
+ * Apply OP to blocks 0..N-1. N is compile-time constant, so unused
+ * branches are removed and AB/CD arrays are kept in registers.
+ *
+ * Only N = 2 is used: with wider interleave, state of N blocks plus
+ * preloaded F-function constants no longer fit in 16 XMM registers and
+ * spill, and even without spills (32-register AVX-512 build) 4- and 8-way
+ * did not beat table-based code. Tails of 4 or more blocks go to 16-block
+ * (or masked 32-block) kernels instead. */
+#define for_each_blk(n, op, ...) \
+	op(0, __VA_ARGS__); \
+	if ((n) >= 2) { \
+	  op(1, __VA_ARGS__); \
+	}
+
+#define inpack_blkn(i, ab, cd, src, key) \
+	inpack_blk1(ab[i], cd[i], (const uint8_t *)(src) + (i) * 16, x2, x3, key)
+
+#define outunpack_blkn(i, ab, cd, dst, key) \
+	outunpack_blk1(ab[i], cd[i], (uint8_t *)(dst) + (i) * 16, x2, x3, key)
+
+#define roundsm_blkn(i, ab, cd, key) \
+	roundsm_blk1(ab[i], cd[i], x2, x3, x4, x5, x6, x7, key)
+
+#define fls_blkn(i, ab, cd, kll_klr, krl_krr) \
+	fls_blk1(ab[i], cd[i], x2, x3, x4, x5, kll_klr, krl_krr)
+
+/* Each round is done for all N blocks before next round, so that
+ * F-functions of independent blocks can execute in parallel. */
+#define two_roundsm_blkn(n, ab, cd, i, dir) \
+	for_each_blk(n, roundsm_blkn, ab, cd, ctx->key_table[(i)]); \
+	for_each_blk(n, roundsm_blkn, cd, ab, ctx->key_table[(i) + (dir)]);
+
+#define enc_rounds_blkn(n, ab, cd, i) \
+	two_roundsm_blkn(n, ab, cd, (i) + 2, 1); \
+	two_roundsm_blkn(n, ab, cd, (i) + 4, 1); \
+	two_roundsm_blkn(n, ab, cd, (i) + 6, 1);
+
+#define dec_rounds_blkn(n, ab, cd, i) \
+	two_roundsm_blkn(n, ab, cd, (i) + 7, -1); \
+	two_roundsm_blkn(n, ab, cd, (i) + 5, -1); \
+	two_roundsm_blkn(n, ab, cd, (i) + 3, -1);
+
+static inline __attribute__((always_inline)) void
+camellia_encrypt_blkn(struct camellia_simd_ctx *ctx, void *out, const void *in,
+		      const unsigned int n)
+{
+  __m128i ab[2], cd[2];
+  __m128i x2, x3, x4, x5, x6, x7, x8, x10, x11, x12, x13, x14, x15;
+  __m128i x9 __attribute__((unused));
+  unsigned int lastk, k;
+
+  preload_camellia_f_consts();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  for_each_blk(n, inpack_blkn, ab, cd, in, ctx->key_table[0]);
+
+  k = 0;
+  while (1) {
+    enc_rounds_blkn(n, ab, cd, k);
+
+    if (k == lastk - 8)
+      break;
+
+    for_each_blk(n, fls_blkn, ab, cd,
+		 &ctx->key_table[k + 8],
+		 &ctx->key_table[k + 9]);
+
+    k += 8;
+  }
+
+  for_each_blk(n, outunpack_blkn, ab, cd, out, ctx->key_table[lastk]);
+}
+
+static inline __attribute__((always_inline)) void
+camellia_decrypt_blkn(struct camellia_simd_ctx *ctx, void *out, const void *in,
+		      const unsigned int n)
+{
+  __m128i ab[2], cd[2];
+  __m128i x2, x3, x4, x5, x6, x7, x8, x10, x11, x12, x13, x14, x15;
+  __m128i x9 __attribute__((unused));
+  unsigned int firstk, k;
+
+  preload_camellia_f_consts();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  for_each_blk(n, inpack_blkn, ab, cd, in, ctx->key_table[firstk]);
+
+  k = firstk - 8;
+  while (1) {
+    dec_rounds_blkn(n, ab, cd, k);
+
+    if (k == 0)
+      break;
+
+    for_each_blk(n, fls_blkn, ab, cd,
+		 &ctx->key_table[k + 1],
+		 &ctx->key_table[k + 0]);
+
+    k -= 8;
+  }
+
+  for_each_blk(n, outunpack_blkn, ab, cd, out, ctx->key_table[0]);
+}
+
+#else /* USE_GFNI || USE_BITSLICED_SBOX */
+
+/* AES instruction sboxes: two blocks packed to 64-bit halves of AB and CD,
+ * so that sbox filters and AES instructions (which take most of F-function)
+ * are shared by the blocks. With AES ShiftRows, byte J of AB ends up at
+ * position of byte J ^ 8 of other half, so the blocks stay separable. */
+
+static const __m128i_mem pack_bswap_blk2 =
+  M128I_U32(0x00010203, 0x04050607, 0x08090a0b, 0x0c0d0e0f);
+
+/* P-function masks for both blocks. Each sbox output byte goes to up to two
+ * bytes of 64-bit result, selected by 'lo' and 'hi' mask; high half of mask
+ * is low half with source bytes of second block (index ^ 8). */
+static const __m128i_mem sp1mask_lo_blk2 =
+  M128I_BYTE(0xff, 0x04, 0x04, 0x04, 0xff, 0x04, 0x04, 0x04,
+	     0xff, 0x0c, 0x0c, 0x0c, 0xff, 0x0c, 0x0c, 0x0c);
+
+static const __m128i_mem sp1mask_hi_blk2 =
+  if_aes_subbytes(M128I_BYTE(0xff, 0x03, 0x03, 0x03, 0x03, 0xff, 0xff, 0x03,
+			     0xff, 0x0b, 0x0b, 0x0b, 0x0b, 0xff, 0xff, 0x0b))
+  if_not_aes_subbytes(M128I_BYTE(0xff, 0x07, 0x07, 0x07, 0x07, 0xff, 0xff, 0x07,
+				 0xff, 0x0f, 0x0f, 0x0f, 0x0f, 0xff, 0xff, 0x0f));
+
+static const __m128i_mem sp2mask_lo_blk2 =
+  if_aes_subbytes(M128I_BYTE(0x07, 0x07, 0x07, 0xff, 0x07, 0x07, 0x07, 0xff,
+			     0x0f, 0x0f, 0x0f, 0xff, 0x0f, 0x0f, 0x0f, 0xff))
+  if_not_aes_subbytes(M128I_BYTE(0x0b, 0x0b, 0x0b, 0xff, 0x0b, 0x0b, 0x0b, 0xff,
+				 0x03, 0x03, 0x03, 0xff, 0x03, 0x03, 0x03, 0xff));
+
+static const __m128i_mem sp2mask_hi_blk2 =
+  if_aes_subbytes(M128I_BYTE(0x02, 0x02, 0x02, 0xff, 0xff, 0xff, 0x02, 0x02,
+			     0x0a, 0x0a, 0x0a, 0xff, 0xff, 0xff, 0x0a, 0x0a))
+  if_not_aes_subbytes(M128I_BYTE(0x0a, 0x0a, 0x0a, 0xff, 0xff, 0xff, 0x0a, 0x0a,
+				 0x02, 0x02, 0x02, 0xff, 0xff, 0xff, 0x02, 0x02));
+
+static const __m128i_mem sp3mask_lo_blk2 =
+  if_aes_subbytes(M128I_BYTE(0x06, 0x06, 0xff, 0x06, 0x06, 0x06, 0xff, 0x06,
+			     0x0e, 0x0e, 0xff, 0x0e, 0x0e, 0x0e, 0xff, 0x0e))
+  if_not_aes_subbytes(M128I_BYTE(0x0e, 0x0e, 0xff, 0x0e, 0x0e, 0x0e, 0xff, 0x0e,
+				 0x06, 0x06, 0xff, 0x06, 0x06, 0x06, 0xff, 0x06));
+
+static const __m128i_mem sp3mask_hi_blk2 =
+  if_aes_subbytes(M128I_BYTE(0x01, 0x01, 0xff, 0x01, 0xff, 0x01, 0x01, 0xff,
+			     0x09, 0x09, 0xff, 0x09, 0xff, 0x09, 0x09, 0xff))
+  if_not_aes_subbytes(M128I_BYTE(0x0d, 0x0d, 0xff, 0x0d, 0xff, 0x0d, 0x0d, 0xff,
+				 0x05, 0x05, 0xff, 0x05, 0xff, 0x05, 0x05, 0xff));
+
+static const __m128i_mem sp4mask_lo_blk2 =
+  M128I_BYTE(0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
+	     0x08, 0xff, 0x08, 0x08, 0x08, 0x08, 0xff, 0xff);
+
+static const __m128i_mem sp4mask_hi_blk2 =
+  if_aes_subbytes(M128I_BYTE(0x05, 0xff, 0x05, 0x05, 0x05, 0xff, 0x05, 0x05,
+			     0x0d, 0xff, 0x0d, 0x0d, 0x0d, 0xff, 0x0d, 0x0d))
+  if_not_aes_subbytes(M128I_BYTE(0x01, 0xff, 0x01, 0x01, 0x01, 0xff, 0x01, 0x01,
+				 0x09, 0xff, 0x09, 0x09, 0x09, 0xff, 0x09, 0x09));
+
+/* postfilter sbox output nibbles LO/HI with tables S and permute result
+ * with masks SP to O */
+#define filter_n_perm_blk2(o, lo, hi, s, sp, t0, t1) \
+	vmovdqa128_memld(&post_tf_lo_##s, t0); \
+	vmovdqa128_memld(&post_tf_hi_##s, t1); \
+	filter_8bit_nibbles(t1, lo, hi, t0, t1, t0); \
+	vpshufb128_amemld(&sp##mask_lo_blk2, t1, o); \
+	vpshufb128_amemld(&sp##mask_hi_blk2, t1, t1); \
+	vpxor128(t1, o, o);
+
+/* Camellia F-function for 2 packed blocks; result is XORed to CD. Output
+ * rotations of sbox2 and sbox3 are done by postfilter tables, so that
+ * sbox outputs need no per-block processing. */
+#define camellia_f_core_blk2(ab, x, t0, t1, t2, t3, t4, t5, _0f0f0f0fmask, \
+			     pre_s1lo_mask, pre_s1hi_mask, cd) \
+	vmovdqa128_memld(&pre_tf_lo_s4, t0); \
+	vmovdqa128_memld(&pre_tf_hi_s4, t1); \
+	\
+	/* prefilter sboxes s1,s2,s3 */ \
+	split_nibbles(t2, x, ab, _0f0f0f0fmask); \
+	filter_8bit_nibbles(t4, t2, x, pre_s1lo_mask, pre_s1hi_mask, t3); \
+	if_not_aes_subbytes(load_zero(t3)); \
+	\
+	/* prefilter sbox s4 */ \
+	filter_8bit_nibbles(x, t2, x, t0, t1, t2); \
+	\
+	if_not_aes_subbytes(/* AES subbytes + AES shift rows */); \
+	if_not_aes_subbytes(aes_subbytes_and_shuf_and_xor(t3, t4, t4)); \
+	if_not_aes_subbytes(aes_subbytes_and_shuf_and_xor(t3, x, x)); \
+	\
+	if_aes_subbytes(/* AES subbytes */); \
+	if_aes_subbytes(aes_subbytes(t4, t4)); \
+	if_aes_subbytes(aes_subbytes(x, x)); \
+	\
+	/* postfilter and permutation, sbox s4 */ \
+	split_nibbles(t2, x, x, _0f0f0f0fmask); \
+	filter_n_perm_blk2(t5, t2, x, s1, sp4, t0, t1); \
+	\
+	/* postfilter and permutation, sboxes s1,s2,s3 */ \
+	split_nibbles(t2, t3, t4, _0f0f0f0fmask); \
+	filter_n_perm_blk2(t4, t2, t3, s1, sp1, t0, t1); \
+	vpxor128(t4, t5, t5); \
+	filter_n_perm_blk2(x, t2, t3, s2, sp2, t0, t1); \
+	filter_n_perm_blk2(t4, t2, t3, s3, sp3, t0, t1); \
+	vpxor128(t4, x, x); \
+	vpxor128(t5, cd, cd); \
+	vpxor128(x, cd, cd);
+
+#define preload_camellia_f_consts_blk2() \
+	vmovdqa128_memld(&mask_0f, x10); \
+	vmovdqa128_memld(&pre_tf_lo_s1, x11); \
+	vmovdqa128_memld(&pre_tf_hi_s1, x12);
+
+#define do_camellia_f_blk2(ab, cd, x, t0, t1, t2, t3, t4, t5) \
+	camellia_f_core_blk2(ab, x, t0, t1, t2, t3, t4, t5, x10, x11, x12, cd);
+
+#define load_key_blk2(key, o) \
+	vmovq128_amemld(&(key), o); \
+	vpunpcklqdq128(o, o, o);
+
+#define roundsm_blk2(ab, cd, key) \
+	load_key_blk2(key, x0); \
+	vpxor128(x0, cd, cd); \
+	do_camellia_f_blk2(ab, cd, x0, x1, x2, x3, x4, x5, x6);
+
+#define two_roundsm_blk2(ab, cd, i, dir) \
+	roundsm_blk2(ab, cd, ctx->key_table[(i)]); \
+	roundsm_blk2(cd, ab, ctx->key_table[(i) + (dir)]);
+
+#define enc_rounds_blk2(ab, cd, i) \
+	two_roundsm_blk2(ab, cd, (i) + 2, 1); \
+	two_roundsm_blk2(ab, cd, (i) + 4, 1); \
+	two_roundsm_blk2(ab, cd, (i) + 6, 1);
+
+#define dec_rounds_blk2(ab, cd, i) \
+	two_roundsm_blk2(ab, cd, (i) + 7, -1); \
+	two_roundsm_blk2(ab, cd, (i) + 5, -1); \
+	two_roundsm_blk2(ab, cd, (i) + 3, -1);
+
+/* FL and FL^-1 on 32-bit words of both blocks. Key words are broadcast to
+ * both 64-bit halves, and results are moved between low (ll, rl) and high
+ * (lr, rr) words with 64-bit shifts. */
+#define fls_blk2(ll_lr, rl_rr, t0, t1, t2, kll_klr, krl_krr) \
+	vmovq128_amemld(kll_klr, t1); \
+	vpunpcklqdq128(t1, t1, t1); \
+	vpand128(ll_lr, t1, t0); \
+	do_vprold(1, t0, t2); \
+	vpsllq128(32, t0, t0); \
+	vpxor128(t0, ll_lr, ll_lr); \
+	vpor128(ll_lr, t1, t1); \
+	vpsrlq128(32, t1, t1); \
+	vpxor128(t1, ll_lr, ll_lr); \
+	\
+	vmovq128_amemld(krl_krr, t1); \
+	vpunpcklqdq128(t1, t1, t1); \
+	vpor128(rl_rr, t1, t0); \
+	vpsrlq128(32, t0, t0); \
+	vpxor128(t0, rl_rr, rl_rr); \
+	vpand128(rl_rr, t1, t1); \
+	do_vprold(1, t1, t2); \
+	vpsllq128(32, t1, t1); \
+	vpxor128(t1, rl_rr, rl_rr);
+
+#define inpack_blk2(ab, cd, src, t0, t1, key) \
+	vmovdqu128_memld(src, t0); \
+	vmovdqu128_memld((const uint8_t *)(src) + 16, t1); \
+	vpunpckhqdq128(t1, t0, cd); \
+	vpunpcklqdq128(t1, t0, ab); \
+	vmovdqa128_memld(&pack_bswap_blk2, t0); \
+	vpshufb128(t0, ab, ab); \
+	vpshufb128(t0, cd, cd); \
+	load_key_blk2(key, t1); \
+	vpxor128(t1, ab, ab);
+
+#define outunpack_blk2(ab, cd, dst, t0, t1, key) \
+	load_key_blk2(key, t1); \
+	vpxor128(t1, cd, cd); \
+	vmovdqa128_memld(&pack_bswap_blk2, t0); \
+	vpshufb128(t0, ab, ab); \
+	vpshufb128(t0, cd, cd); \
+	vpunpcklqdq128(ab, cd, t0); \
+	vpunpckhqdq128(ab, cd, t1); \
+	vmovdqu128_memst(t0, dst); \
+	vmovdqu128_memst(t1, (uint8_t *)(dst) + 16);
+
+static inline __attribute__((always_inline)) void
+camellia_encrypt_blkn(struct camellia_simd_ctx *ctx, void *out, const void *in,
+		      const unsigned int n)
+{
+  __m128i ab, cd, x0, x1, x2, x3, x4, x5, x6, x10, x11, x12;
+  unsigned int lastk, k;
+
+  (void)n;
+
+  preload_camellia_f_consts_blk2();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  inpack_blk2(ab, cd, in, x0, x1, ctx->key_table[0]);
+
+  k = 0;
+  while (1) {
+    enc_rounds_blk2(ab, cd, k);
+
+    if (k == lastk - 8)
+      break;
+
+    fls_blk2(ab, cd, x0, x1, x2,
+	     &ctx->key_table[k + 8],
+	     &ctx->key_table[k + 9]);
+
+    k += 8;
+  }
+
+  outunpack_blk2(ab, cd, out, x0, x1, ctx->key_table[lastk]);
+}
+
+static inline __attribute__((always_inline)) void
+camellia_decrypt_blkn(struct camellia_simd_ctx *ctx, void *out, const void *in,
+		      const unsigned int n)
+{
+  __m128i ab, cd, x0, x1, x2, x3, x4, x5, x6, x10, x11, x12;
+  unsigned int firstk, k;
+
+  (void)n;
+
+  preload_camellia_f_consts_blk2();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  inpack_blk2(ab, cd, in, x0, x1, ctx->key_table[firstk]);
+
+  k = firstk - 8;
+  while (1) {
+    dec_rounds_blk2(ab, cd, k);
+
+    if (k == 0)
+      break;
+
+    fls_blk2(ab, cd, x0, x1, x2,
+	     &ctx->key_table[k + 1],
+	     &ctx->key_table[k + 0]);
+
+    k -= 8;
+  }
+
+  outunpack_blk2(ab, cd, out, x0, x1, ctx->key_table[0]);
+}
+
+#endif /* USE_GFNI || USE_BITSLICED_SBOX */
+
+void camellia_encrypt_2blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				    const void *in)
+{
+  camellia_encrypt_blkn(ctx, out, in, 2);
+}
+
+void camellia_decrypt_2blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				    const void *in)
+{
+  camellia_decrypt_blkn(ctx, out, in, 2);
+}
+
 /********* Key setup **********************************************************/
 
 /*
@@ -1800,10 +4257,16 @@ static void __camellia_avx_setup128(struct camellia_simd_ctx *ctx, __m128i x0)
 
   vpshufb128_amemld(&bswap128_mask, KL128, KL128);
 
+#if defined(USE_GFNI)
+  load_camellia_f_bitmatrices(x11, x13, x14, x15);
+#elif defined(USE_BITSLICED_SBOX)
+  load_camellia_f_bitslice_masks(x11, x13, x14, x15);
+#else
   if_not_vprolb128(vmovdqa128_memld(&inv_shift_row_and_unpcklbw, x11));
   vmovdqa128_memld(&mask_0f, x13);
   vmovdqa128_memld(&pre_tf_lo_s1, x14);
   vmovdqa128_memld(&pre_tf_hi_s1, x15);
+#endif
 
   /*
    * Generate KA
@@ -2158,10 +4621,16 @@ static void __camellia_avx_setup256(struct camellia_simd_ctx *ctx, __m128i x0,
   vpshufb128_amemld(&bswap128_mask, KL128, KL128);
   vpshufb128_amemld(&bswap128_mask, KR128, KR128);
 
+#if defined(USE_GFNI)
+  load_camellia_f_bitmatrices(x11, x13, x14, x15);
+#elif defined(USE_BITSLICED_SBOX)
+  load_camellia_f_bitslice_masks(x11, x13, x14, x15);
+#else
   if_not_vprolb128(vmovdqa128_memld(&inv_shift_row_and_unpcklbw, x11));
   vmovdqa128_memld(&mask_0f, x13);
   vmovdqa128_memld(&pre_tf_lo_s1, x14);
   vmovdqa128_memld(&pre_tf_hi_s1, x15);
+#endif
 
   /*
    * Generate KA
@@ -15,7 +15,12 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 #include <x86intrin.h>
+/* Kernels of this file are declared under USE_SIMD256 in camellia_simd.h. */
+#ifndef USE_SIMD256
+#define USE_SIMD256 1
+#endif
 #include "camellia_simd.h"
 
 /**********************************************************************
@@ -28,6 +33,8 @@
 
 #define vpsrld256(s, a, o)      (o = _mm256_srli_epi32(a, s))
 #define vpsrldq256(s, a, o)     (o = _mm256_srli_si256(a, s))
+#define vpsrlq256(s, a, o)      (o = _mm256_srli_epi64(a, s))
+#define vpsllq256(s, a, o)      (o = _mm256_slli_epi64(a, s))
 
 #define vpaddb256(a, b, o)      (o = _mm256_add_epi8(b, a))
 
@@ -35,6 +42,22 @@
 #define vpabsb256(a, o)         (o = _mm256_abs_epi8(a))
 
 #define vpshufb256(m, a, o)     (o = _mm256_shuffle_epi8(a, m))
+#define vpshufd256_0x4e(a, o)   (o = _mm256_shuffle_epi32(a, 0x4e))
+#define vpblendd256(m, a, b, o) (o = _mm256_blend_epi32(b, a, m))
+
+#define vpxor128(a, b, o)       (o = _mm_xor_si128(b, a))
+#define vpor128(a, b, o)        (o = _mm_or_si128(b, a))
+#define vpslld128(s, a, o)      (o = _mm_slli_epi32(a, s))
+#define vpsrld128(s, a, o)      (o = _mm_srli_epi32(a, s))
+#define vpslldq128(s, a, o)     (o = _mm_slli_si128(a, s))
+#define vpsrldq128(s, a, o)     (o = _mm_srli_si128(a, s))
+#define vpshufb128(m, a, o)     (o = _mm_shuffle_epi8(a, m))
+
+/* Carry-less multiplication for GHASH */
+#define vpclmulqdq128(i, a, b, o) (o = _mm_clmulepi64_si128(b, a, i))
+#ifdef __VPCLMULQDQ__
+ #define vpclmulqdq256(i, a, b, o) (o = _mm256_clmulepi64_epi128(b, a, i))
+#endif
 
 #define vpunpckhdq256(a, b, o)  (o = _mm256_unpackhi_epi32(b, a))
 #define vpunpckldq256(a, b, o)  (o = _mm256_unpacklo_epi32(b, a))
@@ -55,11 +78,36 @@
 #define vmovq128_si256(a, o)    (o = _mm256_set_epi64x(0, a, 0, a))
 
 #define vpbroadcastq(a, o)      (o = _mm256_set1_epi64x(a))
+#define vbroadcasti128_memld(a, o) \
+	(o = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(a))))
 
 /* Following operations may have unaligned memory input/output */
 #define vmovdqu256_memst(a, o)  _mm256_storeu_si256((__m256i *)(o), a)
+#define vmovdqu128_lo256_memst(a, o) \
+	_mm_storeu_si128((__m128i *)(o), _mm256_castsi256_si128(a))
+#define vpxor256_lanes_memxor128(a, o) \
+	_mm_storeu_si128((__m128i *)(o), \
+			 _mm_xor_si128(_mm_loadu_si128((const __m128i *)(o)), \
+				       _mm_xor_si128(_mm256_castsi256_si128(a), \
+						     _mm256_extracti128_si256(a, 1))))
 #define vpxor256_memld(a, b, o) \
 	vpxor256(b, _mm256_loadu_si256((const __m256i *)(a)), o)
+#define vpxor256_memld_2x128(lo, hi, b, o) \
+	vpxor256(b, _mm256_inserti128_si256(_mm256_castsi128_si256( \
+		   _mm_loadu_si128((const __m128i *)(lo))), \
+		 _mm_loadu_si128((const __m128i *)(hi)), 1), o)
+#define vmovdqu256_memst_2x128(a, lo, hi) \
+	_mm_storeu_si128((__m128i *)(lo), _mm256_castsi256_si128(a)); \
+	_mm_storeu_si128((__m128i *)(hi), _mm256_extracti128_si256(a, 1))
+
+/* AVX512BW/VL byte-masked loads and stores, for partial 32-block batches */
+#if defined(__AVX512BW__) && defined(__AVX512VL__)
+ #define HAVE_MASKED_MEMOPS 1
+ #define vpxor256_memld_mask(a, m, b, o) \
+	vpxor256(b, _mm256_maskz_loadu_epi8(m, (const void *)(a)), o)
+ #define vmovdqu256_memst_mask(a, m, o) \
+	_mm256_mask_storeu_epi8((void *)(o), m, a)
+#endif
 
 #ifndef USE_GFNI
   /* Macros for exposing SubBytes from AES-NI/VAES instruction sets. */
@@ -700,6 +748,106 @@
 	vpxor256_memld((rio) + 14 * 32, x0, x1); \
 	vpxor256_memld((rio) + 15 * 32, x0, x0);
 
+/* load blocks from array of 32 block pointers RIO to registers and apply
+ * pre-whitening */
+#define inpack16_pre_gather(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			    y4, y5, y6, y7, rio, key) \
+	vmovq128_si256((key), x0); \
+	vpshufb256(pack_bswap, x0, x0); \
+	\
+	vpxor256_memld_2x128((rio)[0], (rio)[1], x0, y7); \
+	vpxor256_memld_2x128((rio)[2], (rio)[3], x0, y6); \
+	vpxor256_memld_2x128((rio)[4], (rio)[5], x0, y5); \
+	vpxor256_memld_2x128((rio)[6], (rio)[7], x0, y4); \
+	vpxor256_memld_2x128((rio)[8], (rio)[9], x0, y3); \
+	vpxor256_memld_2x128((rio)[10], (rio)[11], x0, y2); \
+	vpxor256_memld_2x128((rio)[12], (rio)[13], x0, y1); \
+	vpxor256_memld_2x128((rio)[14], (rio)[15], x0, y0); \
+	vpxor256_memld_2x128((rio)[16], (rio)[17], x0, x7); \
+	vpxor256_memld_2x128((rio)[18], (rio)[19], x0, x6); \
+	vpxor256_memld_2x128((rio)[20], (rio)[21], x0, x5); \
+	vpxor256_memld_2x128((rio)[22], (rio)[23], x0, x4); \
+	vpxor256_memld_2x128((rio)[24], (rio)[25], x0, x3); \
+	vpxor256_memld_2x128((rio)[26], (rio)[27], x0, x2); \
+	vpxor256_memld_2x128((rio)[28], (rio)[29], x0, x1); \
+	vpxor256_memld_2x128((rio)[30], (rio)[31], x0, x0);
+
+#ifdef HAVE_MASKED_MEMOPS
+/* 32-bit byte mask for register K of 32-block batch with N valid blocks.
+ * Register K holds blocks 2*K and 2*K+1. */
+#define blk_pair_mask(n, k) \
+	((__mmask32)(((n) > 2 * (k) ? 0x0000ffffU : 0) | \
+		     ((n) > 2 * (k) + 1 ? 0xffff0000U : 0)))
+
+/* load first N blocks to registers and apply pre-whitening, missing blocks
+ * are zero */
+#define inpack16_pre_masked(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			    y4, y5, y6, y7, rio, key, n) \
+	vmovq128_si256((key), x0); \
+	vpshufb256(pack_bswap, x0, x0); \
+	\
+	vpxor256_memld_mask((rio) + 0 * 32, blk_pair_mask(n, 0), x0, y7); \
+	vpxor256_memld_mask((rio) + 1 * 32, blk_pair_mask(n, 1), x0, y6); \
+	vpxor256_memld_mask((rio) + 2 * 32, blk_pair_mask(n, 2), x0, y5); \
+	vpxor256_memld_mask((rio) + 3 * 32, blk_pair_mask(n, 3), x0, y4); \
+	vpxor256_memld_mask((rio) + 4 * 32, blk_pair_mask(n, 4), x0, y3); \
+	vpxor256_memld_mask((rio) + 5 * 32, blk_pair_mask(n, 5), x0, y2); \
+	vpxor256_memld_mask((rio) + 6 * 32, blk_pair_mask(n, 6), x0, y1); \
+	vpxor256_memld_mask((rio) + 7 * 32, blk_pair_mask(n, 7), x0, y0); \
+	vpxor256_memld_mask((rio) + 8 * 32, blk_pair_mask(n, 8), x0, x7); \
+	vpxor256_memld_mask((rio) + 9 * 32, blk_pair_mask(n, 9), x0, x6); \
+	vpxor256_memld_mask((rio) + 10 * 32, blk_pair_mask(n, 10), x0, x5); \
+	vpxor256_memld_mask((rio) + 11 * 32, blk_pair_mask(n, 11), x0, x4); \
+	vpxor256_memld_mask((rio) + 12 * 32, blk_pair_mask(n, 12), x0, x3); \
+	vpxor256_memld_mask((rio) + 13 * 32, blk_pair_mask(n, 13), x0, x2); \
+	vpxor256_memld_mask((rio) + 14 * 32, blk_pair_mask(n, 14), x0, x1); \
+	vpxor256_memld_mask((rio) + 15 * 32, blk_pair_mask(n, 15), x0, x0);
+
+/* store first N blocks, memory after them is not accessed */
+#define write_output_masked(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			    y4, y5, y6, y7, rio, n) \
+	vmovdqu256_memst_mask(x0, blk_pair_mask(n, 0), (rio) + 0 * 32); \
+	vmovdqu256_memst_mask(x1, blk_pair_mask(n, 1), (rio) + 1 * 32); \
+	vmovdqu256_memst_mask(x2, blk_pair_mask(n, 2), (rio) + 2 * 32); \
+	vmovdqu256_memst_mask(x3, blk_pair_mask(n, 3), (rio) + 3 * 32); \
+	vmovdqu256_memst_mask(x4, blk_pair_mask(n, 4), (rio) + 4 * 32); \
+	vmovdqu256_memst_mask(x5, blk_pair_mask(n, 5), (rio) + 5 * 32); \
+	vmovdqu256_memst_mask(x6, blk_pair_mask(n, 6), (rio) + 6 * 32); \
+	vmovdqu256_memst_mask(x7, blk_pair_mask(n, 7), (rio) + 7 * 32); \
+	vmovdqu256_memst_mask(y0, blk_pair_mask(n, 8), (rio) + 8 * 32); \
+	vmovdqu256_memst_mask(y1, blk_pair_mask(n, 9), (rio) + 9 * 32); \
+	vmovdqu256_memst_mask(y2, blk_pair_mask(n, 10), (rio) + 10 * 32); \
+	vmovdqu256_memst_mask(y3, blk_pair_mask(n, 11), (rio) + 11 * 32); \
+	vmovdqu256_memst_mask(y4, blk_pair_mask(n, 12), (rio) + 12 * 32); \
+	vmovdqu256_memst_mask(y5, blk_pair_mask(n, 13), (rio) + 13 * 32); \
+	vmovdqu256_memst_mask(y6, blk_pair_mask(n, 14), (rio) + 14 * 32); \
+	vmovdqu256_memst_mask(y7, blk_pair_mask(n, 15), (rio) + 15 * 32);
+#endif /* HAVE_MASKED_MEMOPS */
+
+/* load blocks from IV and from RIO shifted by one block (IV, RIO[0], ...,
+ * RIO[30]) and apply pre-whitening, for CFB decryption */
+#define inpack16_pre_shifted(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			     y4, y5, y6, y7, iv, rio, key) \
+	vmovq128_si256((key), x0); \
+	vpshufb256(pack_bswap, x0, x0); \
+	\
+	vpxor256_memld_2x128(iv, (rio) + 0 * 16, x0, y7); \
+	vpxor256_memld((rio) + 1 * 32 - 16, x0, y6); \
+	vpxor256_memld((rio) + 2 * 32 - 16, x0, y5); \
+	vpxor256_memld((rio) + 3 * 32 - 16, x0, y4); \
+	vpxor256_memld((rio) + 4 * 32 - 16, x0, y3); \
+	vpxor256_memld((rio) + 5 * 32 - 16, x0, y2); \
+	vpxor256_memld((rio) + 6 * 32 - 16, x0, y1); \
+	vpxor256_memld((rio) + 7 * 32 - 16, x0, y0); \
+	vpxor256_memld((rio) + 8 * 32 - 16, x0, x7); \
+	vpxor256_memld((rio) + 9 * 32 - 16, x0, x6); \
+	vpxor256_memld((rio) + 10 * 32 - 16, x0, x5); \
+	vpxor256_memld((rio) + 11 * 32 - 16, x0, x4); \
+	vpxor256_memld((rio) + 12 * 32 - 16, x0, x3); \
+	vpxor256_memld((rio) + 13 * 32 - 16, x0, x2); \
+	vpxor256_memld((rio) + 14 * 32 - 16, x0, x1); \
+	vpxor256_memld((rio) + 15 * 32 - 16, x0, x0);
+
 /* byteslice pre-whitened blocks and store to temporary memory */
 #define inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
 		      y6, y7, mem_ab, mem_cd) \
@@ -770,6 +918,569 @@
 	vmovdqu256_memst(y6, (rio) + 14 * 32); \
 	vmovdqu256_memst(y7, (rio) + 15 * 32);
 
+/* store blocks to array of 32 block pointers RIO */
+#define write_output_scatter(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			     y4, y5, y6, y7, rio) \
+	vmovdqu256_memst_2x128(x0, (rio)[0], (rio)[1]); \
+	vmovdqu256_memst_2x128(x1, (rio)[2], (rio)[3]); \
+	vmovdqu256_memst_2x128(x2, (rio)[4], (rio)[5]); \
+	vmovdqu256_memst_2x128(x3, (rio)[6], (rio)[7]); \
+	vmovdqu256_memst_2x128(x4, (rio)[8], (rio)[9]); \
+	vmovdqu256_memst_2x128(x5, (rio)[10], (rio)[11]); \
+	vmovdqu256_memst_2x128(x6, (rio)[12], (rio)[13]); \
+	vmovdqu256_memst_2x128(x7, (rio)[14], (rio)[15]); \
+	vmovdqu256_memst_2x128(y0, (rio)[16], (rio)[17]); \
+	vmovdqu256_memst_2x128(y1, (rio)[18], (rio)[19]); \
+	vmovdqu256_memst_2x128(y2, (rio)[20], (rio)[21]); \
+	vmovdqu256_memst_2x128(y3, (rio)[22], (rio)[23]); \
+	vmovdqu256_memst_2x128(y4, (rio)[24], (rio)[25]); \
+	vmovdqu256_memst_2x128(y5, (rio)[26], (rio)[27]); \
+	vmovdqu256_memst_2x128(y6, (rio)[28], (rio)[29]); \
+	vmovdqu256_memst_2x128(y7, (rio)[30], (rio)[31]);
+
+/* xor blocks with blocks from memory and store result */
+#define write_output_xor(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, rio, xio) \
+	vpxor256_memld((xio) + 0 * 32, x0, x0); \
+	vmovdqu256_memst(x0, (rio) + 0 * 32); \
+	vpxor256_memld((xio) + 1 * 32, x1, x1); \
+	vmovdqu256_memst(x1, (rio) + 1 * 32); \
+	vpxor256_memld((xio) + 2 * 32, x2, x2); \
+	vmovdqu256_memst(x2, (rio) + 2 * 32); \
+	vpxor256_memld((xio) + 3 * 32, x3, x3); \
+	vmovdqu256_memst(x3, (rio) + 3 * 32); \
+	vpxor256_memld((xio) + 4 * 32, x4, x4); \
+	vmovdqu256_memst(x4, (rio) + 4 * 32); \
+	vpxor256_memld((xio) + 5 * 32, x5, x5); \
+	vmovdqu256_memst(x5, (rio) + 5 * 32); \
+	vpxor256_memld((xio) + 6 * 32, x6, x6); \
+	vmovdqu256_memst(x6, (rio) + 6 * 32); \
+	vpxor256_memld((xio) + 7 * 32, x7, x7); \
+	vmovdqu256_memst(x7, (rio) + 7 * 32); \
+	vpxor256_memld((xio) + 8 * 32, y0, y0); \
+	vmovdqu256_memst(y0, (rio) + 8 * 32); \
+	vpxor256_memld((xio) + 9 * 32, y1, y1); \
+	vmovdqu256_memst(y1, (rio) + 9 * 32); \
+	vpxor256_memld((xio) + 10 * 32, y2, y2); \
+	vmovdqu256_memst(y2, (rio) + 10 * 32); \
+	vpxor256_memld((xio) + 11 * 32, y3, y3); \
+	vmovdqu256_memst(y3, (rio) + 11 * 32); \
+	vpxor256_memld((xio) + 12 * 32, y4, y4); \
+	vmovdqu256_memst(y4, (rio) + 12 * 32); \
+	vpxor256_memld((xio) + 13 * 32, y5, y5); \
+	vmovdqu256_memst(y5, (rio) + 13 * 32); \
+	vpxor256_memld((xio) + 14 * 32, y6, y6); \
+	vmovdqu256_memst(y6, (rio) + 14 * 32); \
+	vpxor256_memld((xio) + 15 * 32, y7, y7); \
+	vmovdqu256_memst(y7, (rio) + 15 * 32);
+
+/* load blocks from RIO, apply pre-whitening and xor with blocks from XIO */
+#define inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, rio, xio, key) \
+	vmovq128_si256((key), x0); \
+	vpshufb256(pack_bswap, x0, x0); \
+	\
+	vpxor256_memld((xio) + 0 * 32, x0, y7); \
+	vpxor256_memld((rio) + 0 * 32, y7, y7); \
+	vpxor256_memld((xio) + 1 * 32, x0, y6); \
+	vpxor256_memld((rio) + 1 * 32, y6, y6); \
+	vpxor256_memld((xio) + 2 * 32, x0, y5); \
+	vpxor256_memld((rio) + 2 * 32, y5, y5); \
+	vpxor256_memld((xio) + 3 * 32, x0, y4); \
+	vpxor256_memld((rio) + 3 * 32, y4, y4); \
+	vpxor256_memld((xio) + 4 * 32, x0, y3); \
+	vpxor256_memld((rio) + 4 * 32, y3, y3); \
+	vpxor256_memld((xio) + 5 * 32, x0, y2); \
+	vpxor256_memld((rio) + 5 * 32, y2, y2); \
+	vpxor256_memld((xio) + 6 * 32, x0, y1); \
+	vpxor256_memld((rio) + 6 * 32, y1, y1); \
+	vpxor256_memld((xio) + 7 * 32, x0, y0); \
+	vpxor256_memld((rio) + 7 * 32, y0, y0); \
+	vpxor256_memld((xio) + 8 * 32, x0, x7); \
+	vpxor256_memld((rio) + 8 * 32, x7, x7); \
+	vpxor256_memld((xio) + 9 * 32, x0, x6); \
+	vpxor256_memld((rio) + 9 * 32, x6, x6); \
+	vpxor256_memld((xio) + 10 * 32, x0, x5); \
+	vpxor256_memld((rio) + 10 * 32, x5, x5); \
+	vpxor256_memld((xio) + 11 * 32, x0, x4); \
+	vpxor256_memld((rio) + 11 * 32, x4, x4); \
+	vpxor256_memld((xio) + 12 * 32, x0, x3); \
+	vpxor256_memld((rio) + 12 * 32, x3, x3); \
+	vpxor256_memld((xio) + 13 * 32, x0, x2); \
+	vpxor256_memld((rio) + 13 * 32, x2, x2); \
+	vpxor256_memld((xio) + 14 * 32, x0, x1); \
+	vpxor256_memld((rio) + 14 * 32, x1, x1); \
+	vpxor256_memld((xio) + 15 * 32, x0, x0); \
+	vpxor256_memld((rio) + 15 * 32, x0, x0);
+
+/* Multiply XTS tweaks in both 128-bit lanes of A by x in GF(2^128)
+ * (little-endian, reduction polynomial x^128 + x^7 + x^2 + x + 1), result
+ * to O. */
+#define xts_gfmul_x(a, o, t0) \
+	vpsrlq256(63, a, t0); \
+	vpshufd256_0x4e(t0, t0); \
+	vpshufb256(t0, xts_carry_to_mask, t0); \
+	vpand256(xts_gfmul_poly, t0, t0); \
+	vpsllq256(1, a, o); \
+	vpxor256(t0, o, o);
+
+/* Generate XTS tweaks T, T*x, ..., T*x^31 from TWEAK to memory TWEAKS (two
+ * tweaks per 256-bit vector), and store next tweak T*x^32 back to TWEAK. */
+#define xts_gen_tweaks32(tweaks, tweak, t0, t1, t2) \
+	({ \
+	  unsigned int __i; \
+	  \
+	  vbroadcasti128_memld(tweak, t0); \
+	  xts_gfmul_x(t0, t1, t2); \
+	  vpblendd256(0xf0, t1, t0, t0); \
+	  vmovdqa256(t0, (tweaks)[0]); \
+	  for (__i = 1; __i < 16; __i++) { \
+	    xts_gfmul_x(t0, t0, t2); \
+	    xts_gfmul_x(t0, t0, t2); \
+	    vmovdqa256(t0, (tweaks)[__i]); \
+	  } \
+	  xts_gfmul_x(t0, t0, t2); \
+	  xts_gfmul_x(t0, t0, t2); \
+	  vmovdqu128_lo256_memst(t0, tweak); \
+	})
+
+/* xor-fold 16 registers and xor result into SUM in memory */
+#define xor_fold16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		   y6, y7, sum) \
+	vpxor256(x1, x0, x0); \
+	vpxor256(x3, x2, x2); \
+	vpxor256(x5, x4, x4); \
+	vpxor256(x7, x6, x6); \
+	vpxor256(y1, y0, y0); \
+	vpxor256(y3, y2, y2); \
+	vpxor256(y5, y4, y4); \
+	vpxor256(y7, y6, y6); \
+	vpxor256(x2, x0, x0); \
+	vpxor256(x6, x4, x4); \
+	vpxor256(y2, y0, y0); \
+	vpxor256(y6, y4, y4); \
+	vpxor256(x4, x0, x0); \
+	vpxor256(y4, y0, y0); \
+	vpxor256(y0, x0, x0); \
+	vpxor256_lanes_memxor128(x0, sum);
+
+/* Generate OCB offsets O_i = O_{i-1} ^ L_{ntz(i)} for 32 blocks to memory
+ * OFFSETS (two offsets per 256-bit vector), starting from OFFSET and using L
+ * pointers from LS. Last offset is stored back to OFFSET. */
+#define ocb_gen_offsets32(offsets, offset, Ls) \
+	({ \
+	  __m128i __o = _mm_loadu_si128((const __m128i *)(offset)); \
+	  unsigned int __i; \
+	  \
+	  for (__i = 0; __i < 32; __i++) { \
+	    __o = _mm_xor_si128(__o, \
+				_mm_loadu_si128((const __m128i *)(Ls)[__i])); \
+	    _mm_store_si128((__m128i *)(offsets) + __i, __o); \
+	  } \
+	  _mm_storeu_si128((__m128i *)(offset), __o); \
+	})
+
+/* xor 32 blocks from RIO into CHECKSUM in memory */
+#define ocb_checksum32(rio, checksum, t0) \
+	({ \
+	  unsigned int __i; \
+	  \
+	  load_zero(t0); \
+	  for (__i = 0; __i < 16; __i++) \
+	    vpxor256_memld((rio) + __i * 32, t0, t0); \
+	  vpxor256_lanes_memxor128(t0, checksum); \
+	})
+
+/* CBC decryption: xor blocks with previous ciphertext blocks from IIO (and
+ * first block with IV) and store result. Blocks are stored in reverse order,
+ * so that ciphertext is still available when RIO and IIO are same buffer. */
+#define write_output_cbc_dec(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			     y4, y5, y6, y7, rio, iio, iv) \
+	vpxor256_memld((iio) + 15 * 32 - 16, y7, y7); \
+	vmovdqu256_memst(y7, (rio) + 15 * 32); \
+	vpxor256_memld((iio) + 14 * 32 - 16, y6, y6); \
+	vmovdqu256_memst(y6, (rio) + 14 * 32); \
+	vpxor256_memld((iio) + 13 * 32 - 16, y5, y5); \
+	vmovdqu256_memst(y5, (rio) + 13 * 32); \
+	vpxor256_memld((iio) + 12 * 32 - 16, y4, y4); \
+	vmovdqu256_memst(y4, (rio) + 12 * 32); \
+	vpxor256_memld((iio) + 11 * 32 - 16, y3, y3); \
+	vmovdqu256_memst(y3, (rio) + 11 * 32); \
+	vpxor256_memld((iio) + 10 * 32 - 16, y2, y2); \
+	vmovdqu256_memst(y2, (rio) + 10 * 32); \
+	vpxor256_memld((iio) + 9 * 32 - 16, y1, y1); \
+	vmovdqu256_memst(y1, (rio) + 9 * 32); \
+	vpxor256_memld((iio) + 8 * 32 - 16, y0, y0); \
+	vmovdqu256_memst(y0, (rio) + 8 * 32); \
+	vpxor256_memld((iio) + 7 * 32 - 16, x7, x7); \
+	vmovdqu256_memst(x7, (rio) + 7 * 32); \
+	vpxor256_memld((iio) + 6 * 32 - 16, x6, x6); \
+	vmovdqu256_memst(x6, (rio) + 6 * 32); \
+	vpxor256_memld((iio) + 5 * 32 - 16, x5, x5); \
+	vmovdqu256_memst(x5, (rio) + 5 * 32); \
+	vpxor256_memld((iio) + 4 * 32 - 16, x4, x4); \
+	vmovdqu256_memst(x4, (rio) + 4 * 32); \
+	vpxor256_memld((iio) + 3 * 32 - 16, x3, x3); \
+	vmovdqu256_memst(x3, (rio) + 3 * 32); \
+	vpxor256_memld((iio) + 2 * 32 - 16, x2, x2); \
+	vmovdqu256_memst(x2, (rio) + 2 * 32); \
+	vpxor256_memld((iio) + 1 * 32 - 16, x1, x1); \
+	vmovdqu256_memst(x1, (rio) + 1 * 32); \
+	vpxor256_memld_2x128(iv, (iio) + 0 * 16, x0, x0); \
+	vmovdqu256_memst(x0, (rio) + 0 * 32);
+
+/*
+ * Generate 32 big-endian counter blocks directly in byte-sliced form and
+ * apply pre-whitening. After byte-slicing, register xN holds byte N of all
+ * blocks. When lowest counter byte does not overflow within 32 blocks, bytes
+ * 0..14 are the same for all blocks and only byte 15 varies.
+ *
+ * IN:
+ *   ctr: pointer to big-endian counter, lowest byte must be <= 0xe0
+ * OUT:
+ *   x0..x7, y0..y7: byte-sliced AB and CD state (as from inpack16_post)
+ */
+#define inpack16_ctr_bsliced(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			     y4, y5, y6, y7, ctr, key, mem_ab, mem_cd) \
+	vbroadcasti128_memld(ctr, x0); \
+	vmovq128_si256((key), x1); \
+	vpshufb256(pack_bswap, x1, x1); \
+	\
+	/* byte 15: counter + block index */ \
+	vpshufb256(bcast[15], x0, y7); \
+	vpshufb256(bcast[15], x1, y6); \
+	vpaddb256(ctr_bsliced_add32, y7, y7); \
+	vpxor256(y6, y7, y7); \
+	\
+	/* bytes 0..14: broadcast of whitened counter */ \
+	vpxor256(x0, x1, y6); \
+	vpshufb256(bcast[0], y6, x0); \
+	vpshufb256(bcast[1], y6, x1); \
+	vpshufb256(bcast[2], y6, x2); \
+	vpshufb256(bcast[3], y6, x3); \
+	vpshufb256(bcast[4], y6, x4); \
+	vpshufb256(bcast[5], y6, x5); \
+	vpshufb256(bcast[6], y6, x6); \
+	vpshufb256(bcast[7], y6, x7); \
+	vpshufb256(bcast[8], y6, y0); \
+	vpshufb256(bcast[9], y6, y1); \
+	vpshufb256(bcast[10], y6, y2); \
+	vpshufb256(bcast[11], y6, y3); \
+	vpshufb256(bcast[12], y6, y4); \
+	vpshufb256(bcast[13], y6, y5); \
+	vpshufb256(bcast[14], y6, y6); \
+	\
+	vmovdqa256(x0, mem_ab[0]); \
+	vmovdqa256(x1, mem_ab[1]); \
+	vmovdqa256(x2, mem_ab[2]); \
+	vmovdqa256(x3, mem_ab[3]); \
+	vmovdqa256(x4, mem_ab[4]); \
+	vmovdqa256(x5, mem_ab[5]); \
+	vmovdqa256(x6, mem_ab[6]); \
+	vmovdqa256(x7, mem_ab[7]); \
+	vmovdqa256(y0, mem_cd[0]); \
+	vmovdqa256(y1, mem_cd[1]); \
+	vmovdqa256(y2, mem_cd[2]); \
+	vmovdqa256(y3, mem_cd[3]); \
+	vmovdqa256(y4, mem_cd[4]); \
+	vmovdqa256(y5, mem_cd[5]); \
+	vmovdqa256(y6, mem_cd[6]); \
+	vmovdqa256(y7, mem_cd[7]);
+
+/*
+ * GHASH with carry-less multiplication. Values are kept byte-reflected and
+ * multiplication is done in bit-reflected domain, as in Intel white paper
+ * "Intel Carry-Less Multiplication Instruction and its Usage for Computing
+ * the GCM Mode". Products of 8 blocks with aggregated powers H^8..H^1 are
+ * accumulated unreduced and reduced once per 8 blocks.
+ */
+
+/* lo ^ (mid << 64) ^ (hi << 128) ^= a * h */
+#define ghash_mul_acc128(a, h, lo, mid, hi, t) \
+	vpclmulqdq128(0x00, h, a, t); \
+	vpxor128(t, lo, lo); \
+	vpclmulqdq128(0x11, h, a, t); \
+	vpxor128(t, hi, hi); \
+	vpclmulqdq128(0x01, h, a, t); \
+	vpxor128(t, mid, mid); \
+	vpclmulqdq128(0x10, h, a, t); \
+	vpxor128(t, mid, mid);
+
+/*
+ * IN:
+ *  lo, mid, hi: unreduced product, lo ^ (mid << 64) ^ (hi << 128)
+ * OUT:
+ *  o: reduced product
+ */
+#define ghash_reduce128(lo, mid, hi, o, t0, t1, t2) \
+	vpslldq128(8, mid, t0); \
+	vpsrldq128(8, mid, mid); \
+	vpxor128(t0, lo, lo); \
+	vpxor128(mid, hi, hi); \
+	\
+	/* shift <hi:lo> left by one bit */ \
+	vpsrld128(31, lo, t0); \
+	vpsrld128(31, hi, t1); \
+	vpslld128(1, lo, lo); \
+	vpslld128(1, hi, hi); \
+	vpsrldq128(12, t0, t2); \
+	vpslldq128(4, t1, t1); \
+	vpslldq128(4, t0, t0); \
+	vpor128(t0, lo, lo); \
+	vpor128(t1, hi, hi); \
+	vpor128(t2, hi, hi); \
+	\
+	/* reduce modulo x^128 + x^7 + x^2 + x + 1 */ \
+	vpslld128(31, lo, t0); \
+	vpslld128(30, lo, t1); \
+	vpslld128(25, lo, t2); \
+	vpxor128(t1, t0, t0); \
+	vpxor128(t2, t0, t0); \
+	vpsrldq128(4, t0, t1); \
+	vpslldq128(12, t0, t0); \
+	vpxor128(t0, lo, lo); \
+	vpsrld128(1, lo, t0); \
+	vpsrld128(2, lo, t2); \
+	vpxor128(t2, t0, t0); \
+	vpsrld128(7, lo, t2); \
+	vpxor128(t2, t0, t0); \
+	vpxor128(t1, t0, t0); \
+	vpxor128(t0, lo, lo); \
+	vpxor128(lo, hi, o);
+
+#ifdef __VPCLMULQDQ__
+/* VPCLMULQDQ: two blocks per 256-bit vector, accumulate in 256-bit vectors */
+#define ghash_acc_declare(lo, mid, hi) __m256i lo, mid, hi
+
+#define ghash_acc_zero(lo, mid, hi) \
+	(lo = mid = hi = _mm256_setzero_si256())
+
+#define ghash_mul_acc256(a, h, lo, mid, hi, t) \
+	vpclmulqdq256(0x00, h, a, t); \
+	vpxor256(t, lo, lo); \
+	vpclmulqdq256(0x11, h, a, t); \
+	vpxor256(t, hi, hi); \
+	vpclmulqdq256(0x01, h, a, t); \
+	vpxor256(t, mid, mid); \
+	vpclmulqdq256(0x10, h, a, t); \
+	vpxor256(t, mid, mid);
+
+/* Multiply-accumulate 4 blocks from IN with 4 consecutive powers of H from
+ * HTABLE. X (128-bit) is XORed to first block. */
+#define ghash_mul_4blks(in, htable, x, lo, mid, hi) \
+	({ \
+	  __m256i __a0, __a1, __h, __t; \
+	  \
+	  __a0 = _mm256_loadu_si256((const __m256i *)(in) + 0); \
+	  __a1 = _mm256_loadu_si256((const __m256i *)(in) + 1); \
+	  vpshufb256(ghash_bswap, __a0, __a0); \
+	  vpshufb256(ghash_bswap, __a1, __a1); \
+	  vpxor256(_mm256_zextsi128_si256(x), __a0, __a0); \
+	  __h = _mm256_loadu_si256((const __m256i *)(htable) + 0); \
+	  ghash_mul_acc256(__a0, __h, lo, mid, hi, __t); \
+	  __h = _mm256_loadu_si256((const __m256i *)(htable) + 1); \
+	  ghash_mul_acc256(__a1, __h, lo, mid, hi, __t); \
+	})
+
+#define ghash_reduce(lo, mid, hi, o) \
+	({ \
+	  __m128i __lo, __mid, __hi, __t0, __t1, __t2; \
+	  \
+	  __lo = _mm_xor_si128(_mm256_castsi256_si128(lo), \
+			       _mm256_extracti128_si256(lo, 1)); \
+	  __mid = _mm_xor_si128(_mm256_castsi256_si128(mid), \
+				_mm256_extracti128_si256(mid, 1)); \
+	  __hi = _mm_xor_si128(_mm256_castsi256_si128(hi), \
+			       _mm256_extracti128_si256(hi, 1)); \
+	  ghash_reduce128(__lo, __mid, __hi, o, __t0, __t1, __t2); \
+	})
+#else
+/* PCLMULQDQ: one block per 128-bit vector */
+#define ghash_acc_declare(lo, mid, hi) __m128i lo, mid, hi
+
+#define ghash_acc_zero(lo, mid, hi) \
+	(lo = mid = hi = _mm_setzero_si128())
+
+/* Multiply-accumulate 4 blocks from IN with 4 consecutive powers of H from
+ * HTABLE. X is XORed to first block. */
+#define ghash_mul_4blks(in, htable, x, lo, mid, hi) \
+	({ \
+	  __m128i __a, __h, __t; \
+	  unsigned int __i; \
+	  \
+	  for (__i = 0; __i < 4; __i++) { \
+	    __a = _mm_loadu_si128((const __m128i *)(in) + __i); \
+	    vpshufb128(_mm256_castsi256_si128(ghash_bswap), __a, __a); \
+	    if (__i == 0) \
+	      vpxor128(x, __a, __a); \
+	    __h = _mm_loadu_si128((const __m128i *)(htable) + __i); \
+	    ghash_mul_acc128(__a, __h, lo, mid, hi, __t); \
+	  } \
+	})
+
+#define ghash_reduce(lo, mid, hi, o) \
+	({ \
+	  __m128i __t0, __t1, __t2; \
+	  \
+	  ghash_reduce128(lo, mid, hi, o, __t0, __t1, __t2); \
+	})
+#endif
+
+/*
+ * One GHASH step for stitching to cipher rounds: step S (0..7) hashes blocks
+ * 4*S..4*S+3 from GHASH_IN to byte-reflected state HASH. Accumulators are
+ * reduced after every second step.
+ */
+#define ghash_step32(s, ghash_in, hash, htable, lo, mid, hi) \
+	({ \
+	  ghash_mul_4blks((ghash_in) + (s) * 64, (htable) + ((s) & 1) * 64, \
+			  ((s) & 1) ? _mm_setzero_si128() : hash, lo, mid, hi); \
+	  if ((s) & 1) { \
+	    ghash_reduce(lo, mid, hi, hash); \
+	    ghash_acc_zero(lo, mid, hi); \
+	  } \
+	  (s)++; \
+	})
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state preloaded
+ *  mem_ab: byte-sliced AB state in memory
+ *  mem_cd: byte-sliced CD state in memory
+ *  lastk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: encrypted blocks, ready for write_output
+ */
+#define enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, mem_ab, mem_cd, lastk, stack_tmp0, stack_tmp1) \
+	({ \
+	  unsigned int __k = 0; \
+	  \
+	  while (1) { \
+	    enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, mem_ab, mem_cd, __k); \
+	    \
+	    if (__k == (lastk) - 8) \
+	      break; \
+	    \
+	    fls16(mem_ab, x0, x1, x2, x3, x4, x5, x6, x7, mem_cd, y0, y1, y2, \
+		  y3, y4, y5, y6, y7, &ctx->key_table[__k + 8], \
+		  &ctx->key_table[__k + 9]); \
+	    \
+	    __k += 8; \
+	  } \
+	  \
+	  /* load CD for output */ \
+	  vmovdqa256(mem_cd[0], y0); \
+	  vmovdqa256(mem_cd[1], y1); \
+	  vmovdqa256(mem_cd[2], y2); \
+	  vmovdqa256(mem_cd[3], y3); \
+	  vmovdqa256(mem_cd[4], y4); \
+	  vmovdqa256(mem_cd[5], y5); \
+	  vmovdqa256(mem_cd[6], y6); \
+	  vmovdqa256(mem_cd[7], y7); \
+	  \
+	  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		      y5, y6, y7, ctx->key_table[(lastk)], stack_tmp0, \
+		      stack_tmp1); \
+	})
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state preloaded
+ *  mem_ab: byte-sliced AB state in memory
+ *  mem_cd: byte-sliced CD state in memory
+ *  firstk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: decrypted blocks, ready for write_output
+ */
+#define dec_blk32(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, mem_ab, mem_cd, firstk, stack_tmp0, stack_tmp1) \
+	({ \
+	  unsigned int __k = (firstk) - 8; \
+	  \
+	  while (1) { \
+	    dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, mem_ab, mem_cd, __k); \
+	    \
+	    if (__k == 0) \
+	      break; \
+	    \
+	    fls16(mem_ab, x0, x1, x2, x3, x4, x5, x6, x7, mem_cd, y0, y1, y2, \
+		  y3, y4, y5, y6, y7, &ctx->key_table[__k + 1], \
+		  &ctx->key_table[__k]); \
+	    \
+	    __k -= 8; \
+	  } \
+	  \
+	  /* load CD for output */ \
+	  vmovdqa256(mem_cd[0], y0); \
+	  vmovdqa256(mem_cd[1], y1); \
+	  vmovdqa256(mem_cd[2], y2); \
+	  vmovdqa256(mem_cd[3], y3); \
+	  vmovdqa256(mem_cd[4], y4); \
+	  vmovdqa256(mem_cd[5], y5); \
+	  vmovdqa256(mem_cd[6], y6); \
+	  vmovdqa256(mem_cd[7], y7); \
+	  \
+	  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		      y5, y6, y7, ctx->key_table[0], stack_tmp0, stack_tmp1); \
+	})
+
+/*
+ * Same as enc_blk32, but with independent work STITCH() issued after each
+ * two rounds, so that it can execute on ports not used by S-box computation.
+ * STITCH() is called NSTITCH times in total.
+ */
+#define enc_blk32_stitched(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			   y4, y5, y6, y7, mem_ab, mem_cd, lastk, stack_tmp0, \
+			   stack_tmp1, stitch, nstitch) \
+	({ \
+	  unsigned int __k = 0; \
+	  unsigned int __s = 0; \
+	  \
+	  while (1) { \
+	    two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			  y5, y6, y7, mem_ab, mem_cd, __k + 2, 1, \
+			  store_ab_state); \
+	    if (__s < (nstitch)) { stitch(); __s++; } \
+	    two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			  y5, y6, y7, mem_ab, mem_cd, __k + 4, 1, \
+			  store_ab_state); \
+	    if (__s < (nstitch)) { stitch(); __s++; } \
+	    two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			  y5, y6, y7, mem_ab, mem_cd, __k + 6, 1, \
+			  dummy_store); \
+	    if (__s < (nstitch)) { stitch(); __s++; } \
+	    \
+	    if (__k == (lastk) - 8) \
+	      break; \
+	    \
+	    fls16(mem_ab, x0, x1, x2, x3, x4, x5, x6, x7, mem_cd, y0, y1, y2, \
+		  y3, y4, y5, y6, y7, &ctx->key_table[__k + 8], \
+		  &ctx->key_table[__k + 9]); \
+	    \
+	    __k += 8; \
+	  } \
+	  \
+	  for (; __s < (nstitch); __s++) \
+	    stitch(); \
+	  \
+	  /* load CD for output */ \
+	  vmovdqa256(mem_cd[0], y0); \
+	  vmovdqa256(mem_cd[1], y1); \
+	  vmovdqa256(mem_cd[2], y2); \
+	  vmovdqa256(mem_cd[3], y3); \
+	  vmovdqa256(mem_cd[4], y4); \
+	  vmovdqa256(mem_cd[5], y5); \
+	  vmovdqa256(mem_cd[6], y6); \
+	  vmovdqa256(mem_cd[7], y7); \
+	  \
+	  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		      y5, y6, y7, ctx->key_table[(lastk)], stack_tmp0, \
+		      stack_tmp1); \
+	})
+
 /**********************************************************************
   macros for defining constant vectors
  **********************************************************************/
@@ -844,12 +1555,33 @@ static const __m256i pack_bswap =
   M256I_U32(0x00010203, 0x04050607, 0x0f0f0f0f, 0x0f0f0f0f,
 	    0x00010203, 0x04050607, 0x0f0f0f0f, 0x0f0f0f0f);
 
-static const __m256i bcast[8] =
+static const __m256i bcast[16] =
 {
   M256I_REP32(0), M256I_REP32(1), M256I_REP32(2), M256I_REP32(3),
-  M256I_REP32(4), M256I_REP32(5), M256I_REP32(6), M256I_REP32(7)
+  M256I_REP32(4), M256I_REP32(5), M256I_REP32(6), M256I_REP32(7),
+  M256I_REP32(8), M256I_REP32(9), M256I_REP32(10), M256I_REP32(11),
+  M256I_REP32(12), M256I_REP32(13), M256I_REP32(14), M256I_REP32(15)
 };
 
+/* Block index of each byte in byte-sliced register, for counter byte 15 */
+static const __m256i ctr_bsliced_add32 =
+  M256I_BYTE(30, 22, 14, 6, 28, 20, 12, 4, 26, 18, 10, 2, 24, 16, 8, 0,
+	     31, 23, 15, 7, 29, 21, 13, 5, 27, 19, 11, 3, 25, 17, 9, 1);
+
+/* XTS tweak multiplication: carry bit (0/1) to byte mask lookup, and
+ * reduction values for carries from low and high 64-bit halves. */
+static const __m256i xts_carry_to_mask =
+  M256I_BYTE(0x00, 0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	     0x00, 0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+static const __m256i xts_gfmul_poly =
+  M256I_BYTE(0x87, 0, 0, 0, 0, 0, 0, 0, 0x01, 0, 0, 0, 0, 0, 0, 0,
+	     0x87, 0, 0, 0, 0, 0, 0, 0, 0x01, 0, 0, 0, 0, 0, 0, 0);
+
+/* Byte-reflection of 128-bit GHASH values */
+static const __m256i ghash_bswap =
+  M256I_BYTE(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+	     15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+
 #ifdef USE_GFNI
 
 /* Pre-filters and post-filters bit-matrixes for Camellia sboxes s1, s2, s3
@@ -1079,7 +1811,7 @@ void camellia_encrypt_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
   __m256i ab[8];
   __m256i cd[8];
   __m256i tmp0, tmp1;
-  unsigned int lastk, k;
+  unsigned int lastk;
 
   if (ctx->key_length > 16)
     lastk = 32;
@@ -1092,41 +1824,260 @@ void camellia_encrypt_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
   inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
 		x15, ab, cd);
 
-  k = 0;
-  while (1) {
-    enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-		 x15, ab, cd, k);
+  enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
 
-    if (k == lastk - 8)
-      break;
+  write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
+	       x8, out);
+}
 
-    fls16(ab, x0, x1, x2, x3, x4, x5, x6, x7, cd, x8, x9, x10, x11, x12, x13,
-	  x14, x15, &ctx->key_table[k + 8], &ctx->key_table[k + 9]);
+/* Decrypts 32 input block from IN and writes result to OUT. IN and OUT may
+ * unaligned pointers. */
+void camellia_decrypt_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int firstk;
 
-    k += 8;
-  }
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
 
-  /* load CD for output */
-  vmovdqa256(cd[0], x8);
-  vmovdqa256(cd[1], x9);
-  vmovdqa256(cd[2], x10);
-  vmovdqa256(cd[3], x11);
-  vmovdqa256(cd[4], x12);
-  vmovdqa256(cd[5], x13);
-  vmovdqa256(cd[6], x14);
-  vmovdqa256(cd[7], x15);
+  inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	       x15, in, ctx->key_table[firstk]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
 
-  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-	      x15, ctx->key_table[lastk], tmp0, tmp1);
+  dec_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
 
   write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
 	       x8, out);
 }
 
-/* Decrypts 32 input block from IN and writes result to OUT. IN and OUT may
- * unaligned pointers. */
-void camellia_decrypt_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
-				     const void *vin)
+/* Encrypts 32 blocks, block I loaded from IN[I] and result stored to OUT[I].
+ * All blocks are loaded before first store, so OUT[I] may point to any of
+ * input blocks. */
+void camellia_encrypt_32blks_simd256_ptrs(struct camellia_simd_ctx *ctx,
+					  void *const out[32],
+					  const void *const in[32])
+{
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  inpack16_pre_gather(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12,
+		      x13, x14, x15, in, ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output_scatter(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11,
+		       x10, x9, x8, out);
+}
+
+/* Decrypts 32 blocks, block I loaded from IN[I] and result stored to OUT[I].
+ * All blocks are loaded before first store, so OUT[I] may point to any of
+ * input blocks. */
+void camellia_decrypt_32blks_simd256_ptrs(struct camellia_simd_ctx *ctx,
+					  void *const out[32],
+					  const void *const in[32])
+{
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int firstk;
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  inpack16_pre_gather(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12,
+		      x13, x14, x15, in, ctx->key_table[firstk]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  dec_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
+
+  write_output_scatter(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11,
+		       x10, x9, x8, out);
+}
+
+int have_camellia_nblks_simd256_masked(void)
+{
+#ifdef HAVE_MASKED_MEMOPS
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* Encrypts first NBLKS (at most 32) blocks from IN and writes result to OUT.
+ * IN and OUT may unaligned pointers. With AVX512BW/VL, blocks are loaded and
+ * stored with byte-masked loads/stores, so memory after NBLKS blocks is not
+ * accessed. */
+void camellia_encrypt_nblks_simd256_masked(struct camellia_simd_ctx *ctx,
+					  void *vout, const void *vin,
+					  size_t nblks)
+{
+#ifdef HAVE_MASKED_MEMOPS
+  char *out = vout;
+  const char *in = vin;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int lastk;
+
+  if (nblks == 0)
+    return;
+  if (nblks > 32)
+    nblks = 32;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  inpack16_pre_masked(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12,
+		      x13, x14, x15, in, ctx->key_table[0], nblks);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output_masked(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11,
+		      x10, x9, x8, out, nblks);
+#else
+  uint8_t tmp[32 * 16];
+
+  if (nblks == 0)
+    return;
+  if (nblks > 32)
+    nblks = 32;
+
+  memcpy(tmp, vin, nblks * 16);
+  camellia_encrypt_32blks_simd256(ctx, tmp, tmp);
+  memcpy(vout, tmp, nblks * 16);
+#endif
+}
+
+/* Decrypts first NBLKS (at most 32) blocks from IN and writes result to OUT.
+ * IN and OUT may unaligned pointers. With AVX512BW/VL, blocks are loaded and
+ * stored with byte-masked loads/stores, so memory after NBLKS blocks is not
+ * accessed. */
+void camellia_decrypt_nblks_simd256_masked(struct camellia_simd_ctx *ctx,
+					  void *vout, const void *vin,
+					  size_t nblks)
+{
+#ifdef HAVE_MASKED_MEMOPS
+  char *out = vout;
+  const char *in = vin;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int firstk;
+
+  if (nblks == 0)
+    return;
+  if (nblks > 32)
+    nblks = 32;
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  inpack16_pre_masked(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12,
+		      x13, x14, x15, in, ctx->key_table[firstk], nblks);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  dec_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
+
+  write_output_masked(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11,
+		      x10, x9, x8, out, nblks);
+#else
+  uint8_t tmp[32 * 16];
+
+  if (nblks == 0)
+    return;
+  if (nblks > 32)
+    nblks = 32;
+
+  memcpy(tmp, vin, nblks * 16);
+  camellia_decrypt_32blks_simd256(ctx, tmp, tmp);
+  memcpy(vout, tmp, nblks * 16);
+#endif
+}
+
+/* Encrypts NCHUNKS consecutive 32-block chunks from IN and writes result to
+ * OUT. IN and OUT may unaligned pointers. */
+void camellia_ecb_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, size_t nchunks)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  while (nchunks) {
+    inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		 x14, x15, in, ctx->key_table[0]);
+
+    inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		  x14, x15, ab, cd);
+
+    enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	      x15, ab, cd, lastk, tmp0, tmp1);
+
+    write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		 x9, x8, out);
+
+    in += 32 * 16;
+    out += 32 * 16;
+    nchunks--;
+  }
+}
+
+/* Decrypts NCHUNKS consecutive 32-block chunks from IN and writes result to
+ * OUT. IN and OUT may unaligned pointers. */
+void camellia_ecb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, size_t nchunks)
 {
   char *out = vout;
   const char *in = vin;
@@ -1134,46 +2085,546 @@ void camellia_decrypt_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
   __m256i ab[8];
   __m256i cd[8];
   __m256i tmp0, tmp1;
-  unsigned int firstk, k;
+  unsigned int firstk;
 
   if (ctx->key_length > 16)
     firstk = 32;
   else
     firstk = 24;
 
+  while (nchunks) {
+    inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		 x14, x15, in, ctx->key_table[firstk]);
+
+    inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		  x14, x15, ab, cd);
+
+    dec_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	      x15, ab, cd, firstk, tmp0, tmp1);
+
+    write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		 x9, x8, out);
+
+    in += 32 * 16;
+    out += 32 * 16;
+    nchunks--;
+  }
+}
+
+/**********************************************************************
+  32-way camellia modes of operation
+ **********************************************************************/
+
+/* Add ADD to 128-bit big-endian counter CTR. */
+static inline void ctr_be128_add(uint8_t *ctr, unsigned int add)
+{
+  unsigned int i = 16;
+
+  while (i-- > 0 && add) {
+    add += ctr[i];
+    ctr[i] = add & 0xff;
+    add >>= 8;
+  }
+}
+
+/* Store NBLKS consecutive counter blocks starting from CTR to DST and
+ * advance CTR by NBLKS. */
+static inline void ctr_be128_blks(uint8_t *dst, uint8_t *ctr,
+				  unsigned int nblks)
+{
+  while (nblks--) {
+    ((uint64_unaligned_t *)dst)[0] = ((const uint64_unaligned_t *)ctr)[0];
+    ((uint64_unaligned_t *)dst)[1] = ((const uint64_unaligned_t *)ctr)[1];
+    ctr_be128_add(ctr, 1);
+    dst += 16;
+  }
+}
+
+/* CTR mode: Encrypts 32 counter blocks starting from 128-bit big-endian
+ * counter CTR, XORs result with 32 input blocks from IN and writes result
+ * to OUT. CTR is incremented by 32. IN and OUT may be unaligned pointers. */
+void camellia_ctr_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *vctr)
+{
+  char *out = vout;
+  const char *in = vin;
+  uint8_t *ctr = vctr;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  if (ctr[15] <= 0xff - 31) {
+    /* No carry from lowest counter byte, generate byte-sliced state
+     * directly. */
+    inpack16_ctr_bsliced(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11,
+			 x12, x13, x14, x15, ctr, ctx->key_table[0], ab, cd);
+    ctr_be128_add(ctr, 32);
+  } else {
+    __m256i ctrblks[16];
+
+    ctr_be128_blks((uint8_t *)ctrblks, ctr, 32);
+
+    inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		 x14, x15, (const char *)ctrblks, ctx->key_table[0]);
+
+    inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		  x14, x15, ab, cd);
+  }
+
+  enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, in);
+}
+
+/* CBC mode decryption: Decrypts 32 input blocks from IN, XORs result with
+ * previous ciphertext blocks (first block with IV) and writes result to OUT.
+ * IV is updated with last ciphertext block. IN and OUT may be unaligned
+ * pointers and may point to same buffer. */
+void camellia_cbc_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *viv)
+{
+  char *out = vout;
+  const char *in = vin;
+  uint64_unaligned_t *iv = viv;
+  uint64_t iv_next[2];
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int firstk;
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  /* Save last ciphertext block before it can get overwritten. */
+  iv_next[0] = ((const uint64_unaligned_t *)(in + 31 * 16))[0];
+  iv_next[1] = ((const uint64_unaligned_t *)(in + 31 * 16))[1];
+
   inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
 	       x15, in, ctx->key_table[firstk]);
 
   inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
 		x15, ab, cd);
 
-  k = firstk - 8;
-  while (1) {
-    dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
-		 x14, x15, ab, cd, k);
+  dec_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
+
+  write_output_cbc_dec(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11,
+		       x10, x9, x8, out, in, iv);
+
+  iv[0] = iv_next[0];
+  iv[1] = iv_next[1];
+}
+
+/* CFB mode decryption: Encrypts IV and 31 first input blocks from IN,
+ * XORs result with 32 input blocks from IN and writes result to OUT. IV is
+ * updated with last ciphertext block. IN and OUT may be unaligned pointers
+ * and may point to same buffer. */
+void camellia_cfb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *viv)
+{
+  char *out = vout;
+  const char *in = vin;
+  uint64_unaligned_t *iv = viv;
+  uint64_t iv_next[2];
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  /* Save last ciphertext block before it can get overwritten. */
+  iv_next[0] = ((const uint64_unaligned_t *)(in + 31 * 16))[0];
+  iv_next[1] = ((const uint64_unaligned_t *)(in + 31 * 16))[1];
+
+  inpack16_pre_shifted(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12,
+		       x13, x14, x15, iv, in, ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, in);
+
+  iv[0] = iv_next[0];
+  iv[1] = iv_next[1];
+}
+
+/* XTS mode encryption: Encrypts 32 input blocks from IN with tweaks T, T*x,
+ * ..., T*x^31 (T from TWEAK) and writes result to OUT. TWEAK is updated to
+ * T*x^32. IN and OUT may be unaligned pointers and may point to same
+ * buffer. */
+void camellia_xts_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *tweak)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  __m256i tweaks[16];
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  xts_gen_tweaks32(tweaks, tweak, x0, x1, x2);
+
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, in, (const char *)tweaks,
+		   ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
 
-    if (k == 0)
-      break;
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, (const char *)tweaks);
+}
 
-    fls16(ab, x0, x1, x2, x3, x4, x5, x6, x7, cd, x8, x9, x10, x11, x12, x13,
-	  x14, x15, &ctx->key_table[k + 1], &ctx->key_table[k]);
+/* XTS mode decryption: Decrypts 32 input blocks from IN with tweaks T, T*x,
+ * ..., T*x^31 (T from TWEAK) and writes result to OUT. TWEAK is updated to
+ * T*x^32. IN and OUT may be unaligned pointers and may point to same
+ * buffer. */
+void camellia_xts_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *tweak)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  __m256i tweaks[16];
+  unsigned int firstk;
 
-    k -= 8;
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  xts_gen_tweaks32(tweaks, tweak, x0, x1, x2);
+
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, in, (const char *)tweaks,
+		   ctx->key_table[firstk]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  dec_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, (const char *)tweaks);
+}
+
+/* OCB mode encryption: Encrypts 32 input blocks from IN with offsets
+ * O_i = O_{i-1} ^ L_{ntz(i)}, where O_0 is read from OFFSET and pointers to
+ * L_{ntz(i)} are in LS, and writes result to OUT. Plaintext blocks are
+ * XORed to CHECKSUM and OFFSET is updated to last offset. IN and OUT may be
+ * unaligned pointers and may point to same buffer. */
+void camellia_ocb_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *offset,
+				     void *checksum, const void *Ls[32])
+{
+  char *out = vout;
+  const char *in = vin;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  __m256i offsets[16];
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  ocb_checksum32(in, checksum, x0);
+
+  ocb_gen_offsets32(offsets, offset, Ls);
+
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, in, (const char *)offsets,
+		   ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, (const char *)offsets);
+}
+
+/* OCB mode decryption: Decrypts 32 input blocks from IN with offsets
+ * O_i = O_{i-1} ^ L_{ntz(i)}, where O_0 is read from OFFSET and pointers to
+ * L_{ntz(i)} are in LS, and writes result to OUT. Plaintext blocks are
+ * XORed to CHECKSUM and OFFSET is updated to last offset. IN and OUT may be
+ * unaligned pointers and may point to same buffer. */
+void camellia_ocb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin, void *offset,
+				     void *checksum, const void *Ls[32])
+{
+  char *out = vout;
+  const char *in = vin;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  __m256i offsets[16];
+  unsigned int firstk;
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  ocb_gen_offsets32(offsets, offset, Ls);
+
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, in, (const char *)offsets,
+		   ctx->key_table[firstk]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  dec_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, (const char *)offsets);
+
+  xor_fold16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	     x15, checksum);
+}
+
+/* OCB mode authentication: Encrypts 32 associated data blocks from ABUF
+ * with offsets O_i = O_{i-1} ^ L_{ntz(i)}, where O_0 is read from OFFSET and
+ * pointers to L_{ntz(i)} are in LS, and XORs results to SUM. OFFSET is
+ * updated to last offset. ABUF may be unaligned pointer. */
+void camellia_ocb_auth_32blks_simd256(struct camellia_simd_ctx *ctx,
+				      const void *vabuf, void *offset,
+				      void *sum, const void *Ls[32])
+{
+  const char *abuf = vabuf;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  __m256i offsets[16];
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  ocb_gen_offsets32(offsets, offset, Ls);
+
+  inpack16_pre_xor(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		   x14, x15, abuf, (const char *)offsets,
+		   ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  xor_fold16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	     x15, sum);
+}
+
+/* Add ADD to low 32 bits of big-endian counter block CTR (GCM inc32). */
+static inline void ctr_be32_add(uint8_t *ctr, unsigned int add)
+{
+  uint32_t lo = ((uint32_t)ctr[12] << 24) | ((uint32_t)ctr[13] << 16) |
+		((uint32_t)ctr[14] << 8) | ctr[15];
+
+  lo += add;
+  ctr[12] = lo >> 24;
+  ctr[13] = lo >> 16;
+  ctr[14] = lo >> 8;
+  ctr[15] = lo;
+}
+
+/* Store NBLKS consecutive GCM counter blocks starting from CTR to DST and
+ * advance CTR by NBLKS. */
+static inline void ctr_be32_blks(uint8_t *dst, uint8_t *ctr,
+				 unsigned int nblks)
+{
+  while (nblks--) {
+    ((uint64_unaligned_t *)dst)[0] = ((const uint64_unaligned_t *)ctr)[0];
+    ((uint64_unaligned_t *)dst)[1] = ((const uint64_unaligned_t *)ctr)[1];
+    ctr_be32_add(ctr, 1);
+    dst += 16;
   }
+}
 
-  /* load CD for output */
-  vmovdqa256(cd[0], x8);
-  vmovdqa256(cd[1], x9);
-  vmovdqa256(cd[2], x10);
-  vmovdqa256(cd[3], x11);
-  vmovdqa256(cd[4], x12);
-  vmovdqa256(cd[5], x13);
-  vmovdqa256(cd[6], x14);
-  vmovdqa256(cd[7], x15);
+/* GCM mode: Computes GHASH key table HTABLE from hash subkey H. HTABLE holds
+ * byte-reflected powers H^8..H^1 in 8 first 16-byte entries. */
+void camellia_gcm_ghash_init_simd256(void *vhtable, const void *H)
+{
+  __m128i *htable = vhtable;
+  __m128i bswap = _mm256_castsi256_si128(ghash_bswap);
+  __m128i h, p, lo, mid, hi, t0, t1, t2;
+  unsigned int i;
+
+  h = _mm_loadu_si128((const __m128i *)H);
+  vpshufb128(bswap, h, h);
+  p = h;
+  _mm_storeu_si128(&htable[7], p);
+
+  for (i = 1; i < 8; i++) {
+    lo = mid = hi = _mm_setzero_si128();
+    ghash_mul_acc128(p, h, lo, mid, hi, t0);
+    ghash_reduce128(lo, mid, hi, p, t0, t1, t2);
+    _mm_storeu_si128(&htable[7 - i], p);
+  }
 
-  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
-	      x15, ctx->key_table[0], tmp0, tmp1);
+  for (i = 8; i < 16; i++)
+    _mm_storeu_si128(&htable[i], _mm_setzero_si128());
+}
 
-  write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
-	       x8, out);
+/* GCM mode: Hashes NBLKS blocks from IN to 128-bit GHASH state HASH, using
+ * key table HTABLE from camellia_gcm_ghash_init_simd256. IN may be unaligned
+ * pointer. */
+void camellia_gcm_ghash_simd256(void *vhash, const void *vhtable,
+				const void *vin, size_t nblks)
+{
+  const char *in = vin;
+  const char *htable = vhtable;
+  __m128i bswap = _mm256_castsi256_si128(ghash_bswap);
+  __m128i hash, a, h, t0, t1, t2;
+  __m128i lo128, mid128, hi128;
+  ghash_acc_declare(lo, mid, hi);
+
+  hash = _mm_loadu_si128((const __m128i *)vhash);
+  vpshufb128(bswap, hash, hash);
+
+  while (nblks >= 8) {
+    ghash_acc_zero(lo, mid, hi);
+    ghash_mul_4blks(in, htable, hash, lo, mid, hi);
+    ghash_mul_4blks(in + 4 * 16, htable + 4 * 16, _mm_setzero_si128(),
+		    lo, mid, hi);
+    ghash_reduce(lo, mid, hi, hash);
+    in += 8 * 16;
+    nblks -= 8;
+  }
+
+  h = _mm_loadu_si128((const __m128i *)htable + 7);
+  while (nblks--) {
+    a = _mm_loadu_si128((const __m128i *)in);
+    vpshufb128(bswap, a, a);
+    vpxor128(hash, a, a);
+    lo128 = mid128 = hi128 = _mm_setzero_si128();
+    ghash_mul_acc128(a, h, lo128, mid128, hi128, t0);
+    ghash_reduce128(lo128, mid128, hi128, hash, t0, t1, t2);
+    in += 16;
+  }
+
+  vpshufb128(bswap, hash, hash);
+  _mm_storeu_si128((__m128i *)vhash, hash);
+}
+
+/* GHASH step issued between cipher rounds of GCM kernel. */
+#define gcm_ghash_stitch() \
+	ghash_step32(gh_step, ghash_in, gh_hash, htable, gh_lo, gh_mid, gh_hi)
+
+/* GCM mode: Encrypts 32 counter blocks starting from counter block CTR, XORs
+ * result with 32 input blocks from IN and writes result to OUT. Low 32 bits
+ * of CTR are incremented by 32. Interleaved with cipher rounds, 32 blocks
+ * from GHASH_IN are hashed to 128-bit GHASH state HASH, using key table
+ * HTABLE from camellia_gcm_ghash_init_simd256. For decryption, GHASH_IN is
+ * IN; for encryption, GHASH_IN is output of previous call (or NULL for no
+ * hashing). IN, OUT and GHASH_IN may be unaligned pointers and may point to
+ * same buffer. */
+void camellia_gcm_ctr_ghash_32blks_simd256(struct camellia_simd_ctx *ctx,
+					   void *vout, const void *vin,
+					   void *vctr, const void *vghash_in,
+					   void *vhash, const void *vhtable)
+{
+  char *out = vout;
+  const char *in = vin;
+  const char *ghash_in = vghash_in;
+  const char *htable = vhtable;
+  uint8_t *ctr = vctr;
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m256i ab[8];
+  __m256i cd[8];
+  __m256i tmp0, tmp1;
+  __m128i gh_hash;
+  ghash_acc_declare(gh_lo, gh_mid, gh_hi);
+  unsigned int gh_step = 0;
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  if (ctr[15] <= 0xff - 31) {
+    /* No carry from lowest counter byte, generate byte-sliced state
+     * directly. */
+    inpack16_ctr_bsliced(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11,
+			 x12, x13, x14, x15, ctr, ctx->key_table[0], ab, cd);
+    ctr_be32_add(ctr, 32);
+  } else {
+    __m256i ctrblks[16];
+
+    ctr_be32_blks((uint8_t *)ctrblks, ctr, 32);
+
+    inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		 x14, x15, (const char *)ctrblks, ctx->key_table[0]);
+
+    inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13,
+		  x14, x15, ab, cd);
+  }
+
+  if (ghash_in) {
+    gh_hash = _mm_loadu_si128((const __m128i *)vhash);
+    vpshufb128(_mm256_castsi256_si128(ghash_bswap), gh_hash, gh_hash);
+    ghash_acc_zero(gh_lo, gh_mid, gh_hi);
+
+    enc_blk32_stitched(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12,
+		       x13, x14, x15, ab, cd, lastk, tmp0, tmp1,
+		       gcm_ghash_stitch, 8);
+
+    vpshufb128(_mm256_castsi256_si128(ghash_bswap), gh_hash, gh_hash);
+    _mm_storeu_si128((__m128i *)vhash, gh_hash);
+  } else {
+    enc_blk32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	      x15, ab, cd, lastk, tmp0, tmp1);
+  }
+
+  write_output_xor(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10,
+		   x9, x8, out, in);
 }
@@ -0,0 +1,1174 @@
+/*
+ * Copyright (C) 2026 camellia-simd-aesni contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * AVX-512 implementation of Camellia cipher, using VAES or GFNI for sbox
+ * calculations. This implementation takes 64 input blocks and process
+ * them in parallel.
+ *
+ * Structure is same as in 32-block AVX2 implementation: each 128-bit lane
+ * of 512-bit zmm register holds byte-slices of separate group of 16 blocks,
+ * and all shuffles are done within 128-bit lanes.
+ */
+
+#include <stdint.h>
+#include <x86intrin.h>
+/* Kernels of this file are declared under USE_SIMD256 and USE_SIMD512 in camellia_simd.h. */
+#ifndef USE_SIMD256
+#define USE_SIMD256 1
+#endif
+#ifndef USE_SIMD512
+#define USE_SIMD512 1
+#endif
+#include "camellia_simd.h"
+
+#if !defined(USE_VAES) && !defined(USE_GFNI)
+ #error "64-block implementation requires USE_VAES or USE_GFNI"
+#endif
+
+/**********************************************************************
+  AT&T x86 asm to intrinsics conversion macros
+ **********************************************************************/
+#define vpand512(a, b, o)       (o = _mm512_and_si512(b, a))
+#define vpandn512(a, b, o)      (o = _mm512_andnot_si512(b, a))
+#define vpxor512(a, b, o)       (o = _mm512_xor_si512(b, a))
+#define vpor512(a, b, o)        (o = _mm512_or_si512(b, a))
+
+#define vpsrld512(s, a, o)      (o = _mm512_srli_epi32(a, s))
+#define vpsrldq512(s, a, o)     (o = _mm512_bsrli_epi128(a, s))
+
+#define vpaddb512(a, b, o)      (o = _mm512_add_epi8(b, a))
+
+/* AVX-512 compare produces mask register, expand it back to byte vector */
+#define vpcmpgtb512(a, b, o) \
+	(o = _mm512_movm_epi8(_mm512_cmpgt_epi8_mask(b, a)))
+#define vpabsb512(a, o)         (o = _mm512_abs_epi8(a))
+
+#define vpshufb512(m, a, o)     (o = _mm512_shuffle_epi8(a, m))
+
+#define vpunpckhdq512(a, b, o)  (o = _mm512_unpackhi_epi32(b, a))
+#define vpunpckldq512(a, b, o)  (o = _mm512_unpacklo_epi32(b, a))
+#define vpunpckhqdq512(a, b, o) (o = _mm512_unpackhi_epi64(b, a))
+#define vpunpcklqdq512(a, b, o) (o = _mm512_unpacklo_epi64(b, a))
+
+#define vmovdqa512(a, o)        (o = a)
+#define vmovd128_si512(a, o) \
+	(o = _mm512_broadcast_i32x4(_mm_cvtsi32_si128(a)))
+#define vmovq128_si512(a, o) \
+	(o = _mm512_broadcast_i32x4(_mm_set_epi64x(0, a)))
+
+#define vpbroadcastq(a, o)      (o = _mm512_set1_epi64(a))
+
+/* Following operations may have unaligned memory input/output */
+#define vmovdqu512_memst(a, o)  _mm512_storeu_si512((void *)(o), a)
+#define vpxor512_memld(a, b, o) \
+	vpxor512(b, _mm512_loadu_si512((const void *)(a)), o)
+
+#ifndef USE_GFNI
+  /* Macros for exposing SubBytes from VAES instruction set. */
+  #define aes_subbytes_and_shuf_and_xor(zero, a, o) \
+	(o = _mm512_aesenclast_epi128(a, zero))
+  #define aes_load_inv_shufmask(shufmask_reg) \
+	vmovdqa512(inv_shift_row, shufmask_reg)
+  #define aes_inv_shuf(shufmask_reg, a, o) \
+	vpshufb512(shufmask_reg, a, o)
+#endif /* !USE_GFNI */
+
+#ifdef USE_GFNI
+  /* GFNI macros */
+  #define vgf2p8affineqb(b, A, x, o) \
+	(o = _mm512_gf2p8affine_epi64_epi8(x, A, b))
+  #define vgf2p8affineinvqb(b, A, x, o) \
+	(o = _mm512_gf2p8affineinv_epi64_epi8(x, A, b))
+#endif /* USE_GFNI */
+
+/**********************************************************************
+  GFNI helper macros and constants
+ **********************************************************************/
+
+#ifdef USE_GFNI
+
+#define BV8(a0,a1,a2,a3,a4,a5,a6,a7) \
+	( (((a0) & 1) << 0) | \
+	  (((a1) & 1) << 1) | \
+	  (((a2) & 1) << 2) | \
+	  (((a3) & 1) << 3) | \
+	  (((a4) & 1) << 4) | \
+	  (((a5) & 1) << 5) | \
+	  (((a6) & 1) << 6) | \
+	  (((a7) & 1) << 7) )
+
+#define BM8X8(l0,l1,l2,l3,l4,l5,l6,l7) \
+	( ((uint64_t)(l7) << (0 * 8)) | \
+	  ((uint64_t)(l6) << (1 * 8)) | \
+	  ((uint64_t)(l5) << (2 * 8)) | \
+	  ((uint64_t)(l4) << (3 * 8)) | \
+	  ((uint64_t)(l3) << (4 * 8)) | \
+	  ((uint64_t)(l2) << (5 * 8)) | \
+	  ((uint64_t)(l1) << (6 * 8)) | \
+	  ((uint64_t)(l0) << (7 * 8)) )
+
+/* Pre-filters and post-filters constants for Camellia sboxes s1, s2, s3 and s4.
+ *   See http://urn.fi/URN:NBN:fi:oulu-201305311409, pages 43-48.
+ *
+ * Pre-filters are directly from above source, "θ₁"/"θ₄". Post-filters are
+ * combination of function "A" (AES SubBytes affine transformation) and
+ * "ψ₁"/"ψ₂"/"ψ₃".
+ */
+
+/* Constant from "θ₁(x)" and "θ₄(x)" functions. */
+#define pre_filter_constant_s1234 BV8(1, 0, 1, 0, 0, 0, 1, 0)
+
+/* Constant from "ψ₁(A(x))" function: */
+#define post_filter_constant_s14  BV8(0, 1, 1, 1, 0, 1, 1, 0)
+
+/* Constant from "ψ₂(A(x))" function: */
+#define post_filter_constant_s2   BV8(0, 0, 1, 1, 1, 0, 1, 1)
+
+/* Constant from "ψ₃(A(x))" function: */
+#define post_filter_constant_s3   BV8(1, 1, 1, 0, 1, 1, 0, 0)
+
+#endif /* USE_GFNI */
+
+/**********************************************************************
+  helper macros
+ **********************************************************************/
+#ifndef USE_GFNI
+#define filter_8bit(x, lo_t, hi_t, mask4bit, tmp0) \
+	vpand512(x, mask4bit, tmp0); \
+	vpandn512(x, mask4bit, x); \
+	vpsrld512(4, x, x); \
+	\
+	vpshufb512(tmp0, lo_t, tmp0); \
+	vpshufb512(x, hi_t, x); \
+	vpxor512(tmp0, x, x);
+#endif /* !USE_GFNI */
+
+#define transpose_4x4(x0, x1, x2, x3, t1, t2) \
+	vpunpckhdq512(x1, x0, t2); \
+	vpunpckldq512(x1, x0, x0); \
+	\
+	vpunpckldq512(x3, x2, t1); \
+	vpunpckhdq512(x3, x2, x2); \
+	\
+	vpunpckhqdq512(t1, x0, x1); \
+	vpunpcklqdq512(t1, x0, x0); \
+	\
+	vpunpckhqdq512(x2, t2, x3); \
+	vpunpcklqdq512(x2, t2, x2);
+
+#define load_zero(o) (o = _mm512_setzero_si512())
+
+/**********************************************************************
+  16-way camellia macros
+ **********************************************************************/
+
+#ifdef USE_GFNI
+
+/*
+ * AES-NI/VAES version of round function.
+ *
+ * IN:
+ *   x0..x7: byte-sliced AB state
+ *   mem_cd: register pointer storing CD state
+ *   key: index for key material
+ * OUT:
+ *   x0..x7: new byte-sliced CD state
+ */
+#define roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, t0, t1, t2, t3, t4, t5, t6, \
+		  t7, mem_cd, key) \
+	/* \
+	 * S-function with GFNI \
+	 */ \
+	vpbroadcastq(pre_filter_bitmatrix_s123, t5); \
+	vpbroadcastq(pre_filter_bitmatrix_s4, t2); \
+	vpbroadcastq(post_filter_bitmatrix_s14, t4); \
+	vpbroadcastq(post_filter_bitmatrix_s2, t3); \
+	vpbroadcastq(post_filter_bitmatrix_s3, t7); \
+	load_zero(t6); \
+	vmovq128_si512((key), t0); \
+	\
+	/* prefilter sboxes */ \
+	vgf2p8affineqb(pre_filter_constant_s1234, t5, x0, x0); \
+	vgf2p8affineqb(pre_filter_constant_s1234, t5, x7, x7); \
+	vgf2p8affineqb(pre_filter_constant_s1234, t2, x3, x3); \
+	vgf2p8affineqb(pre_filter_constant_s1234, t2, x6, x6); \
+	vgf2p8affineqb(pre_filter_constant_s1234, t5, x2, x2); \
+	vgf2p8affineqb(pre_filter_constant_s1234, t5, x5, x5); \
+	vgf2p8affineqb(pre_filter_constant_s1234, t5, x1, x1); \
+	vgf2p8affineqb(pre_filter_constant_s1234, t5, x4, x4); \
+	\
+	/* sbox GF8 inverse + postfilter sboxes 1 and 4 */ \
+	vgf2p8affineinvqb(post_filter_constant_s14, t4, x0, x0); \
+	vgf2p8affineinvqb(post_filter_constant_s14, t4, x7, x7); \
+	vgf2p8affineinvqb(post_filter_constant_s14, t4, x3, x3); \
+	vgf2p8affineinvqb(post_filter_constant_s14, t4, x6, x6); \
+	\
+	/* sbox GF8 inverse + postfilter sbox 3 */ \
+	vgf2p8affineinvqb(post_filter_constant_s3, t7, x2, x2); \
+	vgf2p8affineinvqb(post_filter_constant_s3, t7, x5, x5); \
+	\
+	/* sbox GF8 inverse + postfilter sbox 2 */ \
+	vgf2p8affineinvqb(post_filter_constant_s2, t3, x1, x1); \
+	vgf2p8affineinvqb(post_filter_constant_s2, t3, x4, x4); \
+	\
+	vpsrldq512(5, t0, t5); \
+	vpsrldq512(1, t0, t1); \
+	vpsrldq512(2, t0, t2); \
+	vpsrldq512(3, t0, t3); \
+	vpsrldq512(4, t0, t4); \
+	vpshufb512(t6, t0, t0); \
+	vpshufb512(t6, t1, t1); \
+	vpshufb512(t6, t2, t2); \
+	vpshufb512(t6, t3, t3); \
+	vpshufb512(t6, t4, t4); \
+	vpsrldq512(2, t5, t7); \
+	vpshufb512(t6, t7, t7); \
+	\
+	/* P-function */ \
+	vpxor512(x5, x0, x0); \
+	vpxor512(x6, x1, x1); \
+	vpxor512(x7, x2, x2); \
+	vpxor512(x4, x3, x3); \
+	\
+	vpxor512(x2, x4, x4); \
+	vpxor512(x3, x5, x5); \
+	vpxor512(x0, x6, x6); \
+	vpxor512(x1, x7, x7); \
+	\
+	vpxor512(x7, x0, x0); \
+	vpxor512(x4, x1, x1); \
+	vpxor512(x5, x2, x2); \
+	vpxor512(x6, x3, x3); \
+	\
+	vpxor512(x3, x4, x4); \
+	vpxor512(x0, x5, x5); \
+	vpxor512(x1, x6, x6); \
+	vpxor512(x2, x7, x7); /* note: high and low parts swapped */ \
+	\
+	/* Add key material and result to CD (x becomes new CD) */ \
+	\
+	vpxor512(t3, x4, x4); \
+	vpxor512(mem_cd[0], x4, x4); \
+	\
+	vpxor512(t2, x5, x5); \
+	vpxor512(mem_cd[1], x5, x5); \
+	\
+	vpsrldq512(1, t5, t3); \
+	vpshufb512(t6, t5, t5); \
+	vpshufb512(t6, t3, t6); \
+	\
+	vpxor512(t1, x6, x6); \
+	vpxor512(mem_cd[2], x6, x6); \
+	\
+	vpxor512(t0, x7, x7); \
+	vpxor512(mem_cd[3], x7, x7); \
+	\
+	vpxor512(t7, x0, x0); \
+	vpxor512(mem_cd[4], x0, x0); \
+	\
+	vpxor512(t6, x1, x1); \
+	vpxor512(mem_cd[5], x1, x1); \
+	\
+	vpxor512(t5, x2, x2); \
+	vpxor512(mem_cd[6], x2, x2); \
+	\
+	vpxor512(t4, x3, x3); \
+	vpxor512(mem_cd[7], x3, x3);
+
+#else /* USE_GFNI */
+
+/*
+ * AES-NI/VAES version of round function.
+ *
+ * IN:
+ *   x0..x7: byte-sliced AB state
+ *   mem_cd: register pointer storing CD state
+ *   key: index for key material
+ * OUT:
+ *   x0..x7: new byte-sliced CD state
+ */
+#define roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, t0, t1, t2, t3, t4, t5, t6, \
+		  t7, mem_cd, key) \
+	/* \
+	 * S-function with AES subbytes \
+	 */ \
+	aes_load_inv_shufmask(t4); \
+	vmovdqa512(mask_0f, t7); \
+	vmovdqa512(pre_tf_lo_s1, t0); \
+	vmovdqa512(pre_tf_hi_s1, t1); \
+	\
+	/* AES inverse shift rows */ \
+	aes_inv_shuf(t4, x0, x0); \
+	aes_inv_shuf(t4, x7, x7); \
+	aes_inv_shuf(t4, x1, x1); \
+	aes_inv_shuf(t4, x4, x4); \
+	aes_inv_shuf(t4, x2, x2); \
+	aes_inv_shuf(t4, x5, x5); \
+	aes_inv_shuf(t4, x3, x3); \
+	aes_inv_shuf(t4, x6, x6); \
+	\
+	/* prefilter sboxes 1, 2 and 3 */ \
+	vmovdqa512(pre_tf_lo_s4, t2); \
+	vmovdqa512(pre_tf_hi_s4, t3); \
+	filter_8bit(x0, t0, t1, t7, t6); \
+	filter_8bit(x7, t0, t1, t7, t6); \
+	filter_8bit(x1, t0, t1, t7, t6); \
+	filter_8bit(x4, t0, t1, t7, t6); \
+	filter_8bit(x2, t0, t1, t7, t6); \
+	filter_8bit(x5, t0, t1, t7, t6); \
+	\
+	/* prefilter sbox 4 */ \
+	load_zero(t4); \
+	filter_8bit(x3, t2, t3, t7, t6); \
+	filter_8bit(x6, t2, t3, t7, t6); \
+	\
+	/* AES subbytes + AES shift rows */ \
+	vmovdqa512(post_tf_lo_s1, t0); \
+	vmovdqa512(post_tf_hi_s1, t1); \
+	aes_subbytes_and_shuf_and_xor(t4, x0, x0); \
+	aes_subbytes_and_shuf_and_xor(t4, x7, x7); \
+	aes_subbytes_and_shuf_and_xor(t4, x1, x1); \
+	aes_subbytes_and_shuf_and_xor(t4, x4, x4); \
+	aes_subbytes_and_shuf_and_xor(t4, x2, x2); \
+	aes_subbytes_and_shuf_and_xor(t4, x5, x5); \
+	aes_subbytes_and_shuf_and_xor(t4, x3, x3); \
+	aes_subbytes_and_shuf_and_xor(t4, x6, x6); \
+	\
+	/* postfilter sboxes 1 and 4 */ \
+	vmovdqa512(post_tf_lo_s3, t2); \
+	vmovdqa512(post_tf_hi_s3, t3); \
+	filter_8bit(x0, t0, t1, t7, t6); \
+	filter_8bit(x7, t0, t1, t7, t6); \
+	filter_8bit(x3, t0, t1, t7, t6); \
+	filter_8bit(x6, t0, t1, t7, t6); \
+	\
+	/* postfilter sbox 3 */ \
+	vmovdqa512(post_tf_lo_s2, t4); \
+	vmovdqa512(post_tf_hi_s2, t5); \
+	filter_8bit(x2, t2, t3, t7, t6); \
+	filter_8bit(x5, t2, t3, t7, t6); \
+	\
+	vmovq128_si512((key), t0); \
+	\
+	/* postfilter sbox 2 */ \
+	filter_8bit(x1, t4, t5, t7, t2); \
+	filter_8bit(x4, t4, t5, t7, t2); \
+	\
+	/* P-function */ \
+	vpxor512(x5, x0, x0); \
+	vpxor512(x6, x1, x1); \
+	vpxor512(x7, x2, x2); \
+	vpxor512(x4, x3, x3); \
+	\
+	vpxor512(x2, x4, x4); \
+	vpxor512(x3, x5, x5); \
+	vpxor512(x0, x6, x6); \
+	vpxor512(x1, x7, x7); \
+	\
+	vpxor512(x7, x0, x0); \
+	vpxor512(x4, x1, x1); \
+	vpxor512(x5, x2, x2); \
+	vpxor512(x6, x3, x3); \
+	\
+	vpxor512(x3, x4, x4); \
+	vpxor512(x0, x5, x5); \
+	vpxor512(x1, x6, x6); \
+	vpxor512(x2, x7, x7); /* note: high and low parts swapped */ \
+	\
+	/* Add key material and result to CD (x becomes new CD) */ \
+	\
+	vpshufb512(bcast[7], t0, t7); \
+	vpshufb512(bcast[6], t0, t6); \
+	vpshufb512(bcast[5], t0, t5); \
+	vpshufb512(bcast[4], t0, t4); \
+	vpshufb512(bcast[3], t0, t3); \
+	vpshufb512(bcast[2], t0, t2); \
+	vpshufb512(bcast[1], t0, t1); \
+	\
+	vpxor512(t3, x4, x4); \
+	vpxor512(mem_cd[0], x4, x4); \
+	\
+	load_zero(t3); \
+	vpshufb512(t3, t0, t0); \
+	\
+	vpxor512(t2, x5, x5); \
+	vpxor512(mem_cd[1], x5, x5); \
+	\
+	vpxor512(t1, x6, x6); \
+	vpxor512(mem_cd[2], x6, x6); \
+	\
+	vpxor512(t0, x7, x7); \
+	vpxor512(mem_cd[3], x7, x7); \
+	\
+	vpxor512(t7, x0, x0); \
+	vpxor512(mem_cd[4], x0, x0); \
+	\
+	vpxor512(t6, x1, x1); \
+	vpxor512(mem_cd[5], x1, x1); \
+	\
+	vpxor512(t5, x2, x2); \
+	vpxor512(mem_cd[6], x2, x2); \
+	\
+	vpxor512(t4, x3, x3); \
+	vpxor512(mem_cd[7], x3, x3);
+
+#endif /* USE_GFNI */
+
+/*
+ * IN/OUT:
+ *  x0..x7: byte-sliced AB state preloaded
+ *  mem_ab: byte-sliced AB state in memory
+ *  mem_cb: byte-sliced CD state in memory
+ */
+#define two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, i, dir, store_ab) \
+	roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, mem_cd, ctx->key_table[(i)]); \
+	\
+	vmovdqa512(x4, mem_cd[0]); \
+	vmovdqa512(x5, mem_cd[1]); \
+	vmovdqa512(x6, mem_cd[2]); \
+	vmovdqa512(x7, mem_cd[3]); \
+	vmovdqa512(x0, mem_cd[4]); \
+	vmovdqa512(x1, mem_cd[5]); \
+	vmovdqa512(x2, mem_cd[6]); \
+	vmovdqa512(x3, mem_cd[7]); \
+	\
+	roundsm16(x4, x5, x6, x7, x0, x1, x2, x3, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, mem_ab, ctx->key_table[(i) + (dir)]); \
+	\
+	store_ab(x0, x1, x2, x3, x4, x5, x6, x7, mem_ab);
+
+#define dummy_store(x0, x1, x2, x3, x4, x5, x6, x7, mem_ab) /* do nothing */
+
+#define store_ab_state(x0, x1, x2, x3, x4, x5, x6, x7, mem_ab) \
+	/* Store new AB state */ \
+	vmovdqa512(x0, mem_ab[0]); \
+	vmovdqa512(x1, mem_ab[1]); \
+	vmovdqa512(x2, mem_ab[2]); \
+	vmovdqa512(x3, mem_ab[3]); \
+	vmovdqa512(x4, mem_ab[4]); \
+	vmovdqa512(x5, mem_ab[5]); \
+	vmovdqa512(x6, mem_ab[6]); \
+	vmovdqa512(x7, mem_ab[7]);
+
+#define enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, i) \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, (i) + 2, 1, store_ab_state); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, (i) + 4, 1, store_ab_state); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, (i) + 6, 1, dummy_store);
+
+#define dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, i) \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, (i) + 7, -1, store_ab_state); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, (i) + 5, -1, store_ab_state); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd, (i) + 3, -1, dummy_store);
+
+/*
+ * IN:
+ *  v0..3: byte-sliced 32-bit integers
+ * OUT:
+ *  v0..3: (IN <<< 1)
+ */
+#define rol32_1_16(v0, v1, v2, v3, t0, t1, t2, zero) \
+	vpcmpgtb512(v0, zero, t0); \
+	vpaddb512(v0, v0, v0); \
+	vpabsb512(t0, t0); \
+	\
+	vpcmpgtb512(v1, zero, t1); \
+	vpaddb512(v1, v1, v1); \
+	vpabsb512(t1, t1); \
+	\
+	vpcmpgtb512(v2, zero, t2); \
+	vpaddb512(v2, v2, v2); \
+	vpabsb512(t2, t2); \
+	\
+	vpor512(t0, v1, v1); \
+	\
+	vpcmpgtb512(v3, zero, t0); \
+	vpaddb512(v3, v3, v3); \
+	vpabsb512(t0, t0); \
+	\
+	vpor512(t1, v2, v2); \
+	vpor512(t2, v3, v3); \
+	vpor512(t0, v0, v0);
+
+/*
+ * IN:
+ *   r: byte-sliced AB state in memory
+ *   l: byte-sliced CD state in memory
+ * OUT:
+ *   x0..x7: new byte-sliced CD state
+ */
+#define fls16(l, l0, l1, l2, l3, l4, l5, l6, l7, r, t0, t1, t2, t3, tt0, \
+	      tt1, tt2, tt3, kl, kr) \
+	/* \
+	 * t0 = kll; \
+	 * t0 &= ll; \
+	 * lr ^= rol32(t0, 1); \
+	 */ \
+	load_zero(tt0); \
+	vmovd128_si512(*(kl) & 0xffffffff, t0); \
+	vpshufb512(tt0, t0, t3); \
+	vpshufb512(bcast[1], t0, t2); \
+	vpshufb512(bcast[2], t0, t1); \
+	vpshufb512(bcast[3], t0, t0); \
+	\
+	vpand512(l0, t0, t0); \
+	vpand512(l1, t1, t1); \
+	vpand512(l2, t2, t2); \
+	vpand512(l3, t3, t3); \
+	\
+	rol32_1_16(t3, t2, t1, t0, tt1, tt2, tt3, tt0); \
+	\
+	vpxor512(l4, t0, l4); \
+	vmovdqa512(l4, l[4]); \
+	vpxor512(l5, t1, l5); \
+	vmovdqa512(l5, l[5]); \
+	vpxor512(l6, t2, l6); \
+	vmovdqa512(l6, l[6]); \
+	vpxor512(l7, t3, l7); \
+	vmovdqa512(l7, l[7]); \
+	\
+	/* \
+	 * t2 = krr; \
+	 * t2 |= rr; \
+	 * rl ^= t2; \
+	 */ \
+	\
+	vmovd128_si512(*(kr) >> 32, t0); \
+	vpshufb512(tt0, t0, t3); \
+	vpshufb512(bcast[1], t0, t2); \
+	vpshufb512(bcast[2], t0, t1); \
+	vpshufb512(bcast[3], t0, t0); \
+	\
+	vpor512(r[4], t0, t0); \
+	vpor512(r[5], t1, t1); \
+	vpor512(r[6], t2, t2); \
+	vpor512(r[7], t3, t3); \
+	\
+	vpxor512(r[0], t0, t0); \
+	vpxor512(r[1], t1, t1); \
+	vpxor512(r[2], t2, t2); \
+	vpxor512(r[3], t3, t3); \
+	vmovdqa512(t0, r[0]); \
+	vmovdqa512(t1, r[1]); \
+	vmovdqa512(t2, r[2]); \
+	vmovdqa512(t3, r[3]); \
+	\
+	/* \
+	 * t2 = krl; \
+	 * t2 &= rl; \
+	 * rr ^= rol32(t2, 1); \
+	 */ \
+	vmovd128_si512(*(kr) & 0xffffffff, t0); \
+	vpshufb512(tt0, t0, t3); \
+	vpshufb512(bcast[1], t0, t2); \
+	vpshufb512(bcast[2], t0, t1); \
+	vpshufb512(bcast[3], t0, t0); \
+	\
+	vpand512(r[0], t0, t0); \
+	vpand512(r[1], t1, t1); \
+	vpand512(r[2], t2, t2); \
+	vpand512(r[3], t3, t3); \
+	\
+	rol32_1_16(t3, t2, t1, t0, tt1, tt2, tt3, tt0); \
+	\
+	vpxor512(r[4], t0, t0); \
+	vpxor512(r[5], t1, t1); \
+	vpxor512(r[6], t2, t2); \
+	vpxor512(r[7], t3, t3); \
+	vmovdqa512(t0, r[4]); \
+	vmovdqa512(t1, r[5]); \
+	vmovdqa512(t2, r[6]); \
+	vmovdqa512(t3, r[7]); \
+	\
+	/* \
+	 * t0 = klr; \
+	 * t0 |= lr; \
+	 * ll ^= t0; \
+	 */ \
+	\
+	vmovd128_si512(*(kl) >> 32, t0); \
+	vpshufb512(tt0, t0, t3); \
+	vpshufb512(bcast[1], t0, t2); \
+	vpshufb512(bcast[2], t0, t1); \
+	vpshufb512(bcast[3], t0, t0); \
+	\
+	vpor512(l4, t0, t0); \
+	vpor512(l5, t1, t1); \
+	vpor512(l6, t2, t2); \
+	vpor512(l7, t3, t3); \
+	\
+	vpxor512(l0, t0, l0); \
+	vmovdqa512(l0, l[0]); \
+	vpxor512(l1, t1, l1); \
+	vmovdqa512(l1, l[1]); \
+	vpxor512(l2, t2, l2); \
+	vmovdqa512(l2, l[2]); \
+	vpxor512(l3, t3, l3); \
+	vmovdqa512(l3, l[3]);
+
+#define byteslice_16x16b_fast(a0, b0, c0, d0, a1, b1, c1, d1, a2, b2, c2, d2, \
+			      a3, b3, c3, d3, st0, st1) \
+	vmovdqa512(d2, st0); \
+	vmovdqa512(d3, st1); \
+	transpose_4x4(a0, a1, a2, a3, d2, d3); \
+	transpose_4x4(b0, b1, b2, b3, d2, d3); \
+	vmovdqa512(st0, d2); \
+	vmovdqa512(st1, d3); \
+	\
+	vmovdqa512(a0, st0); \
+	vmovdqa512(a1, st1); \
+	transpose_4x4(c0, c1, c2, c3, a0, a1); \
+	transpose_4x4(d0, d1, d2, d3, a0, a1); \
+	\
+	vmovdqa512(shufb_16x16b, a0); \
+	vmovdqa512(st1, a1); \
+	vpshufb512(a0, a2, a2); \
+	vpshufb512(a0, a3, a3); \
+	vpshufb512(a0, b0, b0); \
+	vpshufb512(a0, b1, b1); \
+	vpshufb512(a0, b2, b2); \
+	vpshufb512(a0, b3, b3); \
+	vpshufb512(a0, a1, a1); \
+	vpshufb512(a0, c0, c0); \
+	vpshufb512(a0, c1, c1); \
+	vpshufb512(a0, c2, c2); \
+	vpshufb512(a0, c3, c3); \
+	vpshufb512(a0, d0, d0); \
+	vpshufb512(a0, d1, d1); \
+	vpshufb512(a0, d2, d2); \
+	vpshufb512(a0, d3, d3); \
+	vmovdqa512(d3, st1); \
+	vmovdqa512(st0, d3); \
+	vpshufb512(a0, d3, a0); \
+	vmovdqa512(d2, st0); \
+	\
+	transpose_4x4(a0, b0, c0, d0, d2, d3); \
+	transpose_4x4(a1, b1, c1, d1, d2, d3); \
+	vmovdqa512(st0, d2); \
+	vmovdqa512(st1, d3); \
+	\
+	vmovdqa512(b0, st0); \
+	vmovdqa512(b1, st1); \
+	transpose_4x4(a2, b2, c2, d2, b0, b1); \
+	transpose_4x4(a3, b3, c3, d3, b0, b1); \
+	vmovdqa512(st0, b0); \
+	vmovdqa512(st1, b1); \
+	/* does not adjust output bytes inside vectors */
+
+/* load blocks to registers and apply pre-whitening */
+#define inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		     y6, y7, rio, key) \
+	vmovq128_si512((key), x0); \
+	vpshufb512(pack_bswap, x0, x0); \
+	\
+	vpxor512_memld((rio) + 0 * 64, x0, y7); \
+	vpxor512_memld((rio) + 1 * 64, x0, y6); \
+	vpxor512_memld((rio) + 2 * 64, x0, y5); \
+	vpxor512_memld((rio) + 3 * 64, x0, y4); \
+	vpxor512_memld((rio) + 4 * 64, x0, y3); \
+	vpxor512_memld((rio) + 5 * 64, x0, y2); \
+	vpxor512_memld((rio) + 6 * 64, x0, y1); \
+	vpxor512_memld((rio) + 7 * 64, x0, y0); \
+	vpxor512_memld((rio) + 8 * 64, x0, x7); \
+	vpxor512_memld((rio) + 9 * 64, x0, x6); \
+	vpxor512_memld((rio) + 10 * 64, x0, x5); \
+	vpxor512_memld((rio) + 11 * 64, x0, x4); \
+	vpxor512_memld((rio) + 12 * 64, x0, x3); \
+	vpxor512_memld((rio) + 13 * 64, x0, x2); \
+	vpxor512_memld((rio) + 14 * 64, x0, x1); \
+	vpxor512_memld((rio) + 15 * 64, x0, x0);
+
+/* byteslice pre-whitened blocks and store to temporary memory */
+#define inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, mem_ab, mem_cd) \
+	byteslice_16x16b_fast(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, \
+			      y4, y5, y6, y7, mem_ab[0], mem_cd[0]); \
+	\
+	vmovdqa512(x0, mem_ab[0]); \
+	vmovdqa512(x1, mem_ab[1]); \
+	vmovdqa512(x2, mem_ab[2]); \
+	vmovdqa512(x3, mem_ab[3]); \
+	vmovdqa512(x4, mem_ab[4]); \
+	vmovdqa512(x5, mem_ab[5]); \
+	vmovdqa512(x6, mem_ab[6]); \
+	vmovdqa512(x7, mem_ab[7]); \
+	vmovdqa512(y0, mem_cd[0]); \
+	vmovdqa512(y1, mem_cd[1]); \
+	vmovdqa512(y2, mem_cd[2]); \
+	vmovdqa512(y3, mem_cd[3]); \
+	vmovdqa512(y4, mem_cd[4]); \
+	vmovdqa512(y5, mem_cd[5]); \
+	vmovdqa512(y6, mem_cd[6]); \
+	vmovdqa512(y7, mem_cd[7]);
+
+/* de-byteslice, apply post-whitening and store blocks */
+#define outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		    y5, y6, y7, key, stack_tmp0, stack_tmp1) \
+	byteslice_16x16b_fast(y0, y4, x0, x4, y1, y5, x1, x5, y2, y6, x2, x6, \
+			      y3, y7, x3, x7, stack_tmp0, stack_tmp1); \
+	\
+	vmovdqa512(x0, stack_tmp0); \
+	\
+	vmovq128_si512((key), x0); \
+	vpshufb512(pack_bswap, x0, x0); \
+	\
+	vpxor512(x0, y7, y7); \
+	vpxor512(x0, y6, y6); \
+	vpxor512(x0, y5, y5); \
+	vpxor512(x0, y4, y4); \
+	vpxor512(x0, y3, y3); \
+	vpxor512(x0, y2, y2); \
+	vpxor512(x0, y1, y1); \
+	vpxor512(x0, y0, y0); \
+	vpxor512(x0, x7, x7); \
+	vpxor512(x0, x6, x6); \
+	vpxor512(x0, x5, x5); \
+	vpxor512(x0, x4, x4); \
+	vpxor512(x0, x3, x3); \
+	vpxor512(x0, x2, x2); \
+	vpxor512(x0, x1, x1); \
+	vpxor512(stack_tmp0, x0, x0);
+
+#define write_output(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		     y6, y7, rio) \
+	vmovdqu512_memst(x0, (rio) + 0 * 64); \
+	vmovdqu512_memst(x1, (rio) + 1 * 64); \
+	vmovdqu512_memst(x2, (rio) + 2 * 64); \
+	vmovdqu512_memst(x3, (rio) + 3 * 64); \
+	vmovdqu512_memst(x4, (rio) + 4 * 64); \
+	vmovdqu512_memst(x5, (rio) + 5 * 64); \
+	vmovdqu512_memst(x6, (rio) + 6 * 64); \
+	vmovdqu512_memst(x7, (rio) + 7 * 64); \
+	vmovdqu512_memst(y0, (rio) + 8 * 64); \
+	vmovdqu512_memst(y1, (rio) + 9 * 64); \
+	vmovdqu512_memst(y2, (rio) + 10 * 64); \
+	vmovdqu512_memst(y3, (rio) + 11 * 64); \
+	vmovdqu512_memst(y4, (rio) + 12 * 64); \
+	vmovdqu512_memst(y5, (rio) + 13 * 64); \
+	vmovdqu512_memst(y6, (rio) + 14 * 64); \
+	vmovdqu512_memst(y7, (rio) + 15 * 64);
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state preloaded
+ *  mem_ab: byte-sliced AB state in memory
+ *  mem_cd: byte-sliced CD state in memory
+ *  lastk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: encrypted blocks, ready for write_output
+ */
+#define enc_blk64(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, mem_ab, mem_cd, lastk, stack_tmp0, stack_tmp1) \
+	({ \
+	  unsigned int __k = 0; \
+	  \
+	  while (1) { \
+	    enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, mem_ab, mem_cd, __k); \
+	    \
+	    if (__k == (lastk) - 8) \
+	      break; \
+	    \
+	    fls16(mem_ab, x0, x1, x2, x3, x4, x5, x6, x7, mem_cd, y0, y1, y2, \
+		  y3, y4, y5, y6, y7, &ctx->key_table[__k + 8], \
+		  &ctx->key_table[__k + 9]); \
+	    \
+	    __k += 8; \
+	  } \
+	  \
+	  /* load CD for output */ \
+	  vmovdqa512(mem_cd[0], y0); \
+	  vmovdqa512(mem_cd[1], y1); \
+	  vmovdqa512(mem_cd[2], y2); \
+	  vmovdqa512(mem_cd[3], y3); \
+	  vmovdqa512(mem_cd[4], y4); \
+	  vmovdqa512(mem_cd[5], y5); \
+	  vmovdqa512(mem_cd[6], y6); \
+	  vmovdqa512(mem_cd[7], y7); \
+	  \
+	  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		      y5, y6, y7, ctx->key_table[(lastk)], stack_tmp0, \
+		      stack_tmp1); \
+	})
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state preloaded
+ *  mem_ab: byte-sliced AB state in memory
+ *  mem_cd: byte-sliced CD state in memory
+ *  firstk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: decrypted blocks, ready for write_output
+ */
+#define dec_blk64(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, mem_ab, mem_cd, firstk, stack_tmp0, stack_tmp1) \
+	({ \
+	  unsigned int __k = (firstk) - 8; \
+	  \
+	  while (1) { \
+	    dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, mem_ab, mem_cd, __k); \
+	    \
+	    if (__k == 0) \
+	      break; \
+	    \
+	    fls16(mem_ab, x0, x1, x2, x3, x4, x5, x6, x7, mem_cd, y0, y1, y2, \
+		  y3, y4, y5, y6, y7, &ctx->key_table[__k + 1], \
+		  &ctx->key_table[__k]); \
+	    \
+	    __k -= 8; \
+	  } \
+	  \
+	  /* load CD for output */ \
+	  vmovdqa512(mem_cd[0], y0); \
+	  vmovdqa512(mem_cd[1], y1); \
+	  vmovdqa512(mem_cd[2], y2); \
+	  vmovdqa512(mem_cd[3], y3); \
+	  vmovdqa512(mem_cd[4], y4); \
+	  vmovdqa512(mem_cd[5], y5); \
+	  vmovdqa512(mem_cd[6], y6); \
+	  vmovdqa512(mem_cd[7], y7); \
+	  \
+	  outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+		      y5, y6, y7, ctx->key_table[0], stack_tmp0, stack_tmp1); \
+	})
+
+
+/**********************************************************************
+  macros for defining constant vectors
+ **********************************************************************/
+#define U64_BYTE(a0, a1, a2, a3, a4, a5, a6, a7) \
+	((((a0) & 0xffULL) << 0) | \
+	 (((a1) & 0xffULL) << 8) | \
+	 (((a2) & 0xffULL) << 16) | \
+	 (((a3) & 0xffULL) << 24) | \
+	 (((a4) & 0xffULL) << 32) | \
+	 (((a5) & 0xffULL) << 40) | \
+	 (((a6) & 0xffULL) << 48) | \
+	 (((a7) & 0xffULL) << 56))
+
+/* 128-bit constant replicated to all four 128-bit lanes */
+#define M512I_BYTE(a0, a1, a2, a3, a4, a5, a6, a7, b0, b1, b2, b3, b4, b5, b6, b7) \
+	{ \
+	  U64_BYTE(a0, a1, a2, a3, a4, a5, a6, a7), \
+	  U64_BYTE(b0, b1, b2, b3, b4, b5, b6, b7), \
+	  U64_BYTE(a0, a1, a2, a3, a4, a5, a6, a7), \
+	  U64_BYTE(b0, b1, b2, b3, b4, b5, b6, b7), \
+	  U64_BYTE(a0, a1, a2, a3, a4, a5, a6, a7), \
+	  U64_BYTE(b0, b1, b2, b3, b4, b5, b6, b7), \
+	  U64_BYTE(a0, a1, a2, a3, a4, a5, a6, a7), \
+	  U64_BYTE(b0, b1, b2, b3, b4, b5, b6, b7) \
+	}
+
+#define U64_U32(a0, a1) \
+	((((a0) & 0xffffffffULL) << 0) | \
+	 (((a1) & 0xffffffffULL) << 32))
+
+/* 128-bit constant replicated to all four 128-bit lanes */
+#define M512I_U32(a0, a1, b0, b1) \
+	{ \
+	  U64_U32(a0, a1), U64_U32(b0, b1), \
+	  U64_U32(a0, a1), U64_U32(b0, b1), \
+	  U64_U32(a0, a1), U64_U32(b0, b1), \
+	  U64_U32(a0, a1), U64_U32(b0, b1) \
+	}
+
+#define M512I_REP32(x) \
+	{ \
+	  (0x0101010101010101ULL * (x)), \
+	  (0x0101010101010101ULL * (x)), \
+	  (0x0101010101010101ULL * (x)), \
+	  (0x0101010101010101ULL * (x)), \
+	  (0x0101010101010101ULL * (x)), \
+	  (0x0101010101010101ULL * (x)), \
+	  (0x0101010101010101ULL * (x)), \
+	  (0x0101010101010101ULL * (x)) \
+	}
+
+#define SHUFB_BYTES(idx) \
+	(((0 + (idx)) << 0)  | ((4 + (idx)) << 8) | \
+	 ((8 + (idx)) << 16) | ((12 + (idx)) << 24))
+
+static const __m512i shufb_16x16b =
+  M512I_U32(SHUFB_BYTES(0), SHUFB_BYTES(1), SHUFB_BYTES(2), SHUFB_BYTES(3));
+
+static const __m512i pack_bswap =
+  M512I_U32(0x00010203, 0x04050607, 0x0f0f0f0f, 0x0f0f0f0f);
+
+static const __m512i bcast[16] =
+{
+  M512I_REP32(0), M512I_REP32(1), M512I_REP32(2), M512I_REP32(3),
+  M512I_REP32(4), M512I_REP32(5), M512I_REP32(6), M512I_REP32(7),
+  M512I_REP32(8), M512I_REP32(9), M512I_REP32(10), M512I_REP32(11),
+  M512I_REP32(12), M512I_REP32(13), M512I_REP32(14), M512I_REP32(15)
+};
+
+#ifdef USE_GFNI
+
+/* Pre-filters and post-filters bit-matrixes for Camellia sboxes s1, s2, s3
+ * and s4.
+ *   See http://urn.fi/URN:NBN:fi:oulu-201305311409, pages 43-48.
+ *
+ * Pre-filters are directly from above source, "θ₁"/"θ₄". Post-filters are
+ * combination of function "A" (AES SubBytes affine transformation) and
+ * "ψ₁"/"ψ₂"/"ψ₃".
+ */
+
+/* Bit-matrix from "θ₁(x)" function: */
+static const uint64_t pre_filter_bitmatrix_s123 =
+	      BM8X8(BV8(1, 1, 1, 0, 1, 1, 0, 1),
+		    BV8(0, 0, 1, 1, 0, 0, 1, 0),
+		    BV8(1, 1, 0, 1, 0, 0, 0, 0),
+		    BV8(1, 0, 1, 1, 0, 0, 1, 1),
+		    BV8(0, 0, 0, 0, 1, 1, 0, 0),
+		    BV8(1, 0, 1, 0, 0, 1, 0, 0),
+		    BV8(0, 0, 1, 0, 1, 1, 0, 0),
+		    BV8(1, 0, 0, 0, 0, 1, 1, 0));
+
+/* Bit-matrix from "θ₄(x)" function: */
+static const uint64_t pre_filter_bitmatrix_s4 =
+	      BM8X8(BV8(1, 1, 0, 1, 1, 0, 1, 1),
+		    BV8(0, 1, 1, 0, 0, 1, 0, 0),
+		    BV8(1, 0, 1, 0, 0, 0, 0, 1),
+		    BV8(0, 1, 1, 0, 0, 1, 1, 1),
+		    BV8(0, 0, 0, 1, 1, 0, 0, 0),
+		    BV8(0, 1, 0, 0, 1, 0, 0, 1),
+		    BV8(0, 1, 0, 1, 1, 0, 0, 0),
+		    BV8(0, 0, 0, 0, 1, 1, 0, 1));
+
+/* Bit-matrix from "ψ₁(A(x))" function: */
+static const uint64_t post_filter_bitmatrix_s14 =
+	      BM8X8(BV8(0, 0, 0, 0, 0, 0, 0, 1),
+		    BV8(0, 1, 1, 0, 0, 1, 1, 0),
+		    BV8(1, 0, 1, 1, 1, 1, 1, 0),
+		    BV8(0, 0, 0, 1, 1, 0, 1, 1),
+		    BV8(1, 0, 0, 0, 1, 1, 1, 0),
+		    BV8(0, 1, 0, 1, 1, 1, 1, 0),
+		    BV8(0, 1, 1, 1, 1, 1, 1, 1),
+		    BV8(0, 0, 0, 1, 1, 1, 0, 0));
+
+/* Bit-matrix from "ψ₂(A(x))" function: */
+static const uint64_t post_filter_bitmatrix_s2 =
+	      BM8X8(BV8(0, 0, 0, 1, 1, 1, 0, 0),
+		    BV8(0, 0, 0, 0, 0, 0, 0, 1),
+		    BV8(0, 1, 1, 0, 0, 1, 1, 0),
+		    BV8(1, 0, 1, 1, 1, 1, 1, 0),
+		    BV8(0, 0, 0, 1, 1, 0, 1, 1),
+		    BV8(1, 0, 0, 0, 1, 1, 1, 0),
+		    BV8(0, 1, 0, 1, 1, 1, 1, 0),
+		    BV8(0, 1, 1, 1, 1, 1, 1, 1));
+
+/* Bit-matrix from "ψ₃(A(x))" function: */
+static const uint64_t post_filter_bitmatrix_s3 =
+	      BM8X8(BV8(0, 1, 1, 0, 0, 1, 1, 0),
+		    BV8(1, 0, 1, 1, 1, 1, 1, 0),
+		    BV8(0, 0, 0, 1, 1, 0, 1, 1),
+		    BV8(1, 0, 0, 0, 1, 1, 1, 0),
+		    BV8(0, 1, 0, 1, 1, 1, 1, 0),
+		    BV8(0, 1, 1, 1, 1, 1, 1, 1),
+		    BV8(0, 0, 0, 1, 1, 1, 0, 0),
+		    BV8(0, 0, 0, 0, 0, 0, 0, 1));
+
+#else /* USE_GFNI */
+
+/*
+ * pre-SubByte transform
+ *
+ * pre-lookup for sbox1, sbox2, sbox3:
+ *   swap_bitendianness(
+ *       isom_map_camellia_to_aes(
+ *           camellia_f(
+ *               swap_bitendianess(in)
+ *           )
+ *       )
+ *   )
+ *
+ * (note: '⊕ 0xc5' inside camellia_f())
+ */
+static const __m512i pre_tf_lo_s1 =
+  M512I_BYTE(0x45, 0xe8, 0x40, 0xed, 0x2e, 0x83, 0x2b, 0x86,
+	     0x4b, 0xe6, 0x4e, 0xe3, 0x20, 0x8d, 0x25, 0x88);
+
+static const __m512i pre_tf_hi_s1 =
+  M512I_BYTE(0x00, 0x51, 0xf1, 0xa0, 0x8a, 0xdb, 0x7b, 0x2a,
+	     0x09, 0x58, 0xf8, 0xa9, 0x83, 0xd2, 0x72, 0x23);
+
+/*
+ * pre-SubByte transform
+ *
+ * pre-lookup for sbox4:
+ *   swap_bitendianness(
+ *       isom_map_camellia_to_aes(
+ *           camellia_f(
+ *               swap_bitendianess(in <<< 1)
+ *           )
+ *       )
+ *   )
+ *
+ * (note: '⊕ 0xc5' inside camellia_f())
+ */
+static const __m512i pre_tf_lo_s4 =
+  M512I_BYTE(0x45, 0x40, 0x2e, 0x2b, 0x4b, 0x4e, 0x20, 0x25,
+	     0x14, 0x11, 0x7f, 0x7a, 0x1a, 0x1f, 0x71, 0x74);
+
+static const __m512i pre_tf_hi_s4 =
+  M512I_BYTE(0x00, 0xf1, 0x8a, 0x7b, 0x09, 0xf8, 0x83, 0x72,
+	     0xad, 0x5c, 0x27, 0xd6, 0xa4, 0x55, 0x2e, 0xdf);
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox1, sbox4:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  )
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const __m512i post_tf_lo_s1 =
+  M512I_BYTE(0x3c, 0xcc, 0xcf, 0x3f, 0x32, 0xc2, 0xc1, 0x31,
+	     0xdc, 0x2c, 0x2f, 0xdf, 0xd2, 0x22, 0x21, 0xd1);
+
+static const __m512i post_tf_hi_s1 =
+  M512I_BYTE(0x00, 0xf9, 0x86, 0x7f, 0xd7, 0x2e, 0x51, 0xa8,
+	     0xa4, 0x5d, 0x22, 0xdb, 0x73, 0x8a, 0xf5, 0x0c);
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox2:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  ) <<< 1
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const __m512i post_tf_lo_s2 =
+  M512I_BYTE(0x78, 0x99, 0x9f, 0x7e, 0x64, 0x85, 0x83, 0x62,
+	     0xb9, 0x58, 0x5e, 0xbf, 0xa5, 0x44, 0x42, 0xa3);
+
+static const __m512i post_tf_hi_s2 =
+  M512I_BYTE(0x00, 0xf3, 0x0d, 0xfe, 0xaf, 0x5c, 0xa2, 0x51,
+	     0x49, 0xba, 0x44, 0xb7, 0xe6, 0x15, 0xeb, 0x18);
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox3:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  ) >>> 1
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const __m512i post_tf_lo_s3 =
+  M512I_BYTE(0x1e, 0x66, 0xe7, 0x9f, 0x19, 0x61, 0xe0, 0x98,
+	     0x6e, 0x16, 0x97, 0xef, 0x69, 0x11, 0x90, 0xe8);
+
+static const __m512i post_tf_hi_s3 =
+  M512I_BYTE(0x00, 0xfc, 0x43, 0xbf, 0xeb, 0x17, 0xa8, 0x54,
+	     0x52, 0xae, 0x11, 0xed, 0xb9, 0x45, 0xfa, 0x06);
+
+/* For isolating SubBytes from AESENCLAST, inverse shift row */
+static const __m512i inv_shift_row =
+  M512I_BYTE(0x00, 0x0d, 0x0a, 0x07, 0x04, 0x01, 0x0e, 0x0b,
+	     0x08, 0x05, 0x02, 0x0f, 0x0c, 0x09, 0x06, 0x03);
+
+/* 4-bit mask */
+static const __m512i mask_0f =
+  M512I_U32(0x0f0f0f0f, 0x0f0f0f0f, 0x0f0f0f0f, 0x0f0f0f0f);
+
+#endif /* USE_GFNI */
+
+/* Encrypts 64 input block from IN and writes result to OUT. IN and OUT may
+ * unaligned pointers. */
+void camellia_encrypt_64blks_simd512(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m512i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m512i ab[8];
+  __m512i cd[8];
+  __m512i tmp0, tmp1;
+  unsigned int lastk;
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	       x15, in, ctx->key_table[0]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  enc_blk64(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, lastk, tmp0, tmp1);
+
+  write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
+	       x8, out);
+}
+
+/* Decrypts 64 input block from IN and writes result to OUT. IN and OUT may
+ * unaligned pointers. */
+void camellia_decrypt_64blks_simd512(struct camellia_simd_ctx *ctx, void *vout,
+				     const void *vin)
+{
+  char *out = vout;
+  const char *in = vin;
+  __m512i x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
+  __m512i ab[8];
+  __m512i cd[8];
+  __m512i tmp0, tmp1;
+  unsigned int firstk;
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  inpack16_pre(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	       x15, in, ctx->key_table[firstk]);
+
+  inpack16_post(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+		x15, ab, cd);
+
+  dec_blk64(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, ab, cd, firstk, tmp0, tmp1);
+
+  write_output(x7, x6, x5, x4, x3, x2, x1, x0, x15, x14, x13, x12, x11, x10, x9,
+	       x8, out);
+}
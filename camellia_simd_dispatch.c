@@ -0,0 +1,1112 @@
+/*
+ * Copyright (C) 2026 camellia-simd-aesni contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Runtime selection of Camellia kernel implementation.
+ *
+ * Each kernel variant of the architecture (intrinsics and assembly, with
+ * AES-NI, VAES, GFNI, AVX2 and AVX-512 on x86-64) is built together with
+ * matching build of camellia_simd_modes.c and partially linked to one
+ * object, where variant name is appended to all global symbols (see
+ * 'camellia_impl_*.o' rules in Makefile). This file provides the public
+ * functions of camellia_simd.h on top of those: each call goes through
+ * function pointer table of implementation selected by CPU features (CPUID
+ * on x86-64, HWCAP on AArch64) on first use.
+ *
+ * Environment variable CAMELLIA_SIMD_IMPL may be set to name of
+ * implementation to use instead of the preferred one, for testing and
+ * benchmarking. Unknown or unsupported names are ignored, as is the
+ * variable itself in setuid and setgid programs.
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "camellia_simd.h"
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#elif defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_AES
+#define HWCAP_AES (1 << 3)
+#endif
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+#ifndef HWCAP2_SVE2
+#define HWCAP2_SVE2 (1 << 1)
+#endif
+#ifndef HWCAP2_SVEAES
+#define HWCAP2_SVEAES (1 << 2)
+#endif
+#endif
+
+/**********************************************************************
+  dispatched functions
+ **********************************************************************/
+
+/* FUNC(ret, name, params, args, op, nblks, x) for functions returning
+ * value, PROC(name, params, args, op, nblks, x) for functions returning
+ * void. OP is the autotuned operation the function belongs to (OP_NONE for
+ * kernels, which always go to the selected implementation) and NBLKS its
+ * size in blocks, for picking the size class. X is passed through to
+ * FUNC/PROC. Kernels specific to some of the implementations (SIMD256,
+ * SIMD512, SVE2) are left out; these are used by the modes inside each
+ * implementation. */
+#define DISPATCH_FUNCS(FUNC, PROC, x) \
+  FUNC(int, camellia_keysetup_simd128, \
+       (struct camellia_simd_ctx *ctx, const void *key, unsigned int keylen), \
+       (ctx, key, keylen), OP_NONE, 0, x) \
+  FUNC(int, have_camellia_1blk_simd128, (void), (), OP_NONE, 0, x) \
+  PROC(camellia_encrypt_1blk_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nblocks), \
+       (ctx, out, in, nblocks), OP_NONE, 0, x) \
+  PROC(camellia_decrypt_1blk_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nblocks), \
+       (ctx, out, in, nblocks), OP_NONE, 0, x) \
+  PROC(camellia_encrypt_2blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in), \
+       (ctx, out, in), OP_NONE, 0, x) \
+  PROC(camellia_decrypt_2blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in), \
+       (ctx, out, in), OP_NONE, 0, x) \
+  PROC(camellia_encrypt_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in), \
+       (ctx, out, in), OP_NONE, 0, x) \
+  PROC(camellia_decrypt_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in), \
+       (ctx, out, in), OP_NONE, 0, x) \
+  FUNC(int, have_camellia_32blks_simd128, (void), (), OP_NONE, 0, x) \
+  PROC(camellia_encrypt_32blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in), \
+       (ctx, out, in), OP_NONE, 0, x) \
+  PROC(camellia_decrypt_32blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in), \
+       (ctx, out, in), OP_NONE, 0, x) \
+  PROC(camellia_ecb_enc_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nchunks), \
+       (ctx, out, in, nchunks), OP_NONE, 0, x) \
+  PROC(camellia_ecb_dec_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nchunks), \
+       (ctx, out, in, nchunks), OP_NONE, 0, x) \
+  PROC(camellia_ctr_enc_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, void *ctr), \
+       (ctx, out, in, ctr), OP_NONE, 0, x) \
+  PROC(camellia_cbc_dec_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, void *iv), \
+       (ctx, out, in, iv), OP_NONE, 0, x) \
+  PROC(camellia_cfb_dec_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, void *iv), \
+       (ctx, out, in, iv), OP_NONE, 0, x) \
+  PROC(camellia_xts_enc_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	void *tweak), \
+       (ctx, out, in, tweak), OP_NONE, 0, x) \
+  PROC(camellia_xts_dec_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	void *tweak), \
+       (ctx, out, in, tweak), OP_NONE, 0, x) \
+  PROC(camellia_ocb_enc_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	void *offset, void *checksum, const void *Ls[16]), \
+       (ctx, out, in, offset, checksum, Ls), OP_NONE, 0, x) \
+  PROC(camellia_ocb_dec_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	void *offset, void *checksum, const void *Ls[16]), \
+       (ctx, out, in, offset, checksum, Ls), OP_NONE, 0, x) \
+  PROC(camellia_ocb_auth_16blks_simd128, \
+       (struct camellia_simd_ctx *ctx, const void *abuf, void *offset, \
+	void *sum, const void *Ls[16]), \
+       (ctx, abuf, offset, sum, Ls), OP_NONE, 0, x) \
+  PROC(camellia_ecb_encrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nblks), \
+       (ctx, out, in, nblks), OP_ECB_ENC, nblks, x) \
+  PROC(camellia_ecb_decrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nblks), \
+       (ctx, out, in, nblks), OP_ECB_DEC, nblks, x) \
+  PROC(camellia_ctr_crypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nbytes, void *ctr), \
+       (ctx, out, in, nbytes, ctr), OP_CTR, nbytes / 16, x) \
+  PROC(camellia_cbc_decrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nblks, void *iv), \
+       (ctx, out, in, nblks, iv), OP_CBC_DEC, nblks, x) \
+  PROC(camellia_cbc_encrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nblks, void *iv), \
+       (ctx, out, in, nblks, iv), OP_CBC_ENC, nblks, x) \
+  PROC(camellia_cbc_encrypt_multi, \
+       (struct camellia_simd_ctx *ctx, const struct camellia_cbc_job *jobs, \
+	size_t njobs), \
+       (ctx, jobs, njobs), OP_CBC_ENC_MULTI, 0, x) \
+  PROC(camellia_cfb_encrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nbytes, void *iv), \
+       (ctx, out, in, nbytes, iv), OP_CFB_ENC, nbytes / 16, x) \
+  PROC(camellia_cfb_decrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nbytes, void *iv), \
+       (ctx, out, in, nbytes, iv), OP_CFB_DEC, nbytes / 16, x) \
+  FUNC(int, camellia_xts_encrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nbytes, void *tweak), \
+       (ctx, out, in, nbytes, tweak), OP_XTS, nbytes / 16, x) \
+  FUNC(int, camellia_xts_decrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nbytes, void *tweak), \
+       (ctx, out, in, nbytes, tweak), OP_XTS, nbytes / 16, x) \
+  PROC(camellia_ocb_setkey, \
+       (struct camellia_ocb_ctx *ocb, struct camellia_simd_ctx *ctx), \
+       (ocb, ctx), OP_OCB, 0, x) \
+  FUNC(int, camellia_ocb_set_nonce, \
+       (struct camellia_ocb_ctx *ocb, const void *nonce, size_t noncelen, \
+	size_t taglen), \
+       (ocb, nonce, noncelen, taglen), OP_OCB, 0, x) \
+  PROC(camellia_ocb_authenticate, \
+       (struct camellia_ocb_ctx *ocb, const void *aad, size_t nbytes), \
+       (ocb, aad, nbytes), OP_OCB, 0, x) \
+  PROC(camellia_ocb_encrypt, \
+       (struct camellia_ocb_ctx *ocb, void *out, const void *in, \
+	size_t nbytes), \
+       (ocb, out, in, nbytes), OP_OCB, 0, x) \
+  PROC(camellia_ocb_decrypt, \
+       (struct camellia_ocb_ctx *ocb, void *out, const void *in, \
+	size_t nbytes), \
+       (ocb, out, in, nbytes), OP_OCB, 0, x) \
+  PROC(camellia_ocb_get_tag, \
+       (struct camellia_ocb_ctx *ocb, void *tag), \
+       (ocb, tag), OP_OCB, 0, x) \
+  FUNC(int, camellia_ocb_check_tag, \
+       (struct camellia_ocb_ctx *ocb, const void *tag), \
+       (ocb, tag), OP_OCB, 0, x) \
+  PROC(camellia_gcm_setkey, \
+       (struct camellia_gcm_ctx *gcm, struct camellia_simd_ctx *ctx), \
+       (gcm, ctx), OP_GCM, 0, x) \
+  FUNC(int, camellia_gcm_set_iv, \
+       (struct camellia_gcm_ctx *gcm, const void *iv, size_t ivlen), \
+       (gcm, iv, ivlen), OP_GCM, 0, x) \
+  PROC(camellia_gcm_authenticate, \
+       (struct camellia_gcm_ctx *gcm, const void *aad, size_t nbytes), \
+       (gcm, aad, nbytes), OP_GCM, 0, x) \
+  PROC(camellia_gcm_encrypt, \
+       (struct camellia_gcm_ctx *gcm, void *out, const void *in, \
+	size_t nbytes), \
+       (gcm, out, in, nbytes), OP_GCM, 0, x) \
+  PROC(camellia_gcm_decrypt, \
+       (struct camellia_gcm_ctx *gcm, void *out, const void *in, \
+	size_t nbytes), \
+       (gcm, out, in, nbytes), OP_GCM, 0, x) \
+  PROC(camellia_gcm_get_tag, \
+       (struct camellia_gcm_ctx *gcm, void *tag, size_t taglen), \
+       (gcm, tag, taglen), OP_GCM, 0, x) \
+  FUNC(int, camellia_gcm_check_tag, \
+       (struct camellia_gcm_ctx *gcm, const void *tag, size_t taglen), \
+       (gcm, tag, taglen), OP_GCM, 0, x) \
+  FUNC(int, camellia_ccm_encrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nbytes, const void *nonce, size_t noncelen, const void *aad, \
+	size_t aadlen, void *tag, size_t taglen), \
+       (ctx, out, in, nbytes, nonce, noncelen, aad, aadlen, tag, taglen), \
+       OP_CCM, 0, x) \
+  FUNC(int, camellia_ccm_decrypt, \
+       (struct camellia_simd_ctx *ctx, void *out, const void *in, \
+	size_t nbytes, const void *nonce, size_t noncelen, const void *aad, \
+	size_t aadlen, const void *tag, size_t taglen), \
+       (ctx, out, in, nbytes, nonce, noncelen, aad, aadlen, tag, taglen), \
+       OP_CCM, 0, x) \
+  FUNC(int, camellia_ccm_encrypt_multi, \
+       (struct camellia_simd_ctx *ctx, struct camellia_ccm_msg *msgs, \
+	size_t nmsgs, size_t noncelen, size_t taglen), \
+       (ctx, msgs, nmsgs, noncelen, taglen), OP_CCM, 0, x) \
+  FUNC(int, camellia_ccm_decrypt_multi, \
+       (struct camellia_simd_ctx *ctx, struct camellia_ccm_msg *msgs, \
+	size_t nmsgs, size_t noncelen, size_t taglen), \
+       (ctx, msgs, nmsgs, noncelen, taglen), OP_CCM, 0, x) \
+  PROC(camellia_cmac_setkey, \
+       (struct camellia_cmac_ctx *cmac, struct camellia_simd_ctx *ctx), \
+       (cmac, ctx), OP_CMAC, 0, x) \
+  PROC(camellia_cmac, \
+       (const struct camellia_cmac_ctx *cmac, void *mac, const void *in, \
+	size_t nbytes), \
+       (cmac, mac, in, nbytes), OP_CMAC, 0, x) \
+  PROC(camellia_cmac_multi, \
+       (const struct camellia_cmac_ctx *cmac, \
+	const struct camellia_cmac_msg *msgs, size_t nmsgs), \
+       (cmac, msgs, nmsgs), OP_CMAC, 0, x) \
+  FUNC(int, camellia_stream_init, \
+       (struct camellia_stream_ctx *st, struct camellia_simd_ctx *key, \
+	int mode, const void *iv), \
+       (st, key, mode, iv), OP_NONE, 0, x) \
+  FUNC(size_t, camellia_stream_update, \
+       (struct camellia_stream_ctx *st, void *out, const void *in, \
+	size_t nbytes), \
+       (st, out, in, nbytes), OP_NONE, 0, x) \
+  FUNC(int, camellia_stream_final, \
+       (struct camellia_stream_ctx *st, void *out, size_t *outlen), \
+       (st, out, outlen), OP_NONE, 0, x) \
+  FUNC(int, camellia_ecb_encrypt_iov, \
+       (struct camellia_simd_ctx *ctx, const struct iovec *dst, \
+	size_t dstcnt, const struct iovec *src, size_t srccnt), \
+       (ctx, dst, dstcnt, src, srccnt), OP_NONE, 0, x) \
+  FUNC(int, camellia_ecb_decrypt_iov, \
+       (struct camellia_simd_ctx *ctx, const struct iovec *dst, \
+	size_t dstcnt, const struct iovec *src, size_t srccnt), \
+       (ctx, dst, dstcnt, src, srccnt), OP_NONE, 0, x) \
+  FUNC(int, camellia_ctr_crypt_iov, \
+       (struct camellia_simd_ctx *ctx, const struct iovec *dst, \
+	size_t dstcnt, const struct iovec *src, size_t srccnt, void *ctr), \
+       (ctx, dst, dstcnt, src, srccnt, ctr), OP_NONE, 0, x) \
+  FUNC(int, camellia_cbc_decrypt_iov, \
+       (struct camellia_simd_ctx *ctx, const struct iovec *dst, \
+	size_t dstcnt, const struct iovec *src, size_t srccnt, void *iv), \
+       (ctx, dst, dstcnt, src, srccnt, iv), OP_NONE, 0, x)
+
+/* Operations tuned separately by camellia_simd_autotune(). Functions that
+ * share a context (OCB, GCM, CCM, CMAC) are one operation, so that context
+ * is always used with the implementation it was set up with. */
+enum tune_op
+{
+  OP_ECB_ENC,
+  OP_ECB_DEC,
+  OP_CTR,
+  OP_CBC_ENC,
+  OP_CBC_DEC,
+  OP_CBC_ENC_MULTI,
+  OP_CFB_ENC,
+  OP_CFB_DEC,
+  OP_XTS,
+  OP_OCB,
+  OP_GCM,
+  OP_CCM,
+  OP_CMAC,
+  NUM_TUNE_OPS,
+  OP_NONE = NUM_TUNE_OPS
+};
+
+/**********************************************************************
+  implementation table
+ **********************************************************************/
+
+struct camellia_simd_impl
+{
+  const char *name;
+  int (*supported)(void);
+  unsigned int *min_tail_blks;
+#define FUNC_PTR(ret, name, params, args, op, nblks, x) ret (*name) params;
+#define PROC_PTR(name, params, args, op, nblks, x) void (*name) params;
+  DISPATCH_FUNCS(FUNC_PTR, PROC_PTR, _)
+#undef FUNC_PTR
+#undef PROC_PTR
+};
+
+/* Declare functions of implementation SFX, named <function>_<SFX>, its
+ * copy of tail threshold of camellia_simd_modes.c, and table entry for it. */
+#define DECLARE_FUNC(ret, name, params, args, op, nblks, sfx) \
+	extern ret name##_##sfx params;
+#define DECLARE_PROC(name, params, args, op, nblks, sfx) \
+	extern void name##_##sfx params;
+#define DECLARE_IMPL(sfx) \
+	DISPATCH_FUNCS(DECLARE_FUNC, DECLARE_PROC, sfx) \
+	extern unsigned int camellia_min_tail_blks_for_parallel_##sfx;
+
+#define INIT_FUNC(ret, name, params, args, op, nblks, sfx) name##_##sfx,
+#define INIT_PROC(name, params, args, op, nblks, sfx) name##_##sfx,
+#define IMPL(sfx, supported_fn) \
+	{ #sfx, supported_fn, &camellia_min_tail_blks_for_parallel_##sfx, \
+	  DISPATCH_FUNCS(INIT_FUNC, INIT_PROC, sfx) }
+
+#if defined(__x86_64__)
+
+static int cpu_avx512(void)
+{
+  return __builtin_cpu_supports("avx512f") &&
+	 __builtin_cpu_supports("avx512vl") &&
+	 __builtin_cpu_supports("avx512bw") &&
+	 __builtin_cpu_supports("avx512dq");
+}
+
+static int supports_avx512_intrinsics(void)
+{
+  /* Intrinsics objects are built with CFLAGS_DISPATCH_X86_AVX512, which
+   * enables both VAES and GFNI. */
+  return cpu_avx512() && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul") &&
+	 __builtin_cpu_supports("vaes") &&
+	 __builtin_cpu_supports("vpclmulqdq") &&
+	 __builtin_cpu_supports("gfni");
+}
+
+static int supports_gfni_avx512_asm(void)
+{
+  return cpu_avx512() && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("gfni");
+}
+
+static int supports_vaes_avx512_asm(void)
+{
+  return cpu_avx512() && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("vaes");
+}
+
+static int supports_vaes_avx2(void)
+{
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("vaes");
+}
+
+static int supports_aesni_avx2(void)
+{
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul");
+}
+
+static int supports_gfni_avx2_asm(void)
+{
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("gfni");
+}
+
+static int supports_vaes_avx2_asm(void)
+{
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("vaes");
+}
+
+static int supports_aesni_avx2_asm(void)
+{
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul");
+}
+
+static int supports_aesni_avx(void)
+{
+  return __builtin_cpu_supports("avx") && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul");
+}
+
+static int supports_gfni_sse(void)
+{
+  return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("aes") &&
+	 __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("gfni");
+}
+
+static int supports_bitslice_ssse3(void)
+{
+  return __builtin_cpu_supports("ssse3");
+}
+
+DECLARE_IMPL(gfni_avx512)
+DECLARE_IMPL(vaes_avx512)
+DECLARE_IMPL(gfni_avx512_asm)
+DECLARE_IMPL(vaes_avx512_asm)
+DECLARE_IMPL(gfni_avx2_asm)
+DECLARE_IMPL(vaes_avx2)
+DECLARE_IMPL(vaes_avx2_asm)
+DECLARE_IMPL(aesni_avx2)
+DECLARE_IMPL(aesni_avx2_asm)
+DECLARE_IMPL(aesni_avx)
+DECLARE_IMPL(aesni_avx_asm)
+DECLARE_IMPL(gfni_sse)
+DECLARE_IMPL(bitslice_ssse3)
+
+/* In order of preference. Where intrinsics and assembly variants need same
+ * CPU features, intrinsics variant comes first as it has stitched mode
+ * kernels (CTR, CBC, XTS, OCB, GCM), while assembly variants use generic
+ * ones. Modes of all variants but bitslice_ssse3 are built with -mpclmul for
+ * GHASH. */
+static const struct camellia_simd_impl impls[] = {
+  IMPL(gfni_avx512, supports_avx512_intrinsics),
+  IMPL(vaes_avx512, supports_avx512_intrinsics),
+  IMPL(gfni_avx512_asm, supports_gfni_avx512_asm),
+  IMPL(vaes_avx512_asm, supports_vaes_avx512_asm),
+  IMPL(gfni_avx2_asm, supports_gfni_avx2_asm),
+  IMPL(vaes_avx2, supports_vaes_avx2),
+  IMPL(vaes_avx2_asm, supports_vaes_avx2_asm),
+  IMPL(aesni_avx2, supports_aesni_avx2),
+  IMPL(aesni_avx2_asm, supports_aesni_avx2_asm),
+  IMPL(aesni_avx, supports_aesni_avx),
+  IMPL(aesni_avx_asm, supports_aesni_avx),
+  IMPL(gfni_sse, supports_gfni_sse),
+  IMPL(bitslice_ssse3, supports_bitslice_ssse3),
+};
+
+static void cpu_init(void)
+{
+  __builtin_cpu_init();
+}
+
+static void cpu_model(char *buf, size_t buflen)
+{
+  unsigned int brand[12];
+  unsigned int i;
+
+  if (__get_cpuid_max(0x80000000, NULL) < 0x80000004) {
+    snprintf(buf, buflen, "unknown");
+    return;
+  }
+
+  for (i = 0; i < 3; i++)
+    __cpuid(0x80000002 + i, brand[i * 4 + 0], brand[i * 4 + 1],
+	    brand[i * 4 + 2], brand[i * 4 + 3]);
+
+  snprintf(buf, buflen, "%.48s", (const char *)brand);
+}
+
+#elif defined(__aarch64__)
+
+static int supports_sve2_aes(void)
+{
+  return (getauxval(AT_HWCAP) & HWCAP_AES) &&
+	 (getauxval(AT_HWCAP) & HWCAP_PMULL) &&
+	 (getauxval(AT_HWCAP2) & HWCAP2_SVE2) &&
+	 (getauxval(AT_HWCAP2) & HWCAP2_SVEAES);
+}
+
+static int supports_ce(void)
+{
+  return (getauxval(AT_HWCAP) & HWCAP_AES) &&
+	 (getauxval(AT_HWCAP) & HWCAP_PMULL);
+}
+
+static int supports_bitslice_neon(void)
+{
+  /* Advanced SIMD is mandatory on AArch64 Linux. */
+  return 1;
+}
+
+DECLARE_IMPL(sve2_aes)
+DECLARE_IMPL(ce)
+DECLARE_IMPL(ce_asm)
+DECLARE_IMPL(bitslice_neon)
+
+static const struct camellia_simd_impl impls[] = {
+  IMPL(sve2_aes, supports_sve2_aes),
+  IMPL(ce, supports_ce),
+  IMPL(ce_asm, supports_ce),
+  IMPL(bitslice_neon, supports_bitslice_neon),
+};
+
+static void cpu_init(void)
+{
+}
+
+static void cpu_model(char *buf, size_t buflen)
+{
+  FILE *f;
+
+  snprintf(buf, buflen, "unknown");
+
+  f = fopen("/sys/devices/system/cpu/cpu0/regs/identification/midr_el1",
+	    "r");
+  if (!f)
+    return;
+  if (!fgets(buf, buflen, f))
+    snprintf(buf, buflen, "unknown");
+  fclose(f);
+}
+
+#else
+#error "Runtime dispatch is implemented for x86-64 and AArch64 only."
+#endif
+
+#define NUM_IMPLS (sizeof(impls) / sizeof(impls[0]))
+
+
+/**********************************************************************
+  selection
+ **********************************************************************/
+
+/* Size classes for autotuning, by number of blocks per call: under 16,
+ * under 128 and 128 or more. Operations with context are not split by
+ * size and always use first class. */
+#define NUM_SIZE_CLASSES 3
+
+static const struct camellia_simd_impl *curr_impl;
+static const struct camellia_simd_impl *tuned_impls[NUM_TUNE_OPS]
+						   [NUM_SIZE_CLASSES];
+
+static const struct camellia_simd_impl *find_impl(const char *name)
+{
+  size_t i;
+
+  for (i = 0; i < NUM_IMPLS; i++) {
+    if (strcmp(impls[i].name, name) == 0)
+      return impls[i].supported() ? &impls[i] : NULL;
+  }
+
+  return NULL;
+}
+
+static void clear_tuned_impls(void)
+{
+  unsigned int op, sc;
+
+  for (op = 0; op < NUM_TUNE_OPS; op++)
+    for (sc = 0; sc < NUM_SIZE_CLASSES; sc++)
+      __atomic_store_n(&tuned_impls[op][sc], NULL, __ATOMIC_RELEASE);
+}
+
+/* CAMELLIA_SIMD_IMPL, unless running with elevated privileges. */
+static const char *impl_env(void)
+{
+#if defined(__GLIBC__)
+  return secure_getenv("CAMELLIA_SIMD_IMPL");
+#else
+  if (getuid() != geteuid() || getgid() != getegid())
+    return NULL;
+  return getenv("CAMELLIA_SIMD_IMPL");
+#endif
+}
+
+/* Select implementation named in CAMELLIA_SIMD_IMPL if set and supported,
+ * otherwise first supported one. Last entry of table is baseline for the
+ * architecture and used if nothing else is supported. Selection is
+ * idempotent, so threads racing here on first use store same pointer. */
+static const struct camellia_simd_impl *select_impl(void)
+{
+  const struct camellia_simd_impl *impl = NULL;
+  const char *env;
+  size_t i;
+
+  cpu_init();
+
+  env = impl_env();
+  if (env)
+    impl = find_impl(env);
+
+  for (i = 0; !impl && i < NUM_IMPLS; i++) {
+    if (impls[i].supported())
+      impl = &impls[i];
+  }
+
+  if (!impl)
+    impl = &impls[NUM_IMPLS - 1];
+
+  __atomic_store_n(&curr_impl, impl, __ATOMIC_RELEASE);
+  return impl;
+}
+
+static inline const struct camellia_simd_impl *get_impl(void)
+{
+  const struct camellia_simd_impl *impl;
+
+  impl = __atomic_load_n(&curr_impl, __ATOMIC_ACQUIRE);
+  if (__builtin_expect(impl == NULL, 0))
+    impl = select_impl();
+
+  return impl;
+}
+
+static inline unsigned int size_class(size_t nblks)
+{
+  return (nblks >= 16) + (nblks >= 128);
+}
+
+/* Autotuned implementation for OP with NBLKS blocks, or selected
+ * implementation if OP has not been tuned. */
+static inline const struct camellia_simd_impl *get_op_impl(unsigned int op,
+							   size_t nblks)
+{
+  const struct camellia_simd_impl *impl = NULL;
+
+  if (op != OP_NONE)
+    impl = __atomic_load_n(&tuned_impls[op][size_class(nblks)],
+			   __ATOMIC_ACQUIRE);
+
+  return impl ? impl : get_impl();
+}
+
+const char *camellia_simd_impl_name(void)
+{
+  return get_impl()->name;
+}
+
+const char *camellia_simd_impl_available(unsigned int idx)
+{
+  size_t i;
+
+  cpu_init();
+
+  for (i = 0; i < NUM_IMPLS; i++) {
+    if (!impls[i].supported())
+      continue;
+    if (idx-- == 0)
+      return impls[i].name;
+  }
+
+  return NULL;
+}
+
+int camellia_simd_set_impl(const char *name)
+{
+  const struct camellia_simd_impl *impl;
+
+  cpu_init();
+
+  impl = find_impl(name);
+  if (!impl)
+    return -1;
+
+  clear_tuned_impls();
+  __atomic_store_n(&curr_impl, impl, __ATOMIC_RELEASE);
+  return 0;
+}
+
+/**********************************************************************
+  autotuning
+ **********************************************************************/
+
+#define TUNE_CACHE_VERSION 2
+
+/* Time spent on benchmarking each implementation per operation and size
+ * class. */
+#define TUNE_NSECS (2 * 1000 * 1000)
+
+/* Benchmark sizes for each size class, and for operations with context. */
+#define TUNE_MAX_BLKS 512
+static const size_t tune_class_blks[NUM_SIZE_CLASSES] = { 8, 64, 512 };
+#define TUNE_CTX_BLKS 64
+
+static const struct
+{
+  const char *name;
+  int sized;
+} tune_ops[NUM_TUNE_OPS] = {
+  [OP_ECB_ENC] = { "ecb_enc", 1 },
+  [OP_ECB_DEC] = { "ecb_dec", 1 },
+  [OP_CTR] = { "ctr", 1 },
+  [OP_CBC_ENC] = { "cbc_enc", 1 },
+  [OP_CBC_DEC] = { "cbc_dec", 1 },
+  [OP_CBC_ENC_MULTI] = { "cbc_enc_multi", 0 },
+  [OP_CFB_ENC] = { "cfb_enc", 1 },
+  [OP_CFB_DEC] = { "cfb_dec", 1 },
+  [OP_XTS] = { "xts", 1 },
+  [OP_OCB] = { "ocb", 0 },
+  [OP_GCM] = { "gcm", 0 },
+  [OP_CCM] = { "ccm", 0 },
+  [OP_CMAC] = { "cmac", 0 },
+};
+
+static const char *const size_class_names[NUM_SIZE_CLASSES] = {
+  "small", "medium", "large"
+};
+
+struct tune_state
+{
+  struct camellia_simd_ctx ctx;
+  struct camellia_ocb_ctx ocb;
+  struct camellia_gcm_ctx gcm;
+  struct camellia_cmac_ctx cmac;
+  struct camellia_cbc_job jobs[16];
+  uint8_t iv[16][16];
+  uint8_t tag[16];
+  uint8_t buf[TUNE_MAX_BLKS * 16];
+};
+
+static uint64_t tune_clock_nsecs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+static void tune_setup(const struct camellia_simd_impl *impl,
+		       struct tune_state *st)
+{
+  static const uint8_t key[16] = { 0 };
+
+  impl->camellia_keysetup_simd128(&st->ctx, key, sizeof(key));
+  impl->camellia_ocb_setkey(&st->ocb, &st->ctx);
+  impl->camellia_gcm_setkey(&st->gcm, &st->ctx);
+  impl->camellia_cmac_setkey(&st->cmac, &st->ctx);
+}
+
+static void tune_run_op(const struct camellia_simd_impl *impl,
+			struct tune_state *st, unsigned int op, size_t nblks)
+{
+  uint8_t *buf = st->buf;
+  size_t nbytes = nblks * 16;
+  size_t i;
+
+  switch (op) {
+    case OP_ECB_ENC:
+      impl->camellia_ecb_encrypt(&st->ctx, buf, buf, nblks);
+      break;
+    case OP_ECB_DEC:
+      impl->camellia_ecb_decrypt(&st->ctx, buf, buf, nblks);
+      break;
+    case OP_CTR:
+      impl->camellia_ctr_crypt(&st->ctx, buf, buf, nbytes, st->iv[0]);
+      break;
+    case OP_CBC_ENC:
+      impl->camellia_cbc_encrypt(&st->ctx, buf, buf, nblks, st->iv[0]);
+      break;
+    case OP_CBC_DEC:
+      impl->camellia_cbc_decrypt(&st->ctx, buf, buf, nblks, st->iv[0]);
+      break;
+    case OP_CBC_ENC_MULTI:
+      for (i = 0; i < 16; i++) {
+	st->jobs[i].in = buf + i * (nbytes / 16);
+	st->jobs[i].out = buf + i * (nbytes / 16);
+	st->jobs[i].nblks = nblks / 16;
+	st->jobs[i].iv = st->iv[i];
+      }
+      impl->camellia_cbc_encrypt_multi(&st->ctx, st->jobs, 16);
+      break;
+    case OP_CFB_ENC:
+      impl->camellia_cfb_encrypt(&st->ctx, buf, buf, nbytes, st->iv[0]);
+      break;
+    case OP_CFB_DEC:
+      impl->camellia_cfb_decrypt(&st->ctx, buf, buf, nbytes, st->iv[0]);
+      break;
+    case OP_XTS:
+      impl->camellia_xts_encrypt(&st->ctx, buf, buf, nbytes, st->iv[0]);
+      break;
+    case OP_OCB:
+      impl->camellia_ocb_set_nonce(&st->ocb, st->iv[0], 12, 16);
+      impl->camellia_ocb_encrypt(&st->ocb, buf, buf, nbytes);
+      impl->camellia_ocb_get_tag(&st->ocb, st->tag);
+      break;
+    case OP_GCM:
+      impl->camellia_gcm_set_iv(&st->gcm, st->iv[0], 12);
+      impl->camellia_gcm_encrypt(&st->gcm, buf, buf, nbytes);
+      impl->camellia_gcm_get_tag(&st->gcm, st->tag, 16);
+      break;
+    case OP_CCM:
+      impl->camellia_ccm_encrypt(&st->ctx, buf, buf, nbytes, st->iv[0], 12,
+				 NULL, 0, st->tag, 16);
+      break;
+    case OP_CMAC:
+      impl->camellia_cmac(&st->cmac, st->tag, buf, nbytes);
+      break;
+  }
+}
+
+/* Returns number of calls of OP with NBLKS blocks done in TUNE_NSECS,
+ * scaled to calls per second. */
+static uint64_t tune_bench(const struct camellia_simd_impl *impl,
+			   struct tune_state *st, unsigned int op,
+			   size_t nblks)
+{
+  uint64_t start, now, ncalls = 0;
+
+  tune_run_op(impl, st, op, nblks);
+
+  start = tune_clock_nsecs();
+  do {
+    tune_run_op(impl, st, op, nblks);
+    ncalls++;
+    now = tune_clock_nsecs();
+  } while (now - start < TUNE_NSECS);
+
+  return ncalls * 1000 * 1000 * 1000 / (now - start);
+}
+
+/* Set tail threshold of IMPL to smallest tail, in blocks, for which running
+ * parallel kernel on padded input is at least as fast as 1-block kernel,
+ * timed with ECB encryption. Padded parallel pass costs the same for any
+ * tail length and is timed once, as best of two runs so that an interrupted
+ * run does not push threshold up; 1-block path is timed from 1 block up
+ * until it gets slower. 16 means tails always use 1-block kernel. */
+static void tune_min_tail(const struct camellia_simd_impl *impl,
+			  struct tune_state *st)
+{
+  uint64_t parallel_rate, rate;
+  unsigned int n;
+
+  __atomic_store_n(impl->min_tail_blks, 1, __ATOMIC_RELAXED);
+  parallel_rate = tune_bench(impl, st, OP_ECB_ENC, 8);
+  rate = tune_bench(impl, st, OP_ECB_ENC, 8);
+  if (rate > parallel_rate)
+    parallel_rate = rate;
+
+  __atomic_store_n(impl->min_tail_blks, 16, __ATOMIC_RELAXED);
+  for (n = 1; n < 16; n++) {
+    if (tune_bench(impl, st, OP_ECB_ENC, n) < parallel_rate)
+      break;
+  }
+
+  __atomic_store_n(impl->min_tail_blks, n, __ATOMIC_RELAXED);
+}
+
+static int tune_measure(void)
+{
+  const struct camellia_simd_impl *best[NUM_TUNE_OPS][NUM_SIZE_CLASSES];
+  uint64_t best_rate[NUM_TUNE_OPS][NUM_SIZE_CLASSES] = { { 0 } };
+  struct tune_state *st;
+  unsigned int op, sc;
+  uint64_t rate;
+  size_t i;
+
+  st = calloc(1, sizeof(*st));
+  if (!st)
+    return -1;
+
+  for (i = 0; i < NUM_IMPLS; i++) {
+    if (!impls[i].supported())
+      continue;
+
+    tune_setup(&impls[i], st);
+    tune_min_tail(&impls[i], st);
+
+    for (op = 0; op < NUM_TUNE_OPS; op++) {
+      for (sc = 0; sc < NUM_SIZE_CLASSES; sc++) {
+	if (!tune_ops[op].sized && sc > 0)
+	  break;
+
+	rate = tune_bench(&impls[i], st, op,
+			  tune_ops[op].sized ? tune_class_blks[sc]
+					     : TUNE_CTX_BLKS);
+	if (rate > best_rate[op][sc]) {
+	  best_rate[op][sc] = rate;
+	  best[op][sc] = &impls[i];
+	}
+      }
+    }
+  }
+
+  free(st);
+
+  for (op = 0; op < NUM_TUNE_OPS; op++)
+    for (sc = 0; sc < NUM_SIZE_CLASSES; sc++)
+      __atomic_store_n(&tuned_impls[op][sc],
+		       tune_ops[op].sized ? best[op][sc] : best[op][0],
+		       __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+/* Header lines of cache file: format version, CPU model and implementations
+ * supported by this CPU. Cache is valid only if all three match. Header is
+ * followed by '<op> <size class> <implementation>' line for each operation
+ * and size class, and 'min_tail <implementation> <blocks>' line for each
+ * supported implementation. */
+static void tune_cache_header(char *buf, size_t buflen)
+{
+  char model[128];
+  const char *name;
+  size_t len, i;
+
+  cpu_model(model, sizeof(model));
+  for (i = 0; model[i]; i++) {
+    if ((unsigned char)model[i] < ' ')
+      model[i] = ' ';
+  }
+
+  len = snprintf(buf, buflen, "camellia-simd-autotune %d\ncpu %s\nimpls",
+		 TUNE_CACHE_VERSION, model);
+  for (i = 0; (name = camellia_simd_impl_available(i)) != NULL; i++) {
+    if (len < buflen)
+      len += snprintf(buf + len, buflen - len, " %s", name);
+  }
+  if (len < buflen)
+    snprintf(buf + len, buflen - len, "\n");
+}
+
+static int tune_cache_load(const char *path, const char *header)
+{
+  const struct camellia_simd_impl *loaded[NUM_TUNE_OPS][NUM_SIZE_CLASSES];
+  const struct camellia_simd_impl *impl;
+  unsigned int min_tail[NUM_IMPLS];
+  char line[1024];
+  char opname[32], scname[32], implname[32];
+  size_t header_len = strlen(header);
+  size_t pos = 0;
+  unsigned int nloaded = 0, nexpected = 0;
+  unsigned int op, sc, n;
+  size_t i;
+  FILE *f;
+
+  f = fopen(path, "r");
+  if (!f)
+    return -1;
+
+  /* Header must match line by line. */
+  while (pos < header_len && fgets(line, sizeof(line), f)) {
+    if (strncmp(header + pos, line, strlen(line)) != 0)
+      break;
+    pos += strlen(line);
+  }
+  if (pos != header_len) {
+    fclose(f);
+    return -1;
+  }
+
+  memset(loaded, 0, sizeof(loaded));
+  memset(min_tail, 0, sizeof(min_tail));
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "%31s %31s %31s", opname, scname, implname) != 3)
+      break;
+    if (strcmp(opname, "min_tail") == 0) {
+      impl = find_impl(scname);
+      if (!impl || min_tail[impl - impls] ||
+	  sscanf(implname, "%u", &n) != 1 || n < 1 || n > 16)
+	break;
+      min_tail[impl - impls] = n;
+      nloaded++;
+      continue;
+    }
+    for (op = 0; op < NUM_TUNE_OPS; op++)
+      if (strcmp(opname, tune_ops[op].name) == 0)
+	break;
+    for (sc = 0; sc < NUM_SIZE_CLASSES; sc++)
+      if (strcmp(scname, size_class_names[sc]) == 0)
+	break;
+    if (op == NUM_TUNE_OPS || sc == NUM_SIZE_CLASSES || loaded[op][sc])
+      break;
+    loaded[op][sc] = find_impl(implname);
+    if (!loaded[op][sc])
+      break;
+    nloaded++;
+  }
+  fclose(f);
+
+  for (op = 0; op < NUM_TUNE_OPS; op++)
+    nexpected += tune_ops[op].sized ? NUM_SIZE_CLASSES : 1;
+  for (i = 0; i < NUM_IMPLS; i++)
+    nexpected += impls[i].supported() ? 1 : 0;
+  if (nloaded != nexpected)
+    return -1;
+
+  for (i = 0; i < NUM_IMPLS; i++)
+    if (min_tail[i])
+      __atomic_store_n(impls[i].min_tail_blks, min_tail[i],
+		       __ATOMIC_RELAXED);
+
+  for (op = 0; op < NUM_TUNE_OPS; op++)
+    for (sc = 0; sc < NUM_SIZE_CLASSES; sc++)
+      __atomic_store_n(&tuned_impls[op][sc],
+		       tune_ops[op].sized ? loaded[op][sc] : loaded[op][0],
+		       __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+/* Write cache to temporary file first and rename it over PATH, so that
+ * concurrent processes never see partially written cache. Temporary file is
+ * created with mkstemp(), which fails rather than follows an existing file or
+ * symlink at that name. */
+static int tune_cache_store(const char *path, const char *header)
+{
+  char tmppath[4096];
+  unsigned int op, sc;
+  size_t i;
+  FILE *f;
+  int fd, err;
+
+  if (snprintf(tmppath, sizeof(tmppath), "%s.XXXXXX", path)
+      >= (int)sizeof(tmppath))
+    return -1;
+
+  fd = mkstemp(tmppath);
+  if (fd < 0)
+    return -1;
+
+  f = NULL;
+  if (fchmod(fd, 0644) == 0)
+    f = fdopen(fd, "w");
+  if (!f) {
+    close(fd);
+    remove(tmppath);
+    return -1;
+  }
+
+  fputs(header, f);
+  for (op = 0; op < NUM_TUNE_OPS; op++) {
+    for (sc = 0; sc < NUM_SIZE_CLASSES; sc++) {
+      if (!tune_ops[op].sized && sc > 0)
+	break;
+      fprintf(f, "%s %s %s\n", tune_ops[op].name, size_class_names[sc],
+	      tuned_impls[op][sc]->name);
+    }
+  }
+  for (i = 0; i < NUM_IMPLS; i++) {
+    if (impls[i].supported())
+      fprintf(f, "min_tail %s %u\n", impls[i].name,
+	      __atomic_load_n(impls[i].min_tail_blks, __ATOMIC_RELAXED));
+  }
+
+  err = ferror(f);
+  err |= fclose(f);
+  if (err || rename(tmppath, path) != 0) {
+    remove(tmppath);
+    return -1;
+  }
+
+  return 0;
+}
+
+int camellia_simd_autotune(const char *cache_path)
+{
+  char header[1024];
+
+  if (impl_env())
+    return 0;
+
+  get_impl();
+
+  tune_cache_header(header, sizeof(header));
+
+  if (cache_path && tune_cache_load(cache_path, header) == 0)
+    return 0;
+
+  if (tune_measure() != 0)
+    return -1;
+
+  if (cache_path)
+    return tune_cache_store(cache_path, header);
+
+  return 0;
+}
+
+const char *camellia_simd_tuned_impl_name(const char *op, size_t nblks)
+{
+  const struct camellia_simd_impl *impl;
+  unsigned int i;
+
+  for (i = 0; i < NUM_TUNE_OPS; i++) {
+    if (strcmp(op, tune_ops[i].name) == 0)
+      break;
+  }
+  if (i == NUM_TUNE_OPS)
+    return NULL;
+
+  impl = get_op_impl(i, tune_ops[i].sized ? nblks : 0);
+  return impl->name;
+}
+
+/* Only selects implementation by CPU features; autotuning and its cache
+ * file are left to explicit camellia_simd_autotune() calls. */
+static void __attribute__((constructor)) dispatch_init(void)
+{
+  get_impl();
+}
+
+/**********************************************************************
+  public functions
+ **********************************************************************/
+
+#define DEFINE_FUNC(ret, name, params, args, op, nblks, x) \
+	ret name params { return get_op_impl(op, nblks)->name args; }
+#define DEFINE_PROC(name, params, args, op, nblks, x) \
+	void name params { get_op_impl(op, nblks)->name args; }
+
+DISPATCH_FUNCS(DEFINE_FUNC, DEFINE_PROC, _)
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 camellia-simd-aesni contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Bulk block-count interface of libcamellia_simd, on top of the dispatched
+ * mode functions of camellia_simd_dispatch.c. */
+
+#include "camellia_simd_lib.h"
+
+unsigned int camellia_simd_version(void)
+{
+  return CAMELLIA_SIMD_VERSION;
+}
+
+int camellia_simd_setkey(struct camellia_simd_ctx *ctx, const void *key,
+			 size_t keylen)
+{
+  /* Key length is checked here, as assembly key-setup does not return
+   * status. */
+  if (keylen != 16 && keylen != 24 && keylen != 32)
+    return -1;
+
+  camellia_keysetup_simd128(ctx, key, keylen);
+  return 0;
+}
+
+void camellia_simd_ecb_enc_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks)
+{
+  camellia_ecb_encrypt(ctx, out, in, nblocks);
+}
+
+void camellia_simd_ecb_dec_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks)
+{
+  camellia_ecb_decrypt(ctx, out, in, nblocks);
+}
+
+void camellia_simd_cbc_enc_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *iv)
+{
+  camellia_cbc_encrypt(ctx, out, in, nblocks, iv);
+}
+
+void camellia_simd_cbc_dec_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *iv)
+{
+  camellia_cbc_decrypt(ctx, out, in, nblocks, iv);
+}
+
+void camellia_simd_cfb_enc_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *iv)
+{
+  camellia_cfb_encrypt(ctx, out, in, nblocks * CAMELLIA_SIMD_BLOCK_SIZE, iv);
+}
+
+void camellia_simd_cfb_dec_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *iv)
+{
+  camellia_cfb_decrypt(ctx, out, in, nblocks * CAMELLIA_SIMD_BLOCK_SIZE, iv);
+}
+
+void camellia_simd_ctr_blocks(struct camellia_simd_ctx *ctx, void *out,
+			      const void *in, size_t nblocks, void *ctr)
+{
+  camellia_ctr_crypt(ctx, out, in, nblocks * CAMELLIA_SIMD_BLOCK_SIZE, ctr);
+}
+
+void camellia_simd_xts_enc_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *tweak)
+{
+  if (nblocks == 0)
+    return;
+
+  camellia_xts_encrypt(ctx, out, in, nblocks * CAMELLIA_SIMD_BLOCK_SIZE,
+		       tweak);
+}
+
+void camellia_simd_xts_dec_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *tweak)
+{
+  if (nblocks == 0)
+    return;
+
+  camellia_xts_decrypt(ctx, out, in, nblocks * CAMELLIA_SIMD_BLOCK_SIZE,
+		       tweak);
+}
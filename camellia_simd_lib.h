@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 camellia-simd-aesni contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _CAMELLIA_SIMD_LIB_H_
+#define _CAMELLIA_SIMD_LIB_H_
+
+#include "camellia_simd.h"
+
+/* Public interface of libcamellia_simd. Library has runtime dispatch of
+ * all kernel variants of the architecture linked in and exports only the
+ * functions declared here and in camellia_simd.h. Version follows
+ * semantic versioning: functions are only added in minor versions, and
+ * major version (shared library soname) changes when existing function or
+ * structure changes. Keep in sync with LIB_VERSION in Makefile. */
+#define CAMELLIA_SIMD_VERSION_MAJOR 1
+#define CAMELLIA_SIMD_VERSION_MINOR 0
+#define CAMELLIA_SIMD_VERSION_PATCH 0
+#define CAMELLIA_SIMD_VERSION ((CAMELLIA_SIMD_VERSION_MAJOR << 16) | \
+			       (CAMELLIA_SIMD_VERSION_MINOR << 8) | \
+			       CAMELLIA_SIMD_VERSION_PATCH)
+
+#define CAMELLIA_SIMD_BLOCK_SIZE 16
+
+/* Returns CAMELLIA_SIMD_VERSION of the library linked at run time. */
+unsigned int camellia_simd_version(void);
+
+/* Key-setup for bulk functions below. KEYLEN is 16, 24 or 32 bytes.
+ * Returns 0 on success and -1 on invalid key length. */
+int camellia_simd_setkey(struct camellia_simd_ctx *ctx, const void *key,
+			 size_t keylen);
+
+/* Bulk functions processing NBLOCKS 16-byte blocks from IN to OUT. Except
+ * for serial CBC and CFB encryption, input is split to batches for the
+ * widest kernels of the selected implementation and tail is handled with
+ * narrower kernels. IV, CTR and TWEAK are 16-byte buffers updated for next
+ * call, so that consecutive calls continue the same stream. OUT and IN may
+ * be unaligned and may point to same buffer. */
+void camellia_simd_ecb_enc_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks);
+void camellia_simd_ecb_dec_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks);
+void camellia_simd_cbc_enc_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *iv);
+void camellia_simd_cbc_dec_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *iv);
+void camellia_simd_cfb_enc_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *iv);
+void camellia_simd_cfb_dec_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *iv);
+void camellia_simd_ctr_blocks(struct camellia_simd_ctx *ctx, void *out,
+			      const void *in, size_t nblocks, void *ctr);
+void camellia_simd_xts_enc_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *tweak);
+void camellia_simd_xts_dec_blocks(struct camellia_simd_ctx *ctx, void *out,
+				  const void *in, size_t nblocks, void *tweak);
+
+#endif /* _CAMELLIA_SIMD_LIB_H_ */
@@ -0,0 +1,2931 @@
+/*
+ * Copyright (C) 2026 camellia-simd-aesni contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Block cipher modes of operation on top of the parallel Camellia kernels.
+ * Functions here take arbitrary length input and split it to 32-block
+ * (when built with USE_SIMD256), 16-block and 1-block kernel calls. ECB
+ * also uses 64-block kernel when built with USE_SIMD512, masked 32-block
+ * kernel for tails when built with USE_SIMD256 and vector-length agnostic
+ * SVE2 or RVV kernel when built with USE_SVE2 or USE_RVV, and interleaved
+ * 32-block SIMD128 kernel where available (POWER, AArch64 assembly).
+ *
+ * Mode kernels (camellia_ctr_enc_16blks_simd128, etc) are provided by the
+ * intrinsics implementations. When linking with implementations that only
+ * provide ECB kernels (assembly implementations), build with
+ * USE_GENERIC_MODE_KERNELS to get generic mode kernels on top of the ECB
+ * kernels. Add USE_ASM_2BLKS_SIMD128 and USE_ASM_32BLKS_SIMD128 when
+ * assembly implementation also provides 2-block and 32-block SIMD128
+ * kernels (AArch64).
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+#include "camellia_simd.h"
+
+/* Carry-less multiplication instructions for GHASH, when compiler targets
+ * them. */
+#if defined(__PCLMUL__)
+#define HAVE_GHASH_PCLMUL 1
+#include <wmmintrin.h>
+#elif defined(__aarch64__) && \
+      (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+#define HAVE_GHASH_PMULL 1
+#include <arm_neon.h>
+#endif
+
+/* Below this number of blocks, tail is processed with 1-block kernel instead
+ * of running 16-block kernel for padded input. Runtime dispatch build
+ * (camellia_simd_dispatch.c) keeps one copy per implementation, and
+ * camellia_simd_autotune() replaces default with measured crossover point. */
+#define DEFAULT_MIN_TAIL_BLKS_FOR_PARALLEL 4
+unsigned int camellia_min_tail_blks_for_parallel =
+	DEFAULT_MIN_TAIL_BLKS_FOR_PARALLEL;
+#define MIN_TAIL_BLKS_FOR_PARALLEL \
+	__atomic_load_n(&camellia_min_tail_blks_for_parallel, __ATOMIC_RELAXED)
+
+/**********************************************************************
+  helper functions
+ **********************************************************************/
+
+/* Add ADD to 128-bit big-endian counter CTR. */
+static inline void ctr_be128_add(uint8_t *ctr, unsigned int add)
+{
+  unsigned int i = 16;
+
+  while (i-- > 0 && add) {
+    add += ctr[i];
+    ctr[i] = add & 0xff;
+    add >>= 8;
+  }
+}
+
+static inline void xor_bytes(uint8_t *dst, const uint8_t *src1,
+			     const uint8_t *src2, size_t nbytes)
+{
+  while (nbytes--)
+    *dst++ = *src1++ ^ *src2++;
+}
+
+/* Encrypt or decrypt single block from IN to OUT. Uses 16-block kernel when
+ * 1-block kernel is not available. */
+static void crypt_1blk(struct camellia_simd_ctx *ctx, uint8_t *out,
+		       const uint8_t *in, int encrypt)
+{
+  uint8_t tmp[16 * 16];
+
+  if (have_camellia_1blk_simd128()) {
+    if (encrypt)
+      camellia_encrypt_1blk_simd128(ctx, out, in, 1);
+    else
+      camellia_decrypt_1blk_simd128(ctx, out, in, 1);
+    return;
+  }
+
+  memcpy(tmp, in, 16);
+  if (encrypt)
+    camellia_encrypt_16blks_simd128(ctx, tmp, tmp);
+  else
+    camellia_decrypt_16blks_simd128(ctx, tmp, tmp);
+  memcpy(out, tmp, 16);
+}
+
+/* Encrypt or decrypt NBLKS (less than MIN_TAIL_BLKS_FOR_PARALLEL) blocks
+ * from IN to OUT, block pairs with interleaved 2-block kernel and last odd
+ * block with crypt_1blk. */
+static void crypt_small_blks(struct camellia_simd_ctx *ctx, uint8_t *out,
+			     const uint8_t *in, size_t nblks, int encrypt)
+{
+  for (; nblks >= 2; nblks -= 2) {
+    if (encrypt)
+      camellia_encrypt_2blks_simd128(ctx, out, in);
+    else
+      camellia_decrypt_2blks_simd128(ctx, out, in);
+    out += 2 * 16;
+    in += 2 * 16;
+  }
+
+  if (nblks)
+    crypt_1blk(ctx, out, in, encrypt);
+}
+
+enum ocb_op
+{
+  OCB_ENCRYPT,
+  OCB_DECRYPT,
+  OCB_AUTHENTICATE
+};
+
+/* Multiply 128-bit little-endian XTS tweak by x in GF(2^128). */
+static inline void xts_gfmul_x(uint8_t *tweak)
+{
+  unsigned int carry = tweak[15] >> 7;
+  int i;
+
+  for (i = 15; i > 0; i--)
+    tweak[i] = (tweak[i] << 1) | (tweak[i - 1] >> 7);
+  tweak[0] = (tweak[0] << 1) ^ (carry * 0x87);
+}
+
+/* Add ADD to low 32 bits of big-endian counter block CTR (GCM inc32). */
+static inline void ctr_be32_add(uint8_t *ctr, unsigned int add)
+{
+  uint32_t lo = ((uint32_t)ctr[12] << 24) | ((uint32_t)ctr[13] << 16) |
+		((uint32_t)ctr[14] << 8) | ctr[15];
+
+  lo += add;
+  ctr[12] = lo >> 24;
+  ctr[13] = lo >> 16;
+  ctr[14] = lo >> 8;
+  ctr[15] = lo;
+}
+
+/* Store NBLKS consecutive GCM counter blocks starting from CTR to DST and
+ * advance CTR by NBLKS. */
+static inline void ctr_be32_blks(uint8_t *dst, uint8_t *ctr,
+				 unsigned int nblks)
+{
+  while (nblks--) {
+    memcpy(dst, ctr, 16);
+    ctr_be32_add(ctr, 1);
+    dst += 16;
+  }
+}
+
+/* Double 128-bit big-endian value in GF(2^128) (OCB, CMAC). */
+static inline void gf128_double_be(uint8_t *dst, const uint8_t *src)
+{
+  unsigned int carry = src[0] >> 7;
+  int i;
+
+  for (i = 0; i < 15; i++)
+    dst[i] = (src[i] << 1) | (src[i + 1] >> 7);
+  dst[15] = (src[15] << 1) ^ (carry * 0x87);
+}
+
+/* Number of independent blocks per parallel kernel call, for modes that
+ * pack blocks of multiple messages to one call. */
+#ifdef USE_SIMD256
+#define MAX_LANES 32
+#else
+#define MAX_LANES 16
+#endif
+
+/* Encrypt N (at most MAX_LANES) blocks in BUF in place, with 32-block,
+ * 16-block or 2/1-block kernels depending on N. BUF must have space for
+ * MAX_LANES blocks. */
+static void ecb_enc_lanes(struct camellia_simd_ctx *ctx, uint8_t *buf,
+			  size_t n)
+{
+#ifdef USE_SIMD256
+  if (n > 16) {
+    camellia_encrypt_32blks_simd256(ctx, buf, buf);
+    return;
+  }
+#endif
+
+  if (n >= MIN_TAIL_BLKS_FOR_PARALLEL || !have_camellia_1blk_simd128()) {
+    camellia_encrypt_16blks_simd128(ctx, buf, buf);
+    return;
+  }
+
+  crypt_small_blks(ctx, buf, buf, n, 1);
+}
+
+static inline uint64_t load_be64(const uint8_t *p)
+{
+  uint64_t v = 0;
+  int i;
+
+  for (i = 0; i < 8; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+static inline void store_be64(uint8_t *p, uint64_t v)
+{
+  int i;
+
+  for (i = 7; i >= 0; i--) {
+    p[i] = v & 0xff;
+    v >>= 8;
+  }
+}
+
+#if !defined(USE_SIMD256) || defined(USE_GENERIC_MODE_KERNELS)
+/*
+ * GHASH for builds without carry-less multiplication kernels of their own.
+ * With PCLMULQDQ (x86, -mpclmul) or PMULL (AArch64 with Crypto Extensions)
+ * blocks are multiplied with aggregated powers H^8..H^1 and reduced once per
+ * 8 blocks. Otherwise 64x64-bit carry-less products are computed with
+ * integer multiplications of bit-masked operands (ctmul64, as in BearSSL),
+ * so that timing does not depend on data or key, unlike with table lookups.
+ * Key table layout is specific to each variant.
+ */
+#if defined(HAVE_GHASH_PCLMUL)
+typedef __m128i ghash_t;
+
+/* Values are kept byte-reflected and multiplication is done in bit-reflected
+ * domain, as in Intel white paper "Intel Carry-Less Multiplication
+ * Instruction and its Usage for Computing the GCM Mode". Byte reflection is
+ * done with 64-bit byte swaps, so that only SSE2 is needed besides
+ * PCLMULQDQ. */
+static inline __m128i ghash_load(const uint8_t *p)
+{
+  return _mm_set_epi64x(load_be64(p), load_be64(p + 8));
+}
+
+static inline void ghash_store(uint8_t *p, __m128i x)
+{
+  uint64_t t[2];
+
+  _mm_storeu_si128((__m128i *)t, x);
+  store_be64(p, t[1]);
+  store_be64(p + 8, t[0]);
+}
+
+/* lo ^ (mid << 64) ^ (hi << 128) ^= a * h */
+static inline void ghash_mul_acc(__m128i a, __m128i h, __m128i *lo,
+				 __m128i *mid, __m128i *hi)
+{
+  *lo = _mm_xor_si128(*lo, _mm_clmulepi64_si128(a, h, 0x00));
+  *hi = _mm_xor_si128(*hi, _mm_clmulepi64_si128(a, h, 0x11));
+  *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(a, h, 0x01));
+  *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(a, h, 0x10));
+}
+
+static inline __m128i ghash_reduce(__m128i lo, __m128i mid, __m128i hi)
+{
+  __m128i t0, t1, t2;
+
+  lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+  hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+  /* shift <hi:lo> left by one bit */
+  t0 = _mm_srli_epi32(lo, 31);
+  t1 = _mm_srli_epi32(hi, 31);
+  lo = _mm_slli_epi32(lo, 1);
+  hi = _mm_slli_epi32(hi, 1);
+  t2 = _mm_srli_si128(t0, 12);
+  t1 = _mm_slli_si128(t1, 4);
+  t0 = _mm_slli_si128(t0, 4);
+  lo = _mm_or_si128(lo, t0);
+  hi = _mm_or_si128(hi, t1);
+  hi = _mm_or_si128(hi, t2);
+
+  /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+  t0 = _mm_slli_epi32(lo, 31);
+  t1 = _mm_slli_epi32(lo, 30);
+  t2 = _mm_slli_epi32(lo, 25);
+  t0 = _mm_xor_si128(t0, t1);
+  t0 = _mm_xor_si128(t0, t2);
+  t1 = _mm_srli_si128(t0, 4);
+  t0 = _mm_slli_si128(t0, 12);
+  lo = _mm_xor_si128(lo, t0);
+  t0 = _mm_srli_epi32(lo, 1);
+  t2 = _mm_srli_epi32(lo, 2);
+  t0 = _mm_xor_si128(t0, t2);
+  t2 = _mm_srli_epi32(lo, 7);
+  t0 = _mm_xor_si128(t0, t2);
+  t0 = _mm_xor_si128(t0, t1);
+  lo = _mm_xor_si128(lo, t0);
+
+  return _mm_xor_si128(hi, lo);
+}
+
+static inline __m128i ghash_load_key(const uint8_t *p)
+{
+  return _mm_loadu_si128((const __m128i *)p);
+}
+
+static inline void ghash_store_key(uint8_t *p, __m128i x)
+{
+  _mm_storeu_si128((__m128i *)p, x);
+}
+
+static inline __m128i ghash_zero(void)
+{
+  return _mm_setzero_si128();
+}
+
+#define ghash_xor(a, b) _mm_xor_si128(a, b)
+
+#elif defined(HAVE_GHASH_PMULL)
+typedef uint64x2_t ghash_t;
+
+/* Bits of each byte are reversed on load and store, so that bit I of
+ * 128-bit little-endian value is coefficient of x^I and products are plain
+ * polynomial products, reduced with x^128 = x^7 + x^2 + x + 1. */
+static inline uint64x2_t ghash_load(const uint8_t *p)
+{
+  return vreinterpretq_u64_u8(vrbitq_u8(vld1q_u8(p)));
+}
+
+static inline void ghash_store(uint8_t *p, uint64x2_t x)
+{
+  vst1q_u8(p, vrbitq_u8(vreinterpretq_u8_u64(x)));
+}
+
+static inline uint64x2_t ghash_pmull(uint64_t a, uint64_t b)
+{
+  return vreinterpretq_u64_p128(vmull_p64((poly64_t)a, (poly64_t)b));
+}
+
+/* lo ^ (mid << 64) ^ (hi << 128) ^= a * h */
+static inline void ghash_mul_acc(uint64x2_t a, uint64x2_t h, uint64x2_t *lo,
+				 uint64x2_t *mid, uint64x2_t *hi)
+{
+  uint64_t a0 = vgetq_lane_u64(a, 0), a1 = vgetq_lane_u64(a, 1);
+  uint64_t h0 = vgetq_lane_u64(h, 0), h1 = vgetq_lane_u64(h, 1);
+
+  *lo = veorq_u64(*lo, ghash_pmull(a0, h0));
+  *hi = veorq_u64(*hi, ghash_pmull(a1, h1));
+  *mid = veorq_u64(*mid, ghash_pmull(a0, h1));
+  *mid = veorq_u64(*mid, ghash_pmull(a1, h0));
+}
+
+static inline uint64x2_t ghash_reduce(uint64x2_t lo, uint64x2_t mid,
+				      uint64x2_t hi)
+{
+  uint64x2_t zero = vdupq_n_u64(0);
+  uint64x2_t t;
+
+  lo = veorq_u64(lo, vextq_u64(zero, mid, 1));
+  hi = veorq_u64(hi, vextq_u64(mid, zero, 1));
+
+  /* x^192 * hi1 = x^64 * (0x87 * hi1), low half of which stays above
+   * x^128 */
+  t = ghash_pmull(vgetq_lane_u64(hi, 1), 0x87);
+  lo = veorq_u64(lo, vextq_u64(zero, t, 1));
+  t = ghash_pmull(vgetq_lane_u64(hi, 0) ^ vgetq_lane_u64(t, 1), 0x87);
+
+  return veorq_u64(lo, t);
+}
+
+static inline uint64x2_t ghash_load_key(const uint8_t *p)
+{
+  return vreinterpretq_u64_u8(vld1q_u8(p));
+}
+
+static inline void ghash_store_key(uint8_t *p, uint64x2_t x)
+{
+  vst1q_u8(p, vreinterpretq_u8_u64(x));
+}
+
+static inline uint64x2_t ghash_zero(void)
+{
+  return vdupq_n_u64(0);
+}
+
+#define ghash_xor(a, b) veorq_u64(a, b)
+
+#endif
+
+#if defined(HAVE_GHASH_PCLMUL) || defined(HAVE_GHASH_PMULL)
+/* Key table has H^8..H^1, in internal representation, in 8 first
+ * entries. */
+static void ghash_init(void *vhtable, const uint8_t *H)
+{
+  uint8_t *htable = vhtable;
+  ghash_t h, p, lo, mid, hi;
+  unsigned int i;
+
+  h = ghash_load(H);
+  p = h;
+  ghash_store_key(htable + 7 * 16, p);
+
+  for (i = 1; i < 8; i++) {
+    lo = mid = hi = ghash_zero();
+    ghash_mul_acc(p, h, &lo, &mid, &hi);
+    p = ghash_reduce(lo, mid, hi);
+    ghash_store_key(htable + (7 - i) * 16, p);
+  }
+}
+
+static void ghash_blks(uint8_t *hash, const void *vhtable, const uint8_t *in,
+		       size_t nblks)
+{
+  const uint8_t *htable = vhtable;
+  ghash_t x, h, lo, mid, hi;
+  unsigned int i;
+
+  x = ghash_load(hash);
+
+  while (nblks >= 8) {
+    lo = mid = hi = ghash_zero();
+    for (i = 0; i < 8; i++) {
+      h = ghash_load_key(htable + i * 16);
+      ghash_mul_acc(i == 0 ? ghash_xor(x, ghash_load(in)) :
+			     ghash_load(in + i * 16),
+		    h, &lo, &mid, &hi);
+    }
+    x = ghash_reduce(lo, mid, hi);
+    in += 8 * 16;
+    nblks -= 8;
+  }
+
+  h = ghash_load_key(htable + 7 * 16);
+  while (nblks--) {
+    lo = mid = hi = ghash_zero();
+    ghash_mul_acc(ghash_xor(x, ghash_load(in)), h, &lo, &mid, &hi);
+    x = ghash_reduce(lo, mid, hi);
+    in += 16;
+  }
+
+  ghash_store(hash, x);
+}
+#else
+/* Low 64 bits of carry-less product of X and Y. Each integer multiplication
+ * has operands with every fourth bit set at most, so carries of sums of 16
+ * bit products land in the three bits in between and are masked away. */
+static inline uint64_t ghash_bmul64(uint64_t x, uint64_t y)
+{
+  const uint64_t m0 = 0x1111111111111111ULL;
+  const uint64_t m1 = 0x2222222222222222ULL;
+  const uint64_t m2 = 0x4444444444444444ULL;
+  const uint64_t m3 = 0x8888888888888888ULL;
+  uint64_t x0 = x & m0, x1 = x & m1, x2 = x & m2, x3 = x & m3;
+  uint64_t y0 = y & m0, y1 = y & m1, y2 = y & m2, y3 = y & m3;
+  uint64_t z0, z1, z2, z3;
+
+  z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+  z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+  z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+  z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+
+  return (z0 & m0) | (z1 & m1) | (z2 & m2) | (z3 & m3);
+}
+
+static inline uint64_t ghash_rev64(uint64_t x)
+{
+  x = ((x & 0x5555555555555555ULL) << 1) | ((x >> 1) & 0x5555555555555555ULL);
+  x = ((x & 0x3333333333333333ULL) << 2) | ((x >> 2) & 0x3333333333333333ULL);
+  x = ((x & 0x0f0f0f0f0f0f0f0fULL) << 4) | ((x >> 4) & 0x0f0f0f0f0f0f0f0fULL);
+  x = ((x & 0x00ff00ff00ff00ffULL) << 8) | ((x >> 8) & 0x00ff00ff00ff00ffULL);
+  x = ((x & 0x0000ffff0000ffffULL) << 16) |
+      ((x >> 16) & 0x0000ffff0000ffffULL);
+
+  return (x << 32) | (x >> 32);
+}
+
+/* Key table has H as big-endian 64-bit halves, their XOR, and bit-reversed
+ * copies of those three. */
+static void ghash_init(void *vhtable, const uint8_t *H)
+{
+  uint64_t *htable = vhtable;
+
+  htable[1] = load_be64(H);
+  htable[0] = load_be64(H + 8);
+  htable[2] = htable[0] ^ htable[1];
+  htable[3] = ghash_rev64(htable[0]);
+  htable[4] = ghash_rev64(htable[1]);
+  htable[5] = htable[3] ^ htable[4];
+}
+
+/* Karatsuba multiplication, with high halves of 64x64-bit products computed
+ * as bit-reversed low halves of bit-reversed operands. Product is in
+ * bit-reflected domain, so it is shifted left by one bit before reduction. */
+static void ghash_blks(uint8_t *hash, const void *vhtable, const uint8_t *in,
+		       size_t nblks)
+{
+  const uint64_t *htable = vhtable;
+  uint64_t y0, y1, y2, y0r, y1r, y2r;
+  uint64_t z0, z1, z2, z0h, z1h, z2h;
+  uint64_t v0, v1, v2, v3;
+
+  y1 = load_be64(hash);
+  y0 = load_be64(hash + 8);
+
+  while (nblks--) {
+    y1 ^= load_be64(in);
+    y0 ^= load_be64(in + 8);
+    y0r = ghash_rev64(y0);
+    y1r = ghash_rev64(y1);
+    y2 = y0 ^ y1;
+    y2r = y0r ^ y1r;
+
+    z0 = ghash_bmul64(y0, htable[0]);
+    z1 = ghash_bmul64(y1, htable[1]);
+    z2 = ghash_bmul64(y2, htable[2]);
+    z0h = ghash_bmul64(y0r, htable[3]);
+    z1h = ghash_bmul64(y1r, htable[4]);
+    z2h = ghash_bmul64(y2r, htable[5]);
+    z2 ^= z0 ^ z1;
+    z2h ^= z0h ^ z1h;
+    z0h = ghash_rev64(z0h) >> 1;
+    z1h = ghash_rev64(z1h) >> 1;
+    z2h = ghash_rev64(z2h) >> 1;
+
+    v0 = z0;
+    v1 = z0h ^ z2;
+    v2 = z1 ^ z2h;
+    v3 = z1h;
+
+    v3 = (v3 << 1) | (v2 >> 63);
+    v2 = (v2 << 1) | (v1 >> 63);
+    v1 = (v1 << 1) | (v0 >> 63);
+    v0 = v0 << 1;
+
+    /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+    v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+    v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+    v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+
+    y0 = v2;
+    y1 = v3;
+    in += 16;
+  }
+
+  store_be64(hash, y1);
+  store_be64(hash + 8, y0);
+}
+#endif
+#endif
+
+/**********************************************************************
+  generic mode kernels
+ **********************************************************************/
+
+#ifdef USE_GENERIC_MODE_KERNELS
+
+/* Store NBLKS consecutive counter blocks starting from CTR to DST and
+ * advance CTR by NBLKS. */
+static inline void ctr_be128_blks(uint8_t *dst, uint8_t *ctr,
+				  unsigned int nblks)
+{
+  while (nblks--) {
+    memcpy(dst, ctr, 16);
+    ctr_be128_add(ctr, 1);
+    dst += 16;
+  }
+}
+
+#ifndef USE_ASM_2BLKS_SIMD128
+static void small_blks_generic(struct camellia_simd_ctx *ctx, void *out,
+			       const void *in, size_t nblks, int encrypt)
+{
+  uint8_t tmp[16 * 16];
+
+  if (have_camellia_1blk_simd128()) {
+    if (encrypt)
+      camellia_encrypt_1blk_simd128(ctx, out, in, nblks);
+    else
+      camellia_decrypt_1blk_simd128(ctx, out, in, nblks);
+    return;
+  }
+
+  memcpy(tmp, in, nblks * 16);
+  if (encrypt)
+    camellia_encrypt_16blks_simd128(ctx, tmp, tmp);
+  else
+    camellia_decrypt_16blks_simd128(ctx, tmp, tmp);
+  memcpy(out, tmp, nblks * 16);
+}
+
+void camellia_encrypt_2blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				    const void *in)
+{
+  small_blks_generic(ctx, out, in, 2, 1);
+}
+
+void camellia_decrypt_2blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				    const void *in)
+{
+  small_blks_generic(ctx, out, in, 2, 0);
+}
+#endif /* USE_ASM_2BLKS_SIMD128 */
+
+void camellia_ecb_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, size_t nchunks)
+{
+  for (; nchunks; nchunks--) {
+    camellia_encrypt_16blks_simd128(ctx, out, in);
+    out = (uint8_t *)out + 16 * 16;
+    in = (const uint8_t *)in + 16 * 16;
+  }
+}
+
+void camellia_ecb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, size_t nchunks)
+{
+  for (; nchunks; nchunks--) {
+    camellia_decrypt_16blks_simd128(ctx, out, in);
+    out = (uint8_t *)out + 16 * 16;
+    in = (const uint8_t *)in + 16 * 16;
+  }
+}
+
+#ifndef USE_ASM_32BLKS_SIMD128
+int have_camellia_32blks_simd128(void)
+{
+  return 0;
+}
+
+void camellia_encrypt_32blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in)
+{
+  camellia_ecb_enc_16blks_simd128(ctx, out, in, 2);
+}
+
+void camellia_decrypt_32blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in)
+{
+  camellia_ecb_dec_16blks_simd128(ctx, out, in, 2);
+}
+#endif /* USE_ASM_32BLKS_SIMD128 */
+
+#ifdef USE_SIMD256
+void camellia_ecb_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, size_t nchunks)
+{
+  for (; nchunks; nchunks--) {
+    camellia_encrypt_32blks_simd256(ctx, out, in);
+    out = (uint8_t *)out + 32 * 16;
+    in = (const uint8_t *)in + 32 * 16;
+  }
+}
+
+void camellia_ecb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, size_t nchunks)
+{
+  for (; nchunks; nchunks--) {
+    camellia_decrypt_32blks_simd256(ctx, out, in);
+    out = (uint8_t *)out + 32 * 16;
+    in = (const uint8_t *)in + 32 * 16;
+  }
+}
+
+int have_camellia_nblks_simd256_masked(void)
+{
+  return 0;
+}
+
+static void nblks_masked_generic(struct camellia_simd_ctx *ctx, void *out,
+				 const void *in, size_t nblks, int encrypt)
+{
+  uint8_t tmp[32 * 16];
+
+  if (nblks == 0)
+    return;
+  if (nblks > 32)
+    nblks = 32;
+
+  memcpy(tmp, in, nblks * 16);
+  if (encrypt)
+    camellia_encrypt_32blks_simd256(ctx, tmp, tmp);
+  else
+    camellia_decrypt_32blks_simd256(ctx, tmp, tmp);
+  memcpy(out, tmp, nblks * 16);
+}
+
+void camellia_encrypt_nblks_simd256_masked(struct camellia_simd_ctx *ctx,
+					   void *out, const void *in,
+					   size_t nblks)
+{
+  nblks_masked_generic(ctx, out, in, nblks, 1);
+}
+
+void camellia_decrypt_nblks_simd256_masked(struct camellia_simd_ctx *ctx,
+					   void *out, const void *in,
+					   size_t nblks)
+{
+  nblks_masked_generic(ctx, out, in, nblks, 0);
+}
+
+static void blks_ptrs_generic(struct camellia_simd_ctx *ctx,
+			      void *const out[32], const void *const in[32],
+			      int encrypt)
+{
+  uint8_t tmp[32 * 16];
+  unsigned int i;
+
+  for (i = 0; i < 32; i++)
+    memcpy(tmp + i * 16, in[i], 16);
+  if (encrypt)
+    camellia_encrypt_32blks_simd256(ctx, tmp, tmp);
+  else
+    camellia_decrypt_32blks_simd256(ctx, tmp, tmp);
+  for (i = 0; i < 32; i++)
+    memcpy(out[i], tmp + i * 16, 16);
+}
+
+void camellia_encrypt_32blks_simd256_ptrs(struct camellia_simd_ctx *ctx,
+					  void *const out[32],
+					  const void *const in[32])
+{
+  blks_ptrs_generic(ctx, out, in, 1);
+}
+
+void camellia_decrypt_32blks_simd256_ptrs(struct camellia_simd_ctx *ctx,
+					  void *const out[32],
+					  const void *const in[32])
+{
+  blks_ptrs_generic(ctx, out, in, 0);
+}
+#endif
+
+void camellia_ctr_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *ctr)
+{
+  uint8_t tmp[16 * 16];
+
+  ctr_be128_blks(tmp, ctr, 16);
+  camellia_encrypt_16blks_simd128(ctx, tmp, tmp);
+  xor_bytes(out, in, tmp, 16 * 16);
+}
+
+#ifdef USE_SIMD256
+void camellia_ctr_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *ctr)
+{
+  uint8_t tmp[32 * 16];
+
+  ctr_be128_blks(tmp, ctr, 32);
+  camellia_encrypt_32blks_simd256(ctx, tmp, tmp);
+  xor_bytes(out, in, tmp, 32 * 16);
+}
+#endif
+
+void camellia_cbc_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *iv)
+{
+  uint8_t tmp[16 * 16];
+
+  camellia_decrypt_16blks_simd128(ctx, tmp, in);
+  xor_bytes(tmp, tmp, iv, 16);
+  xor_bytes(tmp + 16, tmp + 16, in, 15 * 16);
+  memcpy(iv, (const uint8_t *)in + 15 * 16, 16);
+  memcpy(out, tmp, 16 * 16);
+}
+
+#ifdef USE_SIMD256
+void camellia_cbc_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *iv)
+{
+  uint8_t tmp[32 * 16];
+
+  camellia_decrypt_32blks_simd256(ctx, tmp, in);
+  xor_bytes(tmp, tmp, iv, 16);
+  xor_bytes(tmp + 16, tmp + 16, in, 31 * 16);
+  memcpy(iv, (const uint8_t *)in + 31 * 16, 16);
+  memcpy(out, tmp, 32 * 16);
+}
+#endif
+
+void camellia_cfb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *iv)
+{
+  uint8_t tmp[16 * 16];
+
+  memcpy(tmp, iv, 16);
+  memcpy(tmp + 16, in, 15 * 16);
+  memcpy(iv, (const uint8_t *)in + 15 * 16, 16);
+  camellia_encrypt_16blks_simd128(ctx, tmp, tmp);
+  xor_bytes(out, in, tmp, 16 * 16);
+}
+
+#ifdef USE_SIMD256
+void camellia_cfb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *iv)
+{
+  uint8_t tmp[32 * 16];
+
+  memcpy(tmp, iv, 16);
+  memcpy(tmp + 16, in, 31 * 16);
+  memcpy(iv, (const uint8_t *)in + 31 * 16, 16);
+  camellia_encrypt_32blks_simd256(ctx, tmp, tmp);
+  xor_bytes(out, in, tmp, 32 * 16);
+}
+#endif
+
+/* Generate NBLKS XTS tweaks starting from TWEAK to DST and advance TWEAK. */
+static inline void xts_tweak_blks(uint8_t *dst, uint8_t *tweak,
+				  unsigned int nblks)
+{
+  while (nblks--) {
+    memcpy(dst, tweak, 16);
+    xts_gfmul_x(tweak);
+    dst += 16;
+  }
+}
+
+void camellia_xts_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *tweak)
+{
+  uint8_t tweaks[16 * 16];
+  uint8_t tmp[16 * 16];
+
+  xts_tweak_blks(tweaks, tweak, 16);
+  xor_bytes(tmp, in, tweaks, 16 * 16);
+  camellia_encrypt_16blks_simd128(ctx, tmp, tmp);
+  xor_bytes(out, tmp, tweaks, 16 * 16);
+}
+
+void camellia_xts_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *tweak)
+{
+  uint8_t tweaks[16 * 16];
+  uint8_t tmp[16 * 16];
+
+  xts_tweak_blks(tweaks, tweak, 16);
+  xor_bytes(tmp, in, tweaks, 16 * 16);
+  camellia_decrypt_16blks_simd128(ctx, tmp, tmp);
+  xor_bytes(out, tmp, tweaks, 16 * 16);
+}
+
+#ifdef USE_SIMD256
+void camellia_xts_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *tweak)
+{
+  uint8_t tweaks[32 * 16];
+  uint8_t tmp[32 * 16];
+
+  xts_tweak_blks(tweaks, tweak, 32);
+  xor_bytes(tmp, in, tweaks, 32 * 16);
+  camellia_encrypt_32blks_simd256(ctx, tmp, tmp);
+  xor_bytes(out, tmp, tweaks, 32 * 16);
+}
+
+void camellia_xts_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *tweak)
+{
+  uint8_t tweaks[32 * 16];
+  uint8_t tmp[32 * 16];
+
+  xts_tweak_blks(tweaks, tweak, 32);
+  xor_bytes(tmp, in, tweaks, 32 * 16);
+  camellia_decrypt_32blks_simd256(ctx, tmp, tmp);
+  xor_bytes(out, tmp, tweaks, 32 * 16);
+}
+#endif
+
+/* OCB on top of ECB kernel ECB_BLKS, processing NBLKS (16 or 32) blocks. */
+static void ocb_generic_blks(struct camellia_simd_ctx *ctx,
+			     void (*ecb_blks)(struct camellia_simd_ctx *ctx,
+					      void *out, const void *in),
+			     uint8_t *out, const uint8_t *in, uint8_t *offset,
+			     uint8_t *checksum, const void **Ls,
+			     unsigned int nblks, enum ocb_op op)
+{
+  uint8_t offsets[32 * 16];
+  uint8_t tmp[32 * 16];
+  unsigned int i;
+
+  for (i = 0; i < nblks; i++) {
+    xor_bytes(offset, offset, Ls[i], 16);
+    memcpy(offsets + i * 16, offset, 16);
+    if (op == OCB_ENCRYPT)
+      xor_bytes(checksum, checksum, in + i * 16, 16);
+  }
+
+  xor_bytes(tmp, in, offsets, nblks * 16);
+  ecb_blks(ctx, tmp, tmp);
+
+  if (op == OCB_AUTHENTICATE) {
+    for (i = 0; i < nblks; i++)
+      xor_bytes(checksum, checksum, tmp + i * 16, 16);
+    return;
+  }
+
+  xor_bytes(out, tmp, offsets, nblks * 16);
+
+  if (op == OCB_DECRYPT) {
+    for (i = 0; i < nblks; i++)
+      xor_bytes(checksum, checksum, out + i * 16, 16);
+  }
+}
+
+void camellia_ocb_enc_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *offset,
+				     void *checksum, const void *Ls[16])
+{
+  ocb_generic_blks(ctx, camellia_encrypt_16blks_simd128, out, in, offset,
+		   checksum, Ls, 16, OCB_ENCRYPT);
+}
+
+void camellia_ocb_dec_16blks_simd128(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *offset,
+				     void *checksum, const void *Ls[16])
+{
+  ocb_generic_blks(ctx, camellia_decrypt_16blks_simd128, out, in, offset,
+		   checksum, Ls, 16, OCB_DECRYPT);
+}
+
+void camellia_ocb_auth_16blks_simd128(struct camellia_simd_ctx *ctx,
+				      const void *abuf, void *offset,
+				      void *sum, const void *Ls[16])
+{
+  ocb_generic_blks(ctx, camellia_encrypt_16blks_simd128, NULL, abuf, offset,
+		   sum, Ls, 16, OCB_AUTHENTICATE);
+}
+
+#ifdef USE_SIMD256
+void camellia_ocb_enc_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *offset,
+				     void *checksum, const void *Ls[32])
+{
+  ocb_generic_blks(ctx, camellia_encrypt_32blks_simd256, out, in, offset,
+		   checksum, Ls, 32, OCB_ENCRYPT);
+}
+
+void camellia_ocb_dec_32blks_simd256(struct camellia_simd_ctx *ctx, void *out,
+				     const void *in, void *offset,
+				     void *checksum, const void *Ls[32])
+{
+  ocb_generic_blks(ctx, camellia_decrypt_32blks_simd256, out, in, offset,
+		   checksum, Ls, 32, OCB_DECRYPT);
+}
+
+void camellia_ocb_auth_32blks_simd256(struct camellia_simd_ctx *ctx,
+				      const void *abuf, void *offset,
+				      void *sum, const void *Ls[32])
+{
+  ocb_generic_blks(ctx, camellia_encrypt_32blks_simd256, NULL, abuf, offset,
+		   sum, Ls, 32, OCB_AUTHENTICATE);
+}
+#endif
+
+#ifdef USE_SIMD256
+void camellia_gcm_ghash_init_simd256(void *htable, const void *H)
+{
+  ghash_init(htable, H);
+}
+
+void camellia_gcm_ghash_simd256(void *hash, const void *htable,
+				const void *in, size_t nblks)
+{
+  ghash_blks(hash, htable, in, nblks);
+}
+
+void camellia_gcm_ctr_ghash_32blks_simd256(struct camellia_simd_ctx *ctx,
+					   void *out, const void *in,
+					   void *ctr, const void *ghash_in,
+					   void *hash, const void *htable)
+{
+  uint8_t tmp[32 * 16];
+
+  if (ghash_in)
+    ghash_blks(hash, htable, ghash_in, 32);
+  ctr_be32_blks(tmp, ctr, 32);
+  camellia_encrypt_32blks_simd256(ctx, tmp, tmp);
+  xor_bytes(out, in, tmp, 32 * 16);
+}
+#endif
+
+#endif /* USE_GENERIC_MODE_KERNELS */
+
+/**********************************************************************
+  ECB mode
+ **********************************************************************/
+
+static void ecb_crypt(struct camellia_simd_ctx *ctx, uint8_t *out,
+		      const uint8_t *in, size_t nblks, int encrypt)
+{
+  uint8_t tmp[16 * 16];
+  size_t n;
+
+#ifdef USE_SVE2
+  /* SVE2 kernel takes partial batches with predicated loads/stores, so
+   * whole input goes through it, except short tails. */
+  n = camellia_sve2_parallel_blks();
+  while (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL) {
+    if (n > nblks)
+      n = nblks;
+    if (encrypt)
+      camellia_encrypt_nblks_sve2(ctx, out, in, n);
+    else
+      camellia_decrypt_nblks_sve2(ctx, out, in, n);
+    out += n * 16;
+    in += n * 16;
+    nblks -= n;
+  }
+#endif
+
+#ifdef USE_RVV
+  /* Same for RVV kernel, which sets vector length to block count. */
+  n = camellia_rvv_parallel_blks();
+  while (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL) {
+    if (n > nblks)
+      n = nblks;
+    if (encrypt)
+      camellia_encrypt_nblks_rvv(ctx, out, in, n);
+    else
+      camellia_decrypt_nblks_rvv(ctx, out, in, n);
+    out += n * 16;
+    in += n * 16;
+    nblks -= n;
+  }
+#endif
+
+#ifdef USE_SIMD512
+  while (nblks >= 64) {
+    if (encrypt)
+      camellia_encrypt_64blks_simd512(ctx, out, in);
+    else
+      camellia_decrypt_64blks_simd512(ctx, out, in);
+    out += 64 * 16;
+    in += 64 * 16;
+    nblks -= 64;
+  }
+#endif
+
+#ifdef USE_SIMD256
+  n = nblks / 32;
+  if (n) {
+    if (encrypt)
+      camellia_ecb_enc_32blks_simd256(ctx, out, in, n);
+    else
+      camellia_ecb_dec_32blks_simd256(ctx, out, in, n);
+    out += n * 32 * 16;
+    in += n * 32 * 16;
+    nblks -= n * 32;
+  }
+
+  /* Remaining 17..31 blocks (or 4..16 blocks, if kernel has masked
+   * loads/stores and needs no bounce buffer) in one pass of the 32-block
+   * kernel. */
+  if (nblks > 16 ||
+      (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL &&
+       have_camellia_nblks_simd256_masked())) {
+    if (encrypt)
+      camellia_encrypt_nblks_simd256_masked(ctx, out, in, nblks);
+    else
+      camellia_decrypt_nblks_simd256_masked(ctx, out, in, nblks);
+    return;
+  }
+#else
+  /* Two interleaved 16-block states, where available. */
+  if (have_camellia_32blks_simd128()) {
+    while (nblks >= 32) {
+      if (encrypt)
+	camellia_encrypt_32blks_simd128(ctx, out, in);
+      else
+	camellia_decrypt_32blks_simd128(ctx, out, in);
+      out += 32 * 16;
+      in += 32 * 16;
+      nblks -= 32;
+    }
+  }
+#endif
+
+  n = nblks / 16;
+  if (n) {
+    if (encrypt)
+      camellia_ecb_enc_16blks_simd128(ctx, out, in, n);
+    else
+      camellia_ecb_dec_16blks_simd128(ctx, out, in, n);
+    out += n * 16 * 16;
+    in += n * 16 * 16;
+    nblks -= n * 16;
+  }
+
+  if (nblks == 0)
+    return;
+
+  if (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL ||
+      !have_camellia_1blk_simd128()) {
+    memcpy(tmp, in, nblks * 16);
+    if (encrypt)
+      camellia_encrypt_16blks_simd128(ctx, tmp, tmp);
+    else
+      camellia_decrypt_16blks_simd128(ctx, tmp, tmp);
+    memcpy(out, tmp, nblks * 16);
+    return;
+  }
+
+  crypt_small_blks(ctx, out, in, nblks, encrypt);
+}
+
+void camellia_ecb_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nblks)
+{
+  ecb_crypt(ctx, out, in, nblks, 1);
+}
+
+void camellia_ecb_decrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nblks)
+{
+  ecb_crypt(ctx, out, in, nblks, 0);
+}
+
+/**********************************************************************
+  CTR mode
+ **********************************************************************/
+
+void camellia_ctr_crypt(struct camellia_simd_ctx *ctx, void *vout,
+			const void *vin, size_t nbytes, void *vctr)
+{
+  uint8_t *out = vout;
+  const uint8_t *in = vin;
+  uint8_t *ctr = vctr;
+  uint8_t tmp[16 * 16];
+  size_t nblks, i;
+
+#ifdef USE_SIMD256
+  while (nbytes >= 32 * 16) {
+    camellia_ctr_enc_32blks_simd256(ctx, out, in, ctr);
+    out += 32 * 16;
+    in += 32 * 16;
+    nbytes -= 32 * 16;
+  }
+#endif
+
+  while (nbytes >= 16 * 16) {
+    camellia_ctr_enc_16blks_simd128(ctx, out, in, ctr);
+    out += 16 * 16;
+    in += 16 * 16;
+    nbytes -= 16 * 16;
+  }
+
+  if (nbytes == 0)
+    return;
+
+  nblks = (nbytes + 15) / 16;
+
+  if (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL ||
+      !have_camellia_1blk_simd128()) {
+    uint8_t ctr_next[16];
+
+    memcpy(ctr_next, ctr, 16);
+    ctr_be128_add(ctr_next, nblks);
+
+    memcpy(tmp, in, nbytes);
+    camellia_ctr_enc_16blks_simd128(ctx, tmp, tmp, ctr);
+    memcpy(out, tmp, nbytes);
+
+    memcpy(ctr, ctr_next, 16);
+    return;
+  }
+
+  for (i = 0; i < nblks; i++) {
+    memcpy(tmp + i * 16, ctr, 16);
+    ctr_be128_add(ctr, 1);
+  }
+  crypt_small_blks(ctx, tmp, tmp, nblks, 1);
+  xor_bytes(out, in, tmp, nbytes);
+}
+
+/**********************************************************************
+  multi-lane chains
+ **********************************************************************/
+
+/* Serial CBC chain of one job (CBC encryption stream or CMAC message),
+ * occupying one lane of parallel kernel. Chaining value of lane is kept in
+ * scheduler buffer. */
+struct chain_lane
+{
+  const uint8_t *in;
+  uint8_t *out;		/* output of each block, or NULL */
+  size_t nblks;		/* blocks left */
+  uint8_t last[16];	/* replaces last input block if HAS_LAST is set */
+  int has_last;
+  uint8_t *result;	/* receives final chaining value */
+};
+
+/* Set up LANE and initial chaining value X for job IDX of JOBS. */
+typedef void (*chain_init_fn)(const void *priv, const void *jobs, size_t idx,
+			      struct chain_lane *lane, uint8_t *x);
+
+/* Run chains of NJOBS jobs through parallel kernel: each kernel call
+ * advances every active chain by one block. When chain finishes, its lane
+ * is refilled with next pending job. When few chains are left, kernel
+ * selection in ecb_enc_lanes falls back to 1-block kernel. */
+static void chain_multi(struct camellia_simd_ctx *ctx, chain_init_fn init,
+			const void *priv, const void *jobs, size_t njobs)
+{
+  struct chain_lane lanes[MAX_LANES];
+  uint8_t buf[MAX_LANES * 16];
+  size_t nlanes = 0;
+  size_t next = 0;
+  size_t i;
+
+  for (;;) {
+    /* Refill free lanes with pending jobs. */
+    while (nlanes < MAX_LANES && next < njobs) {
+      init(priv, jobs, next++, &lanes[nlanes], buf + nlanes * 16);
+      if (lanes[nlanes].nblks > 0)
+	nlanes++;
+    }
+
+    if (nlanes == 0)
+      break;
+
+    /* Advance every active chain by one block. */
+    for (i = 0; i < nlanes; i++) {
+      if (lanes[i].nblks == 1 && lanes[i].has_last) {
+	xor_bytes(buf + i * 16, buf + i * 16, lanes[i].last, 16);
+      } else {
+	xor_bytes(buf + i * 16, buf + i * 16, lanes[i].in, 16);
+	lanes[i].in += 16;
+      }
+    }
+
+    ecb_enc_lanes(ctx, buf, nlanes);
+
+    /* Retire finished chains; last active lane is moved to freed slot. */
+    for (i = 0; i < nlanes;) {
+      if (lanes[i].out) {
+	memcpy(lanes[i].out, buf + i * 16, 16);
+	lanes[i].out += 16;
+      }
+
+      if (--lanes[i].nblks > 0) {
+	i++;
+	continue;
+      }
+
+      memcpy(lanes[i].result, buf + i * 16, 16);
+      nlanes--;
+      lanes[i] = lanes[nlanes];
+      memcpy(buf + i * 16, buf + nlanes * 16, 16);
+    }
+  }
+}
+
+/**********************************************************************
+  CBC mode
+ **********************************************************************/
+
+/* Set up chain for CBC encryption job IDX of JOBS. */
+static void cbc_enc_chain_init(const void *priv, const void *jobs, size_t idx,
+			       struct chain_lane *lane, uint8_t *x)
+{
+  const struct camellia_cbc_job *job =
+    (const struct camellia_cbc_job *)jobs + idx;
+
+  (void)priv;
+  lane->in = job->in;
+  lane->out = job->out;
+  lane->result = job->iv;
+  lane->nblks = job->nblks;
+  lane->has_last = 0;
+  memcpy(x, job->iv, 16);
+}
+
+void camellia_cbc_encrypt_multi(struct camellia_simd_ctx *ctx,
+				const struct camellia_cbc_job *jobs,
+				size_t njobs)
+{
+  chain_multi(ctx, cbc_enc_chain_init, NULL, jobs, njobs);
+}
+
+void camellia_cbc_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			  const void *in, size_t nblks, void *iv)
+{
+  struct camellia_cbc_job job = { in, out, nblks, iv };
+
+  camellia_cbc_encrypt_multi(ctx, &job, 1);
+}
+
+void camellia_cbc_decrypt(struct camellia_simd_ctx *ctx, void *vout,
+			  const void *vin, size_t nblks, void *iv)
+{
+  uint8_t *out = vout;
+  const uint8_t *in = vin;
+  uint8_t tmp[16 * 16];
+  uint8_t iv_next[16];
+
+#ifdef USE_SIMD256
+  while (nblks >= 32) {
+    camellia_cbc_dec_32blks_simd256(ctx, out, in, iv);
+    out += 32 * 16;
+    in += 32 * 16;
+    nblks -= 32;
+  }
+#endif
+
+  while (nblks >= 16) {
+    camellia_cbc_dec_16blks_simd128(ctx, out, in, iv);
+    out += 16 * 16;
+    in += 16 * 16;
+    nblks -= 16;
+  }
+
+  if (nblks == 0)
+    return;
+
+  if (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL ||
+      !have_camellia_1blk_simd128()) {
+    memcpy(iv_next, in + (nblks - 1) * 16, 16);
+
+    memcpy(tmp, in, nblks * 16);
+    camellia_cbc_dec_16blks_simd128(ctx, tmp, tmp, iv);
+    memcpy(out, tmp, nblks * 16);
+
+    memcpy(iv, iv_next, 16);
+    return;
+  }
+
+  /* Short tail with 2-block and 1-block kernels. Ciphertext is copied
+   * first, as OUT may overwrite IN. */
+  memcpy(tmp + 8 * 16, in, nblks * 16);
+  crypt_small_blks(ctx, tmp, tmp + 8 * 16, nblks, 0);
+  xor_bytes(out, tmp, iv, 16);
+  xor_bytes(out + 16, tmp + 16, tmp + 8 * 16, (nblks - 1) * 16);
+  memcpy(iv, tmp + 8 * 16 + (nblks - 1) * 16, 16);
+}
+
+/**********************************************************************
+  CFB mode
+ **********************************************************************/
+
+void camellia_cfb_encrypt(struct camellia_simd_ctx *ctx, void *vout,
+			  const void *vin, size_t nbytes, void *iv)
+{
+  uint8_t *out = vout;
+  const uint8_t *in = vin;
+  uint8_t tmp[16];
+
+  /* CFB encryption is serial, each block depends on previous ciphertext
+   * block. */
+  while (nbytes) {
+    size_t n = nbytes < 16 ? nbytes : 16;
+
+    crypt_1blk(ctx, tmp, iv, 1);
+    xor_bytes(out, in, tmp, n);
+    if (n == 16)
+      memcpy(iv, out, 16);
+    out += n;
+    in += n;
+    nbytes -= n;
+  }
+}
+
+void camellia_cfb_decrypt(struct camellia_simd_ctx *ctx, void *vout,
+			  const void *vin, size_t nbytes, void *iv)
+{
+  uint8_t *out = vout;
+  const uint8_t *in = vin;
+  uint8_t tmp[16 * 16];
+  uint8_t iv_next[16];
+  size_t nblks;
+
+#ifdef USE_SIMD256
+  while (nbytes >= 32 * 16) {
+    camellia_cfb_dec_32blks_simd256(ctx, out, in, iv);
+    out += 32 * 16;
+    in += 32 * 16;
+    nbytes -= 32 * 16;
+  }
+#endif
+
+  while (nbytes >= 16 * 16) {
+    camellia_cfb_dec_16blks_simd128(ctx, out, in, iv);
+    out += 16 * 16;
+    in += 16 * 16;
+    nbytes -= 16 * 16;
+  }
+
+  if (nbytes == 0)
+    return;
+
+  nblks = (nbytes + 15) / 16;
+
+  if (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL ||
+      !have_camellia_1blk_simd128()) {
+    if (nbytes % 16 == 0)
+      memcpy(iv_next, in + (nblks - 1) * 16, 16);
+
+    memcpy(tmp, in, nbytes);
+    camellia_cfb_dec_16blks_simd128(ctx, tmp, tmp, iv);
+    memcpy(out, tmp, nbytes);
+
+    if (nbytes % 16 == 0)
+      memcpy(iv, iv_next, 16);
+    return;
+  }
+
+  while (nbytes) {
+    size_t n = nbytes < 16 ? nbytes : 16;
+
+    memcpy(iv_next, in, n);
+    camellia_encrypt_1blk_simd128(ctx, tmp, iv, 1);
+    xor_bytes(out, in, tmp, n);
+    if (n == 16)
+      memcpy(iv, iv_next, 16);
+    out += n;
+    in += n;
+    nbytes -= n;
+  }
+}
+
+/**********************************************************************
+  XTS mode
+ **********************************************************************/
+
+/* Encrypt or decrypt single block from IN to OUT with XTS tweak TWEAK. */
+static void xts_crypt_1blk(struct camellia_simd_ctx *ctx, uint8_t *out,
+			   const uint8_t *in, const uint8_t *tweak,
+			   int encrypt)
+{
+  uint8_t tmp[16];
+
+  xor_bytes(tmp, in, tweak, 16);
+  crypt_1blk(ctx, tmp, tmp, encrypt);
+  xor_bytes(out, tmp, tweak, 16);
+}
+
+static int xts_crypt(struct camellia_simd_ctx *ctx, uint8_t *out,
+		     const uint8_t *in, size_t nbytes, uint8_t *tweak,
+		     int encrypt)
+{
+  uint8_t tmp[16 * 16];
+  size_t nblks = nbytes / 16;
+  size_t tail = nbytes % 16;
+
+  if (nbytes < 16)
+    return -1;
+
+  /* With ciphertext stealing, last full block is processed together with
+   * the partial block. */
+  if (tail)
+    nblks--;
+
+#ifdef USE_SIMD256
+  while (nblks >= 32) {
+    if (encrypt)
+      camellia_xts_enc_32blks_simd256(ctx, out, in, tweak);
+    else
+      camellia_xts_dec_32blks_simd256(ctx, out, in, tweak);
+    out += 32 * 16;
+    in += 32 * 16;
+    nblks -= 32;
+  }
+#endif
+
+  while (nblks >= 16) {
+    if (encrypt)
+      camellia_xts_enc_16blks_simd128(ctx, out, in, tweak);
+    else
+      camellia_xts_dec_16blks_simd128(ctx, out, in, tweak);
+    out += 16 * 16;
+    in += 16 * 16;
+    nblks -= 16;
+  }
+
+  if (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL ||
+      (nblks > 0 && !have_camellia_1blk_simd128())) {
+    uint8_t tweak_tmp[16];
+
+    memcpy(tweak_tmp, tweak, 16);
+    memcpy(tmp, in, nblks * 16);
+    if (encrypt)
+      camellia_xts_enc_16blks_simd128(ctx, tmp, tmp, tweak_tmp);
+    else
+      camellia_xts_dec_16blks_simd128(ctx, tmp, tmp, tweak_tmp);
+    memcpy(out, tmp, nblks * 16);
+
+    out += nblks * 16;
+    in += nblks * 16;
+    for (; nblks > 0; nblks--)
+      xts_gfmul_x(tweak);
+  }
+
+  while (nblks) {
+    xts_crypt_1blk(ctx, out, in, tweak, encrypt);
+    xts_gfmul_x(tweak);
+    out += 16;
+    in += 16;
+    nblks--;
+  }
+
+  if (tail) {
+    uint8_t tweak_next[16];
+    uint8_t last[16];
+
+    memcpy(tweak_next, tweak, 16);
+    xts_gfmul_x(tweak_next);
+
+    /* Ciphertext stealing. Decryption processes last full block with the
+     * tweak of the partial block and vice versa. */
+    xts_crypt_1blk(ctx, tmp, in, encrypt ? tweak : tweak_next, encrypt);
+    memcpy(last, in + 16, tail);
+    memcpy(last + tail, tmp + tail, 16 - tail);
+    memcpy(out + 16, tmp, tail);
+    xts_crypt_1blk(ctx, out, last, encrypt ? tweak_next : tweak, encrypt);
+  }
+
+  return 0;
+}
+
+int camellia_xts_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			 const void *in, size_t nbytes, void *tweak)
+{
+  return xts_crypt(ctx, out, in, nbytes, tweak, 1);
+}
+
+int camellia_xts_decrypt(struct camellia_simd_ctx *ctx, void *out,
+			 const void *in, size_t nbytes, void *tweak)
+{
+  return xts_crypt(ctx, out, in, nbytes, tweak, 0);
+}
+
+/**********************************************************************
+  OCB mode
+ **********************************************************************/
+
+/* Get pointers to L_{ntz(i)} for blocks BLKN + 1 ... BLKN + NBLKS. */
+static inline void ocb_get_Ls(const struct camellia_ocb_ctx *ocb,
+			      const void **Ls, uint64_t blkn,
+			      unsigned int nblks)
+{
+  unsigned int i;
+
+  for (i = 0; i < nblks; i++)
+    Ls[i] = ocb->L[__builtin_ctzll(blkn + 1 + i)];
+}
+
+/* Process less than 16 blocks with offsets computed in scalar code, using
+ * 16-block ECB kernel or 2/1-block kernels depending on number of blocks. */
+static void ocb_crypt_tail(struct camellia_ocb_ctx *ocb, uint8_t *out,
+			   const uint8_t *in, size_t nblks, uint8_t *offset,
+			   uint8_t *checksum, uint64_t *blkn, enum ocb_op op)
+{
+  struct camellia_simd_ctx *ctx = ocb->key;
+  uint8_t offsets[16 * 16];
+  uint8_t tmp[16 * 16];
+  size_t i;
+
+  for (i = 0; i < nblks; i++) {
+    xor_bytes(offset, offset, ocb->L[__builtin_ctzll(++*blkn)], 16);
+    memcpy(offsets + i * 16, offset, 16);
+    if (op == OCB_ENCRYPT)
+      xor_bytes(checksum, checksum, in + i * 16, 16);
+  }
+
+  xor_bytes(tmp, in, offsets, nblks * 16);
+
+  if (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL ||
+      !have_camellia_1blk_simd128()) {
+    if (op == OCB_DECRYPT)
+      camellia_decrypt_16blks_simd128(ctx, tmp, tmp);
+    else
+      camellia_encrypt_16blks_simd128(ctx, tmp, tmp);
+  } else {
+    crypt_small_blks(ctx, tmp, tmp, nblks, op != OCB_DECRYPT);
+  }
+
+  if (op == OCB_AUTHENTICATE) {
+    for (i = 0; i < nblks; i++)
+      xor_bytes(checksum, checksum, tmp + i * 16, 16);
+    return;
+  }
+
+  xor_bytes(out, tmp, offsets, nblks * 16);
+
+  if (op == OCB_DECRYPT) {
+    for (i = 0; i < nblks; i++)
+      xor_bytes(checksum, checksum, out + i * 16, 16);
+  }
+}
+
+/* Process NBLKS full blocks with widest available parallel kernel. */
+static void ocb_crypt_blks(struct camellia_ocb_ctx *ocb, uint8_t *out,
+			   const uint8_t *in, size_t nblks, uint8_t *offset,
+			   uint8_t *checksum, uint64_t *blkn, enum ocb_op op)
+{
+  struct camellia_simd_ctx *ctx = ocb->key;
+  const void *Ls[32];
+
+#ifdef USE_SIMD256
+  while (nblks >= 32) {
+    ocb_get_Ls(ocb, Ls, *blkn, 32);
+    if (op == OCB_ENCRYPT)
+      camellia_ocb_enc_32blks_simd256(ctx, out, in, offset, checksum, Ls);
+    else if (op == OCB_DECRYPT)
+      camellia_ocb_dec_32blks_simd256(ctx, out, in, offset, checksum, Ls);
+    else
+      camellia_ocb_auth_32blks_simd256(ctx, in, offset, checksum, Ls);
+    *blkn += 32;
+    if (out)
+      out += 32 * 16;
+    in += 32 * 16;
+    nblks -= 32;
+  }
+#endif
+
+  while (nblks >= 16) {
+    ocb_get_Ls(ocb, Ls, *blkn, 16);
+    if (op == OCB_ENCRYPT)
+      camellia_ocb_enc_16blks_simd128(ctx, out, in, offset, checksum, Ls);
+    else if (op == OCB_DECRYPT)
+      camellia_ocb_dec_16blks_simd128(ctx, out, in, offset, checksum, Ls);
+    else
+      camellia_ocb_auth_16blks_simd128(ctx, in, offset, checksum, Ls);
+    *blkn += 16;
+    if (out)
+      out += 16 * 16;
+    in += 16 * 16;
+    nblks -= 16;
+  }
+
+  if (nblks > 0)
+    ocb_crypt_tail(ocb, out, in, nblks, offset, checksum, blkn, op);
+}
+
+void camellia_ocb_setkey(struct camellia_ocb_ctx *ocb,
+			 struct camellia_simd_ctx *ctx)
+{
+  unsigned int i;
+
+  memset(ocb, 0, sizeof(*ocb));
+  ocb->key = ctx;
+
+  crypt_1blk(ctx, ocb->L_star, ocb->L_star, 1);
+  gf128_double_be(ocb->L_dollar, ocb->L_star);
+  gf128_double_be(ocb->L[0], ocb->L_dollar);
+  for (i = 1; i < 64; i++)
+    gf128_double_be(ocb->L[i], ocb->L[i - 1]);
+}
+
+int camellia_ocb_set_nonce(struct camellia_ocb_ctx *ocb, const void *nonce,
+			   size_t noncelen, size_t taglen)
+{
+  uint8_t ktop[16];
+  uint8_t stretch[24];
+  unsigned int bottom, byteshift, bitshift;
+  unsigned int i;
+
+  if (noncelen < 1 || noncelen > 15 || taglen < 1 || taglen > 16)
+    return -1;
+
+  /* Nonce = num2str(TAGLEN mod 128, 7) || zeros || 1 || N */
+  memset(ktop, 0, sizeof(ktop));
+  memcpy(ktop + 16 - noncelen, nonce, noncelen);
+  ktop[15 - noncelen] |= 1;
+  ktop[0] |= ((taglen * 8) % 128) << 1;
+
+  bottom = ktop[15] & 63;
+  ktop[15] &= 0xc0;
+  crypt_1blk(ocb->key, ktop, ktop, 1);
+
+  /* Stretch = Ktop || (Ktop[1..64] xor Ktop[9..72]) */
+  memcpy(stretch, ktop, 16);
+  for (i = 0; i < 8; i++)
+    stretch[16 + i] = ktop[i] ^ ktop[i + 1];
+
+  /* Offset_0 = Stretch[1+bottom..128+bottom] */
+  byteshift = bottom / 8;
+  bitshift = bottom % 8;
+  for (i = 0; i < 16; i++) {
+    ocb->offset[i] = stretch[i + byteshift] << bitshift;
+    if (bitshift)
+      ocb->offset[i] |= stretch[i + byteshift + 1] >> (8 - bitshift);
+  }
+
+  memset(ocb->checksum, 0, sizeof(ocb->checksum));
+  memset(ocb->aad_offset, 0, sizeof(ocb->aad_offset));
+  memset(ocb->aad_sum, 0, sizeof(ocb->aad_sum));
+  ocb->blkn = 0;
+  ocb->aad_blkn = 0;
+  ocb->aad_partial_len = 0;
+  ocb->taglen = taglen;
+
+  return 0;
+}
+
+void camellia_ocb_authenticate(struct camellia_ocb_ctx *ocb, const void *vaad,
+			       size_t nbytes)
+{
+  const uint8_t *aad = vaad;
+  size_t n;
+
+  if (ocb->aad_partial_len) {
+    n = 16 - ocb->aad_partial_len;
+    n = nbytes < n ? nbytes : n;
+    memcpy(ocb->aad_partial + ocb->aad_partial_len, aad, n);
+    ocb->aad_partial_len += n;
+    aad += n;
+    nbytes -= n;
+
+    if (ocb->aad_partial_len < 16)
+      return;
+
+    ocb_crypt_tail(ocb, NULL, ocb->aad_partial, 1, ocb->aad_offset,
+		   ocb->aad_sum, &ocb->aad_blkn, OCB_AUTHENTICATE);
+    ocb->aad_partial_len = 0;
+  }
+
+  ocb_crypt_blks(ocb, NULL, aad, nbytes / 16, ocb->aad_offset, ocb->aad_sum,
+		 &ocb->aad_blkn, OCB_AUTHENTICATE);
+  aad += nbytes & ~(size_t)15;
+  nbytes &= 15;
+
+  memcpy(ocb->aad_partial, aad, nbytes);
+  ocb->aad_partial_len = nbytes;
+}
+
+static void ocb_crypt(struct camellia_ocb_ctx *ocb, uint8_t *out,
+		      const uint8_t *in, size_t nbytes, enum ocb_op op)
+{
+  uint8_t pad[16];
+  size_t nblks = nbytes / 16;
+
+  ocb_crypt_blks(ocb, out, in, nblks, ocb->offset, ocb->checksum,
+		 &ocb->blkn, op);
+  out += nblks * 16;
+  in += nblks * 16;
+  nbytes -= nblks * 16;
+
+  if (nbytes == 0)
+    return;
+
+  /* Final partial block: Offset_* = Offset_m xor L_*, Pad = E(Offset_*) */
+  xor_bytes(ocb->offset, ocb->offset, ocb->L_star, 16);
+  crypt_1blk(ocb->key, pad, ocb->offset, 1);
+
+  /* Checksum_* = Checksum_m xor (P_* || 1 || zeros) */
+  if (op == OCB_ENCRYPT)
+    xor_bytes(ocb->checksum, ocb->checksum, in, nbytes);
+  xor_bytes(out, in, pad, nbytes);
+  if (op == OCB_DECRYPT)
+    xor_bytes(ocb->checksum, ocb->checksum, out, nbytes);
+  ocb->checksum[nbytes] ^= 0x80;
+}
+
+void camellia_ocb_encrypt(struct camellia_ocb_ctx *ocb, void *out,
+			  const void *in, size_t nbytes)
+{
+  ocb_crypt(ocb, out, in, nbytes, OCB_ENCRYPT);
+}
+
+void camellia_ocb_decrypt(struct camellia_ocb_ctx *ocb, void *out,
+			  const void *in, size_t nbytes)
+{
+  ocb_crypt(ocb, out, in, nbytes, OCB_DECRYPT);
+}
+
+static void ocb_calc_tag(struct camellia_ocb_ctx *ocb, uint8_t *tag)
+{
+  uint8_t sum[16];
+  uint8_t tmp[16];
+
+  /* HASH(K, A), with final partial block A_* */
+  memcpy(sum, ocb->aad_sum, 16);
+  if (ocb->aad_partial_len) {
+    memset(tmp, 0, 16);
+    memcpy(tmp, ocb->aad_partial, ocb->aad_partial_len);
+    tmp[ocb->aad_partial_len] = 0x80;
+    xor_bytes(tmp, tmp, ocb->aad_offset, 16);
+    xor_bytes(tmp, tmp, ocb->L_star, 16);
+    crypt_1blk(ocb->key, tmp, tmp, 1);
+    xor_bytes(sum, sum, tmp, 16);
+  }
+
+  /* Tag = ENCIPHER(K, Checksum xor Offset xor L_$) xor HASH(K, A) */
+  xor_bytes(tmp, ocb->checksum, ocb->offset, 16);
+  xor_bytes(tmp, tmp, ocb->L_dollar, 16);
+  crypt_1blk(ocb->key, tmp, tmp, 1);
+  xor_bytes(tag, tmp, sum, 16);
+}
+
+void camellia_ocb_get_tag(struct camellia_ocb_ctx *ocb, void *tag)
+{
+  uint8_t tmp[16];
+
+  ocb_calc_tag(ocb, tmp);
+  memcpy(tag, tmp, ocb->taglen);
+}
+
+int camellia_ocb_check_tag(struct camellia_ocb_ctx *ocb, const void *vtag)
+{
+  const uint8_t *tag = vtag;
+  uint8_t tmp[16];
+  uint8_t diff = 0;
+  unsigned int i;
+
+  ocb_calc_tag(ocb, tmp);
+  for (i = 0; i < ocb->taglen; i++)
+    diff |= tmp[i] ^ tag[i];
+
+  return diff ? -1 : 0;
+}
+
+/**********************************************************************
+  GCM mode
+ **********************************************************************/
+
+static void gcm_ghash(struct camellia_gcm_ctx *gcm, const uint8_t *in,
+		      size_t nblks)
+{
+#ifdef USE_SIMD256
+  camellia_gcm_ghash_simd256(gcm->hash, gcm->htable, in, nblks);
+#else
+  ghash_blks(gcm->hash, gcm->htable, in, nblks);
+#endif
+}
+
+/* Hash NBYTES from IN, with last partial block zero padded. */
+static void gcm_ghash_padded(struct camellia_gcm_ctx *gcm, const uint8_t *in,
+			     size_t nbytes)
+{
+  uint8_t tmp[16];
+
+  gcm_ghash(gcm, in, nbytes / 16);
+  in += nbytes & ~(size_t)15;
+  nbytes &= 15;
+
+  if (nbytes) {
+    memset(tmp, 0, 16);
+    memcpy(tmp, in, nbytes);
+    gcm_ghash(gcm, tmp, 1);
+  }
+}
+
+/* Encrypt 16 counter blocks and XOR with IN to OUT. Uses 16-block CTR kernel
+ * when low 32 bits of counter do not wrap. */
+static void gcm_ctr_16blks(struct camellia_gcm_ctx *gcm, uint8_t *out,
+			   const uint8_t *in)
+{
+  uint8_t tmp[16 * 16];
+
+  if (gcm->ctr[12] != 0xff || gcm->ctr[13] != 0xff ||
+      gcm->ctr[14] != 0xff || gcm->ctr[15] < 0xf0) {
+    camellia_ctr_enc_16blks_simd128(gcm->key, out, in, gcm->ctr);
+    return;
+  }
+
+  ctr_be32_blks(tmp, gcm->ctr, 16);
+  camellia_encrypt_16blks_simd128(gcm->key, tmp, tmp);
+  xor_bytes(out, in, tmp, 16 * 16);
+}
+
+static void gcm_flush_aad(struct camellia_gcm_ctx *gcm)
+{
+  if (gcm->aad_partial_len) {
+    gcm_ghash_padded(gcm, gcm->aad_partial, gcm->aad_partial_len);
+    gcm->aad_partial_len = 0;
+  }
+}
+
+void camellia_gcm_setkey(struct camellia_gcm_ctx *gcm,
+			 struct camellia_simd_ctx *ctx)
+{
+  uint8_t H[16];
+
+  memset(gcm, 0, sizeof(*gcm));
+  gcm->key = ctx;
+
+  memset(H, 0, 16);
+  crypt_1blk(ctx, H, H, 1);
+
+#ifdef USE_SIMD256
+  camellia_gcm_ghash_init_simd256(gcm->htable, H);
+#else
+  ghash_init(gcm->htable, H);
+#endif
+}
+
+int camellia_gcm_set_iv(struct camellia_gcm_ctx *gcm, const void *iv,
+			size_t ivlen)
+{
+  uint8_t lens[16];
+
+  if (ivlen == 0)
+    return -1;
+
+  memset(gcm->hash, 0, 16);
+
+  if (ivlen == 12) {
+    /* J0 = IV || 0^31 || 1 */
+    memcpy(gcm->J0, iv, 12);
+    memset(gcm->J0 + 12, 0, 4);
+    gcm->J0[15] = 1;
+  } else {
+    /* J0 = GHASH(IV || 0^s || 0^64 || [len(IV)]_64) */
+    gcm_ghash_padded(gcm, iv, ivlen);
+    store_be64(lens, 0);
+    store_be64(lens + 8, (uint64_t)ivlen * 8);
+    gcm_ghash(gcm, lens, 1);
+    memcpy(gcm->J0, gcm->hash, 16);
+    memset(gcm->hash, 0, 16);
+  }
+
+  memcpy(gcm->ctr, gcm->J0, 16);
+  ctr_be32_add(gcm->ctr, 1);
+  gcm->aadlen = 0;
+  gcm->datalen = 0;
+  gcm->aad_partial_len = 0;
+
+  return 0;
+}
+
+void camellia_gcm_authenticate(struct camellia_gcm_ctx *gcm, const void *vaad,
+			       size_t nbytes)
+{
+  const uint8_t *aad = vaad;
+  size_t n;
+
+  gcm->aadlen += nbytes;
+
+  if (gcm->aad_partial_len) {
+    n = 16 - gcm->aad_partial_len;
+    n = nbytes < n ? nbytes : n;
+    memcpy(gcm->aad_partial + gcm->aad_partial_len, aad, n);
+    gcm->aad_partial_len += n;
+    aad += n;
+    nbytes -= n;
+
+    if (gcm->aad_partial_len < 16)
+      return;
+
+    gcm_ghash(gcm, gcm->aad_partial, 1);
+    gcm->aad_partial_len = 0;
+  }
+
+  gcm_ghash(gcm, aad, nbytes / 16);
+  aad += nbytes & ~(size_t)15;
+  nbytes &= 15;
+
+  memcpy(gcm->aad_partial, aad, nbytes);
+  gcm->aad_partial_len = nbytes;
+}
+
+static void gcm_crypt(struct camellia_gcm_ctx *gcm, uint8_t *out,
+		      const uint8_t *in, size_t nbytes, int encrypt)
+{
+  uint8_t tmp[16 * 16];
+  size_t nblks;
+
+  gcm_flush_aad(gcm);
+  gcm->datalen += nbytes;
+
+#ifdef USE_SIMD256
+  if (nbytes >= 32 * 16) {
+    const uint8_t *prev = NULL;
+
+    /* GHASH of ciphertext is interleaved with encryption of next 32 blocks.
+     * For encryption, ciphertext is available only after kernel call, so
+     * hashing lags one call behind. */
+    while (nbytes >= 32 * 16) {
+      camellia_gcm_ctr_ghash_32blks_simd256(gcm->key, out, in, gcm->ctr,
+					    encrypt ? prev : in, gcm->hash,
+					    gcm->htable);
+      prev = out;
+      out += 32 * 16;
+      in += 32 * 16;
+      nbytes -= 32 * 16;
+    }
+
+    if (encrypt)
+      gcm_ghash(gcm, prev, 32);
+  }
+#endif
+
+  while (nbytes >= 16 * 16) {
+    if (!encrypt)
+      gcm_ghash(gcm, in, 16);
+    gcm_ctr_16blks(gcm, out, in);
+    if (encrypt)
+      gcm_ghash(gcm, out, 16);
+    out += 16 * 16;
+    in += 16 * 16;
+    nbytes -= 16 * 16;
+  }
+
+  if (nbytes == 0)
+    return;
+
+  nblks = (nbytes + 15) / 16;
+
+  if (!encrypt)
+    gcm_ghash_padded(gcm, in, nbytes);
+
+  if (nblks >= MIN_TAIL_BLKS_FOR_PARALLEL ||
+      !have_camellia_1blk_simd128()) {
+    uint8_t ctr_next[16];
+
+    memcpy(ctr_next, gcm->ctr, 16);
+    ctr_be32_add(ctr_next, nblks);
+
+    memcpy(tmp, in, nbytes);
+    gcm_ctr_16blks(gcm, tmp, tmp);
+    memcpy(out, tmp, nbytes);
+
+    memcpy(gcm->ctr, ctr_next, 16);
+  } else {
+    uint8_t *dst = out;
+    size_t left = nbytes;
+
+    while (left) {
+      size_t n = left < 16 ? left : 16;
+
+      camellia_encrypt_1blk_simd128(gcm->key, tmp, gcm->ctr, 1);
+      ctr_be32_add(gcm->ctr, 1);
+      xor_bytes(dst, in, tmp, n);
+      dst += n;
+      in += n;
+      left -= n;
+    }
+  }
+
+  if (encrypt)
+    gcm_ghash_padded(gcm, out, nbytes);
+}
+
+void camellia_gcm_encrypt(struct camellia_gcm_ctx *gcm, void *out,
+			  const void *in, size_t nbytes)
+{
+  gcm_crypt(gcm, out, in, nbytes, 1);
+}
+
+void camellia_gcm_decrypt(struct camellia_gcm_ctx *gcm, void *out,
+			  const void *in, size_t nbytes)
+{
+  gcm_crypt(gcm, out, in, nbytes, 0);
+}
+
+static void gcm_calc_tag(struct camellia_gcm_ctx *gcm, uint8_t *tag)
+{
+  uint8_t hash[16];
+  uint8_t lens[16];
+
+  gcm_flush_aad(gcm);
+
+  /* S = GHASH(A || 0^v || C || 0^u || [len(A)]_64 || [len(C)]_64) */
+  memcpy(hash, gcm->hash, 16);
+  store_be64(lens, gcm->aadlen * 8);
+  store_be64(lens + 8, gcm->datalen * 8);
+  gcm_ghash(gcm, lens, 1);
+
+  /* T = E(K, J0) xor S */
+  crypt_1blk(gcm->key, tag, gcm->J0, 1);
+  xor_bytes(tag, tag, gcm->hash, 16);
+
+  memcpy(gcm->hash, hash, 16);
+}
+
+void camellia_gcm_get_tag(struct camellia_gcm_ctx *gcm, void *tag,
+			  size_t taglen)
+{
+  uint8_t tmp[16];
+
+  gcm_calc_tag(gcm, tmp);
+  memcpy(tag, tmp, taglen < 16 ? taglen : 16);
+}
+
+int camellia_gcm_check_tag(struct camellia_gcm_ctx *gcm, const void *vtag,
+			   size_t taglen)
+{
+  const uint8_t *tag = vtag;
+  uint8_t tmp[16];
+  uint8_t diff = 0;
+  unsigned int i;
+
+  if (taglen < 1 || taglen > 16)
+    return -1;
+
+  gcm_calc_tag(gcm, tmp);
+  for (i = 0; i < taglen; i++)
+    diff |= tmp[i] ^ tag[i];
+
+  return diff ? -1 : 0;
+}
+
+/**********************************************************************
+  CCM mode
+ **********************************************************************/
+
+/* CBC-MAC input formatting of one message: B_0 || encoded AAD length ||
+ * AAD || zero padding || payload || zero padding. */
+struct ccm_fmt
+{
+  uint8_t b0[16];
+  uint8_t hdr[10];
+  unsigned int hdrlen;
+  const uint8_t *aad;
+  size_t aadlen;
+  const uint8_t *data;
+  size_t nbytes;
+  size_t naadblks;
+  size_t nblks;
+};
+
+static int ccm_check_params(size_t noncelen, size_t taglen)
+{
+  if (noncelen < 7 || noncelen > 13)
+    return -1;
+  if (taglen < 4 || taglen > 16 || (taglen & 1))
+    return -1;
+  return 0;
+}
+
+static int ccm_format_init(struct ccm_fmt *f, const uint8_t *nonce,
+			   size_t noncelen, const uint8_t *aad, size_t aadlen,
+			   const uint8_t *data, size_t nbytes, size_t taglen)
+{
+  unsigned int L = 15 - noncelen;
+  uint64_t len = nbytes;
+  unsigned int i;
+
+  if (ccm_check_params(noncelen, taglen) < 0)
+    return -1;
+  if (L < 8 && (nbytes >> (8 * L)) != 0)
+    return -1;
+
+  /* B_0 = Flags || Nonce || l(m) */
+  f->b0[0] = (aadlen ? 0x40 : 0) | (((taglen - 2) / 2) << 3) | (L - 1);
+  memcpy(f->b0 + 1, nonce, noncelen);
+  for (i = 15; i > noncelen; i--) {
+    f->b0[i] = len & 0xff;
+    len >>= 8;
+  }
+
+  /* l(a) encoding */
+  if (aadlen == 0) {
+    f->hdrlen = 0;
+  } else if (aadlen < 0xff00) {
+    f->hdrlen = 2;
+  } else if ((uint64_t)aadlen <= 0xffffffffU) {
+    f->hdr[0] = 0xff;
+    f->hdr[1] = 0xfe;
+    f->hdrlen = 6;
+  } else {
+    f->hdr[0] = 0xff;
+    f->hdr[1] = 0xff;
+    f->hdrlen = 10;
+  }
+  len = aadlen;
+  for (i = f->hdrlen; i > (f->hdrlen > 2 ? 2 : 0); i--) {
+    f->hdr[i - 1] = len & 0xff;
+    len >>= 8;
+  }
+
+  f->aad = aad;
+  f->aadlen = aadlen;
+  f->data = data;
+  f->nbytes = nbytes;
+  f->naadblks = (f->hdrlen + aadlen + 15) / 16;
+  f->nblks = 1 + f->naadblks + (nbytes + 15) / 16;
+
+  return 0;
+}
+
+/* Get CBC-MAC input block IDX of message. */
+static void ccm_format_blk(const struct ccm_fmt *f, size_t idx, uint8_t *blk)
+{
+  size_t pos, n, i;
+
+  if (idx == 0) {
+    memcpy(blk, f->b0, 16);
+    return;
+  }
+
+  idx--;
+  if (idx < f->naadblks) {
+    pos = idx * 16;
+    for (i = 0; i < 16; i++, pos++) {
+      if (pos < f->hdrlen)
+	blk[i] = f->hdr[pos];
+      else if (pos - f->hdrlen < f->aadlen)
+	blk[i] = f->aad[pos - f->hdrlen];
+      else
+	blk[i] = 0;
+    }
+    return;
+  }
+
+  pos = (idx - f->naadblks) * 16;
+  n = f->nbytes - pos < 16 ? f->nbytes - pos : 16;
+  memcpy(blk, f->data + pos, n);
+  memset(blk + n, 0, 16 - n);
+}
+
+/* CBC-MAC chain over input blocks START..END-1 of message, with 1-block
+ * kernel. */
+static void ccm_mac_blks(struct camellia_simd_ctx *ctx, uint8_t *mac,
+			 const struct ccm_fmt *f, size_t start, size_t end)
+{
+  uint8_t blk[16];
+
+  for (; start < end; start++) {
+    ccm_format_blk(f, start, blk);
+    xor_bytes(mac, mac, blk, 16);
+    crypt_1blk(ctx, mac, mac, 1);
+  }
+}
+
+/* A_0 = Flags || Nonce || 0 */
+static void ccm_ctr_init(uint8_t *ctr, const uint8_t *nonce, size_t noncelen)
+{
+  memset(ctr, 0, 16);
+  ctr[0] = (15 - noncelen) - 1;
+  memcpy(ctr + 1, nonce, noncelen);
+}
+
+static int ccm_crypt(struct camellia_simd_ctx *ctx, uint8_t *out,
+		     const uint8_t *in, size_t nbytes, const uint8_t *nonce,
+		     size_t noncelen, const uint8_t *aad, size_t aadlen,
+		     uint8_t *tag, size_t taglen, int encrypt)
+{
+  struct ccm_fmt f;
+  uint8_t mac[16];
+  uint8_t ctr[16];
+  uint8_t s0[16];
+  size_t idx;
+
+  /* CBC-MAC is computed over plaintext: input for encryption and output
+   * for decryption. */
+  if (ccm_format_init(&f, nonce, noncelen, aad, aadlen, encrypt ? in : out,
+		      nbytes, taglen) < 0)
+    return -1;
+
+  ccm_ctr_init(ctr, nonce, noncelen);
+  crypt_1blk(ctx, s0, ctr, 1);
+  ctr_be128_add(ctr, 1);
+
+  memset(mac, 0, 16);
+  ccm_mac_blks(ctx, mac, &f, 0, 1 + f.naadblks);
+  idx = 1 + f.naadblks;
+
+  /* Serial CBC-MAC chain with 1-block kernel is interleaved with parallel
+   * CTR kernel calls, one batch at a time. For encryption, plaintext batch
+   * is authenticated before CTR kernel so that in-place operation works;
+   * for decryption, batch is decrypted first. */
+#ifdef USE_SIMD256
+  while (nbytes >= 32 * 16) {
+    if (encrypt)
+      ccm_mac_blks(ctx, mac, &f, idx, idx + 32);
+    camellia_ctr_enc_32blks_simd256(ctx, out, in, ctr);
+    if (!encrypt)
+      ccm_mac_blks(ctx, mac, &f, idx, idx + 32);
+    idx += 32;
+    out += 32 * 16;
+    in += 32 * 16;
+    nbytes -= 32 * 16;
+  }
+#endif
+
+  while (nbytes >= 16 * 16) {
+    if (encrypt)
+      ccm_mac_blks(ctx, mac, &f, idx, idx + 16);
+    camellia_ctr_enc_16blks_simd128(ctx, out, in, ctr);
+    if (!encrypt)
+      ccm_mac_blks(ctx, mac, &f, idx, idx + 16);
+    idx += 16;
+    out += 16 * 16;
+    in += 16 * 16;
+    nbytes -= 16 * 16;
+  }
+
+  if (encrypt)
+    ccm_mac_blks(ctx, mac, &f, idx, f.nblks);
+  camellia_ctr_crypt(ctx, out, in, nbytes, ctr);
+  if (!encrypt)
+    ccm_mac_blks(ctx, mac, &f, idx, f.nblks);
+
+  xor_bytes(tag, mac, s0, taglen);
+  return 0;
+}
+
+int camellia_ccm_encrypt(struct camellia_simd_ctx *ctx, void *out,
+			 const void *in, size_t nbytes, const void *nonce,
+			 size_t noncelen, const void *aad, size_t aadlen,
+			 void *tag, size_t taglen)
+{
+  return ccm_crypt(ctx, out, in, nbytes, nonce, noncelen, aad, aadlen, tag,
+		   taglen, 1);
+}
+
+/* Compare tags in constant time. */
+static int ccm_tag_cmp(const uint8_t *a, const uint8_t *b, size_t taglen)
+{
+  uint8_t diff = 0;
+  size_t i;
+
+  for (i = 0; i < taglen; i++)
+    diff |= a[i] ^ b[i];
+
+  return diff ? -1 : 0;
+}
+
+int camellia_ccm_decrypt(struct camellia_simd_ctx *ctx, void *out,
+			 const void *in, size_t nbytes, const void *nonce,
+			 size_t noncelen, const void *aad, size_t aadlen,
+			 const void *tag, size_t taglen)
+{
+  uint8_t tmp[16];
+
+  if (ccm_crypt(ctx, out, in, nbytes, nonce, noncelen, aad, aadlen, tmp,
+		taglen, 0) < 0)
+    return -1;
+
+  if (ccm_tag_cmp(tmp, tag, taglen) < 0) {
+    memset(out, 0, nbytes);
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Keystream request of multi-message CTR: DST = SRC ^ E(counter), N
+ * bytes. */
+struct ccm_ks_lane
+{
+  uint8_t *dst;
+  const uint8_t *src;
+  size_t n;
+};
+
+/* CTR processing of multiple messages: counter blocks of all messages are
+ * packed to parallel kernel calls. A_0 of each message is encrypted to
+ * S0[i]. */
+static void ccm_ctr_multi(struct camellia_simd_ctx *ctx,
+			  struct camellia_ccm_msg **msgs, size_t nmsgs,
+			  size_t noncelen, uint8_t (*s0)[16])
+{
+  static const uint8_t zero[16];
+  struct ccm_ks_lane lanes[MAX_LANES];
+  uint8_t buf[MAX_LANES * 16];
+  uint8_t ctr[16];
+  size_t nlanes = 0;
+  size_t i, j, pos;
+
+  for (i = 0; i < nmsgs; i++) {
+    const uint8_t *in = msgs[i]->in;
+    uint8_t *out = msgs[i]->out;
+    size_t nbytes = msgs[i]->nbytes;
+
+    ccm_ctr_init(ctr, msgs[i]->nonce, noncelen);
+
+    /* A_0 for S_0, then A_1... for payload */
+    for (pos = 0; pos < 16 + nbytes; pos += 16) {
+      memcpy(buf + nlanes * 16, ctr, 16);
+      ctr_be128_add(ctr, 1);
+
+      if (pos == 0) {
+	lanes[nlanes].dst = s0[i];
+	lanes[nlanes].src = zero;
+	lanes[nlanes].n = 16;
+      } else {
+	lanes[nlanes].dst = out + pos - 16;
+	lanes[nlanes].src = in + pos - 16;
+	lanes[nlanes].n = nbytes - (pos - 16) < 16 ? nbytes - (pos - 16) : 16;
+      }
+
+      if (++nlanes == MAX_LANES) {
+	ecb_enc_lanes(ctx, buf, nlanes);
+	for (j = 0; j < nlanes; j++)
+	  xor_bytes(lanes[j].dst, lanes[j].src, buf + j * 16, lanes[j].n);
+	nlanes = 0;
+      }
+    }
+  }
+
+  if (nlanes) {
+    ecb_enc_lanes(ctx, buf, nlanes);
+    for (j = 0; j < nlanes; j++)
+      xor_bytes(lanes[j].dst, lanes[j].src, buf + j * 16, lanes[j].n);
+  }
+}
+
+/* CBC-MAC of up to MAX_LANES messages: each step advances the chain of
+ * every unfinished message by one block in a single parallel kernel call. */
+static void ccm_mac_multi(struct camellia_simd_ctx *ctx,
+			  const struct ccm_fmt *f, size_t nmsgs,
+			  uint8_t (*mac)[16])
+{
+  uint8_t buf[MAX_LANES * 16];
+  uint8_t blk[16];
+  size_t lane_msg[MAX_LANES];
+  size_t maxblks = 0;
+  size_t step, i, n;
+
+  for (i = 0; i < nmsgs; i++) {
+    memset(mac[i], 0, 16);
+    if (f[i].nblks > maxblks)
+      maxblks = f[i].nblks;
+  }
+
+  for (step = 0; step < maxblks; step++) {
+    for (i = 0, n = 0; i < nmsgs; i++) {
+      if (step >= f[i].nblks)
+	continue;
+      ccm_format_blk(&f[i], step, blk);
+      xor_bytes(buf + n * 16, mac[i], blk, 16);
+      lane_msg[n++] = i;
+    }
+
+    ecb_enc_lanes(ctx, buf, n);
+
+    for (i = 0; i < n; i++)
+      memcpy(mac[lane_msg[i]], buf + i * 16, 16);
+  }
+}
+
+static int ccm_crypt_multi(struct camellia_simd_ctx *ctx,
+			   struct camellia_ccm_msg *msgs, size_t nmsgs,
+			   size_t noncelen, size_t taglen, int encrypt)
+{
+  struct camellia_ccm_msg *batch[MAX_LANES];
+  struct ccm_fmt f[MAX_LANES];
+  uint8_t mac[MAX_LANES][16];
+  uint8_t s0[MAX_LANES][16];
+  uint8_t tag[16];
+  size_t i, n;
+  int ret = 0;
+
+  if (ccm_check_params(noncelen, taglen) < 0)
+    return -1;
+
+  while (nmsgs > 0) {
+    /* Gather next batch of messages, skipping ones with payload too long
+     * for nonce length; those get status -1 and are left untouched. */
+    for (n = 0; nmsgs > 0 && n < MAX_LANES; msgs++, nmsgs--) {
+      if (ccm_format_init(&f[n], msgs->nonce, noncelen, msgs->aad,
+			  msgs->aadlen, encrypt ? msgs->in : msgs->out,
+			  msgs->nbytes, taglen) < 0) {
+	msgs->status = -1;
+	ret = -1;
+	continue;
+      }
+      msgs->status = 0;
+      batch[n++] = msgs;
+    }
+    if (n == 0)
+      break;
+
+    /* For encryption, authenticate plaintext before it is overwritten by
+     * in-place CTR. For decryption, decrypt first. */
+    if (encrypt)
+      ccm_mac_multi(ctx, f, n, mac);
+    ccm_ctr_multi(ctx, batch, n, noncelen, s0);
+    if (!encrypt)
+      ccm_mac_multi(ctx, f, n, mac);
+
+    for (i = 0; i < n; i++) {
+      if (encrypt) {
+	xor_bytes(batch[i]->tag, mac[i], s0[i], taglen);
+	continue;
+      }
+
+      xor_bytes(tag, mac[i], s0[i], taglen);
+      batch[i]->status = ccm_tag_cmp(tag, batch[i]->tag, taglen);
+      if (batch[i]->status < 0) {
+	memset(batch[i]->out, 0, batch[i]->nbytes);
+	ret = -1;
+      }
+    }
+  }
+
+  return ret;
+}
+
+int camellia_ccm_encrypt_multi(struct camellia_simd_ctx *ctx,
+			       struct camellia_ccm_msg *msgs, size_t nmsgs,
+			       size_t noncelen, size_t taglen)
+{
+  return ccm_crypt_multi(ctx, msgs, nmsgs, noncelen, taglen, 1);
+}
+
+int camellia_ccm_decrypt_multi(struct camellia_simd_ctx *ctx,
+			       struct camellia_ccm_msg *msgs, size_t nmsgs,
+			       size_t noncelen, size_t taglen)
+{
+  return ccm_crypt_multi(ctx, msgs, nmsgs, noncelen, taglen, 0);
+}
+
+/**********************************************************************
+  CMAC
+ **********************************************************************/
+
+/* Set up chain for message IDX of JOBS: M_n is padded and XORed with K1 or
+ * K2 to LAST. Empty message is one padded block. */
+static void cmac_chain_init(const void *priv, const void *jobs, size_t idx,
+			    struct chain_lane *lane, uint8_t *x)
+{
+  const struct camellia_cmac_ctx *cmac = priv;
+  const struct camellia_cmac_msg *msg =
+    (const struct camellia_cmac_msg *)jobs + idx;
+  size_t nbytes = msg->nbytes;
+  size_t rem;
+
+  lane->in = msg->in;
+  lane->out = NULL;
+  lane->result = msg->mac;
+  lane->nblks = nbytes ? (nbytes + 15) / 16 : 1;
+  lane->has_last = 1;
+  memset(x, 0, 16);
+
+  rem = nbytes - (lane->nblks - 1) * 16;
+  memset(lane->last, 0, 16);
+  if (rem)
+    memcpy(lane->last, lane->in + (lane->nblks - 1) * 16, rem);
+
+  if (rem == 16) {
+    xor_bytes(lane->last, lane->last, cmac->K1, 16);
+  } else {
+    lane->last[rem] = 0x80;
+    xor_bytes(lane->last, lane->last, cmac->K2, 16);
+  }
+}
+
+void camellia_cmac_setkey(struct camellia_cmac_ctx *cmac,
+			  struct camellia_simd_ctx *ctx)
+{
+  uint8_t L[16];
+
+  memset(cmac, 0, sizeof(*cmac));
+  cmac->key = ctx;
+
+  memset(L, 0, 16);
+  crypt_1blk(ctx, L, L, 1);
+  gf128_double_be(cmac->K1, L);
+  gf128_double_be(cmac->K2, cmac->K1);
+}
+
+void camellia_cmac_multi(const struct camellia_cmac_ctx *cmac,
+			 const struct camellia_cmac_msg *msgs, size_t nmsgs)
+{
+  chain_multi(cmac->key, cmac_chain_init, cmac, msgs, nmsgs);
+}
+
+void camellia_cmac(const struct camellia_cmac_ctx *cmac, void *mac,
+		   const void *in, size_t nbytes)
+{
+  struct camellia_cmac_msg msg = { in, nbytes, mac };
+
+  camellia_cmac_multi(cmac, &msg, 1);
+}
+
+/**********************************************************************
+  streaming
+ **********************************************************************/
+
+/* Process NBYTES (whole blocks, or partial last block for CTR) from IN to
+ * OUT in stream MODE, continuing IV or counter. */
+static void crypt_stream_mode(struct camellia_simd_ctx *ctx, int mode,
+			      uint8_t *iv, uint8_t *out, const uint8_t *in,
+			      size_t nbytes)
+{
+  switch (mode) {
+    case CAMELLIA_STREAM_ECB_ENC:
+      camellia_ecb_encrypt(ctx, out, in, nbytes / 16);
+      break;
+    case CAMELLIA_STREAM_ECB_DEC:
+      camellia_ecb_decrypt(ctx, out, in, nbytes / 16);
+      break;
+    case CAMELLIA_STREAM_CTR:
+      camellia_ctr_crypt(ctx, out, in, nbytes, iv);
+      break;
+    case CAMELLIA_STREAM_CBC_DEC:
+      camellia_cbc_decrypt(ctx, out, in, nbytes / 16, iv);
+      break;
+  }
+}
+
+int camellia_stream_init(struct camellia_stream_ctx *st,
+			 struct camellia_simd_ctx *key, int mode,
+			 const void *iv)
+{
+  if (mode != CAMELLIA_STREAM_ECB_ENC && mode != CAMELLIA_STREAM_ECB_DEC &&
+      mode != CAMELLIA_STREAM_CTR && mode != CAMELLIA_STREAM_CBC_DEC)
+    return -1;
+
+  st->key = key;
+  st->mode = mode;
+  st->buflen = 0;
+  if (iv)
+    memcpy(st->iv, iv, 16);
+  else
+    memset(st->iv, 0, 16);
+
+  return 0;
+}
+
+size_t camellia_stream_update(struct camellia_stream_ctx *st, void *vout,
+			      const void *vin, size_t nbytes)
+{
+  uint8_t *out = vout;
+  const uint8_t *in = vin;
+  size_t nout = 0;
+  size_t n;
+
+  /* Complete buffered batch first. */
+  if (st->buflen) {
+    n = CAMELLIA_STREAM_BATCH_BYTES - st->buflen;
+    if (n > nbytes)
+      n = nbytes;
+    memcpy(st->buf + st->buflen, in, n);
+    st->buflen += n;
+    in += n;
+    nbytes -= n;
+
+    if (st->buflen < CAMELLIA_STREAM_BATCH_BYTES)
+      return 0;
+
+    crypt_stream_mode(st->key, st->mode, st->iv, out, st->buf,
+		      CAMELLIA_STREAM_BATCH_BYTES);
+    st->buflen = 0;
+    out += CAMELLIA_STREAM_BATCH_BYTES;
+    nout += CAMELLIA_STREAM_BATCH_BYTES;
+  }
+
+  /* Whole batches directly from input. */
+  n = nbytes - nbytes % CAMELLIA_STREAM_BATCH_BYTES;
+  if (n) {
+    crypt_stream_mode(st->key, st->mode, st->iv, out, in, n);
+    in += n;
+    nbytes -= n;
+    nout += n;
+  }
+
+  memcpy(st->buf, in, nbytes);
+  st->buflen = nbytes;
+
+  return nout;
+}
+
+int camellia_stream_final(struct camellia_stream_ctx *st, void *out,
+			  size_t *outlen)
+{
+  size_t nbytes = st->buflen;
+
+  *outlen = 0;
+  st->buflen = 0;
+
+  if (st->mode != CAMELLIA_STREAM_CTR && nbytes % 16)
+    return -1;
+
+  if (nbytes)
+    crypt_stream_mode(st->key, st->mode, st->iv, out, st->buf, nbytes);
+  *outlen = nbytes;
+
+  return 0;
+}
+
+/**********************************************************************
+  scatter-gather
+ **********************************************************************/
+
+struct iov_cursor
+{
+  const struct iovec *iov;
+  size_t cnt;
+  size_t off;
+};
+
+/* Skip empty and fully consumed segments. Returns bytes left in current
+ * segment, or 0 at end of array. */
+static size_t iov_cursor_avail(struct iov_cursor *c)
+{
+  while (c->cnt && c->off == c->iov->iov_len) {
+    c->iov++;
+    c->cnt--;
+    c->off = 0;
+  }
+
+  return c->cnt ? c->iov->iov_len - c->off : 0;
+}
+
+static inline uint8_t *iov_cursor_ptr(const struct iov_cursor *c)
+{
+  return (uint8_t *)c->iov->iov_base + c->off;
+}
+
+/* Copy NBYTES between linear buffer BUF and segments at cursor C, in
+ * direction given by GATHER, and advance C. */
+static void iov_cursor_copy(struct iov_cursor *c, uint8_t *buf, size_t nbytes,
+			    int gather)
+{
+  size_t n;
+
+  while (nbytes) {
+    n = iov_cursor_avail(c);
+    if (n > nbytes)
+      n = nbytes;
+    if (gather)
+      memcpy(buf, iov_cursor_ptr(c), n);
+    else
+      memcpy(iov_cursor_ptr(c), buf, n);
+    c->off += n;
+    buf += n;
+    nbytes -= n;
+  }
+}
+
+static size_t iov_total(const struct iovec *iov, size_t cnt)
+{
+  size_t total = 0;
+
+  while (cnt--)
+    total += (iov++)->iov_len;
+
+  return total;
+}
+
+#ifdef USE_SIMD256
+/* Advance cursor C by NBYTES. */
+static void iov_cursor_skip(struct iov_cursor *c, size_t nbytes)
+{
+  size_t n;
+
+  while (nbytes) {
+    n = iov_cursor_avail(c);
+    if (n > nbytes)
+      n = nbytes;
+    c->off += n;
+    nbytes -= n;
+  }
+}
+
+/* XOR 16-byte blocks SRC1 and SRC2 to DST, in words. */
+static inline void xor_blk(uint8_t *dst, const uint8_t *src1,
+			   const uint8_t *src2)
+{
+  uint64_t a[2], b[2];
+
+  memcpy(a, src1, 16);
+  memcpy(b, src2, 16);
+  a[0] ^= b[0];
+  a[1] ^= b[1];
+  memcpy(dst, a, 16);
+}
+
+/* Set PTRS to next 32 blocks at cursor C and advance C. Blocks within one
+ * segment point directly to it; blocks straddling segment boundary point
+ * to slots of BOUNCE, and are either gathered there (POS is NULL) or have
+ * their cursor position saved to POS for later scatter. Returns bitmask of
+ * bounced blocks. */
+static uint32_t iov_cursor_blk_ptrs(struct iov_cursor *c, uint8_t **ptrs,
+				    uint8_t bounce[][16],
+				    struct iov_cursor *pos)
+{
+  uint32_t bounced = 0;
+  unsigned int i = 0;
+  uint8_t *p;
+  size_t n;
+
+  while (i < 32) {
+    n = iov_cursor_avail(c);
+    if (n < 16) {
+      if (pos) {
+	pos[i] = *c;
+	iov_cursor_skip(c, 16);
+      } else {
+	iov_cursor_copy(c, bounce[i], 16, 1);
+      }
+      ptrs[i] = bounce[i];
+      bounced |= (uint32_t)1 << i;
+      i++;
+      continue;
+    }
+
+    n /= 16;
+    if (n > 32 - i)
+      n = 32 - i;
+    p = iov_cursor_ptr(c);
+    c->off += n * 16;
+    for (; n; n--, p += 16)
+      ptrs[i++] = p;
+  }
+
+  return bounced;
+}
+
+/* Process next 32 blocks at cursors S and D in ECB or CBC decryption MODE
+ * and advance cursors. Blocks are passed to gather/scatter kernel as
+ * pointers into segments; only blocks straddling segment boundary go
+ * through 16-byte bounce slots. */
+static void iov_crypt_32blks_ptrs(struct camellia_simd_ctx *ctx, int mode,
+				  uint8_t *iv, struct iov_cursor *s,
+				  struct iov_cursor *d)
+{
+  uint8_t bounce_in[32][16], bounce_out[32][16];
+  uint8_t tmp[32 * 16];
+  uint8_t next_iv[16];
+  uint8_t *inp[32];
+  uint8_t *outp[32];
+  uint8_t *tmpp[32];
+  struct iov_cursor bounce_pos[32];
+  uint32_t bounced;
+  unsigned int i;
+
+  iov_cursor_blk_ptrs(s, inp, bounce_in, NULL);
+  bounced = iov_cursor_blk_ptrs(d, outp, bounce_out, bounce_pos);
+
+  switch (mode) {
+    case CAMELLIA_STREAM_ECB_ENC:
+      camellia_encrypt_32blks_simd256_ptrs(ctx, (void *const *)outp,
+					   (const void *const *)inp);
+      break;
+    case CAMELLIA_STREAM_ECB_DEC:
+      camellia_decrypt_32blks_simd256_ptrs(ctx, (void *const *)outp,
+					   (const void *const *)inp);
+      break;
+    case CAMELLIA_STREAM_CBC_DEC:
+      /* Descending order, so that in-place output does not overwrite
+       * ciphertext of previous block before it is used. */
+      memcpy(next_iv, inp[31], 16);
+      for (i = 0; i < 32; i++)
+	tmpp[i] = tmp + i * 16;
+      camellia_decrypt_32blks_simd256_ptrs(ctx, (void *const *)tmpp,
+					   (const void *const *)inp);
+      for (i = 31; i > 0; i--)
+	xor_blk(outp[i], tmp + i * 16, inp[i - 1]);
+      xor_blk(outp[0], tmp, iv);
+      memcpy(iv, next_iv, 16);
+      break;
+  }
+
+  for (i = 0; i < 32; i++)
+    if (bounced & ((uint32_t)1 << i))
+      iov_cursor_copy(&bounce_pos[i], bounce_out[i], 16, 0);
+}
+#endif
+
+/* Process SRC to DST in stream MODE. Runs where both source and destination
+ * segments have at least a full batch (or rest of data) contiguous are
+ * passed directly to mode function. Elsewhere, in ECB and CBC decryption
+ * modes, SIMD256 builds pass next 32 blocks to gather/scatter kernel as
+ * pointers into segments; otherwise next batch is gathered to stack buffer,
+ * processed there and scattered to DST. CTR keystream does not depend on
+ * data, so CTR always uses stack buffer. Either way, blocks straddling
+ * segment boundaries still go to full width kernels. */
+static int iov_crypt(struct camellia_simd_ctx *ctx, int mode, uint8_t *iv,
+		     const struct iovec *dst, size_t dstcnt,
+		     const struct iovec *src, size_t srccnt)
+{
+  struct iov_cursor s = { src, srccnt, 0 };
+  struct iov_cursor d = { dst, dstcnt, 0 };
+  uint8_t tmp[CAMELLIA_STREAM_BATCH_BYTES];
+  size_t nbytes, n, dn;
+
+  nbytes = iov_total(src, srccnt);
+  if (iov_total(dst, dstcnt) < nbytes)
+    return -1;
+  if (mode != CAMELLIA_STREAM_CTR && nbytes % 16)
+    return -1;
+
+  while (nbytes) {
+    n = iov_cursor_avail(&s);
+    dn = iov_cursor_avail(&d);
+    if (n > dn)
+      n = dn;
+
+    if (n >= nbytes) {
+      n = nbytes;
+    } else if (n >= CAMELLIA_STREAM_BATCH_BYTES) {
+      n -= n % 16;
+    } else {
+#ifdef USE_SIMD256
+      if (mode != CAMELLIA_STREAM_CTR &&
+	  nbytes >= CAMELLIA_STREAM_BATCH_BYTES) {
+	iov_crypt_32blks_ptrs(ctx, mode, iv, &s, &d);
+	nbytes -= CAMELLIA_STREAM_BATCH_BYTES;
+	continue;
+      }
+#endif
+      n = nbytes < sizeof(tmp) ? nbytes : sizeof(tmp);
+      iov_cursor_copy(&s, tmp, n, 1);
+      crypt_stream_mode(ctx, mode, iv, tmp, tmp, n);
+      iov_cursor_copy(&d, tmp, n, 0);
+      nbytes -= n;
+      continue;
+    }
+
+    crypt_stream_mode(ctx, mode, iv, iov_cursor_ptr(&d), iov_cursor_ptr(&s),
+		      n);
+    s.off += n;
+    d.off += n;
+    nbytes -= n;
+  }
+
+  return 0;
+}
+
+int camellia_ecb_encrypt_iov(struct camellia_simd_ctx *ctx,
+			     const struct iovec *dst, size_t dstcnt,
+			     const struct iovec *src, size_t srccnt)
+{
+  return iov_crypt(ctx, CAMELLIA_STREAM_ECB_ENC, NULL, dst, dstcnt, src,
+		   srccnt);
+}
+
+int camellia_ecb_decrypt_iov(struct camellia_simd_ctx *ctx,
+			     const struct iovec *dst, size_t dstcnt,
+			     const struct iovec *src, size_t srccnt)
+{
+  return iov_crypt(ctx, CAMELLIA_STREAM_ECB_DEC, NULL, dst, dstcnt, src,
+		   srccnt);
+}
+
+int camellia_ctr_crypt_iov(struct camellia_simd_ctx *ctx,
+			   const struct iovec *dst, size_t dstcnt,
+			   const struct iovec *src, size_t srccnt, void *ctr)
+{
+  return iov_crypt(ctx, CAMELLIA_STREAM_CTR, ctr, dst, dstcnt, src, srccnt);
+}
+
+int camellia_cbc_decrypt_iov(struct camellia_simd_ctx *ctx,
+			     const struct iovec *dst, size_t dstcnt,
+			     const struct iovec *src, size_t srccnt, void *iv)
+{
+  return iov_crypt(ctx, CAMELLIA_STREAM_CBC_DEC, iv, dst, dstcnt, src,
+		   srccnt);
+}
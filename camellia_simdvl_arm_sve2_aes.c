@@ -0,0 +1,810 @@
+/*
+ * Copyright (C) 2026 camellia-simd-aesni contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * ARMv9 SVE2 implementation of Camellia cipher, using SVE2-AES for sbox
+ * calculations. This implementation is vector-length agnostic and takes
+ * 16 input blocks per 128 bits of SVE vector length (16 blocks on 128-bit
+ * SVE, 32 blocks on 256-bit SVE, ...) and process them in parallel.
+ *
+ * Byte-slicing is done with four levels of UZP1/UZP2 over whole input, so
+ * that register N holds byte N of every block, in block order. Since Camellia
+ * round function works on bytes in byte-sliced form, vector length matters
+ * only to AES instruction, which works on 128-bit segments and needs
+ * segment-local inverse ShiftRows shuffle. With 32 vector registers, whole
+ * AB and CD state is kept in registers.
+ */
+
+#include <stdint.h>
+#include <arm_sve.h>
+/* Kernels of this file are declared under USE_SVE2 in camellia_simd.h. */
+#ifndef USE_SVE2
+#define USE_SVE2 1
+#endif
+#include "camellia_simd.h"
+
+#if !defined(__ARM_FEATURE_SVE2) || !defined(__ARM_FEATURE_SVE2_AES)
+ #error "SVE2 implementation requires SVE2 and SVE2-AES"
+#endif
+
+/**********************************************************************
+  AT&T x86 asm to intrinsics conversion macros (SVE2)
+ **********************************************************************/
+#define vpand(a, b, o)          (o = svand_u8_x(svptrue_b8(), b, a))
+#define vpandn(a, b, o)         (o = svbic_u8_x(svptrue_b8(), a, b))
+#define vpxor(a, b, o)          (o = sveor_u8_x(svptrue_b8(), b, a))
+#define vpor(a, b, o)           (o = svorr_u8_x(svptrue_b8(), b, a))
+
+/* SVE2 three-way exclusive-or, o = a ^ b ^ c */
+#define vpxor3(a, b, c, o)      (o = sveor3_u8(c, b, a))
+
+#define vpsrlb(s, a, o)         (o = svlsr_n_u8_x(svptrue_b8(), a, s))
+#define vpaddb(a, b, o)         (o = svadd_u8_x(svptrue_b8(), b, a))
+
+/* Table lookup over whole vector; index out of range gives zero. */
+#define vtbl(m, a, o)           (o = svtbl_u8(a, m))
+
+#define vmovdqa(a, o)           (o = a)
+#define vpbroadcastb(a, o)      (o = svdup_n_u8(a))
+#define vmovq128_rep(a, o)      (o = svreinterpret_u8_u64(svdupq_n_u64(a, 0)))
+#define load_zero(o)            vpbroadcastb(0, o)
+
+/* Load 128-bit value and replicate it to all 128-bit segments */
+#define vbroadcasti128_memld(a, o) \
+	(o = svld1rq_u8(svptrue_b8(), (const uint8_t *)(a)))
+
+/* Following operations may have unaligned memory input/output. Inactive
+ * bytes of predicate P are not accessed and load as zero. */
+#define vmovdqu_memld_pred(p, a, o) (o = svld1_u8(p, (const uint8_t *)(a)))
+#define vmovdqu_memst_pred(p, a, o) svst1_u8(p, (uint8_t *)(o), a)
+
+/* SVE2-AES encrypt round => XOR round key + ShiftRows + SubBytes */
+#define aes_subbytes_and_shuf_and_xor(zero, a, o) (o = svaese_u8(a, zero))
+#define aes_inv_shuf(shufmask_reg, a, o) vtbl(shufmask_reg, a, o)
+
+/**********************************************************************
+  helper macros
+ **********************************************************************/
+
+/* Broadcast byte N of 64-bit key K to all bytes of O. */
+#define vpbroadcastb_key(k, n, o) \
+	vpbroadcastb((uint8_t)((k) >> ((n) * 8)), o)
+
+/* Pre-/post-whitening key K in block byte order (pack_bswap shuffle of
+ * x86 implementation), replicated to all 128-bit segments. */
+#define vmovq128_rep_whitening(k, o) \
+	vmovq128_rep((uint64_t)__builtin_bswap32((uint32_t)(k)) | \
+		     ((uint64_t)__builtin_bswap32((uint32_t)((k) >> 32)) << 32), \
+		     o)
+
+/* Predicate for active bytes of Nth register of input/output, when NBYTES
+ * bytes are processed with vector length of VLB bytes. */
+#define blk_pred(n) svwhilelt_b8_u64((uint64_t)(n) * vlb, nbytes)
+
+#define filter_8bit(x, lo_t, hi_t, mask4bit, tmp0) \
+	vpand(x, mask4bit, tmp0); \
+	vpsrlb(4, x, x); \
+	\
+	vtbl(tmp0, lo_t, tmp0); \
+	vtbl(x, hi_t, x); \
+	vpxor(tmp0, x, x);
+
+#define uzp_pair(a, b, t) \
+	t = svuzp1_u8(a, b); \
+	b = svuzp2_u8(a, b); \
+	a = t;
+
+#define zip_pair(a, b, t) \
+	t = svzip1_u8(a, b); \
+	b = svzip2_u8(a, b); \
+	a = t;
+
+#define sve_constants_declare \
+	svuint8_t inv_shuf, mask4bit, zero
+
+/* Inverse ShiftRows is done within each 128-bit segment, so segment base
+ * is added to shuffle indexes. Tables for filter_8bit are replicated to all
+ * segments and indexes 0..15 to first segment do not need adjusting. */
+#define prepare_sve_constants() \
+	vbroadcasti128_memld(inv_shift_row, inv_shuf); \
+	vpaddb(svand_n_u8_x(svptrue_b8(), svindex_u8(0, 1), 0xf0), inv_shuf, \
+	       inv_shuf); \
+	vpbroadcastb(0x0f, mask4bit); \
+	load_zero(zero)
+
+/**********************************************************************
+  VL-way camellia macros
+ **********************************************************************/
+
+/*
+ * IN:
+ *   x0..x7: byte-sliced AB state
+ *   y0..y7: byte-sliced CD state
+ *   key: key material
+ * OUT:
+ *   y0..y7: new byte-sliced CD state
+ */
+#define roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, key) \
+	/* \
+	 * S-function with AES subbytes \
+	 */ \
+	\
+	/* AES inverse shift rows */ \
+	aes_inv_shuf(inv_shuf, x0, t0); \
+	aes_inv_shuf(inv_shuf, x7, t7); \
+	aes_inv_shuf(inv_shuf, x1, t1); \
+	aes_inv_shuf(inv_shuf, x4, t4); \
+	aes_inv_shuf(inv_shuf, x2, t2); \
+	aes_inv_shuf(inv_shuf, x5, t5); \
+	aes_inv_shuf(inv_shuf, x3, t3); \
+	aes_inv_shuf(inv_shuf, x6, t6); \
+	\
+	/* prefilter sboxes 1, 2 and 3 */ \
+	vbroadcasti128_memld(pre_tf_lo_s1, tt0); \
+	vbroadcasti128_memld(pre_tf_hi_s1, tt1); \
+	filter_8bit(t0, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t7, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t1, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t4, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t2, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t5, tt0, tt1, mask4bit, tt2); \
+	\
+	/* prefilter sbox 4 */ \
+	vbroadcasti128_memld(pre_tf_lo_s4, tt0); \
+	vbroadcasti128_memld(pre_tf_hi_s4, tt1); \
+	filter_8bit(t3, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t6, tt0, tt1, mask4bit, tt2); \
+	\
+	/* AES subbytes + AES shift rows */ \
+	aes_subbytes_and_shuf_and_xor(zero, t0, t0); \
+	aes_subbytes_and_shuf_and_xor(zero, t7, t7); \
+	aes_subbytes_and_shuf_and_xor(zero, t1, t1); \
+	aes_subbytes_and_shuf_and_xor(zero, t4, t4); \
+	aes_subbytes_and_shuf_and_xor(zero, t2, t2); \
+	aes_subbytes_and_shuf_and_xor(zero, t5, t5); \
+	aes_subbytes_and_shuf_and_xor(zero, t3, t3); \
+	aes_subbytes_and_shuf_and_xor(zero, t6, t6); \
+	\
+	/* postfilter sboxes 1 and 4 */ \
+	vbroadcasti128_memld(post_tf_lo_s1, tt0); \
+	vbroadcasti128_memld(post_tf_hi_s1, tt1); \
+	filter_8bit(t0, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t7, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t3, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t6, tt0, tt1, mask4bit, tt2); \
+	\
+	/* postfilter sbox 3 */ \
+	vbroadcasti128_memld(post_tf_lo_s3, tt0); \
+	vbroadcasti128_memld(post_tf_hi_s3, tt1); \
+	filter_8bit(t2, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t5, tt0, tt1, mask4bit, tt2); \
+	\
+	/* postfilter sbox 2 */ \
+	vbroadcasti128_memld(post_tf_lo_s2, tt0); \
+	vbroadcasti128_memld(post_tf_hi_s2, tt1); \
+	filter_8bit(t1, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t4, tt0, tt1, mask4bit, tt2); \
+	\
+	/* P-function */ \
+	vpxor(t5, t0, t0); \
+	vpxor(t6, t1, t1); \
+	vpxor(t7, t2, t2); \
+	vpxor(t4, t3, t3); \
+	\
+	vpxor(t2, t4, t4); \
+	vpxor(t3, t5, t5); \
+	vpxor(t0, t6, t6); \
+	vpxor(t1, t7, t7); \
+	\
+	vpxor(t7, t0, t0); \
+	vpxor(t4, t1, t1); \
+	vpxor(t5, t2, t2); \
+	vpxor(t6, t3, t3); \
+	\
+	vpxor(t3, t4, t4); \
+	vpxor(t0, t5, t5); \
+	vpxor(t1, t6, t6); \
+	vpxor(t2, t7, t7); /* note: high and low parts swapped */ \
+	\
+	/* Add key material and result to CD */ \
+	vpbroadcastb_key(key, 3, tt0); \
+	vpxor3(tt0, t4, y0, y0); \
+	vpbroadcastb_key(key, 2, tt1); \
+	vpxor3(tt1, t5, y1, y1); \
+	vpbroadcastb_key(key, 1, tt0); \
+	vpxor3(tt0, t6, y2, y2); \
+	vpbroadcastb_key(key, 0, tt1); \
+	vpxor3(tt1, t7, y3, y3); \
+	vpbroadcastb_key(key, 7, tt0); \
+	vpxor3(tt0, t0, y4, y4); \
+	vpbroadcastb_key(key, 6, tt1); \
+	vpxor3(tt1, t1, y5, y5); \
+	vpbroadcastb_key(key, 5, tt0); \
+	vpxor3(tt0, t2, y6, y6); \
+	vpbroadcastb_key(key, 4, tt1); \
+	vpxor3(tt1, t3, y7, y7);
+
+/*
+ * IN/OUT:
+ *  x0..x7: byte-sliced AB state
+ *  y0..y7: byte-sliced CD state
+ */
+#define two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      i, dir) \
+	roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		  ctx->key_table[(i)]); \
+	roundsm16(y0, y1, y2, y3, y4, y5, y6, y7, x0, x1, x2, x3, x4, x5, \
+		  x6, x7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		  ctx->key_table[(i) + (dir)]);
+
+#define enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		     y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, i) \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 2, 1); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 4, 1); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 6, 1);
+
+#define dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		     y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, i) \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 7, -1); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 5, -1); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 3, -1);
+
+/*
+ * IN:
+ *  v0..3: byte-sliced 32-bit integers
+ * OUT:
+ *  v0..3: (IN <<< 1)
+ */
+#define rol32_1_16(v0, v1, v2, v3, t0, t1, t2) \
+	vpsrlb(7, v0, t0); \
+	vpaddb(v0, v0, v0); \
+	\
+	vpsrlb(7, v1, t1); \
+	vpaddb(v1, v1, v1); \
+	\
+	vpsrlb(7, v2, t2); \
+	vpaddb(v2, v2, v2); \
+	\
+	vpor(t0, v1, v1); \
+	\
+	vpsrlb(7, v3, t0); \
+	vpaddb(v3, v3, v3); \
+	\
+	vpor(t1, v2, v2); \
+	vpor(t2, v3, v3); \
+	vpor(t0, v0, v0);
+
+/*
+ * IN/OUT:
+ *   l0..l7: byte-sliced AB state
+ *   r0..r7: byte-sliced CD state
+ */
+#define fls16(l0, l1, l2, l3, l4, l5, l6, l7, r0, r1, r2, r3, r4, r5, r6, \
+	      r7, t0, t1, t2, t3, tt0, tt1, tt2, kl, kr) \
+	/* \
+	 * t0 = kll; \
+	 * t0 &= ll; \
+	 * lr ^= rol32(t0, 1); \
+	 */ \
+	vpbroadcastb_key(*(kl), 0, t3); \
+	vpbroadcastb_key(*(kl), 1, t2); \
+	vpbroadcastb_key(*(kl), 2, t1); \
+	vpbroadcastb_key(*(kl), 3, t0); \
+	\
+	vpand(l0, t0, t0); \
+	vpand(l1, t1, t1); \
+	vpand(l2, t2, t2); \
+	vpand(l3, t3, t3); \
+	\
+	rol32_1_16(t3, t2, t1, t0, tt0, tt1, tt2); \
+	\
+	vpxor(t0, l4, l4); \
+	vpxor(t1, l5, l5); \
+	vpxor(t2, l6, l6); \
+	vpxor(t3, l7, l7); \
+	\
+	/* \
+	 * t2 = krr; \
+	 * t2 |= rr; \
+	 * rl ^= t2; \
+	 */ \
+	vpbroadcastb_key(*(kr), 4, t3); \
+	vpbroadcastb_key(*(kr), 5, t2); \
+	vpbroadcastb_key(*(kr), 6, t1); \
+	vpbroadcastb_key(*(kr), 7, t0); \
+	\
+	vpor(r4, t0, t0); \
+	vpor(r5, t1, t1); \
+	vpor(r6, t2, t2); \
+	vpor(r7, t3, t3); \
+	\
+	vpxor(t0, r0, r0); \
+	vpxor(t1, r1, r1); \
+	vpxor(t2, r2, r2); \
+	vpxor(t3, r3, r3); \
+	\
+	/* \
+	 * t2 = krl; \
+	 * t2 &= rl; \
+	 * rr ^= rol32(t2, 1); \
+	 */ \
+	vpbroadcastb_key(*(kr), 0, t3); \
+	vpbroadcastb_key(*(kr), 1, t2); \
+	vpbroadcastb_key(*(kr), 2, t1); \
+	vpbroadcastb_key(*(kr), 3, t0); \
+	\
+	vpand(r0, t0, t0); \
+	vpand(r1, t1, t1); \
+	vpand(r2, t2, t2); \
+	vpand(r3, t3, t3); \
+	\
+	rol32_1_16(t3, t2, t1, t0, tt0, tt1, tt2); \
+	\
+	vpxor(t0, r4, r4); \
+	vpxor(t1, r5, r5); \
+	vpxor(t2, r6, r6); \
+	vpxor(t3, r7, r7); \
+	\
+	/* \
+	 * t0 = klr; \
+	 * t0 |= lr; \
+	 * ll ^= t0; \
+	 */ \
+	vpbroadcastb_key(*(kl), 4, t3); \
+	vpbroadcastb_key(*(kl), 5, t2); \
+	vpbroadcastb_key(*(kl), 6, t1); \
+	vpbroadcastb_key(*(kl), 7, t0); \
+	\
+	vpor(l4, t0, t0); \
+	vpor(l5, t1, t1); \
+	vpor(l6, t2, t2); \
+	vpor(l7, t3, t3); \
+	\
+	vpxor(t0, l0, l0); \
+	vpxor(t1, l1, l1); \
+	vpxor(t2, l2, l2); \
+	vpxor(t3, l3, l3);
+
+/* Byte-slice 16 registers of consecutive input blocks: after four levels of
+ * unzip, register N holds byte N of all blocks. */
+#define byteslice_16x16b(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, \
+			 x12, x13, x14, x15, t) \
+	uzp_pair(x0, x1, t); uzp_pair(x2, x3, t); \
+	uzp_pair(x4, x5, t); uzp_pair(x6, x7, t); \
+	uzp_pair(x8, x9, t); uzp_pair(x10, x11, t); \
+	uzp_pair(x12, x13, t); uzp_pair(x14, x15, t); \
+	\
+	uzp_pair(x0, x2, t); uzp_pair(x1, x3, t); \
+	uzp_pair(x4, x6, t); uzp_pair(x5, x7, t); \
+	uzp_pair(x8, x10, t); uzp_pair(x9, x11, t); \
+	uzp_pair(x12, x14, t); uzp_pair(x13, x15, t); \
+	\
+	uzp_pair(x0, x4, t); uzp_pair(x1, x5, t); \
+	uzp_pair(x2, x6, t); uzp_pair(x3, x7, t); \
+	uzp_pair(x8, x12, t); uzp_pair(x9, x13, t); \
+	uzp_pair(x10, x14, t); uzp_pair(x11, x15, t); \
+	\
+	uzp_pair(x0, x8, t); uzp_pair(x1, x9, t); \
+	uzp_pair(x2, x10, t); uzp_pair(x3, x11, t); \
+	uzp_pair(x4, x12, t); uzp_pair(x5, x13, t); \
+	uzp_pair(x6, x14, t); uzp_pair(x7, x15, t);
+
+/* Inverse of byteslice_16x16b. */
+#define unbyteslice_16x16b(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, \
+			   x12, x13, x14, x15, t) \
+	zip_pair(x0, x8, t); zip_pair(x1, x9, t); \
+	zip_pair(x2, x10, t); zip_pair(x3, x11, t); \
+	zip_pair(x4, x12, t); zip_pair(x5, x13, t); \
+	zip_pair(x6, x14, t); zip_pair(x7, x15, t); \
+	\
+	zip_pair(x0, x4, t); zip_pair(x1, x5, t); \
+	zip_pair(x2, x6, t); zip_pair(x3, x7, t); \
+	zip_pair(x8, x12, t); zip_pair(x9, x13, t); \
+	zip_pair(x10, x14, t); zip_pair(x11, x15, t); \
+	\
+	zip_pair(x0, x2, t); zip_pair(x1, x3, t); \
+	zip_pair(x4, x6, t); zip_pair(x5, x7, t); \
+	zip_pair(x8, x10, t); zip_pair(x9, x11, t); \
+	zip_pair(x12, x14, t); zip_pair(x13, x15, t); \
+	\
+	zip_pair(x0, x1, t); zip_pair(x2, x3, t); \
+	zip_pair(x4, x5, t); zip_pair(x6, x7, t); \
+	zip_pair(x8, x9, t); zip_pair(x10, x11, t); \
+	zip_pair(x12, x13, t); zip_pair(x14, x15, t);
+
+/* load blocks to registers, apply pre-whitening and byteslice; x0..x7 get
+ * AB state and x8..x15 CD state */
+#define inpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, \
+		 x13, x14, x15, rio, key, t0, t1) \
+	vmovq128_rep_whitening(key, t0); \
+	\
+	vmovdqu_memld_pred(blk_pred(0), (rio) + 0 * vlb, x0); \
+	vmovdqu_memld_pred(blk_pred(1), (rio) + 1 * vlb, x1); \
+	vmovdqu_memld_pred(blk_pred(2), (rio) + 2 * vlb, x2); \
+	vmovdqu_memld_pred(blk_pred(3), (rio) + 3 * vlb, x3); \
+	vmovdqu_memld_pred(blk_pred(4), (rio) + 4 * vlb, x4); \
+	vmovdqu_memld_pred(blk_pred(5), (rio) + 5 * vlb, x5); \
+	vmovdqu_memld_pred(blk_pred(6), (rio) + 6 * vlb, x6); \
+	vmovdqu_memld_pred(blk_pred(7), (rio) + 7 * vlb, x7); \
+	vmovdqu_memld_pred(blk_pred(8), (rio) + 8 * vlb, x8); \
+	vmovdqu_memld_pred(blk_pred(9), (rio) + 9 * vlb, x9); \
+	vmovdqu_memld_pred(blk_pred(10), (rio) + 10 * vlb, x10); \
+	vmovdqu_memld_pred(blk_pred(11), (rio) + 11 * vlb, x11); \
+	vmovdqu_memld_pred(blk_pred(12), (rio) + 12 * vlb, x12); \
+	vmovdqu_memld_pred(blk_pred(13), (rio) + 13 * vlb, x13); \
+	vmovdqu_memld_pred(blk_pred(14), (rio) + 14 * vlb, x14); \
+	vmovdqu_memld_pred(blk_pred(15), (rio) + 15 * vlb, x15); \
+	\
+	vpxor(t0, x0, x0); \
+	vpxor(t0, x1, x1); \
+	vpxor(t0, x2, x2); \
+	vpxor(t0, x3, x3); \
+	vpxor(t0, x4, x4); \
+	vpxor(t0, x5, x5); \
+	vpxor(t0, x6, x6); \
+	vpxor(t0, x7, x7); \
+	vpxor(t0, x8, x8); \
+	vpxor(t0, x9, x9); \
+	vpxor(t0, x10, x10); \
+	vpxor(t0, x11, x11); \
+	vpxor(t0, x12, x12); \
+	vpxor(t0, x13, x13); \
+	vpxor(t0, x14, x14); \
+	vpxor(t0, x15, x15); \
+	\
+	byteslice_16x16b(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, \
+			 x12, x13, x14, x15, t1);
+
+/* de-byteslice, apply post-whitening and store blocks; x0..x15 are bytes
+ * 0..15 of output blocks */
+#define outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, \
+		    x13, x14, x15, rio, key, t0, t1) \
+	unbyteslice_16x16b(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, \
+			   x12, x13, x14, x15, t1); \
+	\
+	vmovq128_rep_whitening(key, t0); \
+	\
+	vpxor(t0, x0, x0); \
+	vmovdqu_memst_pred(blk_pred(0), x0, (rio) + 0 * vlb); \
+	vpxor(t0, x1, x1); \
+	vmovdqu_memst_pred(blk_pred(1), x1, (rio) + 1 * vlb); \
+	vpxor(t0, x2, x2); \
+	vmovdqu_memst_pred(blk_pred(2), x2, (rio) + 2 * vlb); \
+	vpxor(t0, x3, x3); \
+	vmovdqu_memst_pred(blk_pred(3), x3, (rio) + 3 * vlb); \
+	vpxor(t0, x4, x4); \
+	vmovdqu_memst_pred(blk_pred(4), x4, (rio) + 4 * vlb); \
+	vpxor(t0, x5, x5); \
+	vmovdqu_memst_pred(blk_pred(5), x5, (rio) + 5 * vlb); \
+	vpxor(t0, x6, x6); \
+	vmovdqu_memst_pred(blk_pred(6), x6, (rio) + 6 * vlb); \
+	vpxor(t0, x7, x7); \
+	vmovdqu_memst_pred(blk_pred(7), x7, (rio) + 7 * vlb); \
+	vpxor(t0, x8, x8); \
+	vmovdqu_memst_pred(blk_pred(8), x8, (rio) + 8 * vlb); \
+	vpxor(t0, x9, x9); \
+	vmovdqu_memst_pred(blk_pred(9), x9, (rio) + 9 * vlb); \
+	vpxor(t0, x10, x10); \
+	vmovdqu_memst_pred(blk_pred(10), x10, (rio) + 10 * vlb); \
+	vpxor(t0, x11, x11); \
+	vmovdqu_memst_pred(blk_pred(11), x11, (rio) + 11 * vlb); \
+	vpxor(t0, x12, x12); \
+	vmovdqu_memst_pred(blk_pred(12), x12, (rio) + 12 * vlb); \
+	vpxor(t0, x13, x13); \
+	vmovdqu_memst_pred(blk_pred(13), x13, (rio) + 13 * vlb); \
+	vpxor(t0, x14, x14); \
+	vmovdqu_memst_pred(blk_pred(14), x14, (rio) + 14 * vlb); \
+	vpxor(t0, x15, x15); \
+	vmovdqu_memst_pred(blk_pred(15), x15, (rio) + 15 * vlb);
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state
+ *  y0..y7: byte-sliced CD state
+ *  lastk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: encrypted AB and CD state, before post-whitening
+ */
+#define enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, lastk) \
+	({ \
+	  unsigned int __k = 0; \
+	  \
+	  while (1) { \
+	    enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, \
+			 tt2, __k); \
+	    \
+	    if (__k == (lastk) - 8) \
+	      break; \
+	    \
+	    fls16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, y6, \
+		  y7, t0, t1, t2, t3, tt0, tt1, tt2, &ctx->key_table[__k + 8], \
+		  &ctx->key_table[__k + 9]); \
+	    \
+	    __k += 8; \
+	  } \
+	})
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state
+ *  y0..y7: byte-sliced CD state
+ *  firstk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: decrypted AB and CD state, before post-whitening
+ */
+#define dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		  firstk) \
+	({ \
+	  unsigned int __k = (firstk) - 8; \
+	  \
+	  while (1) { \
+	    dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, \
+			 tt2, __k); \
+	    \
+	    if (__k == 0) \
+	      break; \
+	    \
+	    fls16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, y6, \
+		  y7, t0, t1, t2, t3, tt0, tt1, tt2, &ctx->key_table[__k + 1], \
+		  &ctx->key_table[__k]); \
+	    \
+	    __k -= 8; \
+	  } \
+	})
+
+/**********************************************************************
+  constant vectors
+ **********************************************************************/
+
+/*
+ * pre-SubByte transform
+ *
+ * pre-lookup for sbox1, sbox2, sbox3:
+ *   swap_bitendianness(
+ *       isom_map_camellia_to_aes(
+ *           camellia_f(
+ *               swap_bitendianess(in)
+ *           )
+ *       )
+ *   )
+ *
+ * (note: '⊕ 0xc5' inside camellia_f())
+ */
+static const uint8_t pre_tf_lo_s1[16] __attribute__((aligned(16))) =
+{
+  0x45, 0xe8, 0x40, 0xed, 0x2e, 0x83, 0x2b, 0x86,
+  0x4b, 0xe6, 0x4e, 0xe3, 0x20, 0x8d, 0x25, 0x88
+};
+
+static const uint8_t pre_tf_hi_s1[16] __attribute__((aligned(16))) =
+{
+  0x00, 0x51, 0xf1, 0xa0, 0x8a, 0xdb, 0x7b, 0x2a,
+  0x09, 0x58, 0xf8, 0xa9, 0x83, 0xd2, 0x72, 0x23
+};
+
+/*
+ * pre-SubByte transform
+ *
+ * pre-lookup for sbox4:
+ *   swap_bitendianness(
+ *       isom_map_camellia_to_aes(
+ *           camellia_f(
+ *               swap_bitendianess(in <<< 1)
+ *           )
+ *       )
+ *   )
+ *
+ * (note: '⊕ 0xc5' inside camellia_f())
+ */
+static const uint8_t pre_tf_lo_s4[16] __attribute__((aligned(16))) =
+{
+  0x45, 0x40, 0x2e, 0x2b, 0x4b, 0x4e, 0x20, 0x25,
+  0x14, 0x11, 0x7f, 0x7a, 0x1a, 0x1f, 0x71, 0x74
+};
+
+static const uint8_t pre_tf_hi_s4[16] __attribute__((aligned(16))) =
+{
+  0x00, 0xf1, 0x8a, 0x7b, 0x09, 0xf8, 0x83, 0x72,
+  0xad, 0x5c, 0x27, 0xd6, 0xa4, 0x55, 0x2e, 0xdf
+};
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox1, sbox4:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  )
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const uint8_t post_tf_lo_s1[16] __attribute__((aligned(16))) =
+{
+  0x3c, 0xcc, 0xcf, 0x3f, 0x32, 0xc2, 0xc1, 0x31,
+  0xdc, 0x2c, 0x2f, 0xdf, 0xd2, 0x22, 0x21, 0xd1
+};
+
+static const uint8_t post_tf_hi_s1[16] __attribute__((aligned(16))) =
+{
+  0x00, 0xf9, 0x86, 0x7f, 0xd7, 0x2e, 0x51, 0xa8,
+  0xa4, 0x5d, 0x22, 0xdb, 0x73, 0x8a, 0xf5, 0x0c
+};
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox2:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  ) <<< 1
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const uint8_t post_tf_lo_s2[16] __attribute__((aligned(16))) =
+{
+  0x78, 0x99, 0x9f, 0x7e, 0x64, 0x85, 0x83, 0x62,
+  0xb9, 0x58, 0x5e, 0xbf, 0xa5, 0x44, 0x42, 0xa3
+};
+
+static const uint8_t post_tf_hi_s2[16] __attribute__((aligned(16))) =
+{
+  0x00, 0xf3, 0x0d, 0xfe, 0xaf, 0x5c, 0xa2, 0x51,
+  0x49, 0xba, 0x44, 0xb7, 0xe6, 0x15, 0xeb, 0x18
+};
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox3:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  ) >>> 1
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const uint8_t post_tf_lo_s3[16] __attribute__((aligned(16))) =
+{
+  0x1e, 0x66, 0xe7, 0x9f, 0x19, 0x61, 0xe0, 0x98,
+  0x6e, 0x16, 0x97, 0xef, 0x69, 0x11, 0x90, 0xe8
+};
+
+static const uint8_t post_tf_hi_s3[16] __attribute__((aligned(16))) =
+{
+  0x00, 0xfc, 0x43, 0xbf, 0xeb, 0x17, 0xa8, 0x54,
+  0x52, 0xae, 0x11, 0xed, 0xb9, 0x45, 0xfa, 0x06
+};
+
+/* For isolating SubBytes from AESE, inverse shift row */
+static const uint8_t inv_shift_row[16] __attribute__((aligned(16))) =
+{
+  0x00, 0x0d, 0x0a, 0x07, 0x04, 0x01, 0x0e, 0x0b,
+  0x08, 0x05, 0x02, 0x0f, 0x0c, 0x09, 0x06, 0x03
+};
+
+/**********************************************************************
+  VL-way camellia
+ **********************************************************************/
+
+unsigned int camellia_sve2_parallel_blks(void)
+{
+  /* 16 blocks per 128-bit segment, one block per vector byte. */
+  return svcntb();
+}
+
+/* Encrypts NBLKS (at most camellia_sve2_parallel_blks()) input blocks from IN
+ * and writes result to OUT. IN and OUT may unaligned pointers. Memory after
+ * NBLKS blocks is not accessed. */
+void camellia_encrypt_nblks_sve2(struct camellia_simd_ctx *ctx, void *vout,
+				 const void *vin, size_t nblks)
+{
+  char *out = vout;
+  const char *in = vin;
+  const uint64_t vlb = svcntb();
+  uint64_t nbytes;
+  svuint8_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15;
+  svuint8_t t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2;
+  unsigned int lastk;
+  sve_constants_declare;
+
+  if (nblks == 0)
+    return;
+  if (nblks > vlb)
+    nblks = vlb;
+  nbytes = nblks * 16;
+
+  prepare_sve_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  inpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	   x15, in, ctx->key_table[0], t0, t1);
+
+  enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, lastk);
+
+  outunpack16(x8, x9, x10, x11, x12, x13, x14, x15, x0, x1, x2, x3, x4, x5,
+	      x6, x7, out, ctx->key_table[lastk], t0, t1);
+}
+
+/* Decrypts NBLKS (at most camellia_sve2_parallel_blks()) input blocks from IN
+ * and writes result to OUT. IN and OUT may unaligned pointers. Memory after
+ * NBLKS blocks is not accessed. */
+void camellia_decrypt_nblks_sve2(struct camellia_simd_ctx *ctx, void *vout,
+				 const void *vin, size_t nblks)
+{
+  char *out = vout;
+  const char *in = vin;
+  const uint64_t vlb = svcntb();
+  uint64_t nbytes;
+  svuint8_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15;
+  svuint8_t t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2;
+  unsigned int firstk;
+  sve_constants_declare;
+
+  if (nblks == 0)
+    return;
+  if (nblks > vlb)
+    nblks = vlb;
+  nbytes = nblks * 16;
+
+  prepare_sve_constants();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  inpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	   x15, in, ctx->key_table[firstk], t0, t1);
+
+  dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, firstk);
+
+  outunpack16(x8, x9, x10, x11, x12, x13, x14, x15, x0, x1, x2, x3, x4, x5,
+	      x6, x7, out, ctx->key_table[0], t0, t1);
+}
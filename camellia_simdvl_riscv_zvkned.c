@@ -0,0 +1,757 @@
+/*
+ * Copyright (C) 2026 camellia-simd-aesni contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * RISC-V vector implementation of Camellia cipher, using Zvkned for sbox
+ * calculations. This implementation is VLEN agnostic and takes 16 input
+ * blocks per 128 bits of VLEN (16 blocks on VLEN=128, 32 blocks on
+ * VLEN=256, ...) and process them in parallel.
+ *
+ * Byte-slicing is done by strided loads/stores with 16-byte stride, so that
+ * register N holds byte N of every block, in block order. Since Camellia
+ * round function works on bytes in byte-sliced form, VLEN matters only to
+ * AES instruction, which works on 128-bit element groups and needs
+ * group-local inverse ShiftRows shuffle. Byte indexes for VRGATHER limit
+ * parallel blocks to 256 (VLEN=2048); larger VLEN leaves rest of vector
+ * register unused.
+ *
+ * Vector length is set to number of input blocks for loads/stores, so memory
+ * after last block is not accessed. Other operations work on whole 128-bit
+ * element groups.
+ */
+
+#include <stdint.h>
+#include <riscv_vector.h>
+/* Kernels of this file are declared under USE_RVV in camellia_simd.h. */
+#ifndef USE_RVV
+#define USE_RVV 1
+#endif
+#include "camellia_simd.h"
+
+#if !defined(__riscv) || !(__riscv_v_min_vlen >= 128) || \
+    !(__riscv_v_intrinsic >= 11000) || !(__riscv_zvkned >= 1000000)
+ #error "RVV implementation requires V (VLEN >= 128) and Zvkned"
+#endif
+
+#define RVV_MAX_PARALLEL_BLKS 256
+
+/**********************************************************************
+  AT&T x86 asm to intrinsics conversion macros (RISC-V V+Zvkned)
+ **********************************************************************/
+#define cast_u8_to_u32(a)       (__riscv_vreinterpret_v_u8m1_u32m1(a))
+#define cast_u32_to_u8(a)       (__riscv_vreinterpret_v_u32m1_u8m1(a))
+
+#define vpand(a, b, o)          (o = __riscv_vand_vv_u8m1((b), (a), vla))
+#define vpxor(a, b, o)          (o = __riscv_vxor_vv_u8m1((b), (a), vla))
+#define vpor(a, b, o)           (o = __riscv_vor_vv_u8m1((b), (a), vla))
+
+/* o = a ^ b ^ c */
+#define vpxor3(a, b, c, o)      (o = __riscv_vxor_vv_u8m1( \
+					__riscv_vxor_vv_u8m1((c), (b), vla), \
+					(a), vla))
+
+#define vpsrlb(s, a, o)         (o = __riscv_vsrl_vx_u8m1((a), (s), vla))
+#define vpaddb(a, b, o)         (o = __riscv_vadd_vv_u8m1((b), (a), vla))
+
+/* Table lookup over whole vector; index out of range gives zero. */
+#define vtbl(m, a, o)           (o = __riscv_vrgather_vv_u8m1((a), (m), vla))
+
+#define vmovdqa(a, o)           (o = (a))
+#define vpbroadcastb(a, o)      (o = __riscv_vmv_v_x_u8m1((a), vla))
+#define load_zero(o)            vpbroadcastb(0, o)
+
+/* Load 16-byte lookup table. Only table indexes 0..15 are used, so rest of
+ * register is left undefined. */
+#define vmovdqa_tbl16_memld(a, o) \
+	(o = __riscv_vle8_v_u8m1((const uint8_t *)(a), 16))
+
+/* Following operations may have unaligned memory input/output. Byte N of
+ * first VL blocks is loaded/stored, register elements past VL are
+ * undefined after load. */
+#define vmovdqu_memld_byte(n, a, o) \
+	(o = __riscv_vlse8_v_u8m1((const uint8_t *)(a) + (n), 16, vl))
+#define vmovdqu_memst_byte(n, a, o) \
+	__riscv_vsse8_v_u8m1((uint8_t *)(o) + (n), 16, a, vl)
+
+/* Zvkned AES encrypt last round => ShiftRows + SubBytes + XOR round key */
+#define aes_subbytes_and_shuf_and_xor(zero, a, o) \
+	(o = cast_u32_to_u8(__riscv_vaesef_vv_u32m1(cast_u8_to_u32(a), \
+						    cast_u8_to_u32(zero), \
+						    vla / 4)))
+#define aes_inv_shuf(shufmask_reg, a, o) vtbl(shufmask_reg, a, o)
+
+/**********************************************************************
+  helper macros
+ **********************************************************************/
+
+/* Broadcast byte N of 64-bit key K to all bytes of O. */
+#define vpbroadcastb_key(k, n, o) \
+	vpbroadcastb((uint8_t)((k) >> ((n) * 8)), o)
+
+#define filter_8bit(x, lo_t, hi_t, mask4bit, tmp0) \
+	vpand(x, mask4bit, tmp0); \
+	vpsrlb(4, x, x); \
+	\
+	vtbl(tmp0, lo_t, tmp0); \
+	vtbl(x, hi_t, x); \
+	vpxor(tmp0, x, x);
+
+#define rvv_constants_declare \
+	vuint8m1_t inv_shuf, mask4bit, zero
+
+/* Inverse ShiftRows is done within each 128-bit element group, so group base
+ * is added to shuffle indexes (ZERO and MASK4BIT used as temporaries here). */
+#define prepare_rvv_constants() \
+	vmovdqa_tbl16_memld(inv_shift_row, zero); \
+	inv_shuf = __riscv_vand_vx_u8m1(__riscv_vid_v_u8m1(vla), 0x0f, vla); \
+	vtbl(inv_shuf, zero, inv_shuf); \
+	mask4bit = __riscv_vand_vx_u8m1(__riscv_vid_v_u8m1(vla), 0xf0, vla); \
+	vpaddb(mask4bit, inv_shuf, inv_shuf); \
+	vpbroadcastb(0x0f, mask4bit); \
+	load_zero(zero)
+
+/**********************************************************************
+  VLEN-way camellia macros
+ **********************************************************************/
+
+/*
+ * IN:
+ *   x0..x7: byte-sliced AB state
+ *   y0..y7: byte-sliced CD state
+ *   key: key material
+ * OUT:
+ *   y0..y7: new byte-sliced CD state
+ */
+#define roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, key) \
+	/* \
+	 * S-function with AES subbytes \
+	 */ \
+	\
+	/* AES inverse shift rows */ \
+	aes_inv_shuf(inv_shuf, x0, t0); \
+	aes_inv_shuf(inv_shuf, x7, t7); \
+	aes_inv_shuf(inv_shuf, x1, t1); \
+	aes_inv_shuf(inv_shuf, x4, t4); \
+	aes_inv_shuf(inv_shuf, x2, t2); \
+	aes_inv_shuf(inv_shuf, x5, t5); \
+	aes_inv_shuf(inv_shuf, x3, t3); \
+	aes_inv_shuf(inv_shuf, x6, t6); \
+	\
+	/* prefilter sboxes 1, 2 and 3 */ \
+	vmovdqa_tbl16_memld(pre_tf_lo_s1, tt0); \
+	vmovdqa_tbl16_memld(pre_tf_hi_s1, tt1); \
+	filter_8bit(t0, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t7, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t1, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t4, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t2, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t5, tt0, tt1, mask4bit, tt2); \
+	\
+	/* prefilter sbox 4 */ \
+	vmovdqa_tbl16_memld(pre_tf_lo_s4, tt0); \
+	vmovdqa_tbl16_memld(pre_tf_hi_s4, tt1); \
+	filter_8bit(t3, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t6, tt0, tt1, mask4bit, tt2); \
+	\
+	/* AES subbytes + AES shift rows */ \
+	aes_subbytes_and_shuf_and_xor(zero, t0, t0); \
+	aes_subbytes_and_shuf_and_xor(zero, t7, t7); \
+	aes_subbytes_and_shuf_and_xor(zero, t1, t1); \
+	aes_subbytes_and_shuf_and_xor(zero, t4, t4); \
+	aes_subbytes_and_shuf_and_xor(zero, t2, t2); \
+	aes_subbytes_and_shuf_and_xor(zero, t5, t5); \
+	aes_subbytes_and_shuf_and_xor(zero, t3, t3); \
+	aes_subbytes_and_shuf_and_xor(zero, t6, t6); \
+	\
+	/* postfilter sboxes 1 and 4 */ \
+	vmovdqa_tbl16_memld(post_tf_lo_s1, tt0); \
+	vmovdqa_tbl16_memld(post_tf_hi_s1, tt1); \
+	filter_8bit(t0, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t7, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t3, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t6, tt0, tt1, mask4bit, tt2); \
+	\
+	/* postfilter sbox 3 */ \
+	vmovdqa_tbl16_memld(post_tf_lo_s3, tt0); \
+	vmovdqa_tbl16_memld(post_tf_hi_s3, tt1); \
+	filter_8bit(t2, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t5, tt0, tt1, mask4bit, tt2); \
+	\
+	/* postfilter sbox 2 */ \
+	vmovdqa_tbl16_memld(post_tf_lo_s2, tt0); \
+	vmovdqa_tbl16_memld(post_tf_hi_s2, tt1); \
+	filter_8bit(t1, tt0, tt1, mask4bit, tt2); \
+	filter_8bit(t4, tt0, tt1, mask4bit, tt2); \
+	\
+	/* P-function */ \
+	vpxor(t5, t0, t0); \
+	vpxor(t6, t1, t1); \
+	vpxor(t7, t2, t2); \
+	vpxor(t4, t3, t3); \
+	\
+	vpxor(t2, t4, t4); \
+	vpxor(t3, t5, t5); \
+	vpxor(t0, t6, t6); \
+	vpxor(t1, t7, t7); \
+	\
+	vpxor(t7, t0, t0); \
+	vpxor(t4, t1, t1); \
+	vpxor(t5, t2, t2); \
+	vpxor(t6, t3, t3); \
+	\
+	vpxor(t3, t4, t4); \
+	vpxor(t0, t5, t5); \
+	vpxor(t1, t6, t6); \
+	vpxor(t2, t7, t7); /* note: high and low parts swapped */ \
+	\
+	/* Add key material and result to CD */ \
+	vpbroadcastb_key(key, 3, tt0); \
+	vpxor3(tt0, t4, y0, y0); \
+	vpbroadcastb_key(key, 2, tt1); \
+	vpxor3(tt1, t5, y1, y1); \
+	vpbroadcastb_key(key, 1, tt0); \
+	vpxor3(tt0, t6, y2, y2); \
+	vpbroadcastb_key(key, 0, tt1); \
+	vpxor3(tt1, t7, y3, y3); \
+	vpbroadcastb_key(key, 7, tt0); \
+	vpxor3(tt0, t0, y4, y4); \
+	vpbroadcastb_key(key, 6, tt1); \
+	vpxor3(tt1, t1, y5, y5); \
+	vpbroadcastb_key(key, 5, tt0); \
+	vpxor3(tt0, t2, y6, y6); \
+	vpbroadcastb_key(key, 4, tt1); \
+	vpxor3(tt1, t3, y7, y7);
+
+/*
+ * IN/OUT:
+ *  x0..x7: byte-sliced AB state
+ *  y0..y7: byte-sliced CD state
+ */
+#define two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      i, dir) \
+	roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		  ctx->key_table[(i)]); \
+	roundsm16(y0, y1, y2, y3, y4, y5, y6, y7, x0, x1, x2, x3, x4, x5, \
+		  x6, x7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		  ctx->key_table[(i) + (dir)]);
+
+#define enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		     y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, i) \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 2, 1); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 4, 1); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 6, 1);
+
+#define dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		     y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, i) \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 7, -1); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 5, -1); \
+	two_roundsm16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		      y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		      (i) + 3, -1);
+
+/*
+ * IN:
+ *  v0..3: byte-sliced 32-bit integers
+ * OUT:
+ *  v0..3: (IN <<< 1)
+ */
+#define rol32_1_16(v0, v1, v2, v3, t0, t1, t2) \
+	vpsrlb(7, v0, t0); \
+	vpaddb(v0, v0, v0); \
+	\
+	vpsrlb(7, v1, t1); \
+	vpaddb(v1, v1, v1); \
+	\
+	vpsrlb(7, v2, t2); \
+	vpaddb(v2, v2, v2); \
+	\
+	vpor(t0, v1, v1); \
+	\
+	vpsrlb(7, v3, t0); \
+	vpaddb(v3, v3, v3); \
+	\
+	vpor(t1, v2, v2); \
+	vpor(t2, v3, v3); \
+	vpor(t0, v0, v0);
+
+/*
+ * IN/OUT:
+ *   l0..l7: byte-sliced AB state
+ *   r0..r7: byte-sliced CD state
+ */
+#define fls16(l0, l1, l2, l3, l4, l5, l6, l7, r0, r1, r2, r3, r4, r5, r6, \
+	      r7, t0, t1, t2, t3, tt0, tt1, tt2, kl, kr) \
+	/* \
+	 * t0 = kll; \
+	 * t0 &= ll; \
+	 * lr ^= rol32(t0, 1); \
+	 */ \
+	vpbroadcastb_key(*(kl), 0, t3); \
+	vpbroadcastb_key(*(kl), 1, t2); \
+	vpbroadcastb_key(*(kl), 2, t1); \
+	vpbroadcastb_key(*(kl), 3, t0); \
+	\
+	vpand(l0, t0, t0); \
+	vpand(l1, t1, t1); \
+	vpand(l2, t2, t2); \
+	vpand(l3, t3, t3); \
+	\
+	rol32_1_16(t3, t2, t1, t0, tt0, tt1, tt2); \
+	\
+	vpxor(t0, l4, l4); \
+	vpxor(t1, l5, l5); \
+	vpxor(t2, l6, l6); \
+	vpxor(t3, l7, l7); \
+	\
+	/* \
+	 * t2 = krr; \
+	 * t2 |= rr; \
+	 * rl ^= t2; \
+	 */ \
+	vpbroadcastb_key(*(kr), 4, t3); \
+	vpbroadcastb_key(*(kr), 5, t2); \
+	vpbroadcastb_key(*(kr), 6, t1); \
+	vpbroadcastb_key(*(kr), 7, t0); \
+	\
+	vpor(r4, t0, t0); \
+	vpor(r5, t1, t1); \
+	vpor(r6, t2, t2); \
+	vpor(r7, t3, t3); \
+	\
+	vpxor(t0, r0, r0); \
+	vpxor(t1, r1, r1); \
+	vpxor(t2, r2, r2); \
+	vpxor(t3, r3, r3); \
+	\
+	/* \
+	 * t2 = krl; \
+	 * t2 &= rl; \
+	 * rr ^= rol32(t2, 1); \
+	 */ \
+	vpbroadcastb_key(*(kr), 0, t3); \
+	vpbroadcastb_key(*(kr), 1, t2); \
+	vpbroadcastb_key(*(kr), 2, t1); \
+	vpbroadcastb_key(*(kr), 3, t0); \
+	\
+	vpand(r0, t0, t0); \
+	vpand(r1, t1, t1); \
+	vpand(r2, t2, t2); \
+	vpand(r3, t3, t3); \
+	\
+	rol32_1_16(t3, t2, t1, t0, tt0, tt1, tt2); \
+	\
+	vpxor(t0, r4, r4); \
+	vpxor(t1, r5, r5); \
+	vpxor(t2, r6, r6); \
+	vpxor(t3, r7, r7); \
+	\
+	/* \
+	 * t0 = klr; \
+	 * t0 |= lr; \
+	 * ll ^= t0; \
+	 */ \
+	vpbroadcastb_key(*(kl), 4, t3); \
+	vpbroadcastb_key(*(kl), 5, t2); \
+	vpbroadcastb_key(*(kl), 6, t1); \
+	vpbroadcastb_key(*(kl), 7, t0); \
+	\
+	vpor(l4, t0, t0); \
+	vpor(l5, t1, t1); \
+	vpor(l6, t2, t2); \
+	vpor(l7, t3, t3); \
+	\
+	vpxor(t0, l0, l0); \
+	vpxor(t1, l1, l1); \
+	vpxor(t2, l2, l2); \
+	vpxor(t3, l3, l3);
+
+/* load blocks to byte-sliced registers and apply pre-whitening; x0..x7 get
+ * AB state and x8..x15 CD state */
+#define inpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, \
+		 x13, x14, x15, rio, key, t0) \
+	vmovdqu_memld_byte(0, rio, x0); \
+	vmovdqu_memld_byte(1, rio, x1); \
+	vmovdqu_memld_byte(2, rio, x2); \
+	vmovdqu_memld_byte(3, rio, x3); \
+	vmovdqu_memld_byte(4, rio, x4); \
+	vmovdqu_memld_byte(5, rio, x5); \
+	vmovdqu_memld_byte(6, rio, x6); \
+	vmovdqu_memld_byte(7, rio, x7); \
+	vmovdqu_memld_byte(8, rio, x8); \
+	vmovdqu_memld_byte(9, rio, x9); \
+	vmovdqu_memld_byte(10, rio, x10); \
+	vmovdqu_memld_byte(11, rio, x11); \
+	vmovdqu_memld_byte(12, rio, x12); \
+	vmovdqu_memld_byte(13, rio, x13); \
+	vmovdqu_memld_byte(14, rio, x14); \
+	vmovdqu_memld_byte(15, rio, x15); \
+	\
+	/* whitening key covers only AB, in big-endian 32-bit words */ \
+	vpbroadcastb_key(key, 3, t0); \
+	vpxor(t0, x0, x0); \
+	vpbroadcastb_key(key, 2, t0); \
+	vpxor(t0, x1, x1); \
+	vpbroadcastb_key(key, 1, t0); \
+	vpxor(t0, x2, x2); \
+	vpbroadcastb_key(key, 0, t0); \
+	vpxor(t0, x3, x3); \
+	vpbroadcastb_key(key, 7, t0); \
+	vpxor(t0, x4, x4); \
+	vpbroadcastb_key(key, 6, t0); \
+	vpxor(t0, x5, x5); \
+	vpbroadcastb_key(key, 5, t0); \
+	vpxor(t0, x6, x6); \
+	vpbroadcastb_key(key, 4, t0); \
+	vpxor(t0, x7, x7);
+
+/* apply post-whitening and store byte-sliced registers to blocks; x0..x15
+ * are bytes 0..15 of output blocks */
+#define outunpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, \
+		    x13, x14, x15, rio, key, t0) \
+	vpbroadcastb_key(key, 3, t0); \
+	vpxor(t0, x0, x0); \
+	vpbroadcastb_key(key, 2, t0); \
+	vpxor(t0, x1, x1); \
+	vpbroadcastb_key(key, 1, t0); \
+	vpxor(t0, x2, x2); \
+	vpbroadcastb_key(key, 0, t0); \
+	vpxor(t0, x3, x3); \
+	vpbroadcastb_key(key, 7, t0); \
+	vpxor(t0, x4, x4); \
+	vpbroadcastb_key(key, 6, t0); \
+	vpxor(t0, x5, x5); \
+	vpbroadcastb_key(key, 5, t0); \
+	vpxor(t0, x6, x6); \
+	vpbroadcastb_key(key, 4, t0); \
+	vpxor(t0, x7, x7); \
+	\
+	vmovdqu_memst_byte(0, x0, rio); \
+	vmovdqu_memst_byte(1, x1, rio); \
+	vmovdqu_memst_byte(2, x2, rio); \
+	vmovdqu_memst_byte(3, x3, rio); \
+	vmovdqu_memst_byte(4, x4, rio); \
+	vmovdqu_memst_byte(5, x5, rio); \
+	vmovdqu_memst_byte(6, x6, rio); \
+	vmovdqu_memst_byte(7, x7, rio); \
+	vmovdqu_memst_byte(8, x8, rio); \
+	vmovdqu_memst_byte(9, x9, rio); \
+	vmovdqu_memst_byte(10, x10, rio); \
+	vmovdqu_memst_byte(11, x11, rio); \
+	vmovdqu_memst_byte(12, x12, rio); \
+	vmovdqu_memst_byte(13, x13, rio); \
+	vmovdqu_memst_byte(14, x14, rio); \
+	vmovdqu_memst_byte(15, x15, rio);
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state
+ *  y0..y7: byte-sliced CD state
+ *  lastk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: encrypted AB and CD state, before post-whitening
+ */
+#define enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, lastk) \
+	({ \
+	  unsigned int __k = 0; \
+	  \
+	  while (1) { \
+	    enc_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, \
+			 tt2, __k); \
+	    \
+	    if (__k == (lastk) - 8) \
+	      break; \
+	    \
+	    fls16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, y6, \
+		  y7, t0, t1, t2, t3, tt0, tt1, tt2, &ctx->key_table[__k + 8], \
+		  &ctx->key_table[__k + 9]); \
+	    \
+	    __k += 8; \
+	  } \
+	})
+
+/*
+ * IN:
+ *  x0..x7: byte-sliced AB state
+ *  y0..y7: byte-sliced CD state
+ *  firstk: 24 for 16 byte key, 32 for larger
+ * OUT:
+ *  x0..x7, y0..y7: decrypted AB and CD state, before post-whitening
+ */
+#define dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, \
+		  y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, \
+		  firstk) \
+	({ \
+	  unsigned int __k = (firstk) - 8; \
+	  \
+	  while (1) { \
+	    dec_rounds16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, \
+			 y5, y6, y7, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, \
+			 tt2, __k); \
+	    \
+	    if (__k == 0) \
+	      break; \
+	    \
+	    fls16(x0, x1, x2, x3, x4, x5, x6, x7, y0, y1, y2, y3, y4, y5, y6, \
+		  y7, t0, t1, t2, t3, tt0, tt1, tt2, &ctx->key_table[__k + 1], \
+		  &ctx->key_table[__k]); \
+	    \
+	    __k -= 8; \
+	  } \
+	})
+
+/**********************************************************************
+  constant vectors
+ **********************************************************************/
+
+/*
+ * pre-SubByte transform
+ *
+ * pre-lookup for sbox1, sbox2, sbox3:
+ *   swap_bitendianness(
+ *       isom_map_camellia_to_aes(
+ *           camellia_f(
+ *               swap_bitendianess(in)
+ *           )
+ *       )
+ *   )
+ *
+ * (note: '⊕ 0xc5' inside camellia_f())
+ */
+static const uint8_t pre_tf_lo_s1[16] __attribute__((aligned(16))) =
+{
+  0x45, 0xe8, 0x40, 0xed, 0x2e, 0x83, 0x2b, 0x86,
+  0x4b, 0xe6, 0x4e, 0xe3, 0x20, 0x8d, 0x25, 0x88
+};
+
+static const uint8_t pre_tf_hi_s1[16] __attribute__((aligned(16))) =
+{
+  0x00, 0x51, 0xf1, 0xa0, 0x8a, 0xdb, 0x7b, 0x2a,
+  0x09, 0x58, 0xf8, 0xa9, 0x83, 0xd2, 0x72, 0x23
+};
+
+/*
+ * pre-SubByte transform
+ *
+ * pre-lookup for sbox4:
+ *   swap_bitendianness(
+ *       isom_map_camellia_to_aes(
+ *           camellia_f(
+ *               swap_bitendianess(in <<< 1)
+ *           )
+ *       )
+ *   )
+ *
+ * (note: '⊕ 0xc5' inside camellia_f())
+ */
+static const uint8_t pre_tf_lo_s4[16] __attribute__((aligned(16))) =
+{
+  0x45, 0x40, 0x2e, 0x2b, 0x4b, 0x4e, 0x20, 0x25,
+  0x14, 0x11, 0x7f, 0x7a, 0x1a, 0x1f, 0x71, 0x74
+};
+
+static const uint8_t pre_tf_hi_s4[16] __attribute__((aligned(16))) =
+{
+  0x00, 0xf1, 0x8a, 0x7b, 0x09, 0xf8, 0x83, 0x72,
+  0xad, 0x5c, 0x27, 0xd6, 0xa4, 0x55, 0x2e, 0xdf
+};
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox1, sbox4:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  )
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const uint8_t post_tf_lo_s1[16] __attribute__((aligned(16))) =
+{
+  0x3c, 0xcc, 0xcf, 0x3f, 0x32, 0xc2, 0xc1, 0x31,
+  0xdc, 0x2c, 0x2f, 0xdf, 0xd2, 0x22, 0x21, 0xd1
+};
+
+static const uint8_t post_tf_hi_s1[16] __attribute__((aligned(16))) =
+{
+  0x00, 0xf9, 0x86, 0x7f, 0xd7, 0x2e, 0x51, 0xa8,
+  0xa4, 0x5d, 0x22, 0xdb, 0x73, 0x8a, 0xf5, 0x0c
+};
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox2:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  ) <<< 1
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const uint8_t post_tf_lo_s2[16] __attribute__((aligned(16))) =
+{
+  0x78, 0x99, 0x9f, 0x7e, 0x64, 0x85, 0x83, 0x62,
+  0xb9, 0x58, 0x5e, 0xbf, 0xa5, 0x44, 0x42, 0xa3
+};
+
+static const uint8_t post_tf_hi_s2[16] __attribute__((aligned(16))) =
+{
+  0x00, 0xf3, 0x0d, 0xfe, 0xaf, 0x5c, 0xa2, 0x51,
+  0x49, 0xba, 0x44, 0xb7, 0xe6, 0x15, 0xeb, 0x18
+};
+
+/*
+ * post-SubByte transform
+ *
+ * post-lookup for sbox3:
+ *  swap_bitendianness(
+ *      camellia_h(
+ *          isom_map_aes_to_camellia(
+ *              swap_bitendianness(
+ *                  aes_inverse_affine_transform(in)
+ *              )
+ *          )
+ *      )
+ *  ) >>> 1
+ *
+ * (note: '⊕ 0x6e' inside camellia_h())
+ */
+static const uint8_t post_tf_lo_s3[16] __attribute__((aligned(16))) =
+{
+  0x1e, 0x66, 0xe7, 0x9f, 0x19, 0x61, 0xe0, 0x98,
+  0x6e, 0x16, 0x97, 0xef, 0x69, 0x11, 0x90, 0xe8
+};
+
+static const uint8_t post_tf_hi_s3[16] __attribute__((aligned(16))) =
+{
+  0x00, 0xfc, 0x43, 0xbf, 0xeb, 0x17, 0xa8, 0x54,
+  0x52, 0xae, 0x11, 0xed, 0xb9, 0x45, 0xfa, 0x06
+};
+
+/* For isolating SubBytes from AESEF, inverse shift row */
+static const uint8_t inv_shift_row[16] __attribute__((aligned(16))) =
+{
+  0x00, 0x0d, 0x0a, 0x07, 0x04, 0x01, 0x0e, 0x0b,
+  0x08, 0x05, 0x02, 0x0f, 0x0c, 0x09, 0x06, 0x03
+};
+
+/**********************************************************************
+  VLEN-way camellia
+ **********************************************************************/
+
+unsigned int camellia_rvv_parallel_blks(void)
+{
+  /* 16 blocks per 128-bit element group, one block per vector byte. */
+  size_t vlmax = __riscv_vsetvlmax_e8m1();
+
+  return vlmax < RVV_MAX_PARALLEL_BLKS ? vlmax : RVV_MAX_PARALLEL_BLKS;
+}
+
+/* Encrypts NBLKS (at most camellia_rvv_parallel_blks()) input blocks from IN
+ * and writes result to OUT. IN and OUT may unaligned pointers. Memory after
+ * NBLKS blocks is not accessed. */
+void camellia_encrypt_nblks_rvv(struct camellia_simd_ctx *ctx, void *vout,
+				const void *vin, size_t nblks)
+{
+  char *out = vout;
+  const char *in = vin;
+  size_t vl, vla;
+  vuint8m1_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	     x15;
+  vuint8m1_t t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2;
+  unsigned int lastk;
+  rvv_constants_declare;
+
+  if (nblks == 0)
+    return;
+  vl = camellia_rvv_parallel_blks();
+  if (nblks < vl)
+    vl = nblks;
+  /* round up to whole AES element groups */
+  vla = (vl + 15) & ~(size_t)15;
+
+  prepare_rvv_constants();
+
+  if (ctx->key_length > 16)
+    lastk = 32;
+  else
+    lastk = 24;
+
+  inpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	   x15, in, ctx->key_table[0], t0);
+
+  enc_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, lastk);
+
+  outunpack16(x8, x9, x10, x11, x12, x13, x14, x15, x0, x1, x2, x3, x4, x5,
+	      x6, x7, out, ctx->key_table[lastk], t0);
+}
+
+/* Decrypts NBLKS (at most camellia_rvv_parallel_blks()) input blocks from IN
+ * and writes result to OUT. IN and OUT may unaligned pointers. Memory after
+ * NBLKS blocks is not accessed. */
+void camellia_decrypt_nblks_rvv(struct camellia_simd_ctx *ctx, void *vout,
+				const void *vin, size_t nblks)
+{
+  char *out = vout;
+  const char *in = vin;
+  size_t vl, vla;
+  vuint8m1_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	     x15;
+  vuint8m1_t t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2;
+  unsigned int firstk;
+  rvv_constants_declare;
+
+  if (nblks == 0)
+    return;
+  vl = camellia_rvv_parallel_blks();
+  if (nblks < vl)
+    vl = nblks;
+  /* round up to whole AES element groups */
+  vla = (vl + 15) & ~(size_t)15;
+
+  prepare_rvv_constants();
+
+  if (ctx->key_length > 16)
+    firstk = 32;
+  else
+    firstk = 24;
+
+  inpack16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	   x15, in, ctx->key_table[firstk], t0);
+
+  dec_blk16(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14,
+	    x15, t0, t1, t2, t3, t4, t5, t6, t7, tt0, tt1, tt2, firstk);
+
+  outunpack16(x8, x9, x10, x11, x12, x13, x14, x15, x0, x1, x2, x3, x4, x5,
+	      x6, x7, out, ctx->key_table[0], t0);
+}
@@ -11,8 +11,12 @@
 #include <string.h>
 #include <assert.h>
 #include <time.h>
+#include <sys/uio.h>
 #include "camellia-BSD-1.2.0/camellia.h"
 #include "camellia_simd.h"
+#ifdef USE_DISPATCH
+#include "camellia_simd_lib.h"
+#endif
 
 static const uint8_t test_vector_plaintext[] = {
   0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
@@ -100,6 +104,480 @@ static void Camellia_decrypt(const void *src, void *dst, CAMELLIA_KEY *ctx)
   Camellia_decrypt_nblks(src, dst, 1, ctx);
 }
 
+static void ctr_add(uint8_t *ctr, unsigned int add)
+{
+  int i;
+
+  for (i = 15; i >= 0 && add; i--) {
+    add += ctr[i];
+    ctr[i] = add & 0xff;
+    add >>= 8;
+  }
+}
+
+static void Camellia_ctr_crypt(const void *src, void *dst, size_t nbytes,
+			       uint8_t *ctr, CAMELLIA_KEY *ctx)
+{
+  const uint8_t *in = src;
+  uint8_t *out = dst;
+  uint8_t ks[16];
+  size_t i, n;
+
+  while (nbytes) {
+    n = nbytes < 16 ? nbytes : 16;
+    Camellia_encrypt(ctr, ks, ctx);
+    ctr_add(ctr, 1);
+    for (i = 0; i < n; i++)
+      out[i] = in[i] ^ ks[i];
+    in += n;
+    out += n;
+    nbytes -= n;
+  }
+}
+
+static void Camellia_cbc_encrypt(const void *src, void *dst, size_t nblks,
+				 uint8_t *iv, CAMELLIA_KEY *ctx)
+{
+  const uint8_t *in = src;
+  uint8_t *out = dst;
+  size_t i;
+
+  while (nblks) {
+    for (i = 0; i < 16; i++)
+      out[i] = in[i] ^ iv[i];
+    Camellia_encrypt(out, out, ctx);
+    memcpy(iv, out, 16);
+    in += 16;
+    out += 16;
+    nblks--;
+  }
+}
+
+static void Camellia_cbc_decrypt(const void *src, void *dst, size_t nblks,
+				 uint8_t *iv, CAMELLIA_KEY *ctx)
+{
+  const uint8_t *in = src;
+  uint8_t *out = dst;
+  uint8_t tmp[16];
+  size_t i;
+
+  while (nblks) {
+    Camellia_decrypt(in, tmp, ctx);
+    for (i = 0; i < 16; i++)
+      out[i] = tmp[i] ^ iv[i];
+    memcpy(iv, in, 16);
+    in += 16;
+    out += 16;
+    nblks--;
+  }
+}
+
+static void Camellia_cfb_crypt(const void *src, void *dst, size_t nbytes,
+			       uint8_t *iv, CAMELLIA_KEY *ctx, int decrypt)
+{
+  const uint8_t *in = src;
+  uint8_t *out = dst;
+  uint8_t ks[16];
+  size_t i, n;
+
+  while (nbytes) {
+    n = nbytes < 16 ? nbytes : 16;
+    Camellia_encrypt(iv, ks, ctx);
+    for (i = 0; i < n; i++) {
+      iv[i] = decrypt ? in[i] : in[i] ^ ks[i];
+      out[i] = in[i] ^ ks[i];
+    }
+    in += n;
+    out += n;
+    nbytes -= n;
+  }
+}
+
+static void xts_gfmul_x(uint8_t *tweak)
+{
+  unsigned int carry = tweak[15] >> 7;
+  int i;
+
+  for (i = 15; i > 0; i--)
+    tweak[i] = (tweak[i] << 1) | (tweak[i - 1] >> 7);
+  tweak[0] = (tweak[0] << 1) ^ (carry ? 0x87 : 0);
+}
+
+static void Camellia_xts_crypt_blk(const uint8_t *in, uint8_t *out,
+				   const uint8_t *tweak, CAMELLIA_KEY *ctx,
+				   int decrypt)
+{
+  uint8_t tmp[16];
+  int i;
+
+  for (i = 0; i < 16; i++)
+    tmp[i] = in[i] ^ tweak[i];
+  if (decrypt)
+    Camellia_decrypt(tmp, tmp, ctx);
+  else
+    Camellia_encrypt(tmp, tmp, ctx);
+  for (i = 0; i < 16; i++)
+    out[i] = tmp[i] ^ tweak[i];
+}
+
+static void Camellia_xts_crypt(const void *src, void *dst, size_t nbytes,
+			       uint8_t *tweak, CAMELLIA_KEY *ctx, int decrypt)
+{
+  const uint8_t *in = src;
+  uint8_t *out = dst;
+  uint8_t cc[16], pp[16], tweak_next[16];
+  size_t tail = nbytes % 16;
+  size_t nblks = nbytes / 16 - (tail != 0);
+
+  while (nblks--) {
+    Camellia_xts_crypt_blk(in, out, tweak, ctx, decrypt);
+    xts_gfmul_x(tweak);
+    in += 16;
+    out += 16;
+  }
+
+  if (tail) {
+    memcpy(tweak_next, tweak, 16);
+    xts_gfmul_x(tweak_next);
+    Camellia_xts_crypt_blk(in, cc, decrypt ? tweak_next : tweak, ctx,
+			   decrypt);
+    memcpy(pp, in + 16, tail);
+    memcpy(pp + tail, cc + tail, 16 - tail);
+    memcpy(out + 16, cc, tail);
+    Camellia_xts_crypt_blk(pp, out, decrypt ? tweak : tweak_next, ctx,
+			   decrypt);
+  }
+}
+
+static void ocb_double(uint8_t *b)
+{
+  unsigned int carry = b[0] >> 7;
+  int i;
+
+  for (i = 0; i < 15; i++)
+    b[i] = (b[i] << 1) | (b[i + 1] >> 7);
+  b[15] = (b[15] << 1) ^ (carry ? 0x87 : 0);
+}
+
+/* Offset ^= L_{ntz(i)} */
+static void ocb_offset_next(uint8_t *offset, const uint8_t *l_dollar,
+			    uint64_t i)
+{
+  uint8_t l[16];
+  int k;
+
+  memcpy(l, l_dollar, 16);
+  ocb_double(l);
+  while ((i & 1) == 0) {
+    ocb_double(l);
+    i >>= 1;
+  }
+  for (k = 0; k < 16; k++)
+    offset[k] ^= l[k];
+}
+
+static void Camellia_ocb_crypt(const uint8_t *nonce, size_t noncelen,
+			       const uint8_t *aad, size_t aadlen,
+			       const void *src, void *dst, size_t nbytes,
+			       uint8_t *tag, size_t taglen, CAMELLIA_KEY *ctx,
+			       int decrypt)
+{
+  const uint8_t *in = src;
+  uint8_t *out = dst;
+  uint8_t l_star[16] = { 0 }, l_dollar[16], offset[16], checksum[16] = { 0 };
+  uint8_t sum[16] = { 0 }, ktop[16] = { 0 }, stretch[24], tmp[16];
+  unsigned int bottom;
+  uint64_t i;
+  size_t j, n;
+
+  Camellia_encrypt(l_star, l_star, ctx);
+  memcpy(l_dollar, l_star, 16);
+  ocb_double(l_dollar);
+
+  /* HASH(K, A) */
+  memset(offset, 0, 16);
+  for (i = 1; aadlen > 0; i++) {
+    n = aadlen < 16 ? aadlen : 16;
+    memset(tmp, 0, 16);
+    memcpy(tmp, aad, n);
+    if (n < 16) {
+      tmp[n] = 0x80;
+      for (j = 0; j < 16; j++)
+	offset[j] ^= l_star[j];
+    } else {
+      ocb_offset_next(offset, l_dollar, i);
+    }
+    for (j = 0; j < 16; j++)
+      tmp[j] ^= offset[j];
+    Camellia_encrypt(tmp, tmp, ctx);
+    for (j = 0; j < 16; j++)
+      sum[j] ^= tmp[j];
+    aad += n;
+    aadlen -= n;
+  }
+
+  /* Offset_0 from nonce */
+  memcpy(ktop + 16 - noncelen, nonce, noncelen);
+  ktop[15 - noncelen] |= 1;
+  ktop[0] |= ((taglen * 8) % 128) << 1;
+  bottom = ktop[15] & 63;
+  ktop[15] &= 0xc0;
+  Camellia_encrypt(ktop, ktop, ctx);
+  memcpy(stretch, ktop, 16);
+  for (j = 0; j < 8; j++)
+    stretch[16 + j] = ktop[j] ^ ktop[j + 1];
+  for (j = 0; j < 128; j++) {
+    unsigned int bit = j + bottom;
+    unsigned int val = (stretch[bit / 8] >> (7 - bit % 8)) & 1;
+
+    if (j % 8 == 0)
+      offset[j / 8] = 0;
+    offset[j / 8] |= val << (7 - j % 8);
+  }
+
+  for (i = 1; nbytes > 0; i++) {
+    n = nbytes < 16 ? nbytes : 16;
+    if (n < 16) {
+      for (j = 0; j < 16; j++)
+	offset[j] ^= l_star[j];
+      Camellia_encrypt(offset, tmp, ctx);
+      for (j = 0; j < n; j++) {
+	checksum[j] ^= decrypt ? in[j] ^ tmp[j] : in[j];
+	out[j] = in[j] ^ tmp[j];
+      }
+      checksum[n] ^= 0x80;
+    } else {
+      ocb_offset_next(offset, l_dollar, i);
+      for (j = 0; j < 16; j++) {
+	tmp[j] = in[j] ^ offset[j];
+	if (!decrypt)
+	  checksum[j] ^= in[j];
+      }
+      if (decrypt)
+	Camellia_decrypt(tmp, tmp, ctx);
+      else
+	Camellia_encrypt(tmp, tmp, ctx);
+      for (j = 0; j < 16; j++) {
+	out[j] = tmp[j] ^ offset[j];
+	if (decrypt)
+	  checksum[j] ^= out[j];
+      }
+    }
+    in += n;
+    out += n;
+    nbytes -= n;
+  }
+
+  for (j = 0; j < 16; j++)
+    tmp[j] = checksum[j] ^ offset[j] ^ l_dollar[j];
+  Camellia_encrypt(tmp, tmp, ctx);
+  for (j = 0; j < taglen; j++)
+    tag[j] = tmp[j] ^ sum[j];
+}
+
+/* X = X * H in GF(2^128), bitwise GCM reference multiplication. */
+static void gcm_gfmul(uint8_t *x, const uint8_t *h)
+{
+  uint8_t z[16] = { 0 };
+  uint8_t v[16];
+  unsigned int i, j, lsb;
+
+  memcpy(v, h, 16);
+  for (i = 0; i < 128; i++) {
+    if ((x[i / 8] >> (7 - i % 8)) & 1) {
+      for (j = 0; j < 16; j++)
+	z[j] ^= v[j];
+    }
+    lsb = v[15] & 1;
+    for (j = 15; j > 0; j--)
+      v[j] = (v[j] >> 1) | (v[j - 1] << 7);
+    v[0] = (v[0] >> 1) ^ (lsb ? 0xe1 : 0);
+  }
+  memcpy(x, z, 16);
+}
+
+/* Hash NBYTES from IN, last partial block zero padded. */
+static void gcm_ghash_ref(uint8_t *hash, const uint8_t *h, const uint8_t *in,
+			  size_t nbytes)
+{
+  size_t n, j;
+
+  while (nbytes > 0) {
+    n = nbytes < 16 ? nbytes : 16;
+    for (j = 0; j < n; j++)
+      hash[j] ^= in[j];
+    gcm_gfmul(hash, h);
+    in += n;
+    nbytes -= n;
+  }
+}
+
+static void gcm_put_lens(uint8_t *lens, uint64_t alen, uint64_t clen)
+{
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    lens[7 - i] = (alen * 8) >> (i * 8);
+    lens[15 - i] = (clen * 8) >> (i * 8);
+  }
+}
+
+/* Compute pre-counter block J0 from IV. */
+static void gcm_j0_ref(const uint8_t *iv, size_t ivlen, uint8_t *j0,
+		       CAMELLIA_KEY *ctx)
+{
+  uint8_t h[16] = { 0 };
+  uint8_t lens[16];
+
+  if (ivlen == 12) {
+    memcpy(j0, iv, 12);
+    memset(j0 + 12, 0, 4);
+    j0[15] = 1;
+    return;
+  }
+
+  Camellia_encrypt(h, h, ctx);
+  memset(j0, 0, 16);
+  gcm_ghash_ref(j0, h, iv, ivlen);
+  gcm_put_lens(lens, 0, ivlen);
+  gcm_ghash_ref(j0, h, lens, 16);
+}
+
+static void Camellia_gcm_crypt(const uint8_t *j0, const uint8_t *aad,
+			       size_t aadlen, const void *src, void *dst,
+			       size_t nbytes, uint8_t *tag, CAMELLIA_KEY *ctx,
+			       int decrypt)
+{
+  const uint8_t *in = src;
+  uint8_t *out = dst;
+  uint8_t h[16] = { 0 };
+  uint8_t hash[16] = { 0 };
+  uint8_t ctr[16];
+  uint8_t tmp[16];
+  uint32_t lo;
+  size_t n, j, k;
+
+  Camellia_encrypt(h, h, ctx);
+  gcm_ghash_ref(hash, h, aad, aadlen);
+  if (decrypt)
+    gcm_ghash_ref(hash, h, in, nbytes);
+
+  memcpy(ctr, j0, 16);
+  for (j = 0; j < nbytes; j += n) {
+    n = nbytes - j < 16 ? nbytes - j : 16;
+    lo = ((uint32_t)ctr[12] << 24) | ((uint32_t)ctr[13] << 16) |
+	 ((uint32_t)ctr[14] << 8) | ctr[15];
+    lo++;
+    ctr[12] = lo >> 24;
+    ctr[13] = lo >> 16;
+    ctr[14] = lo >> 8;
+    ctr[15] = lo;
+    Camellia_encrypt(ctr, tmp, ctx);
+    for (k = 0; k < n; k++)
+      out[j + k] = in[j + k] ^ tmp[k];
+  }
+
+  if (!decrypt)
+    gcm_ghash_ref(hash, h, out, nbytes);
+  gcm_put_lens(tmp, aadlen, nbytes);
+  gcm_ghash_ref(hash, h, tmp, 16);
+
+  Camellia_encrypt(j0, tag, ctx);
+  for (j = 0; j < 16; j++)
+    tag[j] ^= hash[j];
+}
+
+/* CCM reference: CBC-MAC over B_0 || l(a) || a || m, CTR with A_i. */
+static void Camellia_ccm_crypt(const uint8_t *nonce, size_t noncelen,
+			       const uint8_t *aad, size_t aadlen,
+			       const void *src, void *dst, size_t nbytes,
+			       uint8_t *tag, size_t taglen, CAMELLIA_KEY *ctx,
+			       int decrypt)
+{
+  const uint8_t *in = src;
+  uint8_t *out = dst;
+  const uint8_t *pt = decrypt ? out : in;
+  size_t L = 15 - noncelen;
+  uint8_t mac[16] = { 0 };
+  uint8_t a0[16] = { 0 };
+  uint8_t ctr[16];
+  uint8_t s[16];
+  size_t i, j, pos;
+
+  a0[0] = L - 1;
+  memcpy(a0 + 1, nonce, noncelen);
+
+  /* CBC-MAC is over plaintext, decrypt payload first */
+  memcpy(ctr, a0, 16);
+  ctr_add(ctr, 1);
+  if (decrypt)
+    Camellia_ctr_crypt(in, out, nbytes, ctr, ctx);
+
+  mac[0] = (aadlen ? 0x40 : 0) | (((taglen - 2) / 2) << 3) | (L - 1);
+  memcpy(mac + 1, nonce, noncelen);
+  for (i = 0; i < L && i < sizeof(size_t); i++)
+    mac[15 - i] = nbytes >> (i * 8);
+  Camellia_encrypt(mac, mac, ctx);
+
+  if (aadlen) {
+    /* only short length encoding (aadlen < 0xff00) needed here */
+    uint8_t hdr[2] = { aadlen >> 8, aadlen & 0xff };
+
+    for (pos = 0; pos < aadlen + 2; pos += 16) {
+      for (j = 0; j < 16; j++) {
+	if (pos + j < 2)
+	  mac[j] ^= hdr[pos + j];
+	else if (pos + j - 2 < aadlen)
+	  mac[j] ^= aad[pos + j - 2];
+      }
+      Camellia_encrypt(mac, mac, ctx);
+    }
+  }
+
+  for (pos = 0; pos < nbytes; pos += 16) {
+    for (j = 0; j < 16 && pos + j < nbytes; j++)
+      mac[j] ^= pt[pos + j];
+    Camellia_encrypt(mac, mac, ctx);
+  }
+
+  if (!decrypt)
+    Camellia_ctr_crypt(in, out, nbytes, ctr, ctx);
+
+  Camellia_encrypt(a0, s, ctx);
+  for (j = 0; j < taglen; j++)
+    tag[j] = mac[j] ^ s[j];
+}
+
+/* CMAC reference (RFC 4493 with Camellia). */
+static void Camellia_cmac(const void *src, size_t nbytes, uint8_t *mac,
+			  CAMELLIA_KEY *ctx)
+{
+  const uint8_t *in = src;
+  uint8_t k[16] = { 0 };
+  size_t pos, j;
+
+  Camellia_encrypt(k, k, ctx);
+  ocb_double(k);
+
+  memset(mac, 0, 16);
+  for (pos = 0; pos + 16 < nbytes; pos += 16) {
+    for (j = 0; j < 16; j++)
+      mac[j] ^= in[pos + j];
+    Camellia_encrypt(mac, mac, ctx);
+  }
+
+  /* last block: complete with K1, or padded with K2 */
+  if (nbytes - pos != 16) {
+    ocb_double(k);
+    mac[nbytes - pos] ^= 0x80;
+  }
+  for (j = 0; pos + j < nbytes; j++)
+    mac[j] ^= in[pos + j];
+  for (j = 0; j < 16; j++)
+    mac[j] ^= k[j];
+  Camellia_encrypt(mac, mac, ctx);
+}
+
 static void fill_blks(uint8_t *fill, const uint8_t *blk, unsigned int nblks)
 {
   while (nblks) {
@@ -130,12 +608,15 @@ static void do_selftest(void)
   struct camellia_simd_ctx ctx_simd;
   CAMELLIA_KEY ctx_ref = { 0 };
   uint8_t key[32];
-  uint8_t tmp[32 * 16];
-  uint8_t plaintext_simd[32 * 16];
+  uint8_t tmp[64 * 16];
+  uint8_t plaintext_simd[64 * 16];
   uint8_t ref_large_plaintext[32 * 16];
   uint8_t ref_large_ciphertext_128[32 * 16];
   uint8_t ref_large_ciphertext_256[32 * 16];
   unsigned int i, j;
+#if defined(USE_SVE2) || defined(USE_RVV)
+  unsigned int n;
+#endif
 
   /* Check test vectors against reference implementation. */
   printf("selftest: comparing camellia-%d test vectors against reference implementation...\n", 128);
@@ -226,6 +707,34 @@ static void do_selftest(void)
   camellia_decrypt_16blks_simd128(&ctx_simd, tmp, tmp);
   assert(memcmp(tmp, plaintext_simd, 16 * 16) == 0);
 
+  /* Check interleaved 32-block SIMD128 implementation against known test
+   * vectors. */
+  if (have_camellia_32blks_simd128()) {
+    printf("selftest: checking 32-block parallel camellia-128/SIMD128 against test vectors...\n");
+    fill_blks(plaintext_simd, test_vector_plaintext, 32);
+    memset(tmp, 0xaa, sizeof(tmp));
+    memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+    camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+    camellia_encrypt_32blks_simd128(&ctx_simd, tmp, plaintext_simd);
+    for (i = 0; i < 32; i++) {
+      assert(memcmp(&tmp[i * 16], test_vector_ciphertext_128, 16) == 0);
+    }
+    camellia_decrypt_32blks_simd128(&ctx_simd, tmp, tmp);
+    assert(memcmp(tmp, plaintext_simd, 32 * 16) == 0);
+
+    printf("selftest: checking 32-block parallel camellia-256/SIMD128 against test vectors...\n");
+    fill_blks(plaintext_simd, test_vector_plaintext, 32);
+    memset(tmp, 0xaa, sizeof(tmp));
+    memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+    camellia_keysetup_simd128(&ctx_simd, test_vector_key_256, 256 / 8);
+    camellia_encrypt_32blks_simd128(&ctx_simd, tmp, plaintext_simd);
+    for (i = 0; i < 32; i++) {
+      assert(memcmp(&tmp[i * 16], test_vector_ciphertext_256, 16) == 0);
+    }
+    camellia_decrypt_32blks_simd128(&ctx_simd, tmp, tmp);
+    assert(memcmp(tmp, plaintext_simd, 32 * 16) == 0);
+  }
+
 #ifdef USE_SIMD256
   /* Check 32-block SIMD256 implementation against known test vectors. */
   printf("selftest: checking 32-block parallel camellia-128/SIMD256 against test vectors...\n");
@@ -267,6 +776,133 @@ static void do_selftest(void)
   assert(memcmp(tmp, plaintext_simd, 32 * 16) == 0);
 #endif
 
+#ifdef USE_SIMD512
+  /* Check 64-block SIMD512 implementation against known test vectors. */
+  printf("selftest: checking 64-block parallel camellia-128/SIMD512 against test vectors...\n");
+  fill_blks(plaintext_simd, test_vector_plaintext, 64);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+  camellia_encrypt_64blks_simd512(&ctx_simd, tmp, plaintext_simd);
+  for (i = 0; i < 64; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_128, 16) == 0);
+  }
+  camellia_decrypt_64blks_simd512(&ctx_simd, tmp, tmp);
+  assert(memcmp(tmp, plaintext_simd, 64 * 16) == 0);
+
+  printf("selftest: checking 64-block parallel camellia-192/SIMD512 against test vectors...\n");
+  fill_blks(plaintext_simd, test_vector_plaintext, 64);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_192, 192 / 8);
+  camellia_encrypt_64blks_simd512(&ctx_simd, tmp, plaintext_simd);
+  for (i = 0; i < 64; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_192, 16) == 0);
+  }
+  camellia_decrypt_64blks_simd512(&ctx_simd, tmp, tmp);
+  assert(memcmp(tmp, plaintext_simd, 64 * 16) == 0);
+
+  printf("selftest: checking 64-block parallel camellia-256/SIMD512 against test vectors...\n");
+  fill_blks(plaintext_simd, test_vector_plaintext, 64);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_256, 256 / 8);
+  camellia_encrypt_64blks_simd512(&ctx_simd, tmp, plaintext_simd);
+  for (i = 0; i < 64; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_256, 16) == 0);
+  }
+  camellia_decrypt_64blks_simd512(&ctx_simd, tmp, tmp);
+  assert(memcmp(tmp, plaintext_simd, 64 * 16) == 0);
+#endif
+
+#ifdef USE_SVE2
+  /* Check vector-length agnostic SVE2 implementation against known test
+   * vectors. Block count follows the vector length, capped to the test
+   * buffer size. */
+  n = camellia_sve2_parallel_blks();
+  if (n > 64)
+    n = 64;
+  printf("selftest: checking %u-block parallel camellia-128/SVE2 against test vectors...\n", n);
+  fill_blks(plaintext_simd, test_vector_plaintext, n);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+  camellia_encrypt_nblks_sve2(&ctx_simd, tmp, plaintext_simd, n);
+  for (i = 0; i < n; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_128, 16) == 0);
+  }
+  camellia_decrypt_nblks_sve2(&ctx_simd, tmp, tmp, n);
+  assert(memcmp(tmp, plaintext_simd, n * 16) == 0);
+
+  printf("selftest: checking %u-block parallel camellia-192/SVE2 against test vectors...\n", n);
+  fill_blks(plaintext_simd, test_vector_plaintext, n);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_192, 192 / 8);
+  camellia_encrypt_nblks_sve2(&ctx_simd, tmp, plaintext_simd, n);
+  for (i = 0; i < n; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_192, 16) == 0);
+  }
+  camellia_decrypt_nblks_sve2(&ctx_simd, tmp, tmp, n);
+  assert(memcmp(tmp, plaintext_simd, n * 16) == 0);
+
+  printf("selftest: checking %u-block parallel camellia-256/SVE2 against test vectors...\n", n);
+  fill_blks(plaintext_simd, test_vector_plaintext, n);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_256, 256 / 8);
+  camellia_encrypt_nblks_sve2(&ctx_simd, tmp, plaintext_simd, n);
+  for (i = 0; i < n; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_256, 16) == 0);
+  }
+  camellia_decrypt_nblks_sve2(&ctx_simd, tmp, tmp, n);
+  assert(memcmp(tmp, plaintext_simd, n * 16) == 0);
+#endif
+
+#ifdef USE_RVV
+  /* Check VLEN agnostic RVV implementation against known test
+   * vectors. Block count follows the vector length, capped to the test
+   * buffer size. */
+  n = camellia_rvv_parallel_blks();
+  if (n > 64)
+    n = 64;
+  printf("selftest: checking %u-block parallel camellia-128/RVV against test vectors...\n", n);
+  fill_blks(plaintext_simd, test_vector_plaintext, n);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+  camellia_encrypt_nblks_rvv(&ctx_simd, tmp, plaintext_simd, n);
+  for (i = 0; i < n; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_128, 16) == 0);
+  }
+  camellia_decrypt_nblks_rvv(&ctx_simd, tmp, tmp, n);
+  assert(memcmp(tmp, plaintext_simd, n * 16) == 0);
+
+  printf("selftest: checking %u-block parallel camellia-192/RVV against test vectors...\n", n);
+  fill_blks(plaintext_simd, test_vector_plaintext, n);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_192, 192 / 8);
+  camellia_encrypt_nblks_rvv(&ctx_simd, tmp, plaintext_simd, n);
+  for (i = 0; i < n; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_192, 16) == 0);
+  }
+  camellia_decrypt_nblks_rvv(&ctx_simd, tmp, tmp, n);
+  assert(memcmp(tmp, plaintext_simd, n * 16) == 0);
+
+  printf("selftest: checking %u-block parallel camellia-256/RVV against test vectors...\n", n);
+  fill_blks(plaintext_simd, test_vector_plaintext, n);
+  memset(tmp, 0xaa, sizeof(tmp));
+  memset(&ctx_simd, 0xff, sizeof(ctx_simd));
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_256, 256 / 8);
+  camellia_encrypt_nblks_rvv(&ctx_simd, tmp, plaintext_simd, n);
+  for (i = 0; i < n; i++) {
+    assert(memcmp(&tmp[i * 16], test_vector_ciphertext_256, 16) == 0);
+  }
+  camellia_decrypt_nblks_rvv(&ctx_simd, tmp, tmp, n);
+  assert(memcmp(tmp, plaintext_simd, n * 16) == 0);
+#endif
+
   /* Generate large test vectors. */
   for (i = 0; i < sizeof(key); i++)
     key[i] = ((i + 1231) * 3221) & 0xff;
@@ -306,6 +942,39 @@ static void do_selftest(void)
     assert(memcmp(tmp, ref_large_plaintext, 16 * 16) == 0);
   }
 
+  /* Test 2-block SIMD128 implementation against large test vectors. */
+  printf("selftest: checking 2-block interleaved camellia-128/SIMD128 against large test vectors...\n");
+  camellia_keysetup_simd128(&ctx_simd, key, 128 / 8);
+  memcpy(tmp, ref_large_plaintext, 16 * 16);
+  for (i = 0; i < (1 << 16); i++) {
+    camellia_encrypt_2blks_simd128(&ctx_simd, &tmp[0 * 16], &tmp[0 * 16]);
+    camellia_encrypt_2blks_simd128(&ctx_simd, &tmp[2 * 16], &tmp[2 * 16]);
+    for (j = 4; j < 16; j += 2)
+      camellia_encrypt_2blks_simd128(&ctx_simd, &tmp[j * 16], &tmp[j * 16]);
+  }
+  assert(memcmp(tmp, ref_large_ciphertext_128, 16 * 16) == 0);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 16; j += 2)
+      camellia_decrypt_2blks_simd128(&ctx_simd, &tmp[j * 16], &tmp[j * 16]);
+  }
+  assert(memcmp(tmp, ref_large_plaintext, 16 * 16) == 0);
+
+  printf("selftest: checking 2-block interleaved camellia-256/SIMD128 against large test vectors...\n");
+  camellia_keysetup_simd128(&ctx_simd, key, 256 / 8);
+  memcpy(tmp, ref_large_plaintext, 16 * 16);
+  for (i = 0; i < (1 << 16); i++) {
+    camellia_encrypt_2blks_simd128(&ctx_simd, &tmp[0 * 16], &tmp[0 * 16]);
+    camellia_encrypt_2blks_simd128(&ctx_simd, &tmp[2 * 16], &tmp[2 * 16]);
+    for (j = 4; j < 16; j += 2)
+      camellia_encrypt_2blks_simd128(&ctx_simd, &tmp[j * 16], &tmp[j * 16]);
+  }
+  assert(memcmp(tmp, ref_large_ciphertext_256, 16 * 16) == 0);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 16; j += 2)
+      camellia_decrypt_2blks_simd128(&ctx_simd, &tmp[j * 16], &tmp[j * 16]);
+  }
+  assert(memcmp(tmp, ref_large_plaintext, 16 * 16) == 0);
+
   /* Test 16-block SIMD128 implementation against large test vectors. */
   printf("selftest: checking 16-block parallel camellia-128/SIMD128 against large test vectors...\n");
   camellia_keysetup_simd128(&ctx_simd, key, 128 / 8);
@@ -331,6 +1000,34 @@ static void do_selftest(void)
   }
   assert(memcmp(tmp, ref_large_plaintext, 16 * 16) == 0);
 
+  /* Test interleaved 32-block SIMD128 implementation against large test
+   * vectors. */
+  if (have_camellia_32blks_simd128()) {
+    printf("selftest: checking 32-block parallel camellia-128/SIMD128 against large test vectors...\n");
+    camellia_keysetup_simd128(&ctx_simd, key, 128 / 8);
+    memcpy(tmp, ref_large_plaintext, 32 * 16);
+    for (i = 0; i < (1 << 16); i++) {
+      camellia_encrypt_32blks_simd128(&ctx_simd, tmp, tmp);
+    }
+    assert(memcmp(tmp, ref_large_ciphertext_128, 32 * 16) == 0);
+    for (i = 0; i < (1 << 16); i++) {
+      camellia_decrypt_32blks_simd128(&ctx_simd, tmp, tmp);
+    }
+    assert(memcmp(tmp, ref_large_plaintext, 32 * 16) == 0);
+
+    printf("selftest: checking 32-block parallel camellia-256/SIMD128 against large test vectors...\n");
+    camellia_keysetup_simd128(&ctx_simd, key, 256 / 8);
+    memcpy(tmp, ref_large_plaintext, 32 * 16);
+    for (i = 0; i < (1 << 16); i++) {
+      camellia_encrypt_32blks_simd128(&ctx_simd, tmp, tmp);
+    }
+    assert(memcmp(tmp, ref_large_ciphertext_256, 32 * 16) == 0);
+    for (i = 0; i < (1 << 16); i++) {
+      camellia_decrypt_32blks_simd128(&ctx_simd, tmp, tmp);
+    }
+    assert(memcmp(tmp, ref_large_plaintext, 32 * 16) == 0);
+  }
+
 #ifdef USE_SIMD256
   /* Test 32-block SIMD256 implementation against large test vectors. */
   printf("selftest: checking 32-block parallel camellia-128/SIMD256 against large test vectors...\n");
@@ -357,37 +1054,872 @@ static void do_selftest(void)
   }
   assert(memcmp(tmp, ref_large_plaintext, 32 * 16) == 0);
 #endif
-}
-
-static uint64_t curr_clock_nsecs(void)
-{
-  struct timespec ts;
-
-  clock_gettime(CLOCK_MONOTONIC, &ts);
 
-  return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
-}
+#ifdef USE_SIMD512
+  /* Test 64-block SIMD512 implementation against large test vectors. */
+  printf("selftest: checking 64-block parallel camellia-128/SIMD512 against large test vectors...\n");
+  camellia_keysetup_simd128(&ctx_simd, key, 128 / 8);
+  memcpy(&tmp[0 * 16], ref_large_plaintext, 32 * 16);
+  memcpy(&tmp[32 * 16], ref_large_plaintext, 32 * 16);
+  for (i = 0; i < (1 << 16); i++) {
+    camellia_encrypt_64blks_simd512(&ctx_simd, tmp, tmp);
+  }
+  assert(memcmp(&tmp[0 * 16], ref_large_ciphertext_128, 32 * 16) == 0);
+  assert(memcmp(&tmp[32 * 16], ref_large_ciphertext_128, 32 * 16) == 0);
+  for (i = 0; i < (1 << 16); i++) {
+    camellia_decrypt_64blks_simd512(&ctx_simd, tmp, tmp);
+  }
+  assert(memcmp(&tmp[0 * 16], ref_large_plaintext, 32 * 16) == 0);
+  assert(memcmp(&tmp[32 * 16], ref_large_plaintext, 32 * 16) == 0);
 
-static bool unaligned_mode;
+  printf("selftest: checking 64-block parallel camellia-256/SIMD512 against large test vectors...\n");
+  camellia_keysetup_simd128(&ctx_simd, key, 256 / 8);
+  memcpy(&tmp[0 * 16], ref_large_plaintext, 32 * 16);
+  memcpy(&tmp[32 * 16], ref_large_plaintext, 32 * 16);
+  for (i = 0; i < (1 << 16); i++) {
+    camellia_encrypt_64blks_simd512(&ctx_simd, tmp, tmp);
+  }
+  assert(memcmp(&tmp[0 * 16], ref_large_ciphertext_256, 32 * 16) == 0);
+  assert(memcmp(&tmp[32 * 16], ref_large_ciphertext_256, 32 * 16) == 0);
+  for (i = 0; i < (1 << 16); i++) {
+    camellia_decrypt_64blks_simd512(&ctx_simd, tmp, tmp);
+  }
+  assert(memcmp(&tmp[0 * 16], ref_large_plaintext, 32 * 16) == 0);
+  assert(memcmp(&tmp[32 * 16], ref_large_plaintext, 32 * 16) == 0);
+#endif
 
-static void print_result(const char *variant, uint64_t num_bytes,
-			 uint64_t elapsed_nsecs)
-{
-  char mode_variant[128];
-  double mebi_per_sec, mega_per_sec;
+#ifdef USE_SVE2
+  /* Test SVE2 implementation against large test vectors. With vector lengths
+   * below 512 bits the 32 blocks take several calls; with other than
+   * power-of-two lengths the last call is a partial batch. */
+  printf("selftest: checking %u-block parallel camellia-128/SVE2 against large test vectors...\n", n);
+  camellia_keysetup_simd128(&ctx_simd, key, 128 / 8);
+  memcpy(tmp, ref_large_plaintext, 32 * 16);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 32; j += n) {
+      camellia_encrypt_nblks_sve2(&ctx_simd, &tmp[j * 16], &tmp[j * 16],
+				  32 - j < n ? 32 - j : n);
+    }
+  }
+  assert(memcmp(tmp, ref_large_ciphertext_128, 32 * 16) == 0);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 32; j += n) {
+      camellia_decrypt_nblks_sve2(&ctx_simd, &tmp[j * 16], &tmp[j * 16],
+				  32 - j < n ? 32 - j : n);
+    }
+  }
+  assert(memcmp(tmp, ref_large_plaintext, 32 * 16) == 0);
 
-  if (unaligned_mode) {
-    snprintf(mode_variant, sizeof(mode_variant), "unaligned %44s", variant);
-  } else {
-    snprintf(mode_variant, sizeof(mode_variant), "%44s", variant);
+  printf("selftest: checking %u-block parallel camellia-256/SVE2 against large test vectors...\n", n);
+  camellia_keysetup_simd128(&ctx_simd, key, 256 / 8);
+  memcpy(tmp, ref_large_plaintext, 32 * 16);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 32; j += n) {
+      camellia_encrypt_nblks_sve2(&ctx_simd, &tmp[j * 16], &tmp[j * 16],
+				  32 - j < n ? 32 - j : n);
+    }
+  }
+  assert(memcmp(tmp, ref_large_ciphertext_256, 32 * 16) == 0);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 32; j += n) {
+      camellia_decrypt_nblks_sve2(&ctx_simd, &tmp[j * 16], &tmp[j * 16],
+				  32 - j < n ? 32 - j : n);
+    }
   }
+  assert(memcmp(tmp, ref_large_plaintext, 32 * 16) == 0);
+#endif
 
-  mebi_per_sec = num_bytes * 1e9 / (1024.0 * 1024 * elapsed_nsecs);
-  mega_per_sec = num_bytes * 1e9 / (1e6 * elapsed_nsecs);
-  printf("%s: %10.3f Mebibytes/s, %10.3f Megabytes/s\n",
-	 mode_variant, mebi_per_sec, mega_per_sec);
-  fflush(stdout);
-}
+#ifdef USE_RVV
+  /* Test RVV implementation against large test vectors. With VLEN below
+   * 512 bits the 32 blocks take several calls. */
+  printf("selftest: checking %u-block parallel camellia-128/RVV against large test vectors...\n", n);
+  camellia_keysetup_simd128(&ctx_simd, key, 128 / 8);
+  memcpy(tmp, ref_large_plaintext, 32 * 16);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 32; j += n) {
+      camellia_encrypt_nblks_rvv(&ctx_simd, &tmp[j * 16], &tmp[j * 16],
+				  32 - j < n ? 32 - j : n);
+    }
+  }
+  assert(memcmp(tmp, ref_large_ciphertext_128, 32 * 16) == 0);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 32; j += n) {
+      camellia_decrypt_nblks_rvv(&ctx_simd, &tmp[j * 16], &tmp[j * 16],
+				  32 - j < n ? 32 - j : n);
+    }
+  }
+  assert(memcmp(tmp, ref_large_plaintext, 32 * 16) == 0);
+
+  printf("selftest: checking %u-block parallel camellia-256/RVV against large test vectors...\n", n);
+  camellia_keysetup_simd128(&ctx_simd, key, 256 / 8);
+  memcpy(tmp, ref_large_plaintext, 32 * 16);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 32; j += n) {
+      camellia_encrypt_nblks_rvv(&ctx_simd, &tmp[j * 16], &tmp[j * 16],
+				  32 - j < n ? 32 - j : n);
+    }
+  }
+  assert(memcmp(tmp, ref_large_ciphertext_256, 32 * 16) == 0);
+  for (i = 0; i < (1 << 16); i++) {
+    for (j = 0; j < 32; j += n) {
+      camellia_decrypt_nblks_rvv(&ctx_simd, &tmp[j * 16], &tmp[j * 16],
+				  32 - j < n ? 32 - j : n);
+    }
+  }
+  assert(memcmp(tmp, ref_large_plaintext, 32 * 16) == 0);
+#endif
+}
+
+static void do_selftest_modes(void)
+{
+  static const size_t lengths[] = {
+    1, 15, 16, 17, 3 * 16, 5 * 16 + 7, 16 * 16, 17 * 16 + 3, 32 * 16,
+    48 * 16, 64 * 16 + 9, 100 * 16 + 1
+  };
+  static const size_t cbc_nblks[] = {
+    1, 3, 4, 15, 16, 17, 31, 32, 33, 48, 65, 100
+  };
+  static const uint8_t ctr_lows[][8] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xe5 },
+    { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 },
+    { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }
+  };
+  struct camellia_simd_ctx ctx_simd;
+  struct camellia_ocb_ctx ocb;
+  struct camellia_gcm_ctx gcm;
+  CAMELLIA_KEY ctx_ref = { 0 };
+  uint8_t key[32];
+  uint8_t plaintext[128 * 16];
+  uint8_t expected[128 * 16];
+  uint8_t tmp[128 * 16];
+  uint8_t ctr_start[16], ctr_ref[16], ctr_simd[16];
+  unsigned int i, j, k, keylen;
+
+  for (i = 0; i < sizeof(key); i++)
+    key[i] = ((i + 1231) * 3221) & 0xff;
+  for (i = 0; i < sizeof(plaintext); i++)
+    plaintext[i] = ((i + 3221) * 1231) & 0xff;
+
+  for (keylen = 16; keylen <= 32; keylen += 16) {
+    Camellia_set_key(key, keylen * 8, &ctx_ref);
+    camellia_keysetup_simd128(&ctx_simd, key, keylen);
+
+#ifdef USE_SIMD256
+    /* Check masked partial-batch SIMD256 kernels against reference. */
+    printf("selftest: checking 1..32-block masked camellia-%d/SIMD256 against reference implementation...\n",
+	   keylen * 8);
+    for (j = 1; j <= 32; j++) {
+      size_t nbytes = j * 16;
+
+      Camellia_encrypt_nblks(plaintext, expected, j, &ctx_ref);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_encrypt_nblks_simd256_masked(&ctx_simd, tmp, plaintext, j);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+
+      /* in-place decryption */
+      camellia_decrypt_nblks_simd256_masked(&ctx_simd, tmp, tmp, j);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+    }
+
+    /* Check gather/scatter SIMD256 kernels with permuted, unaligned block
+     * pointers. */
+    printf("selftest: checking gather/scatter camellia-%d/SIMD256 against reference implementation...\n",
+	   keylen * 8);
+    {
+      const void *inp[32];
+      void *outp[32];
+
+      for (j = 0; j < 32; j++) {
+	inp[j] = plaintext + 3 + 16 * ((j * 7) % 32);
+	outp[j] = tmp + 16 * (31 - j);
+	Camellia_encrypt_nblks(inp[j], expected + 16 * j, 1, &ctx_ref);
+      }
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_encrypt_32blks_simd256_ptrs(&ctx_simd, outp, inp);
+      for (j = 0; j < 32; j++)
+	assert(memcmp(outp[j], expected + 16 * j, 16) == 0);
+      assert(tmp[32 * 16] == 0xaa);
+
+      /* in-place decryption */
+      camellia_decrypt_32blks_simd256_ptrs(&ctx_simd, outp,
+					   (const void *const *)outp);
+      for (j = 0; j < 32; j++)
+	assert(memcmp(outp[j], inp[j], 16) == 0);
+    }
+
+#endif
+#ifdef USE_SVE2
+    /* Check predicated partial-batch SVE2 kernel against reference. */
+    printf("selftest: checking 1..%u-block predicated camellia-%d/SVE2 against reference implementation...\n",
+	   camellia_sve2_parallel_blks(), keylen * 8);
+    for (j = 1; j <= camellia_sve2_parallel_blks() && j < 128; j++) {
+      size_t nbytes = j * 16;
+
+      Camellia_encrypt_nblks(plaintext, expected, j, &ctx_ref);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_encrypt_nblks_sve2(&ctx_simd, tmp, plaintext, j);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+
+      /* in-place decryption */
+      camellia_decrypt_nblks_sve2(&ctx_simd, tmp, tmp, j);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+    }
+
+#endif
+
+#ifdef USE_RVV
+    /* Check partial-batch RVV kernel against reference. */
+    printf("selftest: checking 1..%u-block camellia-%d/RVV against reference implementation...\n",
+	   camellia_rvv_parallel_blks(), keylen * 8);
+    for (j = 1; j <= camellia_rvv_parallel_blks() && j < 128; j++) {
+      size_t nbytes = j * 16;
+
+      Camellia_encrypt_nblks(plaintext, expected, j, &ctx_ref);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_encrypt_nblks_rvv(&ctx_simd, tmp, plaintext, j);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+
+      /* in-place decryption */
+      camellia_decrypt_nblks_rvv(&ctx_simd, tmp, tmp, j);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+    }
+
+#endif
+    /* Check ECB bulk functions against reference implementation. */
+    printf("selftest: checking ECB mode camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    for (j = 0; j < sizeof(cbc_nblks) / sizeof(cbc_nblks[0]); j++) {
+      size_t nbytes = cbc_nblks[j] * 16;
+
+      Camellia_encrypt_nblks(plaintext, expected, cbc_nblks[j], &ctx_ref);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_ecb_encrypt(&ctx_simd, tmp, plaintext, cbc_nblks[j]);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+
+      /* in-place decryption */
+      camellia_ecb_decrypt(&ctx_simd, tmp, tmp, cbc_nblks[j]);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+    }
+
+    /* Check CTR mode against reference implementation. */
+    printf("selftest: checking CTR mode camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    for (i = 0; i < sizeof(ctr_lows) / sizeof(ctr_lows[0]); i++) {
+      for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+	for (k = 0; k < 8; k++)
+	  ctr_start[k] = 0xf0 + k;
+	memcpy(&ctr_start[8], ctr_lows[i], 8);
+	memcpy(ctr_ref, ctr_start, 16);
+	memcpy(ctr_simd, ctr_start, 16);
+	Camellia_ctr_crypt(plaintext, expected, lengths[j], ctr_ref, &ctx_ref);
+
+	memset(tmp, 0xaa, sizeof(tmp));
+	camellia_ctr_crypt(&ctx_simd, tmp, plaintext, lengths[j], ctr_simd);
+	assert(memcmp(tmp, expected, lengths[j]) == 0);
+	assert(tmp[lengths[j]] == 0xaa);
+	assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+
+	/* in-place */
+	memcpy(tmp, plaintext, lengths[j]);
+	memcpy(ctr_simd, ctr_start, 16);
+	camellia_ctr_crypt(&ctx_simd, tmp, tmp, lengths[j], ctr_simd);
+	assert(memcmp(tmp, expected, lengths[j]) == 0);
+      }
+    }
+
+    /* Check CBC decryption against reference implementation. */
+    printf("selftest: checking CBC decryption camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    for (j = 0; j < sizeof(cbc_nblks) / sizeof(cbc_nblks[0]); j++) {
+      size_t nbytes = cbc_nblks[j] * 16;
+
+      for (k = 0; k < 16; k++)
+	ctr_start[k] = 0xf0 + k;
+      memcpy(ctr_ref, ctr_start, 16);
+      memcpy(ctr_simd, ctr_start, 16);
+      Camellia_cbc_decrypt(plaintext, expected, cbc_nblks[j], ctr_ref,
+			   &ctx_ref);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_cbc_decrypt(&ctx_simd, tmp, plaintext, cbc_nblks[j], ctr_simd);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+      assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+
+      /* in-place, split in two calls to check IV chaining */
+      memcpy(tmp, plaintext, nbytes);
+      memcpy(ctr_simd, ctr_start, 16);
+      camellia_cbc_decrypt(&ctx_simd, tmp, tmp, cbc_nblks[j] / 2, ctr_simd);
+      camellia_cbc_decrypt(&ctx_simd, tmp + (cbc_nblks[j] / 2) * 16,
+			   tmp + (cbc_nblks[j] / 2) * 16,
+			   cbc_nblks[j] - cbc_nblks[j] / 2, ctr_simd);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+    }
+
+    /* Multi-stream CBC encryption, more streams than parallel lanes and
+     * lengths varying so that lanes get refilled at different steps. */
+    printf("selftest: checking multi-stream CBC encryption camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    {
+      struct camellia_cbc_job jobs[50];
+      uint8_t ivs[50][16];
+      uint8_t expected_ivs[50][16];
+      size_t pos = 0;
+
+      for (j = 0; j < 50; j++) {
+	for (k = 0; k < 16; k++)
+	  ivs[j][k] = expected_ivs[j][k] = j * 16 + k;
+	jobs[j].in = plaintext + pos;
+	jobs[j].out = tmp + pos;
+	jobs[j].nblks = (j * 7) % 5 == 0 ? (j * 3) % 11 : j % 4;
+	jobs[j].iv = ivs[j];
+	Camellia_cbc_encrypt(plaintext + pos, expected + pos, jobs[j].nblks,
+			     expected_ivs[j], &ctx_ref);
+	pos += jobs[j].nblks * 16;
+      }
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_cbc_encrypt_multi(&ctx_simd, jobs, 50);
+      assert(memcmp(tmp, expected, pos) == 0);
+      assert(tmp[pos] == 0xaa);
+      for (j = 0; j < 50; j++)
+	assert(memcmp(ivs[j], expected_ivs[j], 16) == 0);
+
+      /* single stream, in-place */
+      memcpy(tmp, plaintext, 37 * 16);
+      memcpy(ctr_simd, ctr_start, 16);
+      memcpy(ctr_ref, ctr_start, 16);
+      camellia_cbc_encrypt(&ctx_simd, tmp, tmp, 37, ctr_simd);
+      Camellia_cbc_encrypt(plaintext, expected, 37, ctr_ref, &ctx_ref);
+      assert(memcmp(tmp, expected, 37 * 16) == 0);
+      assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+    }
+
+    /* Check CFB mode against reference implementation. */
+    printf("selftest: checking CFB mode camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+      size_t nbytes = lengths[j];
+      size_t split = (nbytes / 2) & ~(size_t)15;
+
+      for (k = 0; k < 16; k++)
+	ctr_start[k] = 0xf0 + k;
+
+      /* encryption */
+      memcpy(ctr_ref, ctr_start, 16);
+      memcpy(ctr_simd, ctr_start, 16);
+      Camellia_cfb_crypt(plaintext, expected, nbytes, ctr_ref, &ctx_ref, 0);
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_cfb_encrypt(&ctx_simd, tmp, plaintext, nbytes, ctr_simd);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+      if (nbytes % 16 == 0)
+	assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+
+      /* decryption */
+      memcpy(ctr_ref, ctr_start, 16);
+      memcpy(ctr_simd, ctr_start, 16);
+      Camellia_cfb_crypt(plaintext, expected, nbytes, ctr_ref, &ctx_ref, 1);
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_cfb_decrypt(&ctx_simd, tmp, plaintext, nbytes, ctr_simd);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+      if (nbytes % 16 == 0)
+	assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+
+      /* in-place decryption, split in two calls to check IV chaining */
+      memcpy(tmp, plaintext, nbytes);
+      memcpy(ctr_simd, ctr_start, 16);
+      camellia_cfb_decrypt(&ctx_simd, tmp, tmp, split, ctr_simd);
+      camellia_cfb_decrypt(&ctx_simd, tmp + split, tmp + split, nbytes - split,
+			   ctr_simd);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+    }
+
+    /* Check XTS mode against reference implementation. */
+    printf("selftest: checking XTS mode camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+      size_t nbytes = lengths[j];
+      size_t split = (nbytes / 2) & ~(size_t)15;
+
+      for (k = 0; k < 16; k++)
+	ctr_start[k] = 0x80 + k * 7;
+
+      if (nbytes < 16) {
+	assert(camellia_xts_encrypt(&ctx_simd, tmp, plaintext, nbytes,
+				    ctr_simd) < 0);
+	continue;
+      }
+
+      for (i = 0; i < 2; i++) {
+	memcpy(ctr_ref, ctr_start, 16);
+	memcpy(ctr_simd, ctr_start, 16);
+	Camellia_xts_crypt(plaintext, expected, nbytes, ctr_ref, &ctx_ref, i);
+	memset(tmp, 0xaa, sizeof(tmp));
+	if (i)
+	  assert(camellia_xts_decrypt(&ctx_simd, tmp, plaintext, nbytes,
+				      ctr_simd) == 0);
+	else
+	  assert(camellia_xts_encrypt(&ctx_simd, tmp, plaintext, nbytes,
+				      ctr_simd) == 0);
+	assert(memcmp(tmp, expected, nbytes) == 0);
+	assert(tmp[nbytes] == 0xaa);
+	if (nbytes % 16 == 0)
+	  assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+      }
+
+      /* in-place, split in two calls to check tweak chaining */
+      memcpy(ctr_ref, ctr_start, 16);
+      Camellia_xts_crypt(plaintext, expected, nbytes, ctr_ref, &ctx_ref, 0);
+      memcpy(tmp, plaintext, nbytes);
+      memcpy(ctr_simd, ctr_start, 16);
+      if (split >= 16 && nbytes - split >= 16) {
+	camellia_xts_encrypt(&ctx_simd, tmp, tmp, split, ctr_simd);
+	camellia_xts_encrypt(&ctx_simd, tmp + split, tmp + split,
+			     nbytes - split, ctr_simd);
+      } else {
+	camellia_xts_encrypt(&ctx_simd, tmp, tmp, nbytes, ctr_simd);
+      }
+      assert(memcmp(tmp, expected, nbytes) == 0);
+
+      memcpy(ctr_simd, ctr_start, 16);
+      camellia_xts_decrypt(&ctx_simd, tmp, tmp, nbytes, ctr_simd);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+    }
+
+    /* Check OCB mode against reference implementation. */
+    printf("selftest: checking OCB mode camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    camellia_ocb_setkey(&ocb, &ctx_simd);
+    for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+      size_t nbytes = lengths[j];
+      size_t aadlen = (j % 4) ? lengths[(j * 5) % (sizeof(lengths) /
+						  sizeof(lengths[0]))] : 0;
+      const uint8_t *aad = plaintext + 7;
+      size_t split = (nbytes / 2) & ~(size_t)15;
+      size_t noncelen = 1 + j % 15;
+      size_t taglen = 16 - j % 9;
+
+      for (k = 0; k < 16; k++)
+	ctr_start[k] = 0x40 + k * 3 + j;
+
+      Camellia_ocb_crypt(ctr_start, noncelen, aad, aadlen, plaintext, expected,
+			 nbytes, ctr_ref, taglen, &ctx_ref, 0);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      assert(camellia_ocb_set_nonce(&ocb, ctr_start, noncelen, taglen) == 0);
+      camellia_ocb_authenticate(&ocb, aad, aadlen);
+      camellia_ocb_encrypt(&ocb, tmp, plaintext, nbytes);
+      camellia_ocb_get_tag(&ocb, ctr_simd);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+      assert(memcmp(ctr_simd, ctr_ref, taglen) == 0);
+
+      /* in-place decryption in two calls, associated data in two calls */
+      assert(camellia_ocb_set_nonce(&ocb, ctr_start, noncelen, taglen) == 0);
+      camellia_ocb_authenticate(&ocb, aad, aadlen / 3);
+      camellia_ocb_authenticate(&ocb, aad + aadlen / 3, aadlen - aadlen / 3);
+      camellia_ocb_decrypt(&ocb, tmp, tmp, split);
+      camellia_ocb_decrypt(&ocb, tmp + split, tmp + split, nbytes - split);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(camellia_ocb_check_tag(&ocb, ctr_ref) == 0);
+      ctr_ref[0] ^= 1;
+      assert(camellia_ocb_check_tag(&ocb, ctr_ref) != 0);
+    }
+
+    /* Check GCM mode against reference implementation. */
+    printf("selftest: checking GCM mode camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    camellia_gcm_setkey(&gcm, &ctx_simd);
+    assert(camellia_gcm_set_iv(&gcm, plaintext, 0) < 0);
+    for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+      size_t nbytes = lengths[j];
+      size_t aadlen = (j % 4) ? lengths[(j * 5) % (sizeof(lengths) /
+						  sizeof(lengths[0]))] : 0;
+      const uint8_t *aad = plaintext + 7;
+      const uint8_t *iv = plaintext + 3 + j;
+      size_t ivlen = (j % 3) ? 1 + (j * 7) % 60 : 12;
+      size_t split = (nbytes / 2) & ~(size_t)15;
+      uint8_t j0[16];
+
+      gcm_j0_ref(iv, ivlen, j0, &ctx_ref);
+      Camellia_gcm_crypt(j0, aad, aadlen, plaintext, expected, nbytes,
+			 ctr_ref, &ctx_ref, 0);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      assert(camellia_gcm_set_iv(&gcm, iv, ivlen) == 0);
+      camellia_gcm_authenticate(&gcm, aad, aadlen);
+      camellia_gcm_encrypt(&gcm, tmp, plaintext, nbytes);
+      camellia_gcm_get_tag(&gcm, ctr_simd, 16);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+      assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+
+      /* in-place decryption in two calls, associated data in two calls */
+      assert(camellia_gcm_set_iv(&gcm, iv, ivlen) == 0);
+      camellia_gcm_authenticate(&gcm, aad, aadlen / 3);
+      camellia_gcm_authenticate(&gcm, aad + aadlen / 3, aadlen - aadlen / 3);
+      camellia_gcm_decrypt(&gcm, tmp, tmp, split);
+      camellia_gcm_decrypt(&gcm, tmp + split, tmp + split, nbytes - split);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(camellia_gcm_check_tag(&gcm, ctr_ref, 16 - j % 5) == 0);
+      ctr_ref[0] ^= 1;
+      assert(camellia_gcm_check_tag(&gcm, ctr_ref, 16 - j % 5) != 0);
+
+      /* wrap-around of 32-bit counter, J0 set directly */
+      memcpy(j0, ctr_start, 12);
+      memset(j0 + 12, 0xff, 3);
+      j0[15] = 0xd0 + j * 3;
+      Camellia_gcm_crypt(j0, aad, aadlen, plaintext, expected, nbytes,
+			 ctr_ref, &ctx_ref, 0);
+      assert(camellia_gcm_set_iv(&gcm, iv, 12) == 0);
+      memcpy(gcm.J0, j0, 16);
+      memcpy(gcm.ctr, j0, 16);
+      gcm.ctr[15]++;
+      camellia_gcm_authenticate(&gcm, aad, aadlen);
+      camellia_gcm_encrypt(&gcm, tmp, plaintext, nbytes);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(camellia_gcm_check_tag(&gcm, ctr_ref, 16) == 0);
+    }
+
+    /* Check CCM mode against reference implementation. */
+    printf("selftest: checking CCM mode camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    if (keylen == 16) {
+      /* RFC 5528, packet vector #1 */
+      static const uint8_t ccm_key[16] = {
+	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+	0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf
+      };
+      static const uint8_t ccm_nonce[13] = {
+	0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xa0,
+	0xa1, 0xa2, 0xa3, 0xa4, 0xa5
+      };
+      static const uint8_t ccm_result[31] = {
+	0xba, 0x73, 0x71, 0x85, 0xe7, 0x19, 0x31, 0x04,
+	0x92, 0xf3, 0x8a, 0x5f, 0x12, 0x51, 0xda, 0x55,
+	0xfa, 0xfb, 0xc9, 0x49, 0x84, 0x8a, 0x0d, 0xfc,
+	0xae, 0xce, 0x74, 0x6b, 0x3d, 0xb9, 0xad
+      };
+      struct camellia_simd_ctx ctx_ccm;
+      uint8_t packet[31];
+
+      for (k = 0; k < sizeof(packet); k++)
+	packet[k] = k;
+      camellia_keysetup_simd128(&ctx_ccm, ccm_key, sizeof(ccm_key));
+      assert(camellia_ccm_encrypt(&ctx_ccm, tmp, packet + 8, 23, ccm_nonce, 13,
+				  packet, 8, tmp + 23, 8) == 0);
+      assert(memcmp(tmp, ccm_result, 31) == 0);
+    }
+    for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+      size_t nbytes = lengths[j];
+      size_t aadlen = (j % 4) ? lengths[(j * 5) % (sizeof(lengths) /
+						  sizeof(lengths[0]))] : 0;
+      const uint8_t *aad = plaintext + 7;
+      const uint8_t *nonce = plaintext + 3 + j;
+      size_t noncelen = 7 + j % 7;
+      size_t taglen = 16 - (j % 7) * 2;
+
+      Camellia_ccm_crypt(nonce, noncelen, aad, aadlen, plaintext, expected,
+			 nbytes, ctr_ref, taglen, &ctx_ref, 0);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      assert(camellia_ccm_encrypt(&ctx_simd, tmp, plaintext, nbytes, nonce,
+				  noncelen, aad, aadlen, ctr_simd,
+				  taglen) == 0);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+      assert(memcmp(ctr_simd, ctr_ref, taglen) == 0);
+
+      /* in-place decryption */
+      assert(camellia_ccm_decrypt(&ctx_simd, tmp, tmp, nbytes, nonce,
+				  noncelen, aad, aadlen, ctr_ref,
+				  taglen) == 0);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      ctr_ref[0] ^= 1;
+      assert(camellia_ccm_decrypt(&ctx_simd, tmp, expected, nbytes, nonce,
+				  noncelen, aad, aadlen, ctr_ref,
+				  taglen) != 0);
+    }
+
+    /* Multi-message CCM, more messages than parallel lanes. */
+    printf("selftest: checking multi-message CCM mode camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    {
+      struct camellia_ccm_msg msgs[40];
+      uint8_t tags[40][16];
+      uint8_t expected_tags[40][16];
+      size_t pos = 0;
+
+      for (j = 0; j < 40; j++) {
+	msgs[j].nonce = plaintext + j;
+	msgs[j].aad = plaintext + 5 + j;
+	msgs[j].aadlen = j % 24;
+	msgs[j].in = plaintext + pos;
+	msgs[j].out = tmp + pos;
+	msgs[j].nbytes = (j * 37) % 48;
+	msgs[j].tag = tags[j];
+	Camellia_ccm_crypt(msgs[j].nonce, 11, msgs[j].aad, msgs[j].aadlen,
+			   plaintext + pos, expected + pos, msgs[j].nbytes,
+			   expected_tags[j], 10, &ctx_ref, 0);
+	pos += msgs[j].nbytes;
+      }
+
+      assert(camellia_ccm_encrypt_multi(&ctx_simd, msgs, 40, 11, 10) == 0);
+      assert(memcmp(tmp, expected, pos) == 0);
+      for (j = 0; j < 40; j++)
+	assert(memcmp(tags[j], expected_tags[j], 10) == 0);
+
+      /* in-place decryption, with one tampered tag */
+      for (j = 0; j < 40; j++)
+	msgs[j].in = msgs[j].out;
+      tags[33][9] ^= 0x80;
+      assert(camellia_ccm_decrypt_multi(&ctx_simd, msgs, 40, 11, 10) != 0);
+      for (j = 0, pos = 0; j < 40; pos += msgs[j].nbytes, j++) {
+	if (j == 33) {
+	  assert(msgs[j].status != 0);
+	  continue;
+	}
+	assert(msgs[j].status == 0);
+	assert(memcmp(tmp + pos, plaintext + pos, msgs[j].nbytes) == 0);
+      }
+
+      /* Message too long for 2-byte length field is skipped, others are
+       * still processed. */
+      for (j = 0; j < 3; j++) {
+	msgs[j].nonce = plaintext + j;
+	msgs[j].aad = NULL;
+	msgs[j].aadlen = 0;
+	msgs[j].in = plaintext + j * 32;
+	msgs[j].out = tmp + j * 32;
+	msgs[j].nbytes = j == 1 ? 0x10000 : 32;
+	msgs[j].tag = tags[j];
+	msgs[j].status = 1;
+	if (j != 1)
+	  Camellia_ccm_crypt(msgs[j].nonce, 13, NULL, 0, plaintext + j * 32,
+			     expected + j * 32, 32, expected_tags[j], 16,
+			     &ctx_ref, 0);
+      }
+      memset(tmp + 32, 0xaa, 32);
+      assert(camellia_ccm_encrypt_multi(&ctx_simd, msgs, 3, 13, 16) != 0);
+      assert(msgs[1].status == -1);
+      assert(tmp[32] == 0xaa && tmp[63] == 0xaa);
+      for (j = 0; j < 3; j += 2) {
+	assert(msgs[j].status == 0);
+	assert(memcmp(tmp + j * 32, expected + j * 32, 32) == 0);
+	assert(memcmp(tags[j], expected_tags[j], 16) == 0);
+      }
+    }
+    /* Multi-message CMAC, more messages than parallel lanes and lengths
+     * varying so that lanes get refilled at different steps. */
+    printf("selftest: checking CMAC camellia-%d against reference implementation...\n",
+	   keylen * 8);
+    {
+      struct camellia_cmac_ctx cmac;
+      struct camellia_cmac_msg msgs[75];
+      uint8_t macs[75][16];
+      uint8_t expected_macs[75][16];
+
+      camellia_cmac_setkey(&cmac, &ctx_simd);
+
+      for (j = 0; j < 75; j++) {
+	msgs[j].in = plaintext + j;
+	msgs[j].nbytes = (j * 97) % 600;
+	msgs[j].mac = macs[j];
+	Camellia_cmac(msgs[j].in, msgs[j].nbytes, expected_macs[j], &ctx_ref);
+      }
+
+      camellia_cmac_multi(&cmac, msgs, 75);
+      for (j = 0; j < 75; j++)
+	assert(memcmp(macs[j], expected_macs[j], 16) == 0);
+
+      for (j = 0; j < 40; j++) {
+	camellia_cmac(&cmac, ctr_simd, plaintext + 1, j * 8);
+	Camellia_cmac(plaintext + 1, j * 8, ctr_ref, &ctx_ref);
+	assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+      }
+    }
+
+    /* Streaming, with fragments splitting blocks and batches. */
+    printf("selftest: checking streaming camellia-%d against bulk functions...\n",
+	   keylen * 8);
+    {
+      static const size_t frags[] = { 1, 15, 100, 513, 7, 1024, 300 };
+      static const int modes[] = {
+	CAMELLIA_STREAM_ECB_ENC, CAMELLIA_STREAM_ECB_DEC,
+	CAMELLIA_STREAM_CTR, CAMELLIA_STREAM_CBC_DEC
+      };
+      struct camellia_stream_ctx st;
+      size_t total, pos, outpos, n, outlen;
+
+      for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+	total = modes[i] == CAMELLIA_STREAM_CTR ? sizeof(plaintext) - 5
+						: sizeof(plaintext);
+
+	memset(ctr_start, 0xfe, sizeof(ctr_start));
+	memcpy(ctr_ref, ctr_start, 16);
+	switch (modes[i]) {
+	  case CAMELLIA_STREAM_ECB_ENC:
+	    camellia_ecb_encrypt(&ctx_simd, expected, plaintext, total / 16);
+	    break;
+	  case CAMELLIA_STREAM_ECB_DEC:
+	    camellia_ecb_decrypt(&ctx_simd, expected, plaintext, total / 16);
+	    break;
+	  case CAMELLIA_STREAM_CTR:
+	    camellia_ctr_crypt(&ctx_simd, expected, plaintext, total, ctr_ref);
+	    break;
+	  case CAMELLIA_STREAM_CBC_DEC:
+	    camellia_cbc_decrypt(&ctx_simd, expected, plaintext, total / 16,
+				 ctr_ref);
+	    break;
+	}
+
+	assert(camellia_stream_init(&st, &ctx_simd, modes[i], ctr_start) == 0);
+	memset(tmp, 0xaa, sizeof(tmp));
+	for (pos = 0, outpos = 0, j = 0; pos < total; pos += n, j++) {
+	  n = frags[j % (sizeof(frags) / sizeof(frags[0]))];
+	  if (n > total - pos)
+	    n = total - pos;
+	  outpos += camellia_stream_update(&st, tmp + outpos, plaintext + pos,
+					   n);
+	  assert(outpos % CAMELLIA_STREAM_BATCH_BYTES == 0);
+	  assert(pos + n - outpos < CAMELLIA_STREAM_BATCH_BYTES);
+	}
+	assert(camellia_stream_final(&st, tmp + outpos, &outlen) == 0);
+	assert(outpos + outlen == total);
+	assert(memcmp(tmp, expected, total) == 0);
+	if (modes[i] != CAMELLIA_STREAM_ECB_ENC &&
+	    modes[i] != CAMELLIA_STREAM_ECB_DEC)
+	  assert(memcmp(st.iv, ctr_ref, 16) == 0);
+      }
+
+      /* Partial block is error for ECB and CBC. */
+      assert(camellia_stream_init(&st, &ctx_simd, CAMELLIA_STREAM_CBC_DEC,
+				  ctr_start) == 0);
+      assert(camellia_stream_update(&st, tmp, plaintext, 17) == 0);
+      assert(camellia_stream_final(&st, tmp, &outlen) == -1);
+      assert(camellia_stream_init(&st, &ctx_simd, 99, NULL) == -1);
+    }
+
+    /* Scatter-gather, with segments splitting blocks and long segments
+     * processed in place. */
+    printf("selftest: checking scatter-gather camellia-%d against bulk functions...\n",
+	   keylen * 8);
+    {
+      static const size_t src_lens[] = { 7, 600, 33, 1, 0, 200, 1100, 107 };
+      static const size_t dst_lens[] = { 1500, 16, 5, 527 };
+      struct iovec src_iov[8], dst_iov[4];
+      size_t total, pos;
+
+      for (pos = 0, j = 0; j < 8; pos += src_lens[j], j++) {
+	src_iov[j].iov_base = plaintext + pos;
+	src_iov[j].iov_len = src_lens[j];
+      }
+      total = pos;
+      assert(total == sizeof(plaintext));
+      for (pos = 0, j = 0; j < 4; pos += dst_lens[j], j++) {
+	dst_iov[j].iov_base = tmp + pos;
+	dst_iov[j].iov_len = dst_lens[j];
+      }
+      assert(pos == total);
+
+      camellia_ecb_encrypt(&ctx_simd, expected, plaintext, total / 16);
+      memset(tmp, 0xaa, sizeof(tmp));
+      assert(camellia_ecb_encrypt_iov(&ctx_simd, dst_iov, 4, src_iov, 8) == 0);
+      assert(memcmp(tmp, expected, total) == 0);
+
+      camellia_ecb_decrypt(&ctx_simd, expected, plaintext, total / 16);
+      assert(camellia_ecb_decrypt_iov(&ctx_simd, dst_iov, 4, src_iov, 8) == 0);
+      assert(memcmp(tmp, expected, total) == 0);
+
+      memset(ctr_ref, 0x7f, 16);
+      memset(ctr_simd, 0x7f, 16);
+      camellia_cbc_decrypt(&ctx_simd, expected, plaintext, total / 16,
+			   ctr_ref);
+      assert(camellia_cbc_decrypt_iov(&ctx_simd, dst_iov, 4, src_iov, 8,
+				      ctr_simd) == 0);
+      assert(memcmp(tmp, expected, total) == 0);
+      assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+
+      /* CBC in place. */
+      memcpy(tmp, plaintext, total);
+      for (pos = 0, j = 0; j < 8; pos += src_iov[j].iov_len, j++)
+	src_iov[j].iov_base = tmp + pos;
+      memset(ctr_simd, 0x7f, 16);
+      assert(camellia_cbc_decrypt_iov(&ctx_simd, src_iov, 8, src_iov, 8,
+				      ctr_simd) == 0);
+      assert(memcmp(tmp, expected, total) == 0);
+      assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+
+      /* CTR in place, with partial last block. */
+      src_iov[7].iov_len -= 3;
+      total -= 3;
+      memset(ctr_ref, 0xfd, 16);
+      memset(ctr_simd, 0xfd, 16);
+      camellia_ctr_crypt(&ctx_simd, expected, plaintext, total, ctr_ref);
+      memcpy(tmp, plaintext, sizeof(plaintext));
+      for (pos = 0, j = 0; j < 8; pos += src_iov[j].iov_len, j++)
+	src_iov[j].iov_base = tmp + pos;
+      assert(camellia_ctr_crypt_iov(&ctx_simd, src_iov, 8, src_iov, 8,
+				    ctr_simd) == 0);
+      assert(memcmp(tmp, expected, total) == 0);
+      assert(tmp[total] == plaintext[total]);
+      assert(memcmp(ctr_simd, ctr_ref, 16) == 0);
+
+      /* Partial block for ECB and short destination are errors. */
+      assert(camellia_ecb_encrypt_iov(&ctx_simd, src_iov, 8, src_iov, 8) ==
+	     -1);
+      assert(camellia_ecb_encrypt_iov(&ctx_simd, dst_iov, 1, dst_iov, 4) ==
+	     -1);
+    }
+  }
+}
+
+static uint64_t curr_clock_nsecs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+static bool unaligned_mode;
+
+static void print_result(const char *variant, uint64_t num_bytes,
+			 uint64_t elapsed_nsecs)
+{
+  char mode_variant[128];
+  double mebi_per_sec, mega_per_sec;
+
+  if (unaligned_mode) {
+    snprintf(mode_variant, sizeof(mode_variant), "unaligned %44s", variant);
+  } else {
+    snprintf(mode_variant, sizeof(mode_variant), "%44s", variant);
+  }
+
+  mebi_per_sec = num_bytes * 1e9 / (1024.0 * 1024 * elapsed_nsecs);
+  mega_per_sec = num_bytes * 1e9 / (1e6 * elapsed_nsecs);
+  printf("%s: %10.3f Mebibytes/s, %10.3f Megabytes/s\n",
+	 mode_variant, mebi_per_sec, mega_per_sec);
+  fflush(stdout);
+}
 
 static void do_speedtest(bool unaligned)
 {
@@ -396,11 +1928,23 @@ static void do_speedtest(bool unaligned)
   CAMELLIA_KEY ctx_ref = { 0 };
   uint8_t tmp[16 * 32 * 16] __attribute__((aligned(64)));
   uint8_t tmp_unaligned[16 * 32 * 16 + 1] __attribute__((aligned(64)));
+  struct camellia_ocb_ctx ocb;
+  struct camellia_gcm_ctx gcm;
+  struct camellia_ccm_msg ccm_msgs[sizeof(tmp) / 64];
+  uint8_t msg_tags[sizeof(tmp) / 64][16];
+  struct camellia_cmac_ctx cmac;
+  struct camellia_cmac_msg cmac_msgs[sizeof(tmp) / 64];
+  struct camellia_cbc_job cbc_jobs[sizeof(tmp) / 64];
   uint8_t *tmp_ptr = tmp;
+  uint8_t ctr[16];
   uint64_t start_time;
   uint64_t end_time;
   uint64_t total_bytes;
   unsigned int i, j;
+#if defined(USE_SVE2) || defined(USE_RVV)
+  char vl_name[64];
+  unsigned int n;
+#endif
 
   for (i = 0; i < sizeof(tmp); i++)
     tmp[i] = ((i + 3221) * 1231) & 0xff;
@@ -468,6 +2012,22 @@ static void do_speedtest(bool unaligned)
 		total_bytes, end_time - start_time);
   }
 
+  /* Test speed of 2-block SIMD128 implementation. */
+  total_bytes = 0;
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (j = 0; j + 2 * 16 <= sizeof(tmp); j += 2 * 16) {
+      camellia_encrypt_2blks_simd128(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j]);
+      total_bytes += 2 * 16;
+    }
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 SIMD128 (2 blocks) encryption",
+	       total_bytes, end_time - start_time);
+
   /* Test speed of 16-block SIMD128 implementation. */
   total_bytes = 0;
   camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
@@ -501,6 +2061,41 @@ static void do_speedtest(bool unaligned)
   print_result("camellia-128 SIMD128 (16 blocks) decryption",
 	       total_bytes, end_time - start_time);
 
+  if (have_camellia_32blks_simd128()) {
+    /* Test speed of interleaved 32-block SIMD128 implementation. */
+    total_bytes = 0;
+    camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+    start_time = curr_clock_nsecs();
+    do {
+      for (j = 0; j < sizeof(tmp); ) {
+	camellia_encrypt_32blks_simd128(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j]);
+	j += 32 * 16;
+	total_bytes += 32 * 16;
+      }
+      end_time = curr_clock_nsecs();
+    } while (start_time + test_nsecs > end_time);
+
+    print_result("camellia-128 SIMD128 (32 blocks) encryption",
+		 total_bytes, end_time - start_time);
+
+    total_bytes = 0;
+    camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+    start_time = curr_clock_nsecs();
+    do {
+      for (j = 0; j < sizeof(tmp); ) {
+	camellia_decrypt_32blks_simd128(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j]);
+	j += 32 * 16;
+	total_bytes += 32 * 16;
+      }
+      end_time = curr_clock_nsecs();
+    } while (start_time + test_nsecs > end_time);
+
+    print_result("camellia-128 SIMD128 (32 blocks) decryption",
+		 total_bytes, end_time - start_time);
+  }
+
 #ifdef USE_SIMD256
   /* Test speed of 32-block SIMD256 implementation. */
   total_bytes = 0;
@@ -535,14 +2130,487 @@ static void do_speedtest(bool unaligned)
   print_result("camellia-128 SIMD256 (32 blocks) decryption",
 	       total_bytes, end_time - start_time);
 #endif
+
+#ifdef USE_SIMD512
+  /* Test speed of 64-block SIMD512 implementation. */
+  total_bytes = 0;
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (j = 0; j < sizeof(tmp); ) {
+      camellia_encrypt_64blks_simd512(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j]);
+      j += 64 * 16;
+      total_bytes += 64 * 16;
+    }
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 SIMD512 (64 blocks) encryption",
+	       total_bytes, end_time - start_time);
+
+  total_bytes = 0;
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (j = 0; j < sizeof(tmp); ) {
+      camellia_decrypt_64blks_simd512(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j]);
+      j += 64 * 16;
+      total_bytes += 64 * 16;
+    }
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 SIMD512 (64 blocks) decryption",
+	       total_bytes, end_time - start_time);
+#endif
+
+#ifdef USE_SVE2
+  /* Test speed of vector-length agnostic SVE2 implementation. */
+  n = camellia_sve2_parallel_blks();
+  total_bytes = 0;
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (j = 0; j + n * 16 <= sizeof(tmp); ) {
+      camellia_encrypt_nblks_sve2(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j], n);
+      j += n * 16;
+      total_bytes += n * 16;
+    }
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  snprintf(vl_name, sizeof(vl_name), "camellia-128 SVE2 (%u blocks) encryption", n);
+  print_result(vl_name, total_bytes, end_time - start_time);
+
+  total_bytes = 0;
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (j = 0; j + n * 16 <= sizeof(tmp); ) {
+      camellia_decrypt_nblks_sve2(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j], n);
+      j += n * 16;
+      total_bytes += n * 16;
+    }
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  snprintf(vl_name, sizeof(vl_name), "camellia-128 SVE2 (%u blocks) decryption", n);
+  print_result(vl_name, total_bytes, end_time - start_time);
+#endif
+
+#ifdef USE_RVV
+  /* Test speed of VLEN agnostic RVV implementation. */
+  n = camellia_rvv_parallel_blks();
+  total_bytes = 0;
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (j = 0; j + n * 16 <= sizeof(tmp); ) {
+      camellia_encrypt_nblks_rvv(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j], n);
+      j += n * 16;
+      total_bytes += n * 16;
+    }
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  snprintf(vl_name, sizeof(vl_name), "camellia-128 RVV (%u blocks) encryption", n);
+  print_result(vl_name, total_bytes, end_time - start_time);
+
+  total_bytes = 0;
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (j = 0; j + n * 16 <= sizeof(tmp); ) {
+      camellia_decrypt_nblks_rvv(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j], n);
+      j += n * 16;
+      total_bytes += n * 16;
+    }
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  snprintf(vl_name, sizeof(vl_name), "camellia-128 RVV (%u blocks) decryption", n);
+  print_result(vl_name, total_bytes, end_time - start_time);
+#endif
+
+  /* Test speed of ECB bulk encryption. */
+  total_bytes = 0;
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_ecb_encrypt(&ctx_simd, tmp_ptr, tmp_ptr, sizeof(tmp) / 16);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 ECB encryption",
+	       total_bytes, end_time - start_time);
+
+  total_bytes = 0;
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (j = 0; j + 20 * 16 <= sizeof(tmp); j += 20 * 16) {
+      camellia_ecb_encrypt(&ctx_simd, &tmp_ptr[j], &tmp_ptr[j], 20);
+      total_bytes += 20 * 16;
+    }
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 ECB encryption (20 blocks)",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of CTR mode. */
+  total_bytes = 0;
+  camellia_keysetup_simd128(&ctx_simd, test_vector_key_128, 128 / 8);
+  memset(ctr, 0, sizeof(ctr));
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_ctr_crypt(&ctx_simd, tmp_ptr, tmp_ptr, sizeof(tmp), ctr);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CTR encryption",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of CBC decryption. */
+  total_bytes = 0;
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_cbc_decrypt(&ctx_simd, tmp_ptr, tmp_ptr, sizeof(tmp) / 16, ctr);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CBC decryption",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of CBC encryption. */
+  total_bytes = 0;
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_cbc_encrypt(&ctx_simd, tmp_ptr, tmp_ptr, sizeof(tmp) / 16, ctr);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CBC encryption",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of multi-stream CBC encryption, with 64-byte streams. */
+  total_bytes = 0;
+  memset(msg_tags, 0, sizeof(msg_tags));
+  for (i = 0; i < sizeof(cbc_jobs) / sizeof(cbc_jobs[0]); i++) {
+    cbc_jobs[i].in = tmp_ptr + i * 64;
+    cbc_jobs[i].out = tmp_ptr + i * 64;
+    cbc_jobs[i].nblks = 4;
+    cbc_jobs[i].iv = msg_tags[i];
+  }
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_cbc_encrypt_multi(&ctx_simd, cbc_jobs,
+			       sizeof(cbc_jobs) / sizeof(cbc_jobs[0]));
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CBC encryption (multi)",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of CFB decryption. */
+  total_bytes = 0;
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_cfb_decrypt(&ctx_simd, tmp_ptr, tmp_ptr, sizeof(tmp), ctr);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CFB decryption",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of XTS encryption, with 512-byte data units. */
+  total_bytes = 0;
+
+  start_time = curr_clock_nsecs();
+  do {
+    for (i = 0; i + 512 <= sizeof(tmp); i += 512) {
+      memset(ctr, 0, sizeof(ctr));
+      camellia_xts_encrypt(&ctx_simd, tmp_ptr + i, tmp_ptr + i, 512, ctr);
+    }
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 XTS encryption",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of OCB encryption. */
+  total_bytes = 0;
+  camellia_ocb_setkey(&ocb, &ctx_simd);
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_ocb_set_nonce(&ocb, ctr, 12, 16);
+    camellia_ocb_encrypt(&ocb, tmp_ptr, tmp_ptr, sizeof(tmp));
+    camellia_ocb_get_tag(&ocb, ctr);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 OCB encryption",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of GCM encryption. */
+  total_bytes = 0;
+  camellia_gcm_setkey(&gcm, &ctx_simd);
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_gcm_set_iv(&gcm, ctr, 12);
+    camellia_gcm_encrypt(&gcm, tmp_ptr, tmp_ptr, sizeof(tmp));
+    camellia_gcm_get_tag(&gcm, ctr, 16);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 GCM encryption",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of CCM encryption. */
+  total_bytes = 0;
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_ccm_encrypt(&ctx_simd, tmp_ptr, tmp_ptr, sizeof(tmp), ctr, 12,
+			 NULL, 0, ctr, 16);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CCM encryption",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of multi-message CCM encryption, with 64-byte messages. */
+  total_bytes = 0;
+  for (i = 0; i < sizeof(ccm_msgs) / sizeof(ccm_msgs[0]); i++) {
+    ccm_msgs[i].nonce = ctr;
+    ccm_msgs[i].aad = NULL;
+    ccm_msgs[i].aadlen = 0;
+    ccm_msgs[i].in = tmp_ptr + i * 64;
+    ccm_msgs[i].out = tmp_ptr + i * 64;
+    ccm_msgs[i].nbytes = 64;
+    ccm_msgs[i].tag = msg_tags[i];
+  }
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_ccm_encrypt_multi(&ctx_simd, ccm_msgs,
+			       sizeof(ccm_msgs) / sizeof(ccm_msgs[0]), 12, 16);
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CCM encryption (multi)",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of CMAC. */
+  camellia_cmac_setkey(&cmac, &ctx_simd);
+  total_bytes = 0;
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_cmac(&cmac, ctr, tmp_ptr, sizeof(tmp));
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CMAC",
+	       total_bytes, end_time - start_time);
+
+  /* Test speed of multi-message CMAC, with 64-byte messages. */
+  total_bytes = 0;
+  for (i = 0; i < sizeof(cmac_msgs) / sizeof(cmac_msgs[0]); i++) {
+    cmac_msgs[i].in = tmp_ptr + i * 64;
+    cmac_msgs[i].nbytes = 64;
+    cmac_msgs[i].mac = msg_tags[i];
+  }
+
+  start_time = curr_clock_nsecs();
+  do {
+    camellia_cmac_multi(&cmac, cmac_msgs,
+			sizeof(cmac_msgs) / sizeof(cmac_msgs[0]));
+    total_bytes += sizeof(tmp);
+    end_time = curr_clock_nsecs();
+  } while (start_time + test_nsecs > end_time);
+
+  print_result("camellia-128 CMAC (multi)",
+	       total_bytes, end_time - start_time);
+}
+
+#ifdef USE_DISPATCH
+static void do_selftest_lib(void)
+{
+  static const size_t nblocks[] = { 1, 15, 16, 17, 33, 100 };
+  struct camellia_simd_ctx ctx_simd;
+  CAMELLIA_KEY ctx_ref = { 0 };
+  uint8_t key[32];
+  uint8_t plaintext[100 * 16];
+  uint8_t expected[100 * 16];
+  uint8_t tmp[100 * 16 + 1];
+  uint8_t iv[16], iv_lib[16];
+  unsigned int i, j, keylen;
+
+  printf("selftest: checking library version and bulk functions...\n");
+
+  assert(camellia_simd_version() == CAMELLIA_SIMD_VERSION);
+
+  for (i = 0; i < sizeof(key); i++)
+    key[i] = ((i + 1231) * 3221) & 0xff;
+  for (i = 0; i < sizeof(plaintext); i++)
+    plaintext[i] = ((i + 3221) * 1231) & 0xff;
+
+  assert(camellia_simd_setkey(&ctx_simd, key, 20) == -1);
+
+  for (keylen = 16; keylen <= 32; keylen += 8) {
+    Camellia_set_key(key, keylen * 8, &ctx_ref);
+    assert(camellia_simd_setkey(&ctx_simd, key, keylen) == 0);
+
+    for (j = 0; j < sizeof(nblocks) / sizeof(nblocks[0]); j++) {
+      size_t nbytes = nblocks[j] * 16;
+      size_t half = nblocks[j] / 2;
+
+      Camellia_encrypt_nblks(plaintext, expected, nblocks[j], &ctx_ref);
+
+      memset(tmp, 0xaa, sizeof(tmp));
+      camellia_simd_ecb_enc_blocks(&ctx_simd, tmp, plaintext, nblocks[j]);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(tmp[nbytes] == 0xaa);
+      camellia_simd_ecb_dec_blocks(&ctx_simd, tmp, tmp, nblocks[j]);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+
+      /* Split calls must continue the same stream as one mode call. */
+      memset(iv, 0xf0, sizeof(iv));
+      memcpy(iv_lib, iv, sizeof(iv));
+      camellia_ctr_crypt(&ctx_simd, expected, plaintext, nbytes, iv);
+      camellia_simd_ctr_blocks(&ctx_simd, tmp, plaintext, half, iv_lib);
+      camellia_simd_ctr_blocks(&ctx_simd, tmp + half * 16,
+			       plaintext + half * 16, nblocks[j] - half,
+			       iv_lib);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(memcmp(iv, iv_lib, sizeof(iv)) == 0);
+
+      memset(iv, 0x5a, sizeof(iv));
+      memcpy(iv_lib, iv, sizeof(iv));
+      camellia_cbc_encrypt(&ctx_simd, expected, plaintext, nblocks[j], iv);
+      camellia_simd_cbc_enc_blocks(&ctx_simd, tmp, plaintext, half, iv_lib);
+      camellia_simd_cbc_enc_blocks(&ctx_simd, tmp + half * 16,
+				   plaintext + half * 16, nblocks[j] - half,
+				   iv_lib);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      assert(memcmp(iv, iv_lib, sizeof(iv)) == 0);
+
+      memset(iv_lib, 0x5a, sizeof(iv_lib));
+      camellia_simd_cbc_dec_blocks(&ctx_simd, tmp, tmp, nblocks[j], iv_lib);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(memcmp(iv, iv_lib, sizeof(iv)) == 0);
+
+      memset(iv, 0x3c, sizeof(iv));
+      memcpy(iv_lib, iv, sizeof(iv));
+      camellia_cfb_encrypt(&ctx_simd, expected, plaintext, nbytes, iv);
+      camellia_simd_cfb_enc_blocks(&ctx_simd, tmp, plaintext, nblocks[j],
+				   iv_lib);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      memset(iv_lib, 0x3c, sizeof(iv_lib));
+      camellia_simd_cfb_dec_blocks(&ctx_simd, tmp, tmp, nblocks[j], iv_lib);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(memcmp(iv, iv_lib, sizeof(iv)) == 0);
+
+      memset(iv, 0xc3, sizeof(iv));
+      memcpy(iv_lib, iv, sizeof(iv));
+      camellia_xts_encrypt(&ctx_simd, expected, plaintext, nbytes, iv);
+      camellia_simd_xts_enc_blocks(&ctx_simd, tmp, plaintext, nblocks[j],
+				   iv_lib);
+      assert(memcmp(tmp, expected, nbytes) == 0);
+      memset(iv_lib, 0xc3, sizeof(iv_lib));
+      camellia_simd_xts_dec_blocks(&ctx_simd, tmp, tmp, nblocks[j], iv_lib);
+      assert(memcmp(tmp, plaintext, nbytes) == 0);
+      assert(memcmp(iv, iv_lib, sizeof(iv)) == 0);
+    }
+  }
 }
+#endif
 
 int main(int argc, const char *argv[])
 {
+#ifdef USE_DISPATCH
+  const char *selected_impl;
+  const char *impl;
+  unsigned int i;
+#endif
+
   printf("%s:\n", argv[0]);
 
+#ifdef USE_DISPATCH
+  /* Run selftests with each implementation supported by this CPU, and
+   * speedtests with the one selected at startup. */
+  selected_impl = camellia_simd_impl_name();
+  for (i = 0; (impl = camellia_simd_impl_available(i)) != NULL; i++) {
+    printf("selftest: using implementation %s...\n", impl);
+    assert(camellia_simd_set_impl(impl) == 0);
+    do_selftest();
+    do_selftest_modes();
+    do_selftest_lib();
+  }
+
+  /* Modes with autotuned implementations, possibly different one for each
+   * operation and size. */
+  assert(camellia_simd_set_impl(selected_impl) == 0);
+  assert(camellia_simd_autotune(NULL) == 0);
+  {
+    /* Cache is written on first call and loaded back on second one. */
+    char cache_path[64];
+    FILE *f;
+
+    snprintf(cache_path, sizeof(cache_path), "/tmp/camellia_simd_tune.%ld",
+	     (long)time(NULL) ^ (long)clock());
+    assert(camellia_simd_autotune(cache_path) == 0);
+    f = fopen(cache_path, "r");
+    assert(f != NULL);
+    fclose(f);
+    assert(camellia_simd_autotune(cache_path) == 0);
+    remove(cache_path);
+  }
+  printf("selftest: using autotuned implementations (ecb_enc: %s/%s/%s, "
+	 "ctr: %s/%s/%s, gcm: %s)...\n",
+	 camellia_simd_tuned_impl_name("ecb_enc", 8),
+	 camellia_simd_tuned_impl_name("ecb_enc", 64),
+	 camellia_simd_tuned_impl_name("ecb_enc", 512),
+	 camellia_simd_tuned_impl_name("ctr", 8),
+	 camellia_simd_tuned_impl_name("ctr", 64),
+	 camellia_simd_tuned_impl_name("ctr", 512),
+	 camellia_simd_tuned_impl_name("gcm", 0));
+  do_selftest_modes();
+
+  assert(camellia_simd_set_impl(selected_impl) == 0);
+  printf("speedtest: using implementation %s\n", selected_impl);
+#else
   do_selftest();
 
+  do_selftest_modes();
+#endif
+
   do_speedtest(false);
 
   do_speedtest(true);